@@ -47,6 +47,9 @@
 #define GPR_DEFAULT_ARGUMENTS 2
 #define GPR_TERMINALS         2
 
+/* the largest subtree height which is recorded within a node */
+#define GPR_MAX_HEIGHT        255
+
 /* used to indicate a missing value */
 #define GPR_MISSING_VALUE     -9999
 
@@ -56,14 +56,38 @@ int is_nan(float v)
     return d != d;
 }
 
-/* Lehmer random number generator */
+/* Counter based random number generator.
+   The seed is a counter which advances by a fixed odd step, and
+   each value is a hash of the counter.  Every seed is valid and
+   there are no divisions, so it is much cheaper than a Lehmer
+   generator */
 int rand_num(unsigned int * seed)
 {
-    unsigned int v =
-        ((unsigned long long)(*seed) * 279470273UL) % 4294967291UL;
-    if (v==0) v = (int)time(NULL); /* avoid the singularity */
+    unsigned int v = *seed + 0x6D2B79F5U;
+
     *seed = v;
-    return abs((int)v);
+    v = (v ^ (v >> 15)) * (v | 1U);
+    v ^= v + ((v ^ (v >> 7)) * (v | 61U));
+    return (int)((v ^ (v >> 14)) >> 1);
+}
+
+/* mixes the bits of the given value */
+static unsigned int rand_mix(unsigned int v)
+{
+    v ^= v >> 16;
+    v *= 0x85EBCA6BU;
+    v ^= v >> 13;
+    v *= 0xC2B2AE35U;
+    v ^= v >> 16;
+    return v;
+}
+
+/* Returns the seed for an independent stream of random numbers
+   derived from the given seed.  This allows each individual to be
+   bred on any thread while still giving the same results */
+unsigned int rand_stream(unsigned int seed, unsigned int stream)
+{
+    return rand_mix(seed ^ rand_mix(stream*0x9E3779B9U + 0x7F4A7C15U));
 }
 
 /* is the given function type a terminal ? */
@@ -119,6 +143,7 @@ static void gpr_replace(gpr_function * f,
                         max_argc);
         }
     }
+    gpr_annotate_node(f);
 }
 
 /* returns 1 if the given program contains the given function */
@@ -242,6 +267,7 @@ void gpr_enforce_ADFs(gpr_function * f, gpr_state * state)
             }
         }
     }
+    gpr_annotate_node(f);
 }
 
 /* returns a pair of numbers from the arguments of the given program */
@@ -1228,7 +1254,7 @@ static void gpr_store_c(FILE * fp, int argc)
 }
 
 /* stores a value in a register or actuator */
-static float store(float v1, float v2, gpr_state * state)
+float gpr_state_store(float v1, float v2, gpr_state * state)
 {
     int index, v;
 
@@ -1255,17 +1281,17 @@ static float gpr_set(gpr_function * f,
                      gpr_state * state, int call_depth,
                      float (*custom_function)(float,float,float))
 {
-    return store(gpr_run_function((gpr_function*)f->argv[0], state,
-                                  call_depth,
-                                  (*custom_function)),
-                 gpr_run_function((gpr_function*)f->argv[1], state,
-                                  call_depth,
-                                  (*custom_function)),
-                 state);
+    return gpr_state_store(gpr_run_function((gpr_function*)f->argv[0],
+                                            state, call_depth,
+                                            (*custom_function)),
+                           gpr_run_function((gpr_function*)f->argv[1],
+                                            state, call_depth,
+                                            (*custom_function)),
+                           state);
 }
 
 /* push a value to a particular field */
-static float push(float v1, float v2, gpr_state * state)
+float gpr_state_push(float v1, float v2, gpr_state * state)
 {
     if (state->data.fields == 0) return 0;
     gpr_data_set_head(&state->data,
@@ -1287,17 +1313,17 @@ static float gpr_push(gpr_function * f,
                       gpr_state * state, int call_depth,
                       float (*custom_function)(float,float,float))
 {
-    return push(gpr_run_function((gpr_function*)f->argv[0], state,
-                                 call_depth,
-                                 (*custom_function)),
-                gpr_run_function((gpr_function*)f->argv[1], state,
-                                 call_depth,
-                                 (*custom_function)),
-                state);
+    return gpr_state_push(gpr_run_function((gpr_function*)f->argv[0],
+                                           state, call_depth,
+                                           (*custom_function)),
+                          gpr_run_function((gpr_function*)f->argv[1],
+                                           state, call_depth,
+                                           (*custom_function)),
+                          state);
 }
 
 /* returns a value at the tail of the data store and removes that entry */
-static float pop(float v1, gpr_state * state)
+float gpr_state_pop(float v1, gpr_state * state)
 {
     float real = 0, imaginary = 0;
     /* return a value at the tail */
@@ -1322,14 +1348,14 @@ static float gpr_pop(gpr_function * f,
                      gpr_state * state, int call_depth,
                      float (*custom_function)(float,float,float))
 {
-    return pop(gpr_run_function((gpr_function*)f->argv[0],
-                                state, call_depth,
-                                (*custom_function)),
-               state);
+    return gpr_state_pop(gpr_run_function((gpr_function*)f->argv[0],
+                                          state, call_depth,
+                                          (*custom_function)),
+                         state);
 }
 
 /* returns a value from the data store in the given field */
-static float data_get(float v1, float v2, gpr_state * state)
+float gpr_state_data_get(float v1, float v2, gpr_state * state)
 {
     float real = 0, imaginary = 0;
     if (state->data.fields == 0) return 0;
@@ -1352,17 +1378,17 @@ static float gpr_data_get(gpr_function * f,
                           gpr_state * state, int call_depth,
                           float (*custom_function)(float,float,float))
 {
-    return data_get(gpr_run_function((gpr_function*)f->argv[0],
-                                     state, call_depth,
-                                     (*custom_function)),
-                    gpr_run_function((gpr_function*)f->argv[1],
-                                     state, call_depth,
-                                     (*custom_function)),
-                    state);
+    return gpr_state_data_get(gpr_run_function((gpr_function*)f->argv[0],
+                                               state, call_depth,
+                                               (*custom_function)),
+                              gpr_run_function((gpr_function*)f->argv[1],
+                                               state, call_depth,
+                                               (*custom_function)),
+                              state);
 }
 
 /* returns a value from the data store in the given field */
-static float data_set(float v1, float v2, gpr_state * state)
+float gpr_state_data_set(float v1, float v2, gpr_state * state)
 {
     gpr_data_set_elem(&state->data,
                       (unsigned int)v1,
@@ -1382,13 +1408,13 @@ static float gpr_data_set(gpr_function * f,
                           gpr_state * state, int call_depth,
                           float (*custom_function)(float,float,float))
 {
-    return data_set(gpr_run_function((gpr_function*)f->argv[0], state,
-                                     call_depth,
-                                     (*custom_function)),
-                    gpr_run_function((gpr_function*)f->argv[0], state,
-                                     call_depth,
-                                     (*custom_function)),
-                    state);
+    return gpr_state_data_set(gpr_run_function((gpr_function*)f->argv[0],
+                                               state, call_depth,
+                                               (*custom_function)),
+                              gpr_run_function((gpr_function*)f->argv[0],
+                                               state, call_depth,
+                                               (*custom_function)),
+                              state);
 }
 
 static void gpr_fetch_c(FILE * fp, int argc)
@@ -1421,7 +1447,7 @@ static void gpr_fetch_c(FILE * fp, int argc)
 }
 
 /* retrieves a value from register, sensor or actuator */
-static float fetch(float v1, float v2, gpr_state * state)
+float gpr_state_fetch(float v1, float v2, gpr_state * state)
 {
     int oracle_type = (int)v1 % GPR_ORACLES;
     int index, v =  abs((int)v2);
@@ -1453,13 +1479,13 @@ static float gpr_get(gpr_function * f,
                      gpr_state * state, int call_depth,
                      float (*custom_function)(float,float,float))
 {
-    return fetch(gpr_run_function((gpr_function*)f->argv[0], state,
-                                  call_depth,
-                                  (*custom_function)),
-                 gpr_run_function((gpr_function*)f->argv[1], state,
-                                  call_depth,
-                                  (*custom_function)),
-                 state);
+    return gpr_state_fetch(gpr_run_function((gpr_function*)f->argv[0],
+                                            state, call_depth,
+                                            (*custom_function)),
+                           gpr_run_function((gpr_function*)f->argv[1],
+                                            state, call_depth,
+                                            (*custom_function)),
+                           state);
 }
 
 /* Used to check that the two functions are the same.
@@ -1503,18 +1529,80 @@ void gpr_functions_are_equal(gpr_function * f1, gpr_function * f2,
     }
 }
 
+/* returns a new node, from the arena selected on this thread
+   if there is one */
+gpr_function * gpr_node_alloc(void)
+{
+    gpr_function * f;
+    gpr_arena * arena = gpr_arena_selected();
+
+    if (arena != NULL) {
+        f = gpr_arena_alloc(arena);
+        f->arena = 1;
+    }
+    else {
+        f = (gpr_function*)malloc(sizeof(gpr_function));
+        f->arena = 0;
+    }
+    return f;
+}
+
+/* frees a node returned by gpr_node_alloc.  Nodes within an arena
+   are released along with the arena */
+void gpr_node_free(gpr_function * f)
+{
+    if (f->arena == 0) free(f);
+}
+
+/* Updates the number of nodes and the height of a node from those
+   of its arguments.  Functions which change a tree keep these up
+   to date, so that crossover can find nodes without walking the
+   whole tree */
+void gpr_annotate_node(gpr_function * f)
+{
+    int i, height = 0;
+
+    f->nodes = (f->function_type != GPR_FUNCTION_NONE);
+    for (i = 0; i < f->argc; i++) {
+        if (f->argv[i]!=0) {
+            f->nodes += f->argv[i]->nodes;
+            if (f->argv[i]->height >= height) {
+                height = f->argv[i]->height + 1;
+            }
+        }
+    }
+    if (height > GPR_MAX_HEIGHT) height = GPR_MAX_HEIGHT;
+    f->height = (unsigned char)height;
+}
+
+/* updates the number of nodes and the height throughout a tree,
+   which is needed if the tree has been assembled by hand */
+void gpr_annotate(gpr_function * f)
+{
+    int i;
+
+    for (i = 0; i < GPR_MAX_ARGUMENTS; i++) {
+        if (f->argv[i]!=0) {
+            gpr_annotate(f->argv[i]);
+        }
+    }
+    gpr_annotate_node(f);
+}
+
 /* deallocate memory */
 void gpr_free(gpr_function * f)
 {
     for (int i = 0; i < GPR_MAX_ARGUMENTS; i++) {
         if (f->argv[i]!=0) {
             gpr_free((gpr_function*)f->argv[i]);
-            free(f->argv[i]);
+            gpr_node_free(f->argv[i]);
             f->argv[i]=0;
         }
     }
     f->function_type = GPR_FUNCTION_NONE;
     f->value = 0;
+    f->nodes = 0;
+    f->height = 0;
 }
 
 
@@ -1711,14 +1799,18 @@ void gpr_init(gpr_function * f)
     f->function_type = GPR_FUNCTION_VALUE;
     f->value = 0;
     f->argc = GPR_DEFAULT_ARGUMENTS;
+    f->nodes = 1;
+    f->height = 1;
     for (i = 0; i < GPR_MAX_ARGUMENTS; i++) {
-        f->argv[i] = (gpr_function*)malloc(sizeof(gpr_function));
+        f->argv[i] = gpr_node_alloc();
 #ifdef DEBUG
         assert(f->argv[i]!=0);
 #endif
         f->argv[i]->function_type = GPR_FUNCTION_NONE;
         f->argv[i]->value=0;
         f->argv[i]->argc=GPR_DEFAULT_ARGUMENTS;
+        f->argv[i]->nodes=0;
+        f->argv[i]->height=0;
         for (j = 0; j < GPR_MAX_ARGUMENTS; j++) {
             f->argv[i]->argv[j]=0;
         }
@@ -1742,11 +1834,12 @@ void gpr_copy(gpr_function * source, gpr_function * dest)
         }
         else {
             if (dest->argv[i]!=0) {
-                free(dest->argv[i]);
+                gpr_node_free(dest->argv[i]);
                 dest->argv[i]=0;
             }
         }
     }
+    gpr_annotate_node(dest);
 }
 
 /* ensure that the program tree doesn't go below a maximum depth */
@@ -1756,6 +1849,12 @@ void gpr_prune(gpr_function * f, int depth, int max_depth,
 {
     int i = 0;
 
+    /* nothing below this node is deep enough to be pruned */
+    if ((f->height < GPR_MAX_HEIGHT) &&
+        (depth + f->height < max_depth-1)) {
+        return;
+    }
+
     if (depth >= max_depth-1) {
         if (is_terminal(f->function_type)==0) {
             /* remove any subtree */
@@ -1774,6 +1873,7 @@ void gpr_prune(gpr_function * f, int depth, int max_depth,
                       min_value, max_value, random_seed);
         }
     }
+    gpr_annotate_node(f);
 }
 
 /* validate the given tree */
@@ -2065,30 +2165,59 @@ void gpr_random(gpr_function * f, int depth,
                        instruction_set, no_of_instructions);
         }
     }
+    gpr_annotate_node(f);
 }
 
-/* returns the node with the given index number */
-static void get_node(gpr_function * f, int index, int * ctr,
-                     gpr_function ** node,
-                     int depth, int * returned_depth)
+/* returns the node with the given index number, in the order in
+   which gpr_nodes counts them, along with its depth.  The number of
+   nodes within each subtree is used to descend directly to it */
+static gpr_function * get_node(gpr_function * f, int index,
+                               int * returned_depth)
 {
-    int i=0;
+    int i;
 
-    if (f->function_type != GPR_FUNCTION_NONE) {
-        if (*ctr == index) {
-            *node = (gpr_function*)f;
-            *returned_depth = depth;
+    *returned_depth = 0;
+    while (f != 0) {
+        if (f->function_type != GPR_FUNCTION_NONE) {
+            if (index == 0) return f;
+            index--;
         }
 
-        *ctr = *ctr + 1;
+        for (i = 0; i < f->argc; i++) {
+            if (f->argv[i]!=0) {
+                if (index < f->argv[i]->nodes) break;
+                index -= f->argv[i]->nodes;
+            }
+        }
+        if (i == f->argc) return 0;
+
+        f = (gpr_function*)f->argv[i];
+        *returned_depth = *returned_depth + 1;
+    }
+    return 0;
+}
+
+/* updates the number of nodes and the height of each node above
+   the one with the given index number after its subtree changes */
+static void gpr_annotate_path(gpr_function * f, int index)
+{
+    int i;
+
+    if (f->function_type != GPR_FUNCTION_NONE) {
+        if (index == 0) return;
+        index--;
     }
 
     for (i = 0; i < f->argc; i++) {
         if (f->argv[i]!=0) {
-            get_node((gpr_function*)f->argv[i], index, ctr, node,
-                     depth+1, returned_depth);
+            if (index < f->argv[i]->nodes) {
+                gpr_annotate_path((gpr_function*)f->argv[i], index);
+                break;
+            }
+            index -= f->argv[i]->nodes;
         }
     }
+    gpr_annotate_node(f);
 }
 
 /* crossover the sensor sources and actuator destinations */
@@ -2197,13 +2326,13 @@ int gpr_crossover_ADF(gpr_function * parent1, gpr_function * parent2,
             second_parent->argv[second_parent_node_index];
 
         if ((first_parent_subtree==0) || (second_parent_subtree==0)) {
-            return 1;
+            break;
         }
 
         /* the subtree must be of non-zero size */
         if ((is_terminal(first_parent_subtree->function_type)!=0) ||
             (is_terminal(second_parent_subtree->function_type)!=0)) {
-            return 1;
+            break;
         }
 
         /* get the child subtree */
@@ -2218,6 +2347,7 @@ int gpr_crossover_ADF(gpr_function * parent1, gpr_function * parent2,
                       min_value, max_value,
                       random_seed);
     }
+    gpr_annotate_node(child);
     return 1;
 }
 
@@ -2233,7 +2363,7 @@ int gpr_crossover(gpr_function * parent1, gpr_function * parent2,
     int second_parent_nodes=0;
     int first_parent_crossover_node=0;
     int second_parent_crossover_node=0;
-    int ctr=0, depth, returned_depth_child, returned_depth_parent2;
+    int depth, returned_depth_child, returned_depth_parent2;
     gpr_function * child_node;
     gpr_function * second_parent_node;
 
@@ -2251,8 +2381,8 @@ int gpr_crossover(gpr_function * parent1, gpr_function * parent2,
     gpr_copy(first_parent,child);
 
     /* get the number of nodes */
-    gpr_nodes(first_parent, &first_parent_nodes);
-    gpr_nodes(second_parent, &second_parent_nodes);
+    first_parent_nodes = child->nodes;
+    second_parent_nodes = second_parent->nodes;
 
     if ((first_parent_nodes>1) && (second_parent_nodes>1)) {
         /* identify crossover points */
@@ -2262,19 +2392,12 @@ int gpr_crossover(gpr_function * parent1, gpr_function * parent2,
             1 + (rand_num(random_seed)%(second_parent_nodes-1));
 
         /* get nodes for the two points */
-        ctr = 0;
-        child_node = 0;
-        depth = 0;
-        returned_depth_child = 0;
-        get_node(child, first_parent_crossover_node, &ctr, &child_node,
-                 depth, &returned_depth_child);
-        ctr = 0;
-        second_parent_node = 0;
-        depth = 0;
-        returned_depth_parent2 = 0;
-        get_node(second_parent, second_parent_crossover_node,
-                 &ctr, &second_parent_node,
-                 depth, &returned_depth_parent2);
+        child_node =
+            get_node(child, first_parent_crossover_node,
+                     &returned_depth_child);
+        second_parent_node =
+            get_node(second_parent, second_parent_crossover_node,
+                     &returned_depth_parent2);
 
         if ((child_node!=0) && (second_parent_node!=0)) {
             if ((returned_depth_child < max_depth-3) &&
@@ -2288,6 +2411,7 @@ int gpr_crossover(gpr_function * parent1, gpr_function * parent2,
                 
                     /* copy the parent2 subtree */
                     gpr_copy(second_parent_node,child_node);
+                    gpr_annotate_path(child, first_parent_crossover_node);
 
                     /* ensure that the child tree
                        doesn't exceed the maximum depth */
@@ -2418,6 +2542,7 @@ static void gpr_remove_argument(gpr_function * f, int index)
         victim = f->argv[index];
         gpr_free(victim);
         victim->function_type = GPR_FUNCTION_VALUE;
+        gpr_annotate_node(victim);
 
         /* shuffle the arguments */
         for (i = index+1; i < f->argc; i++) {
@@ -2630,10 +2755,12 @@ void gpr_mutate(gpr_function * f, int depth, int max_depth, float prob,
                     break;
                 }
                 }
+                gpr_annotate_node(fn);
             }
         }
         i++;
     }
+    gpr_annotate_node(f);
 }
 
 /* two parents mate and produce a child */
@@ -2682,6 +2809,7 @@ void gpr_mate(gpr_function * parent1, gpr_function * parent2,
     }
     /* set the top level node function */
     child->function_type = GPR_TOP_LEVEL_FUNCTION;
+    gpr_annotate_node(child);
 
     /* enforce ADF structure */
     if (ADFs>0) gpr_enforce_ADFs(child, child_state);
@@ -2848,6 +2976,337 @@ float gpr_run(gpr_function * f, gpr_state * state,
     return 0;
 }
 
+/* returns non-zero if running the given function type can change
+   the state, in which case it is never removed by simplification */
+static int gpr_simplify_effects(int function_type)
+{
+    switch(function_type) {
+    case GPR_FUNCTION_NONE:
+    case GPR_FUNCTION_VALUE:
+    case GPR_FUNCTION_ARG:
+    case GPR_FUNCTION_GET:
+    case GPR_FUNCTION_DATA_GET:
+    case GPR_FUNCTION_DEFUN:
+    case GPR_FUNCTION_MAIN:
+    case GPR_FUNCTION_PROGRAM: {
+        return 0;
+    }
+    case GPR_FUNCTION_SET:
+    case GPR_FUNCTION_DATA_PUSH:
+    case GPR_FUNCTION_DATA_POP:
+    case GPR_FUNCTION_DATA_SET:
+    case GPR_FUNCTION_CUSTOM:
+    case GPR_FUNCTION_ADF: {
+        return 1;
+    }
+    }
+    /* arithmetic and logical functions only return a value,
+       whereas dynamic functions are left alone */
+    return (function_type >= GPR_FUNCTION_TYPES_ADVANCED);
+}
+
+/* returns non-zero if the given function type only depends upon
+   its arguments, so that it can be evaluated once all of its
+   arguments are constants */
+static int gpr_simplify_foldable(int function_type)
+{
+    if ((function_type < GPR_FUNCTION_ADD) ||
+        (function_type >= GPR_FUNCTION_TYPES_ADVANCED)) {
+        return 0;
+    }
+    return ((function_type < GPR_FUNCTION_DATA_PUSH) ||
+            (function_type > GPR_FUNCTION_GET));
+}
+
+/* returns non-zero if the given function never returns NaN,
+   because it replaces NaN with zero */
+static int gpr_simplify_never_nan(gpr_function * f)
+{
+    if (f == 0) return 1;
+
+    switch(f->function_type) {
+    case GPR_FUNCTION_VALUE: {
+        return (is_nan(f->value) == 0);
+    }
+    case GPR_FUNCTION_ARG:
+    case GPR_FUNCTION_GET:
+    case GPR_FUNCTION_DATA_PUSH:
+    case GPR_FUNCTION_DATA_POP:
+    case GPR_FUNCTION_DATA_GET:
+    case GPR_FUNCTION_DATA_SET:
+    case GPR_FUNCTION_SIGMOID:
+    case GPR_FUNCTION_MIN:
+    case GPR_FUNCTION_MAX:
+    case GPR_FUNCTION_CUSTOM:
+    case GPR_FUNCTION_ADF: {
+        return 0;
+    }
+    }
+    return 1;
+}
+
+/* returns non-zero if the given argument is a constant, which
+   is also the case for a missing argument since it returns zero */
+static int gpr_simplify_constant(gpr_function * f, float * value)
+{
+    *value = 0;
+    if (f == 0) return 1;
+    if (f->function_type == GPR_FUNCTION_NONE) return 1;
+    if (f->function_type == GPR_FUNCTION_VALUE) {
+        *value = f->value;
+        return 1;
+    }
+    return 0;
+}
+
+/* returns non-zero if the given trees are the same */
+static int gpr_simplify_equal(gpr_function * f1, gpr_function * f2)
+{
+    int i;
+
+    if ((f1 == 0) || (f2 == 0)) return (f1 == f2);
+    if ((f1->function_type != f2->function_type) ||
+        (f1->value != f2->value) ||
+        (f1->argc != f2->argc)) {
+        return 0;
+    }
+    if (is_terminal(f1->function_type) != 0) return 1;
+    for (i = 0; i < f1->argc; i++) {
+        if (gpr_simplify_equal(f1->argv[i], f2->argv[i]) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* turns a node into a constant */
+static void gpr_simplify_value(gpr_function * f, float value)
+{
+    gpr_free(f);
+    f->function_type = GPR_FUNCTION_VALUE;
+    f->value = value;
+    gpr_annotate_node(f);
+}
+
+/* removes an argument of a node */
+static void gpr_simplify_remove(gpr_function * f, int index)
+{
+    int i;
+
+    if (f->argv[index] != 0) {
+        gpr_free(f->argv[index]);
+        gpr_node_free(f->argv[index]);
+    }
+    for (i = index+1; i < GPR_MAX_ARGUMENTS; i++) {
+        f->argv[i-1] = f->argv[i];
+    }
+    f->argv[GPR_MAX_ARGUMENTS-1] = 0;
+    f->argc--;
+}
+
+/* replaces a node with one of its arguments */
+static void gpr_simplify_replace(gpr_function * f, int index)
+{
+    gpr_function * arg = f->argv[index];
+    unsigned char arena = f->arena;
+
+    f->argv[index] = 0;
+    gpr_free(f);
+    *f = *arg;
+    f->arena = arena;
+    gpr_node_free(arg);
+}
+
+/* removes constant arguments with the given value, starting from
+   the given argument and keeping at least one argument */
+static void gpr_simplify_remove_constants(gpr_function * f, int start,
+                                          float value)
+{
+    int i;
+    float v;
+
+    for (i = f->argc-1; (i >= start) && (f->argc > 1); i--) {
+        if ((gpr_simplify_constant(f->argv[i], &v) != 0) &&
+            (v == value)) {
+            gpr_simplify_remove(f, i);
+        }
+    }
+}
+
+/* Simplifies a node after its arguments have been simplified.
+   The value returned when the node is run stays the same, other
+   than possibly the sign of a zero result, and anything which
+   changes the state is kept in the same order.  Returns non-zero
+   if running the node does not change the state */
+static int gpr_simplify_node(gpr_function * f)
+{
+    int i, pure = 1, constants = 0, pure_args[GPR_MAX_ARGUMENTS];
+    float v, sum;
+
+    /* terminals and dynamic functions do not run their arguments */
+    if ((is_terminal(f->function_type) != 0) ||
+        ((f->function_type >= GPR_FUNCTION_TYPES_ADVANCED) &&
+         (f->function_type < GPR_FUNCTION_DEFUN))) {
+        return (gpr_simplify_effects(f->function_type) == 0);
+    }
+
+    for (i = 0; i < f->argc; i++) {
+        pure_args[i] = 1;
+        if (f->argv[i] != 0) {
+            pure_args[i] = gpr_simplify_node(f->argv[i]);
+        }
+        if (pure_args[i] == 0) pure = 0;
+        constants += gpr_simplify_constant(f->argv[i], &v);
+    }
+    if (gpr_simplify_effects(f->function_type) != 0) {
+        gpr_annotate_node(f);
+        return 0;
+    }
+
+    /* constant folding, using the same function as when run */
+    if ((constants == f->argc) &&
+        (gpr_simplify_foldable(f->function_type) != 0)) {
+        gpr_simplify_value(f, gpr_run_function(f, NULL, 0, NULL));
+        return 1;
+    }
+
+    switch(f->function_type) {
+    case GPR_FUNCTION_NOOP1:
+    case GPR_FUNCTION_NOOP2:
+    case GPR_FUNCTION_NOOP3:
+    case GPR_FUNCTION_NOOP4:
+    case GPR_FUNCTION_MAIN: {
+        /* only arguments which change the state are needed */
+        for (i = f->argc-1; i >= 0; i--) {
+            if ((pure_args[i] != 0) &&
+                ((f->argc > 1) ||
+                 (f->function_type != GPR_FUNCTION_MAIN))) {
+                gpr_simplify_remove(f, i);
+            }
+        }
+        if (f->argc == 0) {
+            gpr_simplify_value(f, 0);
+            return 1;
+        }
+        if ((pure != 0) && (f->argv[0] != 0)) {
+            gpr_simplify_value(f->argv[0], 0);
+        }
+        break;
+    }
+    case GPR_FUNCTION_NEGATE: {
+        gpr_simplify_remove_constants(f, 0, 0);
+        /* -(-(x)) is x */
+        if ((f->argc == 1) && (f->argv[0] != 0) &&
+            (f->argv[0]->function_type == GPR_FUNCTION_NEGATE)) {
+            gpr_simplify_replace(f, 0);
+            f->function_type = GPR_FUNCTION_ADD;
+        }
+        else {
+            break;
+        }
+        /* fall through */
+    }
+    case GPR_FUNCTION_ADD: {
+        gpr_simplify_remove_constants(f, 0, 0);
+        if ((f->argc == 1) && (f->argv[0] != 0) &&
+            (gpr_simplify_never_nan(f->argv[0]) != 0)) {
+            gpr_simplify_replace(f, 0);
+        }
+        break;
+    }
+    case GPR_FUNCTION_SUBTRACT: {
+        /* x - x is zero, or NaN which is returned as zero */
+        if ((pure != 0) && (f->argc == 2) &&
+            (gpr_simplify_equal(f->argv[0], f->argv[1]) != 0)) {
+            gpr_simplify_value(f, 0);
+            return 1;
+        }
+        gpr_simplify_remove_constants(f, 1, 0);
+        if ((f->argc == 1) && (f->argv[0] != 0) &&
+            (gpr_simplify_never_nan(f->argv[0]) != 0)) {
+            gpr_simplify_replace(f, 0);
+        }
+        break;
+    }
+    case GPR_FUNCTION_MULTIPLY: {
+        /* a product with zero is zero, or NaN which is
+           returned as zero */
+        if (pure != 0) {
+            for (i = 0; i < f->argc; i++) {
+                if ((gpr_simplify_constant(f->argv[i], &v) != 0) &&
+                    (v == 0)) {
+                    gpr_simplify_value(f, 0);
+                    return 1;
+                }
+            }
+        }
+        gpr_simplify_remove_constants(f, 0, 1);
+        if ((f->argc == 1) && (f->argv[0] != 0) &&
+            (gpr_simplify_never_nan(f->argv[0]) != 0)) {
+            gpr_simplify_replace(f, 0);
+        }
+        break;
+    }
+    case GPR_FUNCTION_DIVIDE:
+    case GPR_FUNCTION_MODULUS: {
+        if (pure == 0) break;
+        /* a constant divisor which fails the safe-guard,
+           or a zero numerator, gives zero */
+        constants = 0;
+        sum = 0;
+        for (i = f->argc/2; i < f->argc; i++) {
+            constants += gpr_simplify_constant(f->argv[i], &v);
+            sum += v;
+        }
+        if ((constants == f->argc - f->argc/2) &&
+            !(fabs(sum) > 0.01f)) {
+            gpr_simplify_value(f, 0);
+            return 1;
+        }
+        constants = 0;
+        sum = 0;
+        for (i = 0; i < f->argc/2; i++) {
+            constants += gpr_simplify_constant(f->argv[i], &v);
+            sum += v;
+        }
+        if ((constants == f->argc/2) && (sum == 0)) {
+            gpr_simplify_value(f, 0);
+            return 1;
+        }
+        break;
+    }
+    }
+
+    gpr_annotate_node(f);
+    return ((f->function_type == GPR_FUNCTION_VALUE) || (pure != 0));
+}
+
+/* Creates a simplified copy of a program for running or exporting,
+   with constant subtrees folded and redundant functions removed.
+   The copy is not intended to be evolved further.  As with gpr_copy
+   the destination should not be allocated, and if there are ADFs
+   then they should be pointed at the simplified tree within the
+   state before it is run */
+void gpr_simplify(gpr_function * f, gpr_function * simplified)
+{
+    int i;
+
+    gpr_copy(f, simplified);
+
+    /* the top level keeps its structure so that ADFs remain
+       in the same places */
+    if (simplified->function_type == GPR_TOP_LEVEL_FUNCTION) {
+        for (i = 0; i < simplified->argc; i++) {
+            if (simplified->argv[i] != 0) {
+                gpr_simplify_node(simplified->argv[i]);
+            }
+        }
+        gpr_annotate_node(simplified);
+        return;
+    }
+    gpr_simplify_node(simplified);
+}
+
 /* When the population is initialised make some random
    function calls within the main program */
 static void gpr_ADF_calls(gpr_function * f, float prob,
@@ -2872,6 +3331,9 @@ static void gpr_ADF_calls(gpr_function * f, float prob,
     }
 }
 
+/* Initialize the population.  The fitness cache is disabled.
+   If the fitness function is deterministic then it can be
+   enabled with gpr_cache_enable(population->cache, 1) */
 void gpr_init_population(gpr_population * population,
                          int size,
                          int registers,
@@ -2888,6 +3350,7 @@ void gpr_init_population(gpr_population * population,
     int i, j, depth;
     gpr_function * f;
     gpr_state * state;
+    gpr_arena * previous_arena;
 
     /* check that the instruction set is valid */
     if (gpr_validate_instruction_set(instruction_set,
@@ -2898,6 +3361,8 @@ void gpr_init_population(gpr_population * population,
 
     population->data_size = data_size;
     population->data_fields = data_fields;
+    gpr_cache_init(&population->fitness_cache, GPR_CACHE_SIZE);
+    population->cache = &population->fitness_cache;
 
     population->size = size;
     population->history.index = 0;
@@ -2914,6 +3379,12 @@ void gpr_init_population(gpr_population * population,
     /* fitness values */
     population->fitness = (float*)malloc(sizeof(float)*size);
 
+    /* trees of the first generation are within the first arena */
+    gpr_arena_init(&population->arena[0]);
+    gpr_arena_init(&population->arena[1]);
+    population->arena_index = 0;
+    previous_arena = gpr_arena_select(&population->arena[0]);
+
     /* initialise */
     for (i = 0; i < size; i++) {
         state = &population->state[i];
@@ -2948,7 +3419,8 @@ void gpr_init_population(gpr_population * population,
         /* fitness has not been evaluated */
         population->fitness[i] = 0;
     }
-
+    population->arena_nodes = population->arena[0].nodes;
+    gpr_arena_select(previous_arena);
 }
 
 /* initialise an environment with a population */
@@ -3078,6 +3550,12 @@ void gpr_init_system(gpr_system * system,
         /* clear the average fitness for the population */
         system->fitness[i] = 0;
     }
+
+    /* the islands share a single fitness cache */
+    for (i = 1; i < islands; i++) {
+        gpr_cache_free(&system->island[i].fitness_cache);
+        system->island[i].cache = &system->island[0].fitness_cache;
+    }
 }
 
 /* frees memory for a system */
@@ -3106,6 +3584,9 @@ void gpr_free_population(gpr_population * population)
     free(population->individual);
     free(population->state);
     free(population->fitness);
+    gpr_cache_free(&population->fitness_cache);
+    gpr_arena_free(&population->arena[0]);
+    gpr_arena_free(&population->arena[1]);
 }
 
 /* frees memory for an environment */
@@ -3142,6 +3623,47 @@ void gpr_clear_state(gpr_state * state)
     }
 }
 
+/* adds a tree to a phenotype hash */
+static unsigned long long gpr_tree_hash(gpr_function * f,
+                                        unsigned long long hash)
+{
+    int i, value[2];
+
+    value[0] = -1;
+    if (f != 0) {
+        value[0] = f->function_type;
+        value[1] = f->argc;
+    }
+    hash = gpr_cache_hash(hash, value, sizeof(int));
+    if (f == 0) return hash;
+
+    hash = gpr_cache_hash(hash, &value[1], sizeof(int));
+    hash = gpr_cache_hash(hash, &f->value, sizeof(float));
+    for (i = 0; i < f->argc; i++) {
+        hash = gpr_tree_hash((gpr_function*)f->argv[i], hash);
+    }
+    return hash;
+}
+
+/* Returns a hash of the given program and its sensor and
+   actuator redirections, for use with a fitness cache */
+unsigned long long gpr_phenotype_hash(gpr_function * f,
+                                      gpr_state * state)
+{
+    unsigned long long hash = gpr_tree_hash(f, 0);
+
+    if (state->no_of_sensor_sources > 0) {
+        hash = gpr_cache_hash(hash, state->sensor_source,
+                              state->no_of_sensors*sizeof(int));
+    }
+    if (state->no_of_actuator_destinations > 0) {
+        hash = gpr_cache_hash(hash, state->actuator_destination,
+                              state->no_of_actuators*sizeof(int));
+    }
+    if (hash == 0) hash = 1;
+    return hash;
+}
+
 /* Evaluates the fitness of all individuals in the population.
    Here we use openmp to speed up the process, since each
    evaluation is independent */
@@ -3155,14 +3677,30 @@ void gpr_evaluate(gpr_population * population,
     for (int i = 0; i < population->size; i++) {
         if ((population->fitness[i]==0) ||
             (reevaluate>0)) {
+            unsigned long long key = 0;
+            int length = 0;
+
             /* clear the retained state */
             gpr_clear_state(&population->state[i]);
 
-            /* run the evaluation function */
-            population->fitness[i] =
-                (*evaluate_program)(time_steps,
-                                    &population->individual[i],
-                                    &population->state[i], 0);
+            /* has the same program been evaluated previously? */
+            if (population->cache->enabled > 0) {
+                key = gpr_phenotype_hash(&population->individual[i],
+                                         &population->state[i]);
+                key = gpr_cache_hash(key, &time_steps, sizeof(int));
+                gpr_nodes(&population->individual[i], &length);
+            }
+            if ((reevaluate > 0) ||
+                (gpr_cache_get(population->cache, key, length,
+                               &population->fitness[i]) == 0)) {
+                /* run the evaluation function */
+                population->fitness[i] =
+                    (*evaluate_program)(time_steps,
+                                        &population->individual[i],
+                                        &population->state[i], 0);
+                gpr_cache_set(population->cache, key, length,
+                              population->fitness[i]);
+            }
         }
         /* population gets older */
         (&population->state[i])->age++;
@@ -3195,67 +3733,17 @@ void gpr_evaluate_system(gpr_system * system,
 /* sorts individuals in order of fitness */
 void gpr_sort(gpr_population * population)
 {
-    int i, j, best;
-    float max, temp_fitness;
-    gpr_function temp_individual;
-    gpr_state temp_state;
-
-    for (i = 0; i < population->size-1; i++) {
-        max = population->fitness[i];
-        best = i;
-        for (j = i+1; j < population->size; j++) {
-            if (population->fitness[j] > max) {
-                max = population->fitness[j];
-                best = j;
-            }
-        }
-        if (best != i) {
-            /* swap fitness */
-            temp_fitness = population->fitness[i];
-            population->fitness[i] = population->fitness[best];
-            population->fitness[best] = temp_fitness;
-
-            /* swap individual */
-            temp_individual = population->individual[i];
-            population->individual[i] = population->individual[best];
-            population->individual[best] = temp_individual;
-
-            /* swap state */
-            temp_state = population->state[i];
-            population->state[i] = population->state[best];
-            population->state[best] = temp_state;
-        }
-    }
+    gpr_sort_fitness(population->fitness, population->size,
+                     population->size,
+                     population->individual, sizeof(gpr_function),
+                     population->state, sizeof(gpr_state));
 }
 
 /* sorts populations in order of average fitness */
 void gpr_sort_system(gpr_system * system)
 {
-    int i, j, best;
-    float max, temp_fitness;
-    gpr_population temp_island;
-
-    for (i = 0; i < system->size-1; i++) {
-        max = system->fitness[i];
-        best = i;
-        for (j = i+1; j < system->size; j++) {
-            if (system->fitness[j] > max) {
-                max = system->fitness[j];
-                best = j;
-            }
-        }
-        if (best != i) {
-            /* swap fitness */
-            temp_fitness = system->fitness[i];
-            system->fitness[i] = system->fitness[best];
-            system->fitness[best] = temp_fitness;
-
-            /* swap island */
-            temp_island = system->island[i];
-            system->island[i] = system->island[best];
-            system->island[best] = temp_island;
-        }
-    }
+    gpr_sort_fitness(system->fitness, system->size, system->size,
+                     system->island, sizeof(gpr_population), 0, 0);
 }
 
 /* Returns a fitness histogram for the given population */
@@ -3483,6 +3971,25 @@ int gpr_mate_environment(gpr_environment * population,
     return child_index;
 }
 
+/* copies an individual into the arena selected on this thread,
+   so that any arena it was previously within can be released */
+static void gpr_relocate(gpr_function * f, gpr_state * state)
+{
+    int i;
+    gpr_function copy;
+
+    gpr_copy(f, &copy);
+    gpr_free(f);
+    *f = copy;
+
+    /* ADFs are subtrees of the individual */
+    for (i = 0; i < GPR_MAX_ARGUMENTS; i++) {
+        if (state->ADF[i] != 0) {
+            state->ADF[i] = f->argv[i];
+        }
+    }
+}
+
 /* Produce the next generation.
    This assumes that fitness has already been evaluated */
 void gpr_generation(gpr_population * population,
@@ -3495,11 +4002,23 @@ void gpr_generation(gpr_population * population,
                     int ADFs,
                     int * instruction_set, int no_of_instructions)
 {
-    int i, threshold;
+    int i, threshold, relocate;
     float diversity,mutation_prob_range;
+    gpr_arena * current_arena, * previous_arena;
+
+    /* range checking */
+    if ((elitism < 0.1f) || (elitism > 0.9f)) {
+        elitism = 0.3f;
+    }
+
+    /* index setting the threshold for the fittest individuals */
+    threshold = (int)((1.0f - elitism)*(population->size-1));
 
-    /* sort the population in order of fitness */
-    gpr_sort(population);
+    /* sort the population in order of fitness.  Only the fittest
+       individuals which survive need to be in order */
+    gpr_sort_fitness(population->fitness, population->size, threshold,
+                     population->individual, sizeof(gpr_function),
+                     population->state, sizeof(gpr_state));
 
     diversity = gpr_diversity(population);
     mutation_prob_range = (1.0f-mutation_prob)/2;
@@ -3533,13 +4052,19 @@ void gpr_generation(gpr_population * population,
         }
     }
 
-    /* range checking */
-    if ((elitism < 0.1f) || (elitism > 0.9f)) {
-        elitism = 0.3f;
+    /* Children are built within the current arena, which fills up
+       with the nodes of discarded trees.  Once it has grown enough
+       the next generation is built within the other arena instead */
+    current_arena = &population->arena[population->arena_index];
+    relocate = (current_arena->nodes >
+                GPR_ARENA_GROWTH*population->arena_nodes);
+    if (relocate != 0) {
+        previous_arena =
+            gpr_arena_select(&population->arena[1-population->arena_index]);
+    }
+    else {
+        previous_arena = gpr_arena_select(current_arena);
     }
-
-    /* index setting the threshold for the fittest individuals */
-    threshold = (int)((1.0f - elitism)*(population->size-1));
 
     /*#pragma omp parallel for*/
     for (i = 0; i < population->size - threshold; i++) {
@@ -3566,7 +4091,7 @@ void gpr_generation(gpr_population * population,
                  pure_mutant_prob,
                  integers_only,
                  ADFs,
-                 &population->state[i].random_seed,
+                 random_seed,
                  instruction_set, no_of_instructions,
                  &population->individual[threshold + i],
                  &population->state[threshold + i]);
@@ -3585,6 +4110,20 @@ void gpr_generation(gpr_population * population,
         /* fitness not yet evaluated */
         population->fitness[threshold + i] = 0;
     }
+
+    if (relocate != 0) {
+        /* move the survivors into the new arena, after which
+           nothing remains within the previous one */
+        for (i = 0; i < threshold; i++) {
+            gpr_relocate(&population->individual[i],
+                         &population->state[i]);
+        }
+        gpr_arena_clear(current_arena);
+        population->arena_index = 1 - population->arena_index;
+        population->arena_nodes =
+            population->arena[population->arena_index].nodes;
+    }
+    gpr_arena_select(previous_arena);
 }
 
 /* Produce the next generation for a system containing multiple
@@ -3608,6 +4147,7 @@ void gpr_generation_system(gpr_system * system,
     gpr_population * population1, * population2;
     gpr_function * f;
     gpr_state * state;
+    gpr_arena * previous_arena;
 
 #pragma omp parallel for
     for (i = 0; i < system->size; i++) {
@@ -3647,8 +4187,14 @@ void gpr_generation_system(gpr_system * system,
             /* copy it to the other island */
             gpr_free(&population2->individual[population2->size-1]);
 
+            /* within the arena of the island which it moves to */
+            previous_arena =
+                gpr_arena_select(&population2->arena
+                                 [population2->arena_index]);
             gpr_copy(&population1->individual[migrant_index],
                      &population2->individual[population2->size-1]);
+            gpr_arena_select(&population1->arena
+                             [population1->arena_index]);
 
             population2->fitness[population2->size-1] =
                 population1->fitness[migrant_index];
@@ -3679,6 +4225,7 @@ void gpr_generation_system(gpr_system * system,
                 memset((void*)state->ADF,'\0',
                        sizeof(gpr_function*)*GPR_MAX_ARGUMENTS);
             }
+            gpr_arena_select(previous_arena);
         }
     }
 }
@@ -4564,8 +5111,7 @@ int gpr_load(gpr_function *f, FILE * fp)
                         fn[no_of_nodes] = f;
                     }
                     else {
-                        fn[no_of_nodes] =
-                            (gpr_function*)malloc(sizeof(gpr_function));
+                        fn[no_of_nodes] = gpr_node_alloc();
                     }
 #ifdef DEBUG
                     assert(fn[no_of_nodes] != 0);
@@ -4726,6 +5272,7 @@ int gpr_load(gpr_function *f, FILE * fp)
             }
         }
     }
+    if (result == GPR_LOAD_OK) gpr_annotate(f);
     return result;
 }
 
@@ -5373,6 +5920,7 @@ void gpr_arduino(gpr_function * f,
                  int ADFs, FILE * fp)
 {
     int i;
+    gpr_function simplified;
 
     /* check that the number of inputs matches the number of sensors */
     if (no_of_digital_inputs+no_of_analog_inputs!=
@@ -5393,6 +5941,10 @@ void gpr_arduino(gpr_function * f,
         return;
     }
 
+    /* export a simplified version of the program */
+    gpr_simplify(f, &simplified);
+    f = &simplified;
+
     /* comment header */
     fprintf(fp,"%s","// Genetic Program\n");
     fprintf(fp,"%s","// Evolved using libgpr\n");
@@ -5614,6 +6166,8 @@ void gpr_arduino(gpr_function * f,
                       no_of_analog_outputs,                           
                       baud_rate);
     gpr_arduino_main(f, fp, ADFs);
+
+    gpr_free(&simplified);
 }
 
 /* export the given individual as a C program */
@@ -5623,6 +6177,11 @@ void gpr_c_program(gpr_function * f,
                    int ADFs, FILE * fp)
 {
     int i;
+    gpr_function simplified;
+
+    /* export a simplified version of the program */
+    gpr_simplify(f, &simplified);
+    f = &simplified;
 
     /* comment header */
     fprintf(fp,"%s","/* Genetic Program\n");
@@ -5782,6 +6341,8 @@ void gpr_c_program(gpr_function * f,
     gpr_c_setup(fp);
     gpr_c_stdin_args(fp);
     gpr_c_main(f, fp, ADFs);
+
+    gpr_free(&simplified);
 }
 
 /* uses gnuplot to plot the fitness history for the given population */
@@ -45,6 +45,9 @@
 #include <zlib.h>
 #include "pnglite.h"
 #include "gpr_data.h"
+#include "gpr_cache.h"
+#include "gpr_arena.h"
+#include "gpr_rank.h"
 
 /* types of function */
 enum {
@@ -141,10 +144,16 @@ enum {
 struct gpr_func {
     /* the type of function */
     unsigned short function_type;
+    /* non-zero if the node belongs to an arena rather than the heap */
+    unsigned char arena;
+    /* the number of levels below this node, up to GPR_MAX_HEIGHT */
+    unsigned char height;
     /* if this is a terminal then this is the value */
     float value;
     /* the number of function arguments */
     int argc;
+    /* the number of nodes within this subtree, as counted by gpr_nodes */
+    int nodes;
     /* sub-functions */
     struct gpr_func * argv[GPR_MAX_ARGUMENTS];
 };
@@ -218,6 +227,16 @@ struct gpr_pop {
     float * fitness;
     /* data store parameters */
     int data_size, data_fields;
+    /* fitness values of previously evaluated phenotypes, which
+       may be shared with the other islands of a system */
+    gpr_cache fitness_cache;
+    gpr_cache * cache;
+    /* tree nodes of the current and next generations */
+    gpr_arena arena[2];
+    /* the arena containing the current generation */
+    int arena_index;
+    /* the number of nodes in use after the last move between arenas */
+    int arena_nodes;
     /* the fitness history for the population */
     struct gpr_hist history;
 };
@@ -263,6 +282,7 @@ float gpr_mutate_value(float value,
                        unsigned int * random_seed);
 int is_nan(float v);
 int rand_num(unsigned int * seed);
+unsigned int rand_stream(unsigned int seed, unsigned int stream);
 void gpr_validate(gpr_function * f, int depth,
                   int min_depth, int max_depth,
                   int ADFs,
@@ -274,8 +294,19 @@ void gpr_prune(gpr_function * f, int depth, int max_depth,
                unsigned int * random_seed);
 float gpr_run(gpr_function * f, gpr_state * state,
               float (*custom_function)(float,float,float));
+float gpr_state_store(float v1, float v2, gpr_state * state);
+float gpr_state_push(float v1, float v2, gpr_state * state);
+float gpr_state_pop(float v1, gpr_state * state);
+float gpr_state_data_get(float v1, float v2, gpr_state * state);
+float gpr_state_data_set(float v1, float v2, gpr_state * state);
+float gpr_state_fetch(float v1, float v2, gpr_state * state);
 void gpr_nodes(gpr_function * f, int * ctr);
 void gpr_init(gpr_function * f);
+gpr_function * gpr_node_alloc(void);
+void gpr_node_free(gpr_function * f);
+void gpr_annotate_node(gpr_function * f);
+void gpr_annotate(gpr_function * f);
+void gpr_simplify(gpr_function * f, gpr_function * simplified);
 void gpr_init_state(gpr_state * state,
                     int registers,
                     int sensors,
@@ -361,6 +392,8 @@ void gpr_mate(gpr_function * parent1, gpr_function * parent2,
               int * instruction_set, int no_of_instructions,
               gpr_function * child,
               gpr_state * child_state);
+unsigned long long gpr_phenotype_hash(gpr_function * f,
+                                      gpr_state * state);
 void gpr_evaluate(gpr_population * population,
                   int time_steps, int reevaluate,
                   float (*evaluate_program)(int,gpr_function*,gpr_state*,int));
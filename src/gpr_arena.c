@@ -0,0 +1,141 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Arenas for tree nodes.
+
+   Tree nodes are normally allocated one at a time from the heap,
+   and freed one at a time as trees are mutated, crossed over and
+   replaced.  An arena instead hands out nodes from large blocks
+   and never frees an individual node.  All of its nodes are
+   released together by passing its blocks to the list of spares,
+   which are used again rather than being returned to the heap.
+
+   Nodes are taken from the arena which has been selected on the
+   current thread, or from the heap if there is none.  Each
+   population has two arenas.  New generations are built within
+   the current one until it has grown to several times the size
+   of the population's trees, after which the next generation
+   is built within the other arena and the survivors are moved
+   there, so that the current one can then be released at once.
+   Since islands of a system each have their own arenas, threads
+   running different islands do not contend for the heap */
+
+#include "gpr_arena.h"
+#include "gpr.h"
+
+/* the arena which new nodes are taken from on this thread */
+static gpr_arena * gpr_arena_current = NULL;
+#pragma omp threadprivate(gpr_arena_current)
+
+/* returns the first node within a block */
+#define GPR_ARENA_NODES(b) ((gpr_function*)((b) + 1))
+
+/* creates an empty arena */
+void gpr_arena_init(gpr_arena * arena)
+{
+    arena->block = NULL;
+    arena->last = NULL;
+    arena->spare = NULL;
+    arena->nodes = 0;
+}
+
+/* frees the blocks of a list */
+static void gpr_arena_free_blocks(gpr_arena_block * block)
+{
+    gpr_arena_block * next;
+
+    while (block != NULL) {
+        next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+/* frees all memory for an arena.  Any nodes within it
+   must no longer be used */
+void gpr_arena_free(gpr_arena * arena)
+{
+    gpr_arena_free_blocks(arena->block);
+    gpr_arena_free_blocks(arena->spare);
+    gpr_arena_init(arena);
+}
+
+/* releases all nodes within the arena, keeping the blocks
+   so that they may be used again */
+void gpr_arena_clear(gpr_arena * arena)
+{
+    if (arena->block == NULL) return;
+
+    arena->last->next = arena->spare;
+    arena->spare = arena->block;
+    arena->block = NULL;
+    arena->last = NULL;
+    arena->nodes = 0;
+}
+
+/* returns a new node */
+struct gpr_func * gpr_arena_alloc(gpr_arena * arena)
+{
+    gpr_arena_block * block = arena->block;
+
+    if ((block == NULL) || (block->used >= GPR_ARENA_BLOCK_NODES)) {
+        if (arena->spare != NULL) {
+            block = arena->spare;
+            arena->spare = block->next;
+        }
+        else {
+            block = (gpr_arena_block*)
+                malloc(sizeof(gpr_arena_block) +
+                       GPR_ARENA_BLOCK_NODES*sizeof(gpr_function));
+        }
+        block->used = 0;
+        block->next = arena->block;
+        if (arena->block == NULL) arena->last = block;
+        arena->block = block;
+    }
+    arena->nodes++;
+    return &GPR_ARENA_NODES(block)[block->used++];
+}
+
+/* selects the arena which new nodes on this thread are taken
+   from, or the heap if NULL, returning the previous selection */
+gpr_arena * gpr_arena_select(gpr_arena * arena)
+{
+    gpr_arena * previous = gpr_arena_current;
+
+    gpr_arena_current = arena;
+    return previous;
+}
+
+/* returns the arena which new nodes on this thread are
+   taken from, or NULL */
+gpr_arena * gpr_arena_selected(void)
+{
+    return gpr_arena_current;
+}
@@ -0,0 +1,75 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPR_ARENA_H
+#define GPR_ARENA_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <omp.h>
+
+/* the number of tree nodes within each block of an arena */
+#define GPR_ARENA_BLOCK_NODES 1024
+
+/* the number of times by which the nodes of a population's arena
+   may grow before its trees are moved to the other arena */
+#define GPR_ARENA_GROWTH 4
+
+struct gpr_func;
+
+/* a block of tree nodes */
+struct gpr_arena_blk {
+    struct gpr_arena_blk * next;
+    /* the number of nodes which have been handed out */
+    int used;
+};
+typedef struct gpr_arena_blk gpr_arena_block;
+
+/* tree nodes which are all released together */
+struct gpr_ar {
+    /* blocks in use, the most recent first */
+    gpr_arena_block * block;
+    /* the oldest block in use */
+    gpr_arena_block * last;
+    /* released blocks which may be used again */
+    gpr_arena_block * spare;
+    /* the number of nodes handed out */
+    int nodes;
+};
+typedef struct gpr_ar gpr_arena;
+
+void gpr_arena_init(gpr_arena * arena);
+void gpr_arena_free(gpr_arena * arena);
+void gpr_arena_clear(gpr_arena * arena);
+struct gpr_func * gpr_arena_alloc(gpr_arena * arena);
+gpr_arena * gpr_arena_select(gpr_arena * arena);
+gpr_arena * gpr_arena_selected(void);
+
+#endif
@@ -0,0 +1,146 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "gpr_cache.h"
+
+/* FNV-1a parameters */
+#define GPR_CACHE_HASH_INITIAL  14695981039346656037ULL
+#define GPR_CACHE_HASH_PRIME    1099511628211ULL
+
+/* Create a fitness cache with the given number of entries.
+   The cache is initially disabled, since it is only valid if the
+   fitness function is deterministic */
+void gpr_cache_init(gpr_cache * cache, int size)
+{
+    cache->size = size;
+    cache->enabled = 0;
+    cache->key = NULL;
+    cache->length = NULL;
+    cache->fitness = NULL;
+    if (size > 0) {
+        cache->key =
+            (unsigned long long*)malloc(size*sizeof(unsigned long long));
+        cache->length = (int*)malloc(size*sizeof(int));
+        cache->fitness = (float*)malloc(size*sizeof(float));
+    }
+    gpr_cache_clear(cache);
+}
+
+/* deallocate a fitness cache */
+void gpr_cache_free(gpr_cache * cache)
+{
+    if (cache->size > 0) {
+        free(cache->key);
+        free(cache->length);
+        free(cache->fitness);
+    }
+    cache->size = 0;
+}
+
+/* remove all entries and reset the counters */
+void gpr_cache_clear(gpr_cache * cache)
+{
+    if (cache->size > 0) {
+        memset((void*)cache->key, '\0',
+               cache->size*sizeof(unsigned long long));
+    }
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+/* Enables or disables the cache.  This should be disabled if the
+   fitness function isn't deterministic.  Entries are only matched
+   by phenotype, so the cache should also be cleared whenever the
+   data used by the fitness function changes */
+void gpr_cache_enable(gpr_cache * cache, int enabled)
+{
+    cache->enabled = enabled;
+}
+
+/* Adds the given data to a hash.  Use a hash of zero to begin */
+unsigned long long gpr_cache_hash(unsigned long long hash,
+                                  void * data, int length)
+{
+    int i;
+    unsigned char * bytes = (unsigned char*)data;
+
+    if (hash == 0) hash = GPR_CACHE_HASH_INITIAL;
+    for (i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= GPR_CACHE_HASH_PRIME;
+    }
+    return hash;
+}
+
+/* Looks up the fitness for the given phenotype hash and length.
+   The length guards against two phenotypes with the same hash.
+   Returns non-zero if the fitness was found */
+int gpr_cache_get(gpr_cache * cache, unsigned long long key,
+                  int length, float * fitness)
+{
+    int found = 0, index;
+
+    if ((cache->enabled <= 0) || (cache->size <= 0) || (key == 0)) {
+        return 0;
+    }
+
+    index = (int)(key % (unsigned long long)cache->size);
+#pragma omp critical (gpr_cache)
+    {
+        if ((cache->key[index] == key) &&
+            (cache->length[index] == length)) {
+            *fitness = cache->fitness[index];
+            found = 1;
+            cache->hits++;
+        }
+        else {
+            cache->misses++;
+        }
+    }
+    return found;
+}
+
+/* stores the fitness for the given phenotype hash and length */
+void gpr_cache_set(gpr_cache * cache, unsigned long long key,
+                   int length, float fitness)
+{
+    int index;
+
+    if ((cache->enabled <= 0) || (cache->size <= 0) || (key == 0)) {
+        return;
+    }
+
+    index = (int)(key % (unsigned long long)cache->size);
+#pragma omp critical (gpr_cache)
+    {
+        cache->key[index] = key;
+        cache->length[index] = length;
+        cache->fitness[index] = fitness;
+    }
+}
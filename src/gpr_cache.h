@@ -0,0 +1,76 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPR_CACHE_H
+#define GPR_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* default number of entries in a fitness cache */
+#define GPR_CACHE_SIZE  16384
+
+/* A bounded table of fitness values, indexed by a hash of the
+   phenotype of each individual.  Entries are overwritten when
+   another phenotype maps to the same slot.
+   A hit requires the same 64 bit hash and the same phenotype
+   length, so two different programs could still share a fitness
+   value if both collide, although this is very unlikely.
+   The key doesn't include the data set or anything else which
+   the fitness function depends upon, so if that changes the cache
+   should be cleared with gpr_cache_clear */
+struct gpr_cache_struct {
+    /* the number of entries */
+    int size;
+    /* whether the cache is used, which is off by default */
+    int enabled;
+    /* phenotype hash for each entry, or zero if empty */
+    unsigned long long * key;
+    /* phenotype length for each entry, checked on a hit */
+    int * length;
+    /* fitness for each entry */
+    float * fitness;
+    /* the number of lookups which were found or not found */
+    unsigned int hits, misses;
+};
+typedef struct gpr_cache_struct gpr_cache;
+
+void gpr_cache_init(gpr_cache * cache, int size);
+void gpr_cache_free(gpr_cache * cache);
+void gpr_cache_clear(gpr_cache * cache);
+void gpr_cache_enable(gpr_cache * cache, int enabled);
+unsigned long long gpr_cache_hash(unsigned long long hash,
+                                  void * data, int length);
+int gpr_cache_get(gpr_cache * cache, unsigned long long key,
+                  int length, float * fitness);
+void gpr_cache_set(gpr_cache * cache, unsigned long long key,
+                   int length, float fitness);
+
+#endif
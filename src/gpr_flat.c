@@ -0,0 +1,236 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Flat trees.
+
+   Each gpr_function node is allocated separately, so copying or
+   traversing a tree means following pointers around the heap.
+   Here the same tree is held as one array of nodes in prefix
+   order, with each node followed by the subtrees of its arguments
+   and annotated with the size of its own subtree, so that the
+   arguments of a node can be found by skipping over subtrees.
+   Only the arguments within argc are stored, as with gpr_copy,
+   and missing arguments are marked rather than stored.
+   Copying a tree is then a single memcpy and traversals
+   run through memory in order */
+
+#include "gpr_flat.h"
+
+/* returns non-zero if the given argument of a node is missing */
+#define GPR_FLAT_MISSING(n,i) (((n)->missing >> (i)) & 1)
+
+/* creates an empty tree */
+void gpr_flat_init(gpr_flat * t)
+{
+    t->length = 0;
+    t->max_length = 0;
+    t->node = NULL;
+}
+
+/* frees memory for a tree */
+void gpr_flat_free(gpr_flat * t)
+{
+    if (t->node != NULL) free(t->node);
+    gpr_flat_init(t);
+}
+
+/* ensures that there is space for the given number of nodes.
+   Any existing nodes are not kept */
+static void gpr_flat_reserve(gpr_flat * t, int length)
+{
+    if (t->max_length >= length) return;
+
+    if (t->node != NULL) free(t->node);
+    t->node = (gpr_flat_node*)malloc(length*sizeof(gpr_flat_node));
+    t->max_length = length;
+}
+
+/* returns the number of nodes needed to store a tree */
+static int gpr_flat_count(gpr_function * f)
+{
+    int i, length = 1;
+
+    for (i = 0; i < f->argc; i++) {
+        if (f->argv[i] != 0) {
+            length += gpr_flat_count((gpr_function*)f->argv[i]);
+        }
+    }
+    return length;
+}
+
+/* stores a tree beginning at the given index, and returns
+   the index following it */
+static int gpr_flat_store(gpr_function * f, gpr_flat * t, int index)
+{
+    int i, next = index + 1;
+    gpr_flat_node * n = &t->node[index];
+
+    n->function_type = f->function_type;
+    n->argc = (unsigned char)f->argc;
+    n->missing = 0;
+    n->value = f->value;
+
+    for (i = 0; i < f->argc; i++) {
+        if (f->argv[i] == 0) {
+            n->missing |= (unsigned char)(1 << i);
+        }
+        else {
+            next = gpr_flat_store((gpr_function*)f->argv[i], t, next);
+        }
+    }
+    n->size = next - index;
+    return next;
+}
+
+/* converts a tree into flat form and returns the number of nodes */
+int gpr_flat_encode(gpr_function * f, gpr_flat * t)
+{
+    int length = gpr_flat_count(f);
+
+    gpr_flat_reserve(t, length);
+    t->length = gpr_flat_store(f, t, 0);
+    return t->length;
+}
+
+/* loads the subtree beginning at the given index, and returns
+   the index following it */
+static int gpr_flat_load(gpr_flat * t, int index, gpr_function * f)
+{
+    int i, next = index + 1;
+    gpr_flat_node * n = &t->node[index];
+
+    gpr_init(f);
+
+    f->function_type = n->function_type;
+    f->value = n->value;
+    f->argc = n->argc;
+
+    for (i = 0; i < n->argc; i++) {
+        if (GPR_FLAT_MISSING(n, i)) {
+            gpr_node_free(f->argv[i]);
+            f->argv[i] = 0;
+        }
+        else {
+            next = gpr_flat_load(t, next, (gpr_function*)f->argv[i]);
+        }
+    }
+    gpr_annotate_node(f);
+    return next;
+}
+
+/* Converts a flat tree back into a tree of functions, which is
+   the same as the result of gpr_copy on the original tree.
+   As with gpr_copy the destination should not be allocated */
+void gpr_flat_decode(gpr_flat * t, gpr_function * f)
+{
+    if (t->length == 0) {
+        gpr_init(f);
+        f->function_type = GPR_FUNCTION_NONE;
+        gpr_annotate_node(f);
+        return;
+    }
+    gpr_flat_load(t, 0, f);
+}
+
+/* copies one flat tree to another */
+void gpr_flat_copy(gpr_flat * source, gpr_flat * dest)
+{
+    gpr_flat_reserve(dest, source->length);
+    memcpy((void*)dest->node, (void*)source->node,
+           source->length*sizeof(gpr_flat_node));
+    dest->length = source->length;
+}
+
+/* returns the index of the given argument of a node,
+   or -1 if the argument is missing */
+int gpr_flat_child(gpr_flat * t, int index, int argument)
+{
+    int i, child = index + 1;
+    gpr_flat_node * n = &t->node[index];
+
+    if ((argument < 0) || (argument >= n->argc) ||
+        GPR_FLAT_MISSING(n, argument)) {
+        return -1;
+    }
+
+    /* skip over the subtrees of the earlier arguments */
+    for (i = 0; i < argument; i++) {
+        if (!GPR_FLAT_MISSING(n, i)) child += t->node[child].size;
+    }
+    return child;
+}
+
+/* returns the number of nodes in the tree, in the
+   same way as gpr_nodes */
+int gpr_flat_nodes(gpr_flat * t)
+{
+    int i, ctr = 0;
+
+    for (i = 0; i < t->length; i++) {
+        if (t->node[i].function_type != GPR_FUNCTION_NONE) ctr++;
+    }
+    return ctr;
+}
+
+/* returns the maximum depth of the tree, in the
+   same way as gpr_max_depth */
+int gpr_flat_max_depth(gpr_flat * t)
+{
+    int i, j, n, top = 0, max_depth = 0;
+    int * remaining;
+
+    if (t->length == 0) return 0;
+
+    /* the number of arguments still to be visited
+       for each node above the current one */
+    remaining = (int*)malloc(t->length*sizeof(int));
+
+    for (i = 0; i < t->length; i++) {
+        if (top > max_depth) max_depth = top;
+
+        n = 0;
+        for (j = 0; j < t->node[i].argc; j++) {
+            if (!GPR_FLAT_MISSING(&t->node[i], j)) n++;
+        }
+        if (n > 0) {
+            remaining[top++] = n;
+            continue;
+        }
+
+        /* return to the next unvisited argument */
+        while (top > 0) {
+            remaining[top-1]--;
+            if (remaining[top-1] > 0) break;
+            top--;
+        }
+    }
+
+    free(remaining);
+    return max_depth;
+}
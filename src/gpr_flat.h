@@ -0,0 +1,74 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPR_FLAT_H
+#define GPR_FLAT_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#include "gpr.h"
+
+/* a node of a tree stored in prefix order */
+struct gpr_flat_nd {
+    /* the type of function */
+    unsigned short function_type;
+    /* the number of function arguments */
+    unsigned char argc;
+    /* a bit is set for each argument which is missing */
+    unsigned char missing;
+    /* the number of nodes within the subtree beginning here */
+    int size;
+    /* if this is a terminal then this is the value */
+    float value;
+};
+typedef struct gpr_flat_nd gpr_flat_node;
+
+/* a tree stored as a single array of nodes, with each node
+   followed by the subtrees of its arguments */
+struct gpr_flat_tree {
+    /* the number of nodes */
+    int length;
+    /* the number of nodes allocated */
+    int max_length;
+    gpr_flat_node * node;
+};
+typedef struct gpr_flat_tree gpr_flat;
+
+void gpr_flat_init(gpr_flat * t);
+void gpr_flat_free(gpr_flat * t);
+int gpr_flat_encode(gpr_function * f, gpr_flat * t);
+void gpr_flat_decode(gpr_flat * t, gpr_function * f);
+void gpr_flat_copy(gpr_flat * source, gpr_flat * dest);
+int gpr_flat_child(gpr_flat * t, int index, int argument);
+int gpr_flat_nodes(gpr_flat * t);
+int gpr_flat_max_depth(gpr_flat * t);
+
+#endif
@@ -0,0 +1,210 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Ranking of individuals by fitness.
+
+   Rather than exchanging individuals while searching for the next
+   fittest, the fitness values are first ranked as a list of
+   indexes, so that each individual only needs to be moved once.
+   When only the fittest k individuals matter they are separated
+   from the rest by partitioning, and only those are fully sorted.
+
+   Fitness values are ordered from highest to lowest, with NaN
+   below any number.  Equal values keep their original order, so
+   that the result doesn't depend upon how the sort proceeds. */
+
+#include "gpr_rank.h"
+
+/* a fitness value together with its original index */
+struct gpr_rank_ent {
+    float fitness;
+    int index;
+};
+typedef struct gpr_rank_ent gpr_rank_entry;
+
+/* returns non-zero if entry a ranks before entry b */
+static int gpr_rank_before(gpr_rank_entry * a, gpr_rank_entry * b)
+{
+    if (a->fitness > b->fitness) return 1;
+    if (a->fitness < b->fitness) return 0;
+    if (isnan(a->fitness) != isnan(b->fitness)) {
+        return isnan(b->fitness);
+    }
+    return a->index < b->index;
+}
+
+static int gpr_rank_compare(const void * a, const void * b)
+{
+    gpr_rank_entry * entry_a = (gpr_rank_entry*)a;
+    gpr_rank_entry * entry_b = (gpr_rank_entry*)b;
+
+    if (gpr_rank_before(entry_a, entry_b)) return -1;
+    if (gpr_rank_before(entry_b, entry_a)) return 1;
+    return 0;
+}
+
+static void gpr_rank_swap(gpr_rank_entry * a, gpr_rank_entry * b)
+{
+    gpr_rank_entry temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+/* partitions the entries so that the first k rank before the rest */
+static void gpr_rank_select(gpr_rank_entry * entry, int size, int k)
+{
+    int left = 0, right = size-1, mid, i, store;
+
+    while (right > left) {
+        /* median of three as the pivot, moved to the right */
+        mid = left + (right-left)/2;
+        if (gpr_rank_before(&entry[mid], &entry[left])) {
+            gpr_rank_swap(&entry[mid], &entry[left]);
+        }
+        if (gpr_rank_before(&entry[right], &entry[left])) {
+            gpr_rank_swap(&entry[right], &entry[left]);
+        }
+        if (gpr_rank_before(&entry[mid], &entry[right])) {
+            gpr_rank_swap(&entry[mid], &entry[right]);
+        }
+
+        store = left;
+        for (i = left; i < right; i++) {
+            if (gpr_rank_before(&entry[i], &entry[right])) {
+                gpr_rank_swap(&entry[i], &entry[store]);
+                store++;
+            }
+        }
+        gpr_rank_swap(&entry[store], &entry[right]);
+
+        if (store == k) return;
+        if (store < k) {
+            left = store+1;
+        }
+        else {
+            right = store-1;
+        }
+    }
+}
+
+/* Returns the indexes of the fitness values from highest to lowest.
+   If k is less than the size then only the first k ranks are
+   sorted, and the remainder are in no particular order */
+void gpr_rank(float * fitness, int size, int k, int * rank)
+{
+    int i;
+    gpr_rank_entry * entry;
+
+    if (size <= 0) return;
+    if ((k <= 0) || (k > size)) k = size;
+
+    entry = (gpr_rank_entry*)malloc(size*sizeof(gpr_rank_entry));
+#ifdef DEBUG
+    assert(entry != 0);
+#endif
+
+    for (i = 0; i < size; i++) {
+        entry[i].fitness = fitness[i];
+        entry[i].index = i;
+    }
+
+    if (k < size) {
+        gpr_rank_select(entry, size, k);
+    }
+    qsort(entry, k, sizeof(gpr_rank_entry), gpr_rank_compare);
+
+    for (i = 0; i < size; i++) {
+        rank[i] = entry[i].index;
+    }
+    free(entry);
+}
+
+/* Rearranges the items so that item i becomes the one which was
+   previously at index rank[i].  Each item is moved once by
+   following the cycles of the permutation */
+void gpr_permute(void * items, int item_size, int * rank, int size)
+{
+    int i, j, next;
+    unsigned char * item = (unsigned char*)items;
+    unsigned char * temp;
+
+    if ((items == 0) || (size <= 1)) return;
+
+    temp = (unsigned char*)malloc(item_size);
+#ifdef DEBUG
+    assert(temp != 0);
+#endif
+
+    for (i = 0; i < size; i++) {
+        if ((rank[i] < 0) || (rank[i] == i)) continue;
+
+        memcpy(temp, &item[i*item_size], item_size);
+        j = i;
+        while (rank[j] != i) {
+            next = rank[j];
+            memcpy(&item[j*item_size], &item[next*item_size],
+                   item_size);
+            /* mark as visited */
+            rank[j] = -1 - next;
+            j = next;
+        }
+        memcpy(&item[j*item_size], temp, item_size);
+        rank[j] = -1 - i;
+    }
+
+    /* restore the ranks */
+    for (i = 0; i < size; i++) {
+        if (rank[i] < 0) rank[i] = -1 - rank[i];
+    }
+    free(temp);
+}
+
+/* Sorts fitness values from highest to lowest, together with one
+   or two arrays of items belonging to them.  If k is less than the
+   size then only the fittest k are sorted */
+void gpr_sort_fitness(float * fitness, int size, int k,
+                      void * items, int item_size,
+                      void * items2, int item_size2)
+{
+    int * rank;
+
+    if (size <= 1) return;
+
+    rank = (int*)malloc(size*sizeof(int));
+#ifdef DEBUG
+    assert(rank != 0);
+#endif
+
+    gpr_rank(fitness, size, k, rank);
+    gpr_permute(fitness, sizeof(float), rank, size);
+    gpr_permute(items, item_size, rank, size);
+    gpr_permute(items2, item_size2, rank, size);
+
+    free(rank);
+}
@@ -0,0 +1,803 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Stack machine for tree programs.
+
+   gpr_run walks the tree recursively, calling a helper for each
+   node which in turn calls gpr_run_function for each of its
+   arguments.  Here the tree is compiled once into a postfix
+   sequence of instructions, where each instruction takes the
+   values of its arguments from an operand stack and pushes its
+   result, so that running the program is a single loop over an
+   array.  Where the compiler supports it the next instruction is
+   dispatched with a computed goto, otherwise with a switch.
+
+   ADFs are compiled after the main program and called with a
+   frame which points to the arguments on the stack, rather than
+   by copying them into temp_ADF_arg.  The call depth limit is
+   the same as for gpr_run.  Within an ADF call made from inside
+   another ADF, ARG terminals within the call arguments return
+   the arguments of the enclosing ADF, and arguments beyond those
+   passed to the ADF are zero.
+
+   A program is compiled against the ADFs within the given state,
+   so it should be compiled again after the tree changes */
+
+#include "gpr_vm.h"
+
+#if defined(__GNUC__) && !defined(GPR_VM_SWITCH)
+#define GPR_VM_COMPUTED_GOTO
+#endif
+
+#define GPR_VM_NAN(v) ((v) != (v))
+
+/* state used while compiling */
+struct gpr_vm_comp {
+    gpr_vm * vm;
+    gpr_state * state;
+    /* height of the operand stack at the current instruction */
+    int height;
+    /* maximum height of the stack within the current section */
+    int max_height;
+};
+
+/* an ADF call in progress */
+struct gpr_vm_frm {
+    /* where to continue after returning */
+    gpr_vm_instruction * pc;
+    /* the arguments of the call */
+    float * args;
+    int argc;
+};
+typedef struct gpr_vm_frm gpr_vm_frame;
+
+/* creates an empty program */
+void gpr_vm_init(gpr_vm * vm)
+{
+    vm->length = 0;
+    vm->max_length = 0;
+    vm->code = NULL;
+    vm->start = 0;
+    vm->stack_size = 0;
+    vm->stack = NULL;
+}
+
+/* frees memory for a program */
+void gpr_vm_free(gpr_vm * vm)
+{
+    if (vm->code != NULL) free(vm->code);
+    if (vm->stack != NULL) free(vm->stack);
+    gpr_vm_init(vm);
+}
+
+/* appends an instruction and returns its position */
+static int gpr_vm_emit(struct gpr_vm_comp * c, int opcode, int argc,
+                       int operand, float value)
+{
+    gpr_vm * vm = c->vm;
+    gpr_vm_instruction * instr;
+
+    if (vm->length >= vm->max_length) {
+        vm->max_length = (vm->max_length == 0) ? 64 : vm->max_length*2;
+        vm->code = (gpr_vm_instruction*)
+            realloc(vm->code, vm->max_length*sizeof(gpr_vm_instruction));
+    }
+
+    instr = &vm->code[vm->length];
+    instr->opcode = (unsigned short)opcode;
+    instr->argc = (unsigned short)argc;
+    instr->operand = operand;
+    instr->value = value;
+
+    /* arguments are replaced by the result */
+    if (opcode != GPR_VM_ENTER) {
+        c->height += 1 - argc;
+        if (c->height > c->max_height) c->max_height = c->height;
+    }
+    return vm->length++;
+}
+
+/* returns the instruction for a function whose arguments
+   are all evaluated in order, or -1 */
+static int gpr_vm_opcode(int function_type)
+{
+    switch(function_type) {
+    case GPR_FUNCTION_ADD: return GPR_VM_ADD;
+    case GPR_FUNCTION_DEFUN: return GPR_VM_ADD;
+    case GPR_FUNCTION_NEGATE: return GPR_VM_NEGATE;
+    case GPR_FUNCTION_DIVIDE: return GPR_VM_DIVIDE;
+    case GPR_FUNCTION_MODULUS: return GPR_VM_MODULUS;
+    case GPR_FUNCTION_FLOOR: return GPR_VM_FLOOR;
+    case GPR_FUNCTION_AVERAGE: return GPR_VM_AVERAGE;
+    case GPR_FUNCTION_NOOP1: return GPR_VM_NOOP;
+    case GPR_FUNCTION_NOOP2: return GPR_VM_NOOP;
+    case GPR_FUNCTION_NOOP3: return GPR_VM_NOOP;
+    case GPR_FUNCTION_NOOP4: return GPR_VM_NOOP;
+    case GPR_FUNCTION_MAIN: return GPR_VM_NOOP;
+    case GPR_FUNCTION_PROGRAM: return GPR_VM_NOOP;
+    case GPR_FUNCTION_GREATER_THAN: return GPR_VM_GREATER_THAN;
+    case GPR_FUNCTION_LESS_THAN: return GPR_VM_LESS_THAN;
+    case GPR_FUNCTION_EQUALS: return GPR_VM_EQUALS;
+    case GPR_FUNCTION_AND: return GPR_VM_AND;
+    case GPR_FUNCTION_OR: return GPR_VM_OR;
+    case GPR_FUNCTION_XOR: return GPR_VM_XOR;
+    case GPR_FUNCTION_NOT: return GPR_VM_NOT;
+    case GPR_FUNCTION_EXP: return GPR_VM_EXP;
+    case GPR_FUNCTION_SQUARE_ROOT: return GPR_VM_SQUARE_ROOT;
+    case GPR_FUNCTION_ABS: return GPR_VM_ABS;
+    case GPR_FUNCTION_SINE: return GPR_VM_SINE;
+    case GPR_FUNCTION_ARCSINE: return GPR_VM_ARCSINE;
+    case GPR_FUNCTION_COSINE: return GPR_VM_COSINE;
+    case GPR_FUNCTION_ARCCOSINE: return GPR_VM_ARCCOSINE;
+    case GPR_FUNCTION_POW: return GPR_VM_POW;
+    case GPR_FUNCTION_SIGMOID: return GPR_VM_SIGMOID;
+    case GPR_FUNCTION_MIN: return GPR_VM_MIN;
+    case GPR_FUNCTION_MAX: return GPR_VM_MAX;
+    }
+    return -1;
+}
+
+static void gpr_vm_compile_function(gpr_function * f,
+                                    struct gpr_vm_comp * c);
+
+/* compiles the given arguments of a function in order */
+static void gpr_vm_compile_args(gpr_function * f, int argc,
+                                struct gpr_vm_comp * c)
+{
+    int i;
+
+    for (i = 0; i < argc; i++) {
+        gpr_vm_compile_function((gpr_function*)f->argv[i], c);
+    }
+}
+
+/* compiles the two arguments of a function which passes them on
+   to another function.  The order in which those are run is left
+   to the C compiler, and gcc runs the second before the first,
+   so the same is done here to keep any effects upon the state
+   the same as for gpr_run.  The first argument ends up on the
+   top of the stack */
+static void gpr_vm_compile_pair(gpr_function * f,
+                                struct gpr_vm_comp * c)
+{
+    gpr_vm_compile_function((gpr_function*)f->argv[1], c);
+    gpr_vm_compile_function((gpr_function*)f->argv[0], c);
+}
+
+/* compiles a function and its arguments into postfix order.
+   Each function evaluates the same arguments as its equivalent
+   within gpr_run_function, with missing arguments being zero */
+static void gpr_vm_compile_function(gpr_function * f,
+                                    struct gpr_vm_comp * c)
+{
+    int opcode, argc, index, enter;
+
+    if (f == 0) {
+        gpr_vm_emit(c, GPR_VM_VALUE, 0, 0, 0);
+        return;
+    }
+
+    switch(f->function_type) {
+    case GPR_FUNCTION_VALUE: {
+        gpr_vm_emit(c, GPR_VM_VALUE, 0, 0, f->value);
+        return;
+    }
+    case GPR_FUNCTION_ARG: {
+        gpr_vm_emit(c, GPR_VM_ARG, 0, abs((int)f->value), 0);
+        return;
+    }
+    case GPR_FUNCTION_SUBTRACT:
+    case GPR_FUNCTION_MULTIPLY: {
+        /* the first argument is always evaluated */
+        argc = (f->argc > 0) ? f->argc : 1;
+        gpr_vm_compile_args(f, argc, c);
+        opcode = (f->function_type == GPR_FUNCTION_SUBTRACT) ?
+            GPR_VM_SUBTRACT : GPR_VM_MULTIPLY;
+        gpr_vm_emit(c, opcode, argc, 0, 0);
+        return;
+    }
+    case GPR_FUNCTION_WEIGHT: {
+        gpr_vm_compile_args(f, 1, c);
+        gpr_vm_emit(c, GPR_VM_WEIGHT, 1, 0, f->value);
+        return;
+    }
+    case GPR_FUNCTION_CUSTOM: {
+        gpr_vm_compile_pair(f, c);
+        gpr_vm_emit(c, GPR_VM_CUSTOM, 2, 0, f->value);
+        return;
+    }
+    case GPR_FUNCTION_DATA_PUSH: {
+        gpr_vm_compile_pair(f, c);
+        gpr_vm_emit(c, GPR_VM_DATA_PUSH, 2, 0, 0);
+        return;
+    }
+    case GPR_FUNCTION_DATA_POP: {
+        gpr_vm_compile_args(f, 1, c);
+        gpr_vm_emit(c, GPR_VM_DATA_POP, 1, 0, 0);
+        return;
+    }
+    case GPR_FUNCTION_DATA_GET: {
+        gpr_vm_compile_pair(f, c);
+        gpr_vm_emit(c, GPR_VM_DATA_GET, 2, 0, 0);
+        return;
+    }
+    case GPR_FUNCTION_DATA_SET: {
+        /* as in gpr_data_set the first argument is run twice,
+           and the second run is the first argument */
+        gpr_vm_compile_args(f, 1, c);
+        gpr_vm_compile_args(f, 1, c);
+        gpr_vm_emit(c, GPR_VM_DATA_SET, 2, 0, 0);
+        return;
+    }
+    case GPR_FUNCTION_SET: {
+        gpr_vm_compile_pair(f, c);
+        gpr_vm_emit(c, GPR_VM_SET, 2, 0, 0);
+        return;
+    }
+    case GPR_FUNCTION_GET: {
+        gpr_vm_compile_pair(f, c);
+        gpr_vm_emit(c, GPR_VM_GET, 2, 0, 0);
+        return;
+    }
+    case GPR_FUNCTION_ADF: {
+        index = abs(((int)f->value))%GPR_MAX_ARGUMENTS;
+        if (c->state->ADF[index] == 0) {
+            gpr_vm_emit(c, GPR_VM_VALUE, 0, 0, 0);
+            return;
+        }
+        enter = gpr_vm_emit(c, GPR_VM_ENTER, 0, 0, 0);
+        gpr_vm_compile_args(f, f->argc, c);
+        /* the operand is replaced by the position of the ADF
+           once all ADFs have been compiled */
+        gpr_vm_emit(c, GPR_VM_CALL, f->argc, index, 0);
+        c->vm->code[enter].operand = c->vm->length;
+        return;
+    }
+    }
+
+    opcode = gpr_vm_opcode(f->function_type);
+    if (opcode < 0) {
+        /* functions without any effect when run */
+        gpr_vm_emit(c, GPR_VM_VALUE, 0, 0, 0);
+        return;
+    }
+    gpr_vm_compile_args(f, f->argc, c);
+    gpr_vm_emit(c, opcode, f->argc, 0, 0);
+}
+
+/* compiles a tree and the ADFs within the given state.
+   Returns the number of instructions */
+int gpr_vm_compile(gpr_function * f, gpr_state * state, gpr_vm * vm)
+{
+    int i, stack_size, main_height, ADF_height = 0;
+    int entry[GPR_MAX_ARGUMENTS];
+    struct gpr_vm_comp c;
+
+    c.vm = vm;
+    c.state = state;
+    c.height = 0;
+    c.max_height = 0;
+    vm->length = 0;
+    vm->start = 0;
+
+    /* the main program, as selected by gpr_run */
+    if (state->ADF[0] == 0) {
+        gpr_vm_compile_function(f, &c);
+    }
+    else {
+        if (f->argv[f->argc-1] != 0) {
+            gpr_vm_compile_function((gpr_function*)f->argv[f->argc-1],
+                                    &c);
+        }
+        else {
+            gpr_vm_emit(&c, GPR_VM_VALUE, 0, 0, 0);
+        }
+    }
+    gpr_vm_emit(&c, GPR_VM_HALT, 1, 0, 0);
+    main_height = c.max_height;
+
+    /* ADFs */
+    for (i = 0; i < GPR_MAX_ARGUMENTS; i++) {
+        entry[i] = -1;
+        if (state->ADF[i] == 0) continue;
+        entry[i] = vm->length;
+        c.height = 0;
+        c.max_height = 0;
+        gpr_vm_compile_function(state->ADF[i], &c);
+        gpr_vm_emit(&c, GPR_VM_RETURN, 1, 0, 0);
+        if (c.max_height > ADF_height) ADF_height = c.max_height;
+    }
+
+    /* link calls to the ADFs */
+    for (i = 0; i < vm->length; i++) {
+        if (vm->code[i].opcode == GPR_VM_CALL) {
+            vm->code[i].operand = entry[vm->code[i].operand];
+        }
+    }
+
+    /* each nested call adds the stack of an ADF */
+    stack_size = main_height + (GPR_MAX_CALL_DEPTH-1)*ADF_height + 1;
+    if (stack_size > vm->stack_size) {
+        if (vm->stack != NULL) free(vm->stack);
+        vm->stack = (float*)malloc(stack_size*sizeof(float));
+        vm->stack_size = stack_size;
+    }
+    return vm->length;
+}
+
+#ifdef GPR_VM_COMPUTED_GOTO
+#define GPR_VM_OP(op) op_##op:
+#define GPR_VM_NEXT goto *dispatch[(++pc)->opcode]
+#define GPR_VM_JUMP goto *dispatch[pc->opcode]
+#else
+#define GPR_VM_OP(op) case op:
+#define GPR_VM_NEXT pc++; continue
+#define GPR_VM_JUMP continue
+#endif
+
+/* sum of the arguments from the given position */
+#define GPR_VM_SUM(a, from, to, sum) \
+    for (i = (from); i < (to); i++) (sum) += (a)[i]
+
+#ifdef GPR_VM_COMPUTED_GOTO
+/* labels as values are an extension to C99 */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+/* runs a compiled program with the given state, returning
+   the same value as gpr_run */
+float gpr_vm_run(gpr_vm * vm, gpr_state * state,
+                 float (*custom_function)(float,float,float))
+{
+    gpr_vm_instruction * code = vm->code;
+    gpr_vm_instruction * pc = &code[vm->start];
+    float * sp = vm->stack, * a;
+    float * args = vm->stack;
+    int i, n, itt, argc = 0, call_depth = 0, frames = 0;
+    float v, v1, v2;
+    gpr_vm_frame frame[GPR_MAX_CALL_DEPTH];
+
+#ifdef GPR_VM_COMPUTED_GOTO
+    static void * dispatch[GPR_VM_INSTRUCTIONS] = {
+        [GPR_VM_VALUE] = &&op_GPR_VM_VALUE,
+        [GPR_VM_ARG] = &&op_GPR_VM_ARG,
+        [GPR_VM_ADD] = &&op_GPR_VM_ADD,
+        [GPR_VM_SUBTRACT] = &&op_GPR_VM_SUBTRACT,
+        [GPR_VM_NEGATE] = &&op_GPR_VM_NEGATE,
+        [GPR_VM_MULTIPLY] = &&op_GPR_VM_MULTIPLY,
+        [GPR_VM_WEIGHT] = &&op_GPR_VM_WEIGHT,
+        [GPR_VM_DIVIDE] = &&op_GPR_VM_DIVIDE,
+        [GPR_VM_MODULUS] = &&op_GPR_VM_MODULUS,
+        [GPR_VM_FLOOR] = &&op_GPR_VM_FLOOR,
+        [GPR_VM_AVERAGE] = &&op_GPR_VM_AVERAGE,
+        [GPR_VM_NOOP] = &&op_GPR_VM_NOOP,
+        [GPR_VM_GREATER_THAN] = &&op_GPR_VM_GREATER_THAN,
+        [GPR_VM_LESS_THAN] = &&op_GPR_VM_LESS_THAN,
+        [GPR_VM_EQUALS] = &&op_GPR_VM_EQUALS,
+        [GPR_VM_AND] = &&op_GPR_VM_AND,
+        [GPR_VM_OR] = &&op_GPR_VM_OR,
+        [GPR_VM_XOR] = &&op_GPR_VM_XOR,
+        [GPR_VM_NOT] = &&op_GPR_VM_NOT,
+        [GPR_VM_DATA_PUSH] = &&op_GPR_VM_DATA_PUSH,
+        [GPR_VM_DATA_POP] = &&op_GPR_VM_DATA_POP,
+        [GPR_VM_DATA_GET] = &&op_GPR_VM_DATA_GET,
+        [GPR_VM_DATA_SET] = &&op_GPR_VM_DATA_SET,
+        [GPR_VM_SET] = &&op_GPR_VM_SET,
+        [GPR_VM_GET] = &&op_GPR_VM_GET,
+        [GPR_VM_EXP] = &&op_GPR_VM_EXP,
+        [GPR_VM_SQUARE_ROOT] = &&op_GPR_VM_SQUARE_ROOT,
+        [GPR_VM_ABS] = &&op_GPR_VM_ABS,
+        [GPR_VM_SINE] = &&op_GPR_VM_SINE,
+        [GPR_VM_ARCSINE] = &&op_GPR_VM_ARCSINE,
+        [GPR_VM_COSINE] = &&op_GPR_VM_COSINE,
+        [GPR_VM_ARCCOSINE] = &&op_GPR_VM_ARCCOSINE,
+        [GPR_VM_POW] = &&op_GPR_VM_POW,
+        [GPR_VM_SIGMOID] = &&op_GPR_VM_SIGMOID,
+        [GPR_VM_MIN] = &&op_GPR_VM_MIN,
+        [GPR_VM_MAX] = &&op_GPR_VM_MAX,
+        [GPR_VM_CUSTOM] = &&op_GPR_VM_CUSTOM,
+        [GPR_VM_ENTER] = &&op_GPR_VM_ENTER,
+        [GPR_VM_CALL] = &&op_GPR_VM_CALL,
+        [GPR_VM_RETURN] = &&op_GPR_VM_RETURN,
+        [GPR_VM_HALT] = &&op_GPR_VM_HALT
+    };
+
+    if (vm->length == 0) return 0;
+    GPR_VM_JUMP;
+#else
+    if (vm->length == 0) return 0;
+    for (;;) {
+    switch(pc->opcode) {
+#endif
+
+    GPR_VM_OP(GPR_VM_VALUE) {
+        *sp++ = pc->value;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_ARG) {
+        *sp++ = (pc->operand < argc) ? args[pc->operand] : 0;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_ADD) {
+        a = sp - pc->argc;
+        v = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v);
+        sp = a;
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_SUBTRACT) {
+        a = sp - pc->argc;
+        v = a[0];
+        for (i = 1; i < pc->argc; i++) v -= a[i];
+        sp = a;
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_NEGATE) {
+        a = sp - pc->argc;
+        v = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v);
+        sp = a;
+        *sp++ = GPR_VM_NAN(v) ? 0 : -v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_MULTIPLY) {
+        a = sp - pc->argc;
+        v = a[0];
+        for (i = 1; i < pc->argc; i++) v *= a[i];
+        sp = a;
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_WEIGHT) {
+        v = sp[-1] * pc->value;
+        sp[-1] = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_DIVIDE) {
+        a = sp - pc->argc;
+        n = pc->argc/2;
+        v1 = 0;
+        v2 = 0;
+        GPR_VM_SUM(a, 0, n, v1);
+        GPR_VM_SUM(a, n, pc->argc, v2);
+        sp = a;
+        v = 0;
+        if (fabs(v2) > 0.01f) {
+            v = v1 / v2;
+            if (GPR_VM_NAN(v)) v = 0;
+        }
+        *sp++ = v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_MODULUS) {
+        a = sp - pc->argc;
+        n = pc->argc/2;
+        v1 = 0;
+        v2 = 0;
+        GPR_VM_SUM(a, 0, n, v1);
+        GPR_VM_SUM(a, n, pc->argc, v2);
+        sp = a;
+        v = 0;
+        if (fabs(v2) > 0.01f) {
+            v = fmod(v1, v2);
+            if (GPR_VM_NAN(v)) v = 0;
+        }
+        *sp++ = v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_FLOOR) {
+        a = sp - pc->argc;
+        v = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v);
+        sp = a;
+        v = floor(v);
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_AVERAGE) {
+        a = sp - pc->argc;
+        v1 = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v1);
+        sp = a;
+        v = v1 / pc->argc;
+        *sp++ = GPR_VM_NAN(v1) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_NOOP) {
+        sp -= pc->argc;
+        *sp++ = 0;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_GREATER_THAN) {
+        a = sp - pc->argc;
+        n = pc->argc/2;
+        v1 = 0;
+        v2 = 0;
+        GPR_VM_SUM(a, 0, n, v1);
+        GPR_VM_SUM(a, n, pc->argc, v2);
+        sp = a;
+        *sp++ = (v1 > v2) ? GPR_TRUE : GPR_FALSE;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_LESS_THAN) {
+        a = sp - pc->argc;
+        n = pc->argc/2;
+        v1 = 0;
+        v2 = 0;
+        GPR_VM_SUM(a, 0, n, v1);
+        GPR_VM_SUM(a, n, pc->argc, v2);
+        sp = a;
+        *sp++ = (v1 < v2) ? GPR_TRUE : GPR_FALSE;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_EQUALS) {
+        a = sp - pc->argc;
+        n = pc->argc/2;
+        v1 = 0;
+        v2 = 0;
+        GPR_VM_SUM(a, 0, n, v1);
+        GPR_VM_SUM(a, n, pc->argc, v2);
+        sp = a;
+        *sp++ = ((int)v1 == (int)v2) ? GPR_TRUE : GPR_FALSE;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_AND) {
+        a = sp - pc->argc;
+        n = pc->argc/2;
+        v1 = 0;
+        v2 = 0;
+        GPR_VM_SUM(a, 0, n, v1);
+        GPR_VM_SUM(a, n, pc->argc, v2);
+        sp = a;
+        *sp++ = ((v1 > 0) && (v2 > 0)) ? GPR_TRUE : GPR_FALSE;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_OR) {
+        a = sp - pc->argc;
+        n = pc->argc/2;
+        v1 = 0;
+        v2 = 0;
+        GPR_VM_SUM(a, 0, n, v1);
+        GPR_VM_SUM(a, n, pc->argc, v2);
+        sp = a;
+        *sp++ = ((v1 > 0) || (v2 > 0)) ? GPR_TRUE : GPR_FALSE;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_XOR) {
+        a = sp - pc->argc;
+        n = pc->argc/2;
+        v1 = 0;
+        v2 = 0;
+        GPR_VM_SUM(a, 0, n, v1);
+        GPR_VM_SUM(a, n, pc->argc, v2);
+        sp = a;
+        *sp++ = ((v1 > 0) != (v2 > 0)) ? GPR_TRUE : GPR_FALSE;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_NOT) {
+        a = sp - pc->argc;
+        n = pc->argc/2;
+        v1 = 0;
+        v2 = 0;
+        GPR_VM_SUM(a, 0, n, v1);
+        GPR_VM_SUM(a, n, pc->argc, v2);
+        sp = a;
+        *sp++ = ((int)v1 != (int)v2) ? GPR_TRUE : GPR_FALSE;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_DATA_PUSH) {
+        sp--;
+        sp[-1] = gpr_state_push(sp[0], sp[-1], state);
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_DATA_POP) {
+        sp[-1] = gpr_state_pop(sp[-1], state);
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_DATA_GET) {
+        sp--;
+        sp[-1] = gpr_state_data_get(sp[0], sp[-1], state);
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_DATA_SET) {
+        sp--;
+        sp[-1] = gpr_state_data_set(sp[0], sp[-1], state);
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_SET) {
+        sp--;
+        sp[-1] = gpr_state_store(sp[0], sp[-1], state);
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_GET) {
+        sp--;
+        sp[-1] = gpr_state_fetch(sp[0], sp[-1], state);
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_EXP) {
+        a = sp - pc->argc;
+        v1 = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v1);
+        sp = a;
+        v = (float)exp(v1);
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_SQUARE_ROOT) {
+        a = sp - pc->argc;
+        v1 = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v1);
+        sp = a;
+        v1 = fabs(v1);
+        if (GPR_VM_NAN(v1)) v1 = 0;
+        v = (float)sqrt(v1);
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_ABS) {
+        a = sp - pc->argc;
+        v1 = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v1);
+        sp = a;
+        v = fabs(v1);
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_SINE) {
+        a = sp - pc->argc;
+        v1 = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v1);
+        sp = a;
+        v = (float)sin(v1);
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_ARCSINE) {
+        a = sp - pc->argc;
+        v1 = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v1);
+        sp = a;
+        v = (float)asin(v1);
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_COSINE) {
+        a = sp - pc->argc;
+        v1 = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v1);
+        sp = a;
+        v = (float)cos(v1);
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_ARCCOSINE) {
+        a = sp - pc->argc;
+        v1 = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v1);
+        sp = a;
+        v = (float)acos(v1);
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_POW) {
+        a = sp - pc->argc;
+        n = pc->argc/2;
+        v1 = 0;
+        v2 = 0;
+        GPR_VM_SUM(a, 0, n, v1);
+        GPR_VM_SUM(a, n, pc->argc, v2);
+        sp = a;
+        v = v1;
+        itt = 2+(abs((int)v2)%3);
+        for (i = 0; i < itt; i++) v *= v1;
+        *sp++ = GPR_VM_NAN(v) ? 0 : v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_SIGMOID) {
+        a = sp - pc->argc;
+        v1 = 0;
+        GPR_VM_SUM(a, 0, pc->argc, v1);
+        sp = a;
+        *sp++ = 1.0f / (1.0f + exp(v1));
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_MIN) {
+        a = sp - pc->argc;
+        v = 0;
+        for (i = 0; i < pc->argc; i++) {
+            if ((i == 0) || (a[i] < v)) v = a[i];
+        }
+        sp = a;
+        *sp++ = v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_MAX) {
+        a = sp - pc->argc;
+        v = 0;
+        for (i = 0; i < pc->argc; i++) {
+            if ((i == 0) || (a[i] > v)) v = a[i];
+        }
+        sp = a;
+        *sp++ = v;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_CUSTOM) {
+        sp--;
+        sp[-1] = (*custom_function)(pc->value, sp[0], sp[-1]);
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_ENTER) {
+        if (call_depth >= GPR_MAX_CALL_DEPTH-1) {
+            /* too deep, so the call returns zero */
+            *sp++ = 0;
+            pc = &code[pc->operand];
+            GPR_VM_JUMP;
+        }
+        call_depth++;
+        GPR_VM_NEXT;
+    }
+    GPR_VM_OP(GPR_VM_CALL) {
+        frame[frames].pc = pc + 1;
+        frame[frames].args = args;
+        frame[frames].argc = argc;
+        frames++;
+        args = sp - pc->argc;
+        argc = pc->argc;
+        pc = &code[pc->operand];
+        GPR_VM_JUMP;
+    }
+    GPR_VM_OP(GPR_VM_RETURN) {
+        /* the arguments are replaced by the result */
+        v = sp[-1];
+        sp = args;
+        *sp++ = v;
+        frames--;
+        pc = frame[frames].pc;
+        args = frame[frames].args;
+        argc = frame[frames].argc;
+        call_depth--;
+        GPR_VM_JUMP;
+    }
+    GPR_VM_OP(GPR_VM_HALT) {
+        return sp[-1];
+    }
+
+#ifndef GPR_VM_COMPUTED_GOTO
+    }
+    }
+#endif
+    return 0;
+}
+
+#ifdef GPR_VM_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
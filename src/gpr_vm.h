@@ -0,0 +1,125 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPR_VM_H
+#define GPR_VM_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "globals.h"
+#include "gpr.h"
+
+/* instructions of the stack machine */
+enum {
+    GPR_VM_VALUE = 0,
+    GPR_VM_ARG,
+    GPR_VM_ADD,
+    GPR_VM_SUBTRACT,
+    GPR_VM_NEGATE,
+    GPR_VM_MULTIPLY,
+    GPR_VM_WEIGHT,
+    GPR_VM_DIVIDE,
+    GPR_VM_MODULUS,
+    GPR_VM_FLOOR,
+    GPR_VM_AVERAGE,
+    GPR_VM_NOOP,
+    GPR_VM_GREATER_THAN,
+    GPR_VM_LESS_THAN,
+    GPR_VM_EQUALS,
+    GPR_VM_AND,
+    GPR_VM_OR,
+    GPR_VM_XOR,
+    GPR_VM_NOT,
+    GPR_VM_DATA_PUSH,
+    GPR_VM_DATA_POP,
+    GPR_VM_DATA_GET,
+    GPR_VM_DATA_SET,
+    GPR_VM_SET,
+    GPR_VM_GET,
+    GPR_VM_EXP,
+    GPR_VM_SQUARE_ROOT,
+    GPR_VM_ABS,
+    GPR_VM_SINE,
+    GPR_VM_ARCSINE,
+    GPR_VM_COSINE,
+    GPR_VM_ARCCOSINE,
+    GPR_VM_POW,
+    GPR_VM_SIGMOID,
+    GPR_VM_MIN,
+    GPR_VM_MAX,
+    GPR_VM_CUSTOM,
+    /* begins an ADF call, or skips it if too deeply nested */
+    GPR_VM_ENTER,
+    /* calls an ADF with the arguments on the stack */
+    GPR_VM_CALL,
+    /* returns from an ADF */
+    GPR_VM_RETURN,
+    /* end of the main program */
+    GPR_VM_HALT,
+    GPR_VM_INSTRUCTIONS
+};
+
+/* a single instruction */
+struct gpr_vm_instr {
+    /* the type of instruction */
+    unsigned short opcode;
+    /* the number of values taken from the stack */
+    unsigned short argc;
+    /* argument index, jump destination or position of an ADF */
+    int operand;
+    /* constant value */
+    float value;
+};
+typedef struct gpr_vm_instr gpr_vm_instruction;
+
+/* a tree compiled into postfix order, with the main program
+   followed by the ADFs which it may call */
+struct gpr_vm_prog {
+    /* the number of instructions */
+    int length;
+    /* the number of instructions allocated */
+    int max_length;
+    gpr_vm_instruction * code;
+    /* the first instruction of the main program */
+    int start;
+    /* the operand stack */
+    int stack_size;
+    float * stack;
+};
+typedef struct gpr_vm_prog gpr_vm;
+
+void gpr_vm_init(gpr_vm * vm);
+void gpr_vm_free(gpr_vm * vm);
+int gpr_vm_compile(gpr_function * f, gpr_state * state, gpr_vm * vm);
+float gpr_vm_run(gpr_vm * vm, gpr_state * state,
+                 float (*custom_function)(float,float,float));
+
+#endif
@@ -334,6 +334,7 @@ void gprc_invert(gprc_function * source,
             }
         }
     }
+    gprc_invalidate(dest);
 }
 
 /* initialize an individual */
@@ -361,6 +362,12 @@ void gprc_init(gprc_function * f,
         f->genome[m].used =
             (unsigned char*)malloc(((rows*columns) + sens + act)*
                                    sizeof(unsigned char));
+        f->genome[m].program =
+            (int*)malloc(rows*columns*
+                         GPRC_INSTR_SIZE(connections_per_gene)*
+                         sizeof(int));
+        f->genome[m].program_length = GPRC_PROGRAM_INVALID;
+        f->genome[m].call_args = -1;
     }
 
     /* clear the state */
@@ -387,6 +394,7 @@ void gprc_init(gprc_function * f,
     f->age = 0;
 
     f->temp_genes = (int*)malloc(GPRC_MAX_ADF_GENES*3*sizeof(int));
+    f->snapshot = NULL;
 
     gpr_data_init(&f->data,
                   (unsigned int)data_size,
@@ -401,6 +409,7 @@ void gprc_free(gprc_function * f)
         free(f->genome[m].gene);
         free(f->genome[m].state);
         free(f->genome[m].used);
+        free(f->genome[m].program);
     }
 
     if (f->no_of_sensor_sources>0) {
@@ -779,16 +788,94 @@ static int gprc_get_used_gene(gprc_function * f,
     return -1;
 }
 
+/* marks the connections of used genes as being used, sweeping
+   backwards from the gene with index from down to the gene with
+   index to.  Returns 1 if a gene at or beyond the given limit,
+   or beyond the gene being traced, was newly marked, so that
+   another sweep is needed, or -1 if a connection is out of range */
+static int gprc_trace_genes(gprc_ADF_module * f,
+                            int rows, int columns,
+                            int connections_per_gene,
+                            int sensors, int actuators,
+                            int from, int to, int limit)
+{
+    int index,c,connection_index,n,min,max,function_type;
+    int retrace = 0;
+
+    n = from*GPRC_GENE_SIZE(connections_per_gene);
+    for (index = from; index >= to; index--,
+             n -= GPRC_GENE_SIZE(connections_per_gene)) {
+        /* has not been traced */
+        if (f->used[index + sensors] == 0) continue;
+
+        function_type = (int)f->gene[n];
+        min=0;
+        max =
+            gprc_function_args(function_type,
+                               f->gene[n+GPRC_GENE_CONSTANT],
+                               connections_per_gene,
+                               (int)f->gene[n+GPRC_INITIAL]);
+
+        if (function_type==GPR_FUNCTION_ADF) {
+            min=1;
+            max++;
+        }
+
+        for (c = min; c < max; c++) {
+            /* get the prior connection */
+            connection_index =
+                (int)f->gene[n + GPRC_INITIAL + c];
+            if (connection_index >=
+                sensors+actuators+(rows*columns)) {
+                printf("Connection %d out of range %d/%d\n",
+                       c, connection_index,
+                       sensors+actuators+(rows*columns));
+                return -1;
+            }
+            if (connection_index < 0) {
+                printf("Connection %d out of range %d\n",
+                       c, connection_index);
+                return -1;
+            }
+            /* prior has not been traced */
+            if (f->used[connection_index] == 0) {
+                /* mark the prior as traced */
+                f->used[connection_index] = 1;
+                /* connections to later genes are not expected
+                   within a feed forward grid */
+                if ((connection_index - sensors > index) ||
+                    (connection_index - sensors >= limit)) {
+                    retrace = 1;
+                }
+            }
+        }
+    }
+    return retrace;
+}
+
+/* marks the sources of the actuators as being used */
+static void gprc_trace_actuators(gprc_ADF_module * f,
+                                 int rows, int columns,
+                                 int connections_per_gene,
+                                 int sensors, int actuators)
+{
+    int index,n = rows*columns*GPRC_GENE_SIZE(connections_per_gene);
+
+    for (index = 0; index < actuators; index++, n++) {
+        f->used[(int)f->gene[n]] = 1;
+    }
+}
+
 /* the purpose of this is to discover which functions within
    the grid are actually used as part of the input -> output
-   transformation. */
+   transformation.  Genes only connect to earlier columns, so a
+   single backwards sweep is normally sufficient */
 static void gprc_used_genes(gprc_ADF_module * f,
                             int rows, int columns,
                             int connections_per_gene,
                             int sensors, int actuators)
 {
-    int row,col,index=0,index2,c,connection_index,ctr,prev_ctr,n;
-    int min,max,function_type;
+    int index,result;
     int array_bytes =
         (sensors+actuators+(rows*columns))*sizeof(unsigned char);
 
@@ -801,67 +888,53 @@ static void gprc_used_genes(gprc_ADF_module * f,
     }
 
     /* propagate backwards */
-    ctr = 0;
-    prev_ctr = -1;
-    while (ctr > prev_ctr) {
-        prev_ctr = ctr;
-        index = 0;
-        n = 0;
-        for (col = 0; col < columns; col++) {
-            for (row = 0; row < rows; row++, index++,
-                     n += GPRC_GENE_SIZE(connections_per_gene)) {
-                /* has been traced */
-                if (f->used[index + sensors] == 1) {
-
-                    function_type = (int)f->gene[n];
-                    min=0;
-                    max =
-                        gprc_function_args(function_type,
-                                           f->gene[n+GPRC_GENE_CONSTANT],
-                                           connections_per_gene,
-                                           (int)f->gene[n+GPRC_INITIAL]);
-
-                    if (function_type==GPR_FUNCTION_ADF) {
-                        min=1;
-                        max++;
-                    }
+    do {
+        gprc_trace_actuators(f, rows, columns,
+                             connections_per_gene,
+                             sensors, actuators);
+        result = gprc_trace_genes(f, rows, columns,
+                                  connections_per_gene,
+                                  sensors, actuators,
+                                  (rows*columns)-1, 0, rows*columns);
+    } while (result > 0);
+}
 
-                    for (c = min; c < max; c++) {
-                        /* get the prior connection */
-                        connection_index =
-                            (int)f->gene[n + GPRC_INITIAL + c];
-                        if (connection_index >=
-                            sensors+actuators+(rows*columns)) {
-                            printf("Connection %d out of range %d/%d\n",
-                                   c, connection_index,
-                                   sensors+actuators+(rows*columns));
-                            return;
-                        }
-                        if (connection_index < 0) {
-                            printf("Connection %d out of range %d\n",
-                                   c, connection_index);
-                            return;
-                        }
-                        /* prior has not been traced */
-                        if (f->used[connection_index] == 0) {
-                            /* mark the prior as traced */
-                            f->used[connection_index] = 1;
-                            ctr++;
-                        }
-                    }
-                }
-            }
-        }
-        for (index2 = 0; index2 < actuators; index2++, n++) {
-            connection_index = (int)f->gene[n];
-            /* prior has not been traced */
-            if (f->used[connection_index] == 0) {
-                /* mark the prior as traced */
-                f->used[connection_index]=1;
-                ctr++;
-            }
-        }
-    }
+/* Updates which genes are used after the function type or
+   connections of a single gene within the grid have changed.
+   If the gene is not used then nothing else is affected, otherwise
+   only the genes in earlier columns need to be traced again */
+void gprc_retrace_gene(gprc_function * f, int ADF_module,
+                       int gene_index,
+                       int rows, int columns,
+                       int connections_per_gene,
+                       int sensors, int actuators)
+{
+    int start, result;
+    gprc_ADF_module * g = &f->genome[ADF_module];
+    int sens = gprc_get_sensors(ADF_module, sensors);
+    int act = gprc_get_actuators(ADF_module, actuators);
+
+    if (g->used[sens + gene_index] == 0) return;
+
+    /* clear the sensors and earlier columns */
+    start = (gene_index / rows) * rows;
+    memset((void*)g->used,'\0',(sens+start)*sizeof(unsigned char));
+
+    /* later genes which were used remain used, and
+       their connections are traced into the earlier columns */
+    gprc_trace_actuators(g, rows, columns,
+                         connections_per_gene, sens, act);
+    result = gprc_trace_genes(g, rows, columns,
+                              connections_per_gene, sens, act,
+                              (rows*columns)-1, 0, start);
+    if (result > 0) {
+        /* not feed forward, so trace everything */
+        gprc_used_genes(g, rows, columns,
+                        connections_per_gene, sens, act);
+    }
+
+    /* the compiled program needs to be rebuilt */
+    g->program_length = GPRC_PROGRAM_INVALID;
 }
 
 /* the purpose of this is to discover which functions within
@@ -880,6 +953,442 @@ void gprc_used_functions(gprc_function * f,
                         gprc_get_sensors(m, sensors),
                         gprc_get_actuators(m,actuators));
     }
+
+    /* the compiled programs need to be rebuilt */
+    gprc_invalidate(f);
+}
+
+/* marks the compiled programs as needing to be rebuilt.
+   This should be called whenever the genes or used
+   flags are changed */
+void gprc_invalidate(gprc_function * f)
+{
+    for (int m = 0; m < f->ADF_modules+1; m++) {
+        f->genome[m].program_length = GPRC_PROGRAM_INVALID;
+    }
+}
+
+/* returns non-zero if the given function type can alter
+   the genome when it is run */
+static int gprc_modifies_genome(int function_type)
+{
+    return ((function_type == GPR_FUNCTION_COPY_FUNCTION) ||
+            (function_type == GPR_FUNCTION_COPY_CONSTANT) ||
+            (function_type == GPR_FUNCTION_COPY_BLOCK) ||
+            (function_type == GPR_FUNCTION_COPY_CONNECTION1) ||
+            (function_type == GPR_FUNCTION_COPY_CONNECTION2) ||
+            (function_type == GPR_FUNCTION_COPY_CONNECTION3) ||
+            (function_type == GPR_FUNCTION_COPY_CONNECTION4));
+}
+
+/* allocates a snapshot able to record changes to programs
+   with the given dimensions and number of ADF modules */
+void gprc_snapshot_init(gprc_snapshot * snapshot,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int ADF_modules)
+{
+    int m, genes = rows*columns;
+
+    snapshot->rows = rows;
+    snapshot->columns = columns;
+    snapshot->connections_per_gene = connections_per_gene;
+    snapshot->ADF_modules = ADF_modules;
+
+    for (m = 0; m < ADF_modules+1; m++) {
+        snapshot->gene[m] =
+            (float*)malloc(genes*GPRC_GENE_SIZE(connections_per_gene)*
+                           sizeof(float));
+        snapshot->dirty[m] =
+            (unsigned char*)malloc(genes*sizeof(unsigned char));
+        memset((void*)snapshot->dirty[m],'\0',
+               genes*sizeof(unsigned char));
+        snapshot->changed[m] = (int*)malloc(genes*sizeof(int));
+        snapshot->no_of_changes[m] = 0;
+    }
+}
+
+/* frees memory for a snapshot */
+void gprc_snapshot_free(gprc_snapshot * snapshot)
+{
+    for (int m = 0; m < snapshot->ADF_modules+1; m++) {
+        free(snapshot->gene[m]);
+        free(snapshot->dirty[m]);
+        free(snapshot->changed[m]);
+    }
+}
+
+/* Starts recording the genes which are altered when the given
+   program runs, so that gprc_snapshot_restore can undo the changes
+   between trials.  Returns -1 if the snapshot has too few modules */
+int gprc_snapshot_begin(gprc_function * f, gprc_snapshot * snapshot)
+{
+    if (f->ADF_modules > snapshot->ADF_modules) return -1;
+    for (int m = 0; m < snapshot->ADF_modules+1; m++) {
+        snapshot->no_of_changes[m] = 0;
+    }
+    f->snapshot = snapshot;
+    return 0;
+}
+
+/* saves a gene before a dynamic function alters it */
+static void gprc_snapshot_gene(gprc_function * f,
+                               int ADF_module, int index)
+{
+    gprc_snapshot * snapshot = f->snapshot;
+    int gene_size;
+
+    if (snapshot == NULL) return;
+    if (snapshot->dirty[ADF_module][index] != 0) return;
+
+    gene_size = GPRC_GENE_SIZE(snapshot->connections_per_gene);
+    memcpy((void*)&snapshot->gene[ADF_module][index*gene_size],
+           (void*)&f->genome[ADF_module].gene[index*gene_size],
+           gene_size*sizeof(float));
+    snapshot->dirty[ADF_module][index] = 1;
+    snapshot->changed[ADF_module][snapshot->no_of_changes[ADF_module]++] =
+        index;
+}
+
+/* Records a gene which is about to be altered by a dynamic function.
+   A compiled list of used genes may have been built from its previous
+   value, and is used again on the next run which isn't dynamic,
+   so it needs to be rebuilt */
+static void gprc_alter_gene(gprc_function * f,
+                            int ADF_module, int index)
+{
+    gprc_snapshot_gene(f, ADF_module, index);
+    if (f->genome[ADF_module].program_length >= 0) {
+        f->genome[ADF_module].program_length = GPRC_PROGRAM_INVALID;
+    }
+}
+
+/* Puts back any genes which have been altered since the snapshot
+   began or was last restored, and returns the number of genes
+   restored.  The used genes don't need to be retraced, but a
+   program compiled from the altered genes is rebuilt */
+int gprc_snapshot_restore(gprc_function * f)
+{
+    int m, i, index, gene_size, restored = 0;
+    gprc_snapshot * snapshot = f->snapshot;
+
+    if (snapshot == NULL) return 0;
+
+    gene_size = GPRC_GENE_SIZE(snapshot->connections_per_gene);
+    for (m = 0; m < f->ADF_modules+1; m++) {
+        for (i = 0; i < snapshot->no_of_changes[m]; i++) {
+            index = snapshot->changed[m][i];
+            memcpy((void*)&f->genome[m].gene[index*gene_size],
+                   (void*)&snapshot->gene[m][index*gene_size],
+                   gene_size*sizeof(float));
+            snapshot->dirty[m][index] = 0;
+        }
+        if ((snapshot->no_of_changes[m] > 0) &&
+            (f->genome[m].program_length >= 0)) {
+            f->genome[m].program_length = GPRC_PROGRAM_INVALID;
+        }
+        restored += snapshot->no_of_changes[m];
+        snapshot->no_of_changes[m] = 0;
+    }
+    return restored;
+}
+
+/* restores the genome and stops recording changes */
+void gprc_snapshot_end(gprc_function * f)
+{
+    gprc_snapshot_restore(f);
+    f->snapshot = NULL;
+}
+
+/* returns non-zero if the given function type only reads the
+   states of its connections and always writes its own state, so
+   that running it again with the same inputs has no further effect */
+static int gprc_pure_function(int function_type)
+{
+    switch(function_type) {
+    case GPR_FUNCTION_VALUE:
+    case GPR_FUNCTION_SIGMOID:
+    case GPR_FUNCTION_ADD:
+    case GPR_FUNCTION_SUBTRACT:
+    case GPR_FUNCTION_NEGATE:
+    case GPR_FUNCTION_MULTIPLY:
+    case GPR_FUNCTION_WEIGHT:
+    case GPR_FUNCTION_DIVIDE:
+    case GPR_FUNCTION_MODULUS:
+    case GPR_FUNCTION_FLOOR:
+    case GPR_FUNCTION_AVERAGE:
+    case GPR_FUNCTION_NOOP1:
+    case GPR_FUNCTION_NOOP2:
+    case GPR_FUNCTION_NOOP3:
+    case GPR_FUNCTION_NOOP4:
+    case GPR_FUNCTION_GREATER_THAN:
+    case GPR_FUNCTION_LESS_THAN:
+    case GPR_FUNCTION_EQUALS:
+    case GPR_FUNCTION_AND:
+    case GPR_FUNCTION_OR:
+    case GPR_FUNCTION_XOR:
+    case GPR_FUNCTION_NOT:
+    case GPR_FUNCTION_EXP:
+    case GPR_FUNCTION_SQUARE_ROOT:
+    case GPR_FUNCTION_ABS:
+    case GPR_FUNCTION_SINE:
+    case GPR_FUNCTION_ARCSINE:
+    case GPR_FUNCTION_COSINE:
+    case GPR_FUNCTION_ARCCOSINE:
+    case GPR_FUNCTION_POW:
+    case GPR_FUNCTION_MIN:
+    case GPR_FUNCTION_MAX: {
+        return 1;
+    }
+    }
+    return 0;
+}
+
+/* Compiles the used genes within the given module into a packed
+   list of instructions, so that running the program doesn't need
+   to scan the whole grid or decode the genes each time.
+   Returns the number of instructions, or GPRC_PROGRAM_DYNAMIC if
+   the used genes are able to modify the genome */
+int gprc_compile(gprc_function * f,
+                 int ADF_module,
+                 int rows, int columns,
+                 int connections_per_gene,
+                 int sensors)
+{
+    int i, j, n=0, function_type;
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int sens = gprc_get_sensors(ADF_module,sensors);
+    float * gene = f->genome[ADF_module].gene;
+    unsigned char * used = f->genome[ADF_module].used;
+    int * instr = f->genome[ADF_module].program;
+    int length = 0, pure = 1;
+
+    for (i = 0; i < rows*columns; i++, n += gene_size) {
+        if (used[i+sens] == 0) continue;
+
+        function_type = (int)gene[n+GPRC_GENE_FUNCTION_TYPE];
+        if (gprc_modifies_genome(function_type)) {
+            length = GPRC_PROGRAM_DYNAMIC;
+            break;
+        }
+        if (!gprc_pure_function(function_type)) pure = 0;
+
+        instr[GPRC_INSTR_GENE] = i;
+        instr[GPRC_INSTR_FUNCTION_TYPE] = function_type;
+        instr[GPRC_INSTR_ARGS] =
+            gprc_function_args(function_type,
+                               gene[n+GPRC_GENE_CONSTANT],
+                               connections_per_gene,
+                               (int)gene[n+GPRC_INITIAL]);
+        for (j = 0; j < connections_per_gene; j++) {
+            instr[GPRC_INSTR_INITIAL+j] = (int)gene[n+GPRC_INITIAL+j];
+        }
+        instr += instr_size;
+        length++;
+    }
+
+    f->genome[ADF_module].program_length = length;
+    f->genome[ADF_module].program_pure = pure;
+
+    /* each argument of an ADF goes into the next used sensor */
+    if (ADF_module > 0) {
+        n = 0;
+        j = sens + (rows*columns) + gprc_get_actuators(ADF_module, 0);
+        f->genome[ADF_module].arguments = 0;
+        for (i = 0; i < GPRC_MAX_ADF_MODULE_SENSORS; i++, n++) {
+            while ((n < j) && (used[n] == 0)) n++;
+            if (n >= j) break;
+            f->genome[ADF_module].argument[i] = n;
+            f->genome[ADF_module].arguments++;
+        }
+    }
+    return length;
+}
+
+/* returns the compiled program for the given module, compiling
+   it if necessary, or NULL if the interpreter should be used */
+int * gprc_compiled_program(gprc_function * f,
+                            int ADF_module,
+                            int rows, int columns,
+                            int connections_per_gene,
+                            int sensors,
+                            int dynamic)
+{
+    gprc_ADF_module * module = &f->genome[ADF_module];
+
+    /* all genes are run in dynamic mode */
+    if (dynamic > 0) return NULL;
+
+    if (module->program_length == GPRC_PROGRAM_INVALID) {
+        gprc_compile(f, ADF_module, rows, columns,
+                     connections_per_gene, sensors);
+    }
+    if (module->program_length == GPRC_PROGRAM_DYNAMIC) {
+        return NULL;
+    }
+    return module->program;
+}
+
+/* Returns non-zero if the two individuals have identical
+   phenotypes, such that their active genes and outputs are the
+   same even if their inactive genes differ.  Individuals with
+   ADFs or with genes which can alter the genome are never
+   considered to be identical */
+int gprc_same_phenotype(gprc_function * f1, gprc_function * f2,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int sensors, int actuators)
+{
+    int i, j, n1, n2, length;
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int * instr1, * instr2;
+    float * gene1 = f1->genome[0].gene;
+    float * gene2 = f2->genome[0].gene;
+
+    if ((f1->ADF_modules > 0) || (f2->ADF_modules > 0)) return 0;
+
+    instr1 = gprc_compiled_program(f1, 0, rows, columns,
+                                   connections_per_gene, sensors, 0);
+    instr2 = gprc_compiled_program(f2, 0, rows, columns,
+                                   connections_per_gene, sensors, 0);
+    if ((instr1 == NULL) || (instr2 == NULL)) return 0;
+
+    length = f1->genome[0].program_length;
+    if (length != f2->genome[0].program_length) return 0;
+
+    /* sensor sources and actuator destinations */
+    if ((f1->no_of_sensor_sources != f2->no_of_sensor_sources) ||
+        (f1->no_of_actuator_destinations !=
+         f2->no_of_actuator_destinations)) {
+        return 0;
+    }
+    for (i = 0; i < f1->no_of_sensor_sources; i++) {
+        if (f1->sensor_source[i] != f2->sensor_source[i]) return 0;
+    }
+    for (i = 0; i < f1->no_of_actuator_destinations; i++) {
+        if (f1->actuator_destination[i] !=
+            f2->actuator_destination[i]) {
+            return 0;
+        }
+    }
+
+    /* actuator connections */
+    n1 = rows*columns*gene_size;
+    for (i = 0; i < actuators; i++) {
+        if ((int)gene1[n1+i] != (int)gene2[n1+i]) return 0;
+    }
+
+    /* compare each used gene */
+    for (i = 0; i < length; i++, instr1 += instr_size,
+             instr2 += instr_size) {
+        if ((instr1[GPRC_INSTR_GENE] != instr2[GPRC_INSTR_GENE]) ||
+            (instr1[GPRC_INSTR_FUNCTION_TYPE] !=
+             instr2[GPRC_INSTR_FUNCTION_TYPE]) ||
+            (instr1[GPRC_INSTR_ARGS] != instr2[GPRC_INSTR_ARGS])) {
+            return 0;
+        }
+        n1 = instr1[GPRC_INSTR_GENE]*gene_size;
+        n2 = instr2[GPRC_INSTR_GENE]*gene_size;
+        if ((gene1[n1+GPRC_GENE_CONSTANT] !=
+             gene2[n2+GPRC_GENE_CONSTANT]) ||
+            (gene1[n1+GPRC_GENE_IMAGINARY] !=
+             gene2[n2+GPRC_GENE_IMAGINARY])) {
+            return 0;
+        }
+        /* connections and their weights */
+        for (j = 0; j < instr1[GPRC_INSTR_ARGS]; j++) {
+            if ((instr1[GPRC_INSTR_INITIAL+j] !=
+                 instr2[GPRC_INSTR_INITIAL+j]) ||
+                (gene1[n1+GPRC_INITIAL+j+connections_per_gene] !=
+                 gene2[n2+GPRC_INITIAL+j+connections_per_gene])) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* Returns a hash of the phenotype of the given individual, which
+   includes the active genes and their constants but not any
+   inactive genes.  Active genes are numbered in the order in which
+   they are run, so that the same program at different positions
+   within the grid has the same hash.  Zero is returned if the
+   individual can't be hashed */
+unsigned long long gprc_phenotype_hash(gprc_function * f,
+                                       int rows, int columns,
+                                       int connections_per_gene,
+                                       int sensors, int actuators)
+{
+    int i, j, n, length, src, positional = 0;
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int position[rows*columns], value[4];
+    int * program, * instr;
+    float * gene = f->genome[0].gene;
+    unsigned long long hash = 0;
+
+    if (f->ADF_modules > 0) return 0;
+
+    program = gprc_compiled_program(f, 0, rows, columns,
+                                    connections_per_gene, sensors, 0);
+    if (program == NULL) return 0;
+    length = f->genome[0].program_length;
+
+    /* the order in which each active gene is run */
+    for (i = 0, instr = program; i < length; i++, instr += instr_size) {
+        position[instr[GPRC_INSTR_GENE]] = i;
+        if ((instr[GPRC_INSTR_FUNCTION_TYPE] == GPR_FUNCTION_GET) ||
+            (instr[GPRC_INSTR_FUNCTION_TYPE] == GPR_FUNCTION_SET) ||
+            (instr[GPRC_INSTR_FUNCTION_TYPE] == GPR_FUNCTION_CUSTOM)) {
+            /* these depend upon grid positions */
+            positional = 1;
+        }
+    }
+
+    for (i = 0, instr = program; i < length; i++, instr += instr_size) {
+        n = instr[GPRC_INSTR_GENE]*gene_size;
+        value[0] = instr[GPRC_INSTR_FUNCTION_TYPE];
+        value[1] = instr[GPRC_INSTR_ARGS];
+        value[2] = 0;
+        if (positional != 0) value[2] = instr[GPRC_INSTR_GENE];
+        hash = gpr_cache_hash(hash, value, 3*sizeof(int));
+        hash = gpr_cache_hash(hash, &gene[n+GPRC_GENE_CONSTANT],
+                              2*sizeof(float));
+        for (j = 0; j < instr[GPRC_INSTR_ARGS]; j++) {
+            src = instr[GPRC_INSTR_INITIAL+j];
+            value[0] = src;
+            if (src >= sensors) value[0] = sensors + position[src-sensors];
+            hash = gpr_cache_hash(hash, value, sizeof(int));
+            hash = gpr_cache_hash(hash,
+                                  &gene[n+GPRC_INITIAL+j+
+                                        connections_per_gene],
+                                  sizeof(float));
+        }
+    }
+
+    /* actuator connections */
+    n = rows*columns*gene_size;
+    for (i = 0; i < actuators; i++) {
+        src = (int)gene[n+i];
+        value[0] = src;
+        if (src >= sensors) value[0] = sensors + position[src-sensors];
+        hash = gpr_cache_hash(hash, value, sizeof(int));
+    }
+
+    /* sensor sources and actuator destinations */
+    if (f->no_of_sensor_sources > 0) {
+        hash = gpr_cache_hash(hash, f->sensor_source,
+                              sensors*sizeof(int));
+    }
+    if (f->no_of_actuator_destinations > 0) {
+        hash = gpr_cache_hash(hash, f->actuator_destination,
+                              actuators*sizeof(int));
+    }
+
+    if (hash == 0) hash = 1;
+    return hash;
 }
 
 /* Tries to convert code within the given module into
@@ -921,6 +1430,9 @@ int gprc_compress_ADF(gprc_function * f,
         return -2;
     }
 
+    /* the genome is about to be altered */
+    gprc_invalidate(f);
+
     n = (index - gprc_get_sensors(ADF_module,sensors)) *
         GPRC_GENE_SIZE(connections_per_gene);
     function_type = f->genome[ADF_module].gene[n];
@@ -1024,16 +1536,19 @@ void gprc_remove_ADFs(gprc_function * f,
             }
         }
     }
+    gprc_invalidate(f);
 }
 
-void gprc_valid_ADFs(gprc_function * f,
-                     int rows, int columns,
-                     int connections_per_gene,
-                     int sensors,
-                     float min_value, float max_value)
+/* Ensures that ADF calls are valid, and returns the number of
+   genes which were changed */
+int gprc_valid_ADFs(gprc_function * f,
+                    int rows, int columns,
+                    int connections_per_gene,
+                    int sensors,
+                    float min_value, float max_value)
 {
     int m, n, function_type, ADF_module_index;
-    int new_connection,row,col,previous_values;
+    int new_connection,row,col,previous_values,changes=0;
     float v;
 
     /*for (m = 0; m < f->ADF_modules+1; m++) {*/
@@ -1064,11 +1579,13 @@ void gprc_valid_ADFs(gprc_function * f,
                             previous_values;
                         f->genome[m].gene[n+GPRC_INITIAL] =
                             new_connection;
+                        changes++;
                     }
                     else {
                         v = f->genome[m].gene[n+GPRC_GENE_CONSTANT];
                         ADF_module_index =
                             1 + (abs((int)v) % f->ADF_modules);
+                        if (v != ADF_module_index-1) changes++;
                         f->genome[m].gene[n+GPRC_GENE_CONSTANT] =
                             ADF_module_index-1;
                         /*
@@ -1083,18 +1600,20 @@ void gprc_valid_ADFs(gprc_function * f,
             }
         }
     }
+    return changes;
 }
 
 /* for functions which have two inputs make sure that the
-   inputs are from different sources in some cases */
-static void gprc_ADF_valid_logical_operators(gprc_ADF_module * f,
-                                             int rows, int columns,
-                                             int connections_per_gene,
-                                             int sensors,
-                                             unsigned int * random_seed)
+   inputs are from different sources in some cases.
+   Returns the number of genes which were changed */
+static int gprc_ADF_valid_logical_operators(gprc_ADF_module * f,
+                                            int rows, int columns,
+                                            int connections_per_gene,
+                                            int sensors,
+                                            unsigned int * random_seed)
 {
     int row,col,n=0,previous_values,function_type,index;
-    int attempts,max;
+    int attempts,max,changes=0;
 
     for (col = 0; col < columns; col++) {
         previous_values = (col*rows) + sensors;
@@ -1116,6 +1635,7 @@ static void gprc_ADF_valid_logical_operators(gprc_ADF_module * f,
 
             /* look for connections which are the same */
             index = gprc_same_connections(&f->gene[n],max);
+            if (index > -1) changes++;
             attempts=0;
             while ((index>-1) && (attempts<5)) {
                 /* change the connection */
@@ -1129,35 +1649,40 @@ static void gprc_ADF_valid_logical_operators(gprc_ADF_module * f,
             }
         }
     }
+    return changes;
 }
 
 /* for functions which have two inputs make sure that the
-   inputs are from different sources in some cases */
-void gprc_valid_logical_operators(gprc_function * f,
-                                  int rows, int columns,
-                                  int connections_per_gene,
-                                  int sensors,
-                                  unsigned int * random_seed)
+   inputs are from different sources in some cases.
+   Returns the number of genes which were changed */
+int gprc_valid_logical_operators(gprc_function * f,
+                                 int rows, int columns,
+                                 int connections_per_gene,
+                                 int sensors,
+                                 unsigned int * random_seed)
 {
-    int m;
+    int m, changes = 0;
 
     for (m = 0; m < f->ADF_modules+1; m++) {
-        gprc_ADF_valid_logical_operators(&f->genome[m],
-                                         rows, columns,
-                                         connections_per_gene,
-                                         gprc_get_sensors(m,sensors),
-                                         random_seed);
-    }
+        changes +=
+            gprc_ADF_valid_logical_operators(&f->genome[m],
+                                             rows, columns,
+                                             connections_per_gene,
+                                             gprc_get_sensors(m,sensors),
+                                             random_seed);
+    }
+    return changes;
 }
 
-/* ensures that the output sources are unique */
-void gprc_unique_outputs(gprc_function * f,
-                         int rows, int columns,
-                         int connections_per_gene,
-                         int sensors, int actuators,
-                         unsigned int * random_seed)
+/* ensures that the output sources are unique, and returns the
+   number of output sources which were changed */
+int gprc_unique_outputs(gprc_function * f,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int sensors, int actuators,
+                        unsigned int * random_seed)
 {
-    int i,j,changes,attempts,m,act,sens;
+    int i,j,changes,attempts,m,act,sens,total=0;
     int n = rows*columns*GPRC_GENE_SIZE(connections_per_gene);
     float * gene;
     const int max_attempts = 20;
@@ -1184,9 +1709,11 @@ void gprc_unique_outputs(gprc_function * f,
                     }
                 }
             }
+            total += changes;
             attempts++;
         }
     }
+    return total;
 }
 
 /* forces the given individual to be valid */
@@ -1958,6 +2485,172 @@ static void gprc_mutation_permute(gprc_function * f,
     }
 }
 
+/* Applies a point mutation at the given position within the genome
+   of an ADF module.  Positions below the number of actuators are
+   output sources, and the rest index into the genes */
+static void gprc_mutate_position(gprc_function * f, int m, int index,
+                                 int rows, int columns,
+                                 int sensors, int actuators,
+                                 int connections_per_gene,
+                                 float min_value, float max_value,
+                                 int integers_only,
+                                 int * instruction_set,
+                                 int no_of_instructions)
+{
+    int function_type, call_ADF_module;
+    int locn, col, new_connection, gene_index, conn_index;
+    float * gene = f->genome[m].gene;
+    int step = GPRC_GENE_SIZE(connections_per_gene);
+    int act = gprc_get_actuators(m,actuators);
+    int sens = gprc_get_sensors(m,sensors);
+
+    if (index < act) {
+        /* mutate actuators */
+        gprc_set_output_source(f, m, rows, columns,
+                               connections_per_gene,
+                               index,
+                               sens + rand_num(&f->random_seed)%
+                               (rows*columns));
+    }
+    else {
+        index -= act;
+        locn = index % step;
+        /* first value */
+        if (locn == GPRC_GENE_FUNCTION_TYPE) {
+            /* function type */
+            function_type =
+                gpr_random_function(instruction_set,
+                                    no_of_instructions,
+                                    &f->random_seed);
+            if (function_type != GPR_FUNCTION_ADF) {
+                if (gene[index] == GPR_FUNCTION_ADF) {
+                    /* if this was previously an ADF
+                       then change the first connection
+                       back into the expected range */
+                    col =
+                        (index/
+                         GPRC_GENE_SIZE(connections_per_gene)) /
+                        rows;
+                    new_connection =
+                        rand_num(&f->random_seed)%
+                        ((col*rows) +
+                         gprc_get_sensors(m,sensors));
+                    gene[index+GPRC_INITIAL] = new_connection;
+                }
+                gene[index] = function_type;
+            }
+            else {
+                if ((m == 0) && (f->ADF_modules > 0)) {
+                    /* ADF module index */
+                    call_ADF_module =
+                        1 + (abs((int)gene[index+GPRC_GENE_CONSTANT])%
+                             f->ADF_modules);
+                    if (gprc_contains_ADFs(f, 0,
+                                           call_ADF_module,
+                                           rows, columns,
+                                           connections_per_gene,
+                                           sensors) != -1) {
+                        gene[index] = function_type;
+                        gene[index+GPRC_INITIAL] =
+                            get_ADF_args(f, call_ADF_module)-1;
+                    }
+                }
+            }
+        }
+        /* second value */
+        else if (locn < GPRC_INITIAL) {
+            /* value */
+            if (integers_only<=0) {
+                if (rand_num(&f->random_seed)%10000>5000) {
+                    /* incremental */
+                    gene[index] =
+                        gpr_mutate_value(gene[index]+0.01f,
+                                         GPR_MUTATE_VALUE_PERCENT,
+                                         &f->random_seed);
+                }
+                else {
+                    /* random */
+                    gene[index] =
+                        gpr_random_value(min_value, max_value,
+                                         &f->random_seed);
+                }
+            }
+            else {
+                if (rand_num(&f->random_seed)%10000>5000) {
+                    /* incremental */
+                    if (rand_num(&f->random_seed)%2==0) {
+                        gene[index] = (int)gene[index] + 1;
+                    }
+                    else {
+                        gene[index] = (int)gene[index] - 1;
+                    }
+                }
+                else {
+                    /* random */
+                    gene[index] =
+                        (int)gpr_random_value(min_value,
+                                              max_value,
+                                              &f->random_seed);
+                }
+            }
+        }
+        /* connections */
+        else {
+            function_type = (int)gene[index-GPRC_INITIAL];
+            if (!((function_type == GPR_FUNCTION_ADF) &&
+                  (index%step == GPRC_INITIAL) && (m == 0))) {
+                gene_index = index / step;
+                conn_index = index % step;
+                if (conn_index <
+                    GPRC_INITIAL+connections_per_gene) {
+                    /* connections */
+                    col = gene_index / rows;
+                    new_connection =
+                        rand_num(&f->random_seed)%
+                        ((col*rows) +
+                         gprc_get_sensors(m,sensors));
+                    gene[index] = new_connection;
+                }
+                else {
+                    /* weights */
+                    if (rand_num(&f->random_seed)%10000>5000) {
+                        /* incremental */
+                        gene[index] =
+                            gpr_mutate_value(gene[index]+0.01f,
+                                             GPR_MUTATE_VALUE_PERCENT,
+                                             &f->random_seed);
+                    }
+                    else {
+                        gene[index] =
+                            gpr_random_value(GPRC_MIN_WEIGHT,
+                                             GPRC_MIN_WEIGHT,
+                                             &f->random_seed);
+                    }
+                }
+            }
+            else {
+                /* ADF number of connections */
+                call_ADF_module =
+                    1 + (abs((int)gene[index-1])%f->ADF_modules);
+                gene[index] =
+                    get_ADF_args(f,call_ADF_module) - 1;
+                /* if there are no arguments then make
+                   this into a value function */
+                if (gene[index] < 0) {
+                    gene[index-GPRC_INITIAL] =
+                        GPR_FUNCTION_VALUE;
+                    col = (index / step) / rows;
+                    new_connection =
+                        rand_num(&f->random_seed)%
+                        ((col*rows) +
+                         gprc_get_sensors(m,sensors));
+                    gene[index] = new_connection;
+                }
+            }
+        }
+    }
+}
+
 /* mutates an individual */
 void gprc_mutate(gprc_function * f,
                  int rows, int columns,
@@ -1970,10 +2663,8 @@ void gprc_mutate(gprc_function * f,
                  int integers_only,
                  int * instruction_set, int no_of_instructions)
 {
-    int no_of_mutations,function_type,call_ADF_module;
-    int i,m,index,locn,col,new_connection;
-    int sens, act, gene_index, conn_index;
-    float * gene;
+    int no_of_mutations;
+    int i,m,index,act;
     int step = GPRC_GENE_SIZE(connections_per_gene);
 
     /* mutate sensor sources */
@@ -2021,157 +2712,18 @@ void gprc_mutate(gprc_function * f,
         }
 
         /* mutate the genome */
-        gene = f->genome[m].gene;
         act = gprc_get_actuators(m,actuators);
-        sens = gprc_get_sensors(m,sensors);
         for (i = 0; i < no_of_mutations; i++) {
             /* pick a gene at random */
             index =
                 rand_num(&f->random_seed)%(rows*columns*step + act);
-            if (index < act) {
-                /* mutate actuators */
-                gprc_set_output_source(f, m, rows, columns,
-                                       connections_per_gene,
-                                       index,
-                                       sens + rand_num(&f->random_seed)%
-                                       (rows*columns));
-            }
-            else {
-                index -= act;
-                locn = index % step;
-                /* first value */
-                if (locn == GPRC_GENE_FUNCTION_TYPE) {
-                    /* function type */
-                    function_type =
-                        gpr_random_function(instruction_set,
-                                            no_of_instructions,
-                                            &f->random_seed);
-                    if (function_type != GPR_FUNCTION_ADF) {
-                        if (gene[index] == GPR_FUNCTION_ADF) {
-                            /* if this was previously an ADF
-                               then change the first connection
-                               back into the expected range */
-                            col =
-                                (index/
-                                 GPRC_GENE_SIZE(connections_per_gene)) /
-                                rows;
-                            new_connection =
-                                rand_num(&f->random_seed)%
-                                ((col*rows) +
-                                 gprc_get_sensors(m,sensors));
-                            gene[index+GPRC_INITIAL] = new_connection;
-                        }
-                        gene[index] = function_type;
-                    }
-                    else {
-                        if ((m == 0) && (f->ADF_modules > 0)) {
-                            /* ADF module index */
-                            call_ADF_module =
-                                1 + (abs((int)gene[index+GPRC_GENE_CONSTANT])%
-                                     f->ADF_modules);
-                            if (gprc_contains_ADFs(f, 0,
-                                                   call_ADF_module,
-                                                   rows, columns,
-                                                   connections_per_gene,
-                                                   sensors) != -1) {
-                                gene[index] = function_type;
-                                gene[index+GPRC_INITIAL] =
-                                    get_ADF_args(f, call_ADF_module)-1;
-                            }
-                        }
-                    }
-                }
-                /* second value */
-                else if (locn < GPRC_INITIAL) {
-                    /* value */
-                    if (integers_only<=0) {
-                        if (rand_num(&f->random_seed)%10000>5000) {
-                            /* incremental */
-                            gene[index] =
-                                gpr_mutate_value(gene[index]+0.01f,
-                                                 GPR_MUTATE_VALUE_PERCENT,
-                                                 &f->random_seed);
-                        }
-                        else {
-                            /* random */
-                            gene[index] =
-                                gpr_random_value(min_value, max_value,
-                                                 &f->random_seed);
-                        }
-                    }
-                    else {
-                        if (rand_num(&f->random_seed)%10000>5000) {
-                            /* incremental */
-                            if (rand_num(&f->random_seed)%2==0) {
-                                gene[index] = (int)gene[index] + 1;
-                            }
-                            else {
-                                gene[index] = (int)gene[index] - 1;
-                            }
-                        }
-                        else {
-                            /* random */
-                            gene[index] =
-                                (int)gpr_random_value(min_value,
-                                                      max_value,
-                                                      &f->random_seed);
-                        }
-                    }
-                }
-                /* connections */
-                else {
-                    function_type = (int)gene[index-GPRC_INITIAL];
-                    if (!((function_type == GPR_FUNCTION_ADF) &&
-                          (index%step == GPRC_INITIAL) && (m == 0))) {
-                        gene_index = index / step;
-                        conn_index = index % step;
-                        if (conn_index <
-                            GPRC_INITIAL+connections_per_gene) {
-                            /* connections */
-                            col = gene_index / rows;
-                            new_connection =
-                                rand_num(&f->random_seed)%
-                                ((col*rows) +
-                                 gprc_get_sensors(m,sensors));
-                            gene[index] = new_connection;
-                        }
-                        else {
-                            /* weights */
-                            if (rand_num(&f->random_seed)%10000>5000) {
-                                /* incremental */
-                                gene[index] =
-                                    gpr_mutate_value(gene[index]+0.01f,
-                                                     GPR_MUTATE_VALUE_PERCENT,
-                                                     &f->random_seed);
-                            }
-                            else {
-                                gene[index] =
-                                    gpr_random_value(GPRC_MIN_WEIGHT,
-                                                     GPRC_MIN_WEIGHT,
-                                                     &f->random_seed);
-                            }
-                        }
-                    }
-                    else {
-                        /* ADF number of connections */
-                        call_ADF_module =
-                            1 + (abs((int)gene[index-1])%f->ADF_modules);
-                        gene[index] =
-                            get_ADF_args(f,call_ADF_module) - 1;
-                        /* if there are no arguments then make
-                           this into a value function */
-                        if (gene[index] < 0) {
-                            gene[index-GPRC_INITIAL] =
-                                GPR_FUNCTION_VALUE;
-                            new_connection =
-                                rand_num(&f->random_seed)%
-                                ((col*rows) +
-                                 gprc_get_sensors(m,sensors));
-                            gene[index] = new_connection;
-                        }
-                    }
-                }
-            }
+            gprc_mutate_position(f, m, index,
+                                 rows, columns,
+                                 sensors, actuators,
+                                 connections_per_gene,
+                                 min_value, max_value,
+                                 integers_only,
+                                 instruction_set, no_of_instructions);
         }
     }
 
@@ -2193,6 +2745,101 @@ void gprc_mutate(gprc_function * f,
                     connections_per_gene,
                     sensors,
                     min_value, max_value);
+
+    /* the compiled programs are now out of date */
+    gprc_invalidate(f);
+}
+
+/* Mutates randomly chosen positions until one of them changes a gene
+   which is used, or an output source.  This avoids spending an
+   evaluation upon a child which behaves the same as its parent,
+   while still allowing the unused genes to drift.
+   The used genes need to be up to date beforehand, and are
+   updated afterwards.  Changes to unused genes don't alter which
+   genes are used, so only the one used gene which was mutated
+   needs to be traced again */
+void gprc_mutate_active(gprc_function * f,
+                        int rows, int columns,
+                        int sensors, int actuators,
+                        int connections_per_gene,
+                        float min_value, float max_value,
+                        int integers_only,
+                        int * instruction_set, int no_of_instructions)
+{
+    int i, m, index, position, act, sens, active, repairs;
+    int step = GPRC_GENE_SIZE(connections_per_gene);
+    int genes = rows*columns;
+    float previous;
+
+    for (i = 0; i < GPRC_ACTIVE_MUTATION_TRIES; i++) {
+        m = rand_num(&f->random_seed)%(f->ADF_modules+1);
+        act = gprc_get_actuators(m,actuators);
+        sens = gprc_get_sensors(m,sensors);
+        index = rand_num(&f->random_seed)%(genes*step + act);
+
+        /* position of the value within the genome */
+        if (index < act) {
+            position = genes*step + index;
+            active = 1;
+        }
+        else {
+            position = index - act;
+            active = f->genome[m].used[sens + (position/step)];
+        }
+
+        previous = f->genome[m].gene[position];
+        gprc_mutate_position(f, m, index,
+                             rows, columns,
+                             sensors, actuators,
+                             connections_per_gene,
+                             min_value, max_value,
+                             integers_only,
+                             instruction_set, no_of_instructions);
+        if ((active != 0) && (f->genome[m].gene[position] != previous)) {
+            break;
+        }
+    }
+
+    /* make sure thet output sources are unique */
+    repairs =
+        gprc_unique_outputs(f, rows, columns, connections_per_gene,
+                            sensors, actuators, &f->random_seed);
+
+    /* ensure that any logical operators have valid inputs */
+    repairs +=
+        gprc_valid_logical_operators(f, rows, columns,
+                                     connections_per_gene,
+                                     sensors, &f->random_seed);
+
+    /* ensure that ADF calls are valid */
+    repairs +=
+        gprc_valid_ADFs(f, rows, columns,
+                        connections_per_gene,
+                        sensors,
+                        min_value, max_value);
+
+    if (repairs > 0) {
+        /* any gene may have changed */
+        gprc_used_functions(f, rows, columns,
+                            connections_per_gene,
+                            sensors, actuators);
+    }
+    else if (i < GPRC_ACTIVE_MUTATION_TRIES) {
+        if (index < act) {
+            /* an output source changed */
+            gprc_used_genes(&f->genome[m], rows, columns,
+                            connections_per_gene, sens, act);
+        }
+        else {
+            gprc_retrace_gene(f, m, (index - act)/step,
+                              rows, columns,
+                              connections_per_gene,
+                              sensors, actuators);
+        }
+    }
+
+    /* the compiled programs are now out of date */
+    gprc_invalidate(f);
 }
 
 /* validate the genome */
@@ -2332,7 +2979,9 @@ int gprc_validate(gprc_function * f,
     return GPR_VALIDATE_OK;
 }
 
-/* runs an ADF */
+/* runs an ADF.  If the ADF module has no side effects then it only
+   needs to be run once, and if it was last called with the same
+   arguments during this time step then the previous result is used */
 static void gprc_c_run_ADF(gprc_function * f,
                            int ADF_module, int i,
                            float * gp,
@@ -2343,9 +2992,12 @@ static void gprc_c_run_ADF(gprc_function * f,
                            float (*custom_function)(float,float,float),
                            int integers_only)
 {
-    int call_ADF_module,itt,s,sens,argc=1,used_ctr;
+    int call_ADF_module,itt,s,sens,argc=1,used_ctr,runs=2;
     float * ADF_state, * state;
+    float arg[GPRC_MAX_ADF_MODULE_SENSORS];
     unsigned char * ADF_used;
+    int * program;
+    gprc_ADF_module * module;
 
     if ((ADF_module != 0) || (f->ADF_modules == 0)) return;
 
@@ -2355,6 +3007,7 @@ static void gprc_c_run_ADF(gprc_function * f,
     /* index of the ADF_module */
     call_ADF_module =
         1 + (abs((int)gp[GPRC_GENE_CONSTANT])%f->ADF_modules);
+    module = &f->genome[call_ADF_module];
 
     /* get the number of arguments for the ADF */
     argc = 1 + ((abs((int)gp[GPRC_INITIAL]))%
@@ -2363,33 +3016,61 @@ static void gprc_c_run_ADF(gprc_function * f,
         argc = connections_per_gene-1;
     }
 
+    for (s = 0; s < argc; s++) {
+        if (integers_only < 1) {
+            arg[s] = state[(int)gp[1+GPRC_INITIAL+s]];
+        }
+        else {
+            arg[s] = (int)state[(int)gp[1+GPRC_INITIAL+s]];
+        }
+    }
+
+    program = gprc_compiled_program(f, call_ADF_module, rows, columns,
+                                    connections_per_gene, sensors,
+                                    dynamic);
+    if ((dropout_prob <= 0) && (program != NULL) &&
+        (module->program_pure != 0)) {
+        runs = 1;
+
+        /* the same call as last time */
+        if (module->call_args == argc) {
+            for (s = 0; s < argc; s++) {
+                if (module->call_arg[s] != arg[s]) break;
+            }
+            if (s == argc) {
+                state[sens+i] = module->call_result;
+                return;
+            }
+        }
+    }
+
     /* clear the values of all ADF sensors to avoid
        any residue from previous calls */
-    memset((void*)f->genome[call_ADF_module].state,'\0',
+    memset((void*)module->state,'\0',
            GPRC_MAX_ADF_MODULE_SENSORS*sizeof(float));
 
     /* set the inputs to the ADF_module */
-    ADF_used = f->genome[call_ADF_module].used;
-    ADF_state = f->genome[call_ADF_module].state;
-    used_ctr = 0;
-    for (s = 0; s < argc; s++) {
-        /* proceed to the next used ADF argument */
-        while (ADF_used[used_ctr]==0) {
-            used_ctr++;
-        }
-        if (integers_only < 1) {
-            ADF_state[used_ctr] =
-                state[(int)gp[1+GPRC_INITIAL+s]];
+    ADF_used = module->used;
+    ADF_state = module->state;
+    if ((program != NULL) && (argc <= module->arguments)) {
+        for (s = 0; s < argc; s++) {
+            ADF_state[module->argument[s]] = arg[s];
         }
-        else {
-            ADF_state[used_ctr] =
-                (int)state[(int)gp[1+GPRC_INITIAL+s]];
+    }
+    else {
+        used_ctr = 0;
+        for (s = 0; s < argc; s++) {
+            /* proceed to the next used ADF argument */
+            while (ADF_used[used_ctr]==0) {
+                used_ctr++;
+            }
+            ADF_state[used_ctr] = arg[s];
+            used_ctr++;
         }
-        used_ctr++;
     }
 
     /* run the ADF_module */
-    for (itt = 0; itt < 2; itt++) {
+    for (itt = 0; itt < runs; itt++) {
         if (integers_only < 1) {
             gprc_run_float(f, call_ADF_module,
                            rows, columns,
@@ -2415,6 +3096,24 @@ static void gprc_c_run_ADF(gprc_function * f,
     if (integers_only > 0) {
         state[sens+i] = (int)state[sens+i];
     }
+
+    /* remember the call */
+    if (runs == 1) {
+        module->call_args = argc;
+        for (s = 0; s < argc; s++) {
+            module->call_arg[s] = arg[s];
+        }
+        module->call_result = state[sens+i];
+    }
+}
+
+/* forgets the results of previous ADF calls, so that
+   a new time step starts afresh */
+static void gprc_clear_ADF_calls(gprc_function * f)
+{
+    for (int m = 1; m < f->ADF_modules+1; m++) {
+        f->genome[m].call_args = -1;
+    }
 }
 
 /* run an individual */
@@ -2427,11 +3126,16 @@ void gprc_run_float(gprc_function * f,
                     int dynamic,
                     float (*custom_function)(float,float,float))
 {
-    int row,col,n=0,i=0,j,k,g,ctr,src,dest,no_of_args;
+    int n=0,i=0,j,k,g,ctr,src,dest,no_of_args,instr_index;
+    int no_of_instructions, function_type;
+    int * program, * instr, * con;
+    int decoded[connections_per_gene];
     float * gp, a, b, c, d, a2, b2;
     int gene_size = GPRC_GENE_SIZE(connections_per_gene);
     int block_from, block_to, act, no_of_states;
-    int dropout = (int)(dropout_prob*10000);
+    unsigned int dropout = gprc_dropout_threshold(dropout_prob);
+    unsigned long long dropout_key = 0, dropout_hash = 0;
+    int dropout_index = -1;
     int sens = gprc_get_sensors(ADF_module,sensors);
     float * gene = f->genome[ADF_module].gene;
     unsigned char * used = f->genome[ADF_module].used;
@@ -2440,8 +3144,35 @@ void gprc_run_float(gprc_function * f,
     act = gprc_get_actuators(ADF_module,actuators);
     no_of_states = (rows*columns) + sens + act;
 
-    for (col = 0; col < columns; col++) {
-        for (row = 0; row < rows; row++, i++,n+=gene_size) {
+    /* each run of the main program is a new time step */
+    if (ADF_module == 0) gprc_clear_ADF_calls(f);
+
+    /* if possible run only the compiled list of used genes */
+    program = gprc_compiled_program(f, ADF_module, rows, columns,
+                                    connections_per_gene, sensors,
+                                    dynamic);
+    no_of_instructions = rows*columns;
+    if (program) {
+        no_of_instructions = f->genome[ADF_module].program_length;
+    }
+
+    /* a different set of genes is dropped on each run */
+    if (dropout > 0) dropout_key = rand_num(&f->random_seed);
+
+    for (instr_index = 0; instr_index < no_of_instructions;
+         instr_index++) {
+        if (program) {
+            instr = &program[instr_index *
+                             GPRC_INSTR_SIZE(connections_per_gene)];
+            i = instr[GPRC_INSTR_GENE];
+            n = i * gene_size;
+            function_type = instr[GPRC_INSTR_FUNCTION_TYPE];
+            no_of_args = instr[GPRC_INSTR_ARGS];
+            con = &instr[GPRC_INSTR_INITIAL];
+        }
+        else {
+            i = instr_index;
+            n = i * gene_size;
 
             /* if this function is not on the path
                between sensors and actuators then skip it
@@ -2450,662 +3181,664 @@ void gprc_run_float(gprc_function * f,
                 continue;
             }
 
-            /* occasional dropout helps to avoid overfitting*/
-            if (rand_num(&f->random_seed)%10000<dropout) continue;
-
-            gp = &gene[n];
-            switch((int)gp[GPRC_GENE_FUNCTION_TYPE]) {
-            case GPR_FUNCTION_DATA_PUSH: {
-                if ((f->data.size > 0) && (f->data.fields > 0)) {
-                    gpr_data_set_head(&f->data,
-                                      ((unsigned int)state[(int)gp[GPRC_INITIAL]])%f->data.fields,
-                                      state[(int)gp[GPRC_INITIAL+1]],
-                                      state[(int)gp[GPRC_INITIAL+1]+no_of_states]);
-                    gpr_data_push(&f->data);
-                }
-                break;
+            /* decode the gene, which may have been
+               altered by a previous dynamic function */
+            function_type = (int)gene[n+GPRC_GENE_FUNCTION_TYPE];
+            no_of_args =
+                gprc_function_args(function_type,
+                                   gene[n+GPRC_GENE_CONSTANT],
+                                   connections_per_gene,
+                                   (int)gene[n+GPRC_INITIAL]);
+            for (j = 0; j < connections_per_gene; j++) {
+                decoded[j] = (int)gene[n+GPRC_INITIAL+j];
             }
-            case GPR_FUNCTION_DATA_POP: {
-                if ((f->data.size > 0) && (f->data.fields > 0)) {
-                    gpr_data_get_tail(&f->data,
-                                      ((unsigned int)state[(int)gp[GPRC_INITIAL]])%f->data.fields,
-                                      &state[sens+i],
-                                      &state[sens+i+no_of_states]);
-                    gpr_data_pop(&f->data);
-                }
-                break;
+            con = decoded;
+        }
+
+        /* occasional dropout helps to avoid overfitting*/
+        if ((dropout > 0) &&
+            gprc_dropout_gene(dropout_key, dropout, instr_index,
+                              &dropout_index, &dropout_hash)) {
+            continue;
+        }
+
+        gp = &gene[n];
+        switch(function_type) {
+        case GPR_FUNCTION_DATA_PUSH: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_set_head(&f->data,
+                                  ((unsigned int)state[con[0]])%f->data.fields,
+                                  state[con[1]],
+                                  state[con[1]+no_of_states]);
+                gpr_data_push(&f->data);
             }
-            case GPR_FUNCTION_DATA_GET: {
-                if ((f->data.size > 0) && (f->data.fields > 0)) {
-                    gpr_data_get_elem(&f->data,
-                                      (unsigned int)state[(int)gp[GPRC_INITIAL]],
-                                      ((unsigned int)state[(int)gp[GPRC_INITIAL+1]])%(f->data.fields),
-                                      &state[sens+i],
-                                      &state[sens+i+no_of_states]);
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_DATA_POP: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_get_tail(&f->data,
+                                  ((unsigned int)state[con[0]])%f->data.fields,
+                                  &state[sens+i],
+                                  &state[sens+i+no_of_states]);
+                gpr_data_pop(&f->data);
             }
-            case GPR_FUNCTION_DATA_SET: {
-                if ((f->data.size > 0) && (f->data.fields > 0)) {
-                    gpr_data_set_elem(&f->data,
-                                      (unsigned int)state[(int)gp[GPRC_INITIAL]],
-                                      ((unsigned int)state[(int)gp[GPRC_INITIAL+1]])%(f->data.fields),
-                                      state[sens+i],
-                                      state[sens+i+no_of_states]);
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_DATA_GET: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_get_elem(&f->data,
+                                  (unsigned int)state[con[0]],
+                                  ((unsigned int)state[con[1]])%(f->data.fields),
+                                  &state[sens+i],
+                                  &state[sens+i+no_of_states]);
             }
-            case GPR_FUNCTION_GET: {
-                j = abs((int)state[(int)gp[GPRC_INITIAL]] +
-                        (int)state[(int)gp[1+GPRC_INITIAL]])
-                    %(rows*columns);
-                state[sens+i] = state[sens+j];
-                state[sens+i+no_of_states] =
-                    state[sens+j+no_of_states];
-                break;
+            break;
+        }
+        case GPR_FUNCTION_DATA_SET: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_set_elem(&f->data,
+                                  (unsigned int)state[con[0]],
+                                  ((unsigned int)state[con[1]])%(f->data.fields),
+                                  state[sens+i],
+                                  state[sens+i+no_of_states]);
             }
-            case GPR_FUNCTION_SET: {
-                j = abs((int)state[(int)gp[1+GPRC_INITIAL]])
-                    %(rows*columns);
-                state[sens+i] = gp[GPRC_GENE_CONSTANT]*
-                    state[(int)gp[GPRC_INITIAL]];
-                state[sens+i+no_of_states] =
-                    gp[GPRC_GENE_CONSTANT]*
-                    state[(int)gp[GPRC_INITIAL]+no_of_states];
-                state[sens+j] = state[sens+i];
+            break;
+        }
+        case GPR_FUNCTION_GET: {
+            j = abs((int)state[con[0]] +
+                    (int)state[con[1]])
+                %(rows*columns);
+            state[sens+i] = state[sens+j];
+            state[sens+i+no_of_states] =
+                state[sens+j+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_SET: {
+            j = abs((int)state[con[1]])
+                %(rows*columns);
+            state[sens+i] = gp[GPRC_GENE_CONSTANT]*
+                state[con[0]];
+            state[sens+i+no_of_states] =
+                gp[GPRC_GENE_CONSTANT]*
+                state[con[0]+no_of_states];
+            state[sens+j] = state[sens+i];
+            state[sens+j+no_of_states] =
+                state[sens+i+no_of_states];
+            if (state[sens+j] > GPR_MAX_CONSTANT) {
+                state[sens+j] = GPR_MAX_CONSTANT;
+            }
+            if (state[sens+j+no_of_states] >
+                GPR_MAX_CONSTANT) {
                 state[sens+j+no_of_states] =
-                    state[sens+i+no_of_states];
-                if (state[sens+j] > GPR_MAX_CONSTANT) {
-                    state[sens+j] = GPR_MAX_CONSTANT;
-                }
-                if (state[sens+j+no_of_states] >
-                    GPR_MAX_CONSTANT) {
-                    state[sens+j+no_of_states] =
-                        GPR_MAX_CONSTANT;
-                }
-                if (state[sens+j] < -GPR_MAX_CONSTANT) {
-                    state[sens+j] = -GPR_MAX_CONSTANT;
-                }
-                if (state[sens+j+no_of_states] <
-                    -GPR_MAX_CONSTANT) {
-                    state[sens+j+no_of_states] =
-                        -GPR_MAX_CONSTANT;
-                }
-                break;
-            }
-            case GPR_FUNCTION_ADF: {
-                gprc_c_run_ADF(f, ADF_module, i,
-                               gp, rows, columns,
-                               connections_per_gene,
-                               sensors, actuators,
-                               dropout_prob, dynamic,
-                               (*custom_function),0);
-                break;
+                    GPR_MAX_CONSTANT;
             }
-            case GPR_FUNCTION_CUSTOM: {
-                if (*custom_function) {
-                    state[sens+i] =
-                        (*custom_function)(gp[GPRC_GENE_CONSTANT],
-                                           gp[GPRC_INITIAL],
-                                           gp[GPRC_GENE_CONSTANT]);
-                }
-                break;
+            if (state[sens+j] < -GPR_MAX_CONSTANT) {
+                state[sens+j] = -GPR_MAX_CONSTANT;
             }
-            case GPR_FUNCTION_VALUE: {
-                state[sens+i] = gp[GPRC_GENE_CONSTANT];
-                state[sens+i+no_of_states] =
-                    gp[GPRC_GENE_IMAGINARY];
-                break;
+            if (state[sens+j+no_of_states] <
+                -GPR_MAX_CONSTANT) {
+                state[sens+j+no_of_states] =
+                    -GPR_MAX_CONSTANT;
             }
-            case GPR_FUNCTION_SIGMOID: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                state[sens+i] = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    state[sens+i] +=
-                        state[(int)gp[GPRC_INITIAL+j]]*
-                        gp[GPRC_INITIAL+j+connections_per_gene];
-                }
-
+            break;
+        }
+        case GPR_FUNCTION_ADF: {
+            gprc_c_run_ADF(f, ADF_module, i,
+                           gp, rows, columns,
+                           connections_per_gene,
+                           sensors, actuators,
+                           dropout_prob, dynamic,
+                           (*custom_function),0);
+            break;
+        }
+        case GPR_FUNCTION_CUSTOM: {
+            if (*custom_function) {
                 state[sens+i] =
-                    1.0f / (1.0f + exp(-state[sens+i]));
-                break;
+                    (*custom_function)(gp[GPRC_GENE_CONSTANT],
+                                       gp[GPRC_INITIAL],
+                                       gp[GPRC_GENE_CONSTANT]);
+            }
+            break;
+        }
+        case GPR_FUNCTION_VALUE: {
+            state[sens+i] = gp[GPRC_GENE_CONSTANT];
+            state[sens+i+no_of_states] =
+                gp[GPRC_GENE_IMAGINARY];
+            break;
+        }
+        case GPR_FUNCTION_SIGMOID: {
+            state[sens+i] = 0;
+            for (j = 0; j < no_of_args; j++) {
+                state[sens+i] +=
+                    state[con[j]]*
+                    gp[GPRC_INITIAL+j+connections_per_gene];
             }
-            case GPR_FUNCTION_ADD: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                /* a is the real part, b is the imaginary part */
-                a = 0; b = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    k = (int)gp[GPRC_INITIAL+j];
-                    c = state[k];
-                    d = state[k + no_of_states];
-                    a += c;
-                    b += d;
+
+            state[sens+i] =
+                1.0f / (1.0f + exp(-state[sens+i]));
+            break;
+        }
+        case GPR_FUNCTION_ADD: {
+            /* a is the real part, b is the imaginary part */
+            a = 0; b = 0;
+            for (j = 0; j < no_of_args; j++) {
+                k = con[j];
+                c = state[k];
+                d = state[k + no_of_states];
+                a += c;
+                b += d;
+            }
+            state[sens+i] = a;
+            state[sens+i+no_of_states] = b;
+            break;
+        }
+        case GPR_FUNCTION_SUBTRACT: {
+            /* a is the real part, b is the imaginary part */
+            a = 0; b = 0;
+            for (j = 0; j < no_of_args; j++) {
+                k = con[j];
+                c = state[k];
+                d = state[k + no_of_states];
+                if (j > 0) {
+                    a -= c;
+                    b -= d;
+                }
+                else {
+                    a = c;
+                    b = d;
                 }
-                state[sens+i] = a;
-                state[sens+i+no_of_states] = b;
-                break;
             }
-            case GPR_FUNCTION_SUBTRACT: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                /* a is the real part, b is the imaginary part */
-                a = 0; b = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    k = (int)gp[GPRC_INITIAL+j];
-                    c = state[k];
-                    d = state[k + no_of_states];
-                    if (j > 0) {
-                        a -= c;
-                        b -= d;
-                    }
-                    else {
-                        a = c;
-                        b = d;
-                    }
+            state[sens+i] = a;
+            state[sens+i+no_of_states] = b;
+            break;
+        }
+        case GPR_FUNCTION_NEGATE: {
+            state[sens+i] = -state[con[0]];
+            state[sens+i+no_of_states] =
+                -state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_MULTIPLY: {
+            /* a is the real part, b is the imaginary part */
+            a = 0; b = 0;
+            for (j = 0; j < no_of_args; j++) {
+                k = con[j];
+                c = state[k];
+                d = state[k + no_of_states];
+                if (j > 0) {
+                    a2 = (a*c) + (b*d);
+                    b2 = (b*c) + (a*d);
+                    a = a2;
+                    b = b2;
+                }
+                else {
+                    a = c;
+                    b = d;
                 }
-                state[sens+i] = a;
-                state[sens+i+no_of_states] = b;
-                break;
             }
-            case GPR_FUNCTION_NEGATE: {
-                state[sens+i] = -state[(int)gp[GPRC_INITIAL]];
-                state[sens+i+no_of_states] =
-                    -state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+            state[sens+i] = a;
+            state[sens+i+no_of_states] = b;
+            break;
+        }
+        case GPR_FUNCTION_WEIGHT: {
+            state[sens+i] = state[con[0]] *
+                gp[GPRC_GENE_CONSTANT];
+            state[sens+i+no_of_states] =
+                state[con[0]+no_of_states] *
+                gp[GPRC_GENE_CONSTANT];
+            break;
+        }
+        case GPR_FUNCTION_DIVIDE: {
+            j = con[0];
+            k = con[1];
+            if((state[k] <= 1e-1) &&
+               (state[k] >= -1e-1)) {
+                /* if the real denominator is close to zero
+                   then just pass through */
+                state[sens+i] = state[j];
+                state[sens+i+no_of_states] = state[k];
             }
-            case GPR_FUNCTION_MULTIPLY: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                /* a is the real part, b is the imaginary part */
-                a = 0; b = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    k = (int)gp[GPRC_INITIAL+j];
-                    c = state[k];
-                    d = state[k + no_of_states];
-                    if (j > 0) {
-                        a2 = (a*c) + (b*d);
-                        b2 = (b*c) + (a*d);
-                        a = a2;
-                        b = b2;
-                    }
-                    else {
-                        a = c;
-                        b = d;
-                    }
-                }
-                state[sens+i] = a;
-                state[sens+i+no_of_states] = b;
-                break;
+            else {
+                /* a is the real part of numerator,
+                   b is the imaginary part or numerator */
+                a = state[j];
+                b = state[j + no_of_states];
+                /* c is the real part of denominator,
+                   d is the imaginary part or denominator */
+                c = state[k];
+                d = state[k + no_of_states];
+                /* calculate the real value */
+                state[sens+i] =
+                    ((a*c) + (b*d)) / ((c*c) + (d*d));
+                /* calculate the imaginary value */
+                state[sens+i+no_of_states] =
+                    ((b*c) - (a*d)) / ((c*c) + (d*d));
             }
-            case GPR_FUNCTION_WEIGHT: {
-                state[sens+i] = state[(int)gp[GPRC_INITIAL]] *
-                    gp[GPRC_GENE_CONSTANT];
+            break;
+        }
+        case GPR_FUNCTION_MODULUS: {
+            if (fabs(state[con[1]]) <= -1e-1) {
+                /* if the denominator is close to zero */
+                state[sens+i] = state[con[0]];
                 state[sens+i+no_of_states] =
-                    state[(int)gp[GPRC_INITIAL]+no_of_states] *
-                    gp[GPRC_GENE_CONSTANT];
-                break;
+                    state[con[0]+no_of_states];
             }
-            case GPR_FUNCTION_DIVIDE: {
-                j = (int)gp[GPRC_INITIAL];
-                k = (int)gp[1+GPRC_INITIAL];
-                if((state[k] <= 1e-1) &&
-                   (state[k] >= -1e-1)) {
-                    /* if the real denominator is close to zero
-                       then just pass through */
-                    state[sens+i] = state[j];
-                    state[sens+i+no_of_states] = state[k];
+            else {
+                /* a is the real part of numerator,
+                   b is the imaginary part or numerator */
+                a = state[con[0]];
+                b = state[con[0]+no_of_states];
+                /* c is the real part of denominator,
+                   d is the imaginary part or denominator */
+                c = state[con[1]];
+                d = state[con[1]+no_of_states];
+                if (b+d == 0) {
+                    /* if there are no imaginary components */
+                    state[sens+i] = fmod(a,c);
+                    state[sens+i+no_of_states] = 0;
                 }
                 else {
-                    /* a is the real part of numerator,
-                       b is the imaginary part or numerator */
-                    a = state[j];
-                    b = state[j + no_of_states];
-                    /* c is the real part of denominator,
-                       d is the imaginary part or denominator */
-                    c = state[k];
-                    d = state[k + no_of_states];
-                    /* calculate the real value */
+                    /* the meaning of "modulus" here is what
+                       remains when (a+ib) is divided by
+                       (c + id) */
                     state[sens+i] =
-                        ((a*c) + (b*d)) / ((c*c) + (d*d));
-                    /* calculate the imaginary value */
-                    state[sens+i+no_of_states] =
-                        ((b*c) - (a*d)) / ((c*c) + (d*d));
-                }
-                break;
-            }
-            case GPR_FUNCTION_MODULUS: {
-                if (fabs(state[(int)gp[1+GPRC_INITIAL]]) <= -1e-1) {
-                    /* if the denominator is close to zero */
-                    state[sens+i] = state[(int)gp[GPRC_INITIAL]];
+                        fmod(((a*c) + (b*d)), ((c*c) + (d*d)));
                     state[sens+i+no_of_states] =
-                        state[(int)gp[GPRC_INITIAL]+no_of_states];
-                }
-                else {
-                    /* a is the real part of numerator,
-                       b is the imaginary part or numerator */
-                    a = state[(int)gp[GPRC_INITIAL]];
-                    b = state[(int)gp[GPRC_INITIAL]+no_of_states];
-                    /* c is the real part of denominator,
-                       d is the imaginary part or denominator */
-                    c = state[(int)gp[1+GPRC_INITIAL]];
-                    d = state[(int)gp[1+GPRC_INITIAL]+no_of_states];
-                    if (b+d == 0) {
-                        /* if there are no imaginary components */
-                        state[sens+i] = fmod(a,c);
-                        state[sens+i+no_of_states] = 0;
-                    }
-                    else {
-                        /* the meaning of "modulus" here is what
-                           remains when (a+ib) is divided by
-                           (c + id) */
-                        state[sens+i] =
-                            fmod(((a*c) + (b*d)), ((c*c) + (d*d)));
-                        state[sens+i+no_of_states] =
-                            fmod(((b*c) - (a*d)), ((c*c) + (d*d)));
-                    }
+                        fmod(((b*c) - (a*d)), ((c*c) + (d*d)));
                 }
-                break;
             }
-            case GPR_FUNCTION_FLOOR: {
-                state[sens+i] = floor(state[(int)gp[GPRC_INITIAL]]);
+            break;
+        }
+        case GPR_FUNCTION_FLOOR: {
+            state[sens+i] = floor(state[con[0]]);
+            state[sens+i+no_of_states] =
+                floor(state[con[0]+no_of_states]);
+            break;
+        }
+        case GPR_FUNCTION_AVERAGE: {
+            state[sens+i] = state[con[0]];
+            state[sens+i+no_of_states] =
+                state[con[0]+no_of_states];
+            for (j = 1; j < no_of_args; j++) {
+                state[sens+i] += state[con[j]];
+                state[sens+i+no_of_states] +=
+                    state[con[j]+no_of_states];
+            }
+            state[sens+i] /= no_of_args;
+            state[sens+i+no_of_states] /= no_of_args;
+            break;
+        }
+        case GPR_FUNCTION_NOOP1: {
+            state[sens+i] = state[con[0]];
+            state[sens+i+no_of_states] =
+                state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_NOOP2: {
+            state[sens+i] = state[con[0]];
+            state[sens+i+no_of_states] =
+                state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_NOOP3: {
+            state[sens+i] = state[con[0]];
+            state[sens+i+no_of_states] =
+                state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_NOOP4: {
+            state[sens+i] = state[con[0]];
+            state[sens+i+no_of_states] =
+                state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_GREATER_THAN: {
+            if (state[con[0]] >
+                state[con[1]]) {
+                state[sens+i] = gp[GPRC_GENE_CONSTANT];
                 state[sens+i+no_of_states] =
-                    floor(state[(int)gp[GPRC_INITIAL]+no_of_states]);
-                break;
+                    gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_AVERAGE: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                state[sens+i] = state[(int)gp[GPRC_INITIAL]];
-                state[sens+i+no_of_states] =
-                    state[(int)gp[GPRC_INITIAL]+no_of_states];
-                for (j = 1; j < no_of_args; j++) {
-                    state[sens+i] += state[(int)gp[GPRC_INITIAL+j]];
-                    state[sens+i+no_of_states] +=
-                        state[(int)gp[GPRC_INITIAL+j]+no_of_states];
-                }
-                state[sens+i] /= no_of_args;
-                state[sens+i+no_of_states] /= no_of_args;
-                break;
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_NOOP1: {
-                state[sens+i] = state[(int)gp[GPRC_INITIAL]];
+            break;
+        }
+        case GPR_FUNCTION_LESS_THAN: {
+            if (state[con[0]] <
+                state[con[1]]) {
+                state[sens+i] = gp[GPRC_GENE_CONSTANT];
                 state[sens+i+no_of_states] =
-                    state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+                    gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_NOOP2: {
-                state[sens+i] = state[(int)gp[GPRC_INITIAL]];
-                state[sens+i+no_of_states] =
-                    state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_NOOP3: {
-                state[sens+i] = state[(int)gp[GPRC_INITIAL]];
+            break;
+        }
+        case GPR_FUNCTION_EQUALS: {
+            if (((int)state[con[0]] ==
+                 (int)state[con[1]]) &&
+                ((int)state[con[0]+no_of_states] ==
+                 (int)state[con[1]+no_of_states])) {
+                state[sens+i] = gp[GPRC_GENE_CONSTANT];
                 state[sens+i+no_of_states] =
-                    state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+                    gp[GPRC_GENE_IMAGINARY];
+            }
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_NOOP4: {
-                state[sens+i] = state[(int)gp[GPRC_INITIAL]];
+            break;
+        }
+        case GPR_FUNCTION_AND: {
+            if ((state[con[0]]>0) &&
+                (state[con[1]]>0)) {
+                state[sens+i] = gp[GPRC_GENE_CONSTANT];
                 state[sens+i+no_of_states] =
-                    state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+                    gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_GREATER_THAN: {
-                if (state[(int)gp[GPRC_INITIAL]] >
-                    state[(int)gp[1+GPRC_INITIAL]]) {
-                    state[sens+i] = gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
-            }
-            case GPR_FUNCTION_LESS_THAN: {
-                if (state[(int)gp[GPRC_INITIAL]] <
-                    state[(int)gp[1+GPRC_INITIAL]]) {
-                    state[sens+i] = gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
-            }
-            case GPR_FUNCTION_EQUALS: {
-                if (((int)state[(int)gp[GPRC_INITIAL]] ==
-                     (int)state[(int)gp[1+GPRC_INITIAL]]) &&
-                    ((int)state[(int)gp[GPRC_INITIAL]+no_of_states] ==
-                     (int)state[(int)gp[1+GPRC_INITIAL]+no_of_states])) {
-                    state[sens+i] = gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
-            }
-            case GPR_FUNCTION_AND: {
-                if ((state[(int)gp[GPRC_INITIAL]]>0) &&
-                    (state[(int)gp[1+GPRC_INITIAL]]>0)) {
-                    state[sens+i] = gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_OR: {
-                if ((state[(int)gp[GPRC_INITIAL]]>0) ||
-                    (state[(int)gp[1+GPRC_INITIAL]]>0)) {
-                    state[sens+i] = gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_OR: {
+            if ((state[con[0]]>0) ||
+                (state[con[1]]>0)) {
+                state[sens+i] = gp[GPRC_GENE_CONSTANT];
+                state[sens+i+no_of_states] =
+                    gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_XOR: {
-                if ((state[(int)gp[GPRC_INITIAL]]>0) !=
-                    (state[(int)gp[1+GPRC_INITIAL]]>0)) {
-                    state[sens+i] = gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_NOT: {
-                if (((int)state[(int)gp[GPRC_INITIAL]]) !=
-                    ((int)state[(int)gp[1+GPRC_INITIAL]])) {
-                    state[sens+i] = gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_XOR: {
+            if ((state[con[0]]>0) !=
+                (state[con[1]]>0)) {
+                state[sens+i] = gp[GPRC_GENE_CONSTANT];
+                state[sens+i+no_of_states] =
+                    gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_HEBBIAN: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                /* update the output */
+            else {
                 state[sens+i] = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    state[sens+i] +=
-                        state[(int)gp[GPRC_INITIAL+j]] *
-                        gp[GPRC_INITIAL+j+connections_per_gene];
-                }
-                /* adjust weights.  Here the imaginary
-                   component is used to represent the total weight change */
                 state[sens+i+no_of_states] = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    /* change in the weight value */
-                    a = state[sens+i] * state[(int)gp[GPRC_INITIAL+j]] *
-                        GPR_HEBBIAN_LEARNING_RATE;
-                    /* alter the weight */
-                    gp[GPRC_INITIAL+j+connections_per_gene] += a;
-                    /* store the total change */
-                    state[sens+i+no_of_states] += a;
-                }
-                break;
             }
-            case GPR_FUNCTION_EXP: {
-                state[sens+i] = (float)exp(state[(int)gp[GPRC_INITIAL]]);
+            break;
+        }
+        case GPR_FUNCTION_NOT: {
+            if (((int)state[con[0]]) !=
+                ((int)state[con[1]])) {
+                state[sens+i] = gp[GPRC_GENE_CONSTANT];
                 state[sens+i+no_of_states] =
-                    (float)exp(state[(int)gp[GPRC_INITIAL]+no_of_states]);
-                break;
-            }
-            case GPR_FUNCTION_SQUARE_ROOT: {
-                k = (int)gp[GPRC_INITIAL];
-                a = state[k];
-                b = state[k+no_of_states];
-                if (b == 0) {
-                    state[sens+i] =
-                        (float)sqrt(fabs(state[k]));
-                    state[sens+i+no_of_states] = 0;
-                }
-                else {
-                    a2 = (float)sqrt((a*a) + (b*b));
-                    state[sens+i] =
-                        (float)sqrt((a + a2) * 0.5f);
-                    state[sens+i+no_of_states] =
-                        (float)sqrt((-a + a2) * 0.5f);
-                    if (b < 0) {
-                        state[sens+i+no_of_states] =
-                            -state[sens+i+no_of_states];
-                    }
-                }
-                break;
+                    gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_ABS: {
-                k = (int)gp[GPRC_INITIAL];
-                a = state[k];
-                b = state[k+no_of_states];
-                if (b == 0) {
-                    /* ordinary number */
-                    state[sens+i] =
-                        (float)fabs(state[(int)gp[GPRC_INITIAL]]);
-                }
-                else {
-                    /* if this is a complex number */
-                    state[sens+i] =
-                        (float)sqrt((a*a) + (b*b));
-                }
+            else {
+                state[sens+i] = 0;
                 state[sens+i+no_of_states] = 0;
-                break;
             }
-            case GPR_FUNCTION_SINE: {
-                k = (int)gp[GPRC_INITIAL];
-                a = state[k];
-                b = state[k+no_of_states];
-                if (b == 0) {
-                    state[sens+i] =
-                        (float)sin(a)*256;
-                    state[sens+i+no_of_states] = 0;
-                }
-                else {
-                    state[sens+i] =
-                        (float)(sin(a)*cosh(b))*256;
-                    state[sens+i+no_of_states] =
-                        (float)(cos(a)*sinh(b))*256;
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_HEBBIAN: {
+            gprc_snapshot_gene(f, ADF_module, i);
+            /* update the output */
+            state[sens+i] = 0;
+            for (j = 0; j < no_of_args; j++) {
+                state[sens+i] +=
+                    state[con[j]] *
+                    gp[GPRC_INITIAL+j+connections_per_gene];
+            }
+            /* adjust weights.  Here the imaginary
+               component is used to represent the total weight change */
+            state[sens+i+no_of_states] = 0;
+            for (j = 0; j < no_of_args; j++) {
+                /* change in the weight value */
+                a = state[sens+i] * state[con[j]] *
+                    GPR_HEBBIAN_LEARNING_RATE;
+                /* alter the weight */
+                gp[GPRC_INITIAL+j+connections_per_gene] += a;
+                /* store the total change */
+                state[sens+i+no_of_states] += a;
             }
-            case GPR_FUNCTION_ARCSINE: {
+            break;
+        }
+        case GPR_FUNCTION_EXP: {
+            state[sens+i] = (float)exp(state[con[0]]);
+            state[sens+i+no_of_states] =
+                (float)exp(state[con[0]+no_of_states]);
+            break;
+        }
+        case GPR_FUNCTION_SQUARE_ROOT: {
+            k = con[0];
+            a = state[k];
+            b = state[k+no_of_states];
+            if (b == 0) {
                 state[sens+i] =
-                    (float)asin(state[(int)gp[GPRC_INITIAL]]);
-                break;
+                    (float)sqrt(fabs(state[k]));
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_COSINE: {
-                k = (int)gp[GPRC_INITIAL];
-                a = state[k];
-                b = state[k+no_of_states];
-                if (b == 0) {
-                    state[sens+i] =
-                        (float)cos(a)*256;
-                    state[sens+i+no_of_states] = 0;
-                }
-                else {
-                    state[sens+i] =
-                        (float)(cos(a)*cosh(b))*256;
+            else {
+                a2 = (float)sqrt((a*a) + (b*b));
+                state[sens+i] =
+                    (float)sqrt((a + a2) * 0.5f);
+                state[sens+i+no_of_states] =
+                    (float)sqrt((-a + a2) * 0.5f);
+                if (b < 0) {
                     state[sens+i+no_of_states] =
-                        (float)(sin(a)*sinh(b))*256;
+                        -state[sens+i+no_of_states];
                 }
-                break;
             }
-            case GPR_FUNCTION_ARCCOSINE: {
+            break;
+        }
+        case GPR_FUNCTION_ABS: {
+            k = con[0];
+            a = state[k];
+            b = state[k+no_of_states];
+            if (b == 0) {
+                /* ordinary number */
                 state[sens+i] =
-                    (float)acos(state[(int)gp[GPRC_INITIAL]]);
-                break;
+                    (float)fabs(state[con[0]]);
             }
-            case GPR_FUNCTION_POW: {
+            else {
+                /* if this is a complex number */
                 state[sens+i] =
-                    (float)pow(state[(int)gp[GPRC_INITIAL]],
-                               state[(int)gp[1+GPRC_INITIAL]]);
-                state[sens+i+no_of_states] =
-                    (float)pow(state[(int)gp[GPRC_INITIAL]+no_of_states],
-                               state[(int)gp[1+GPRC_INITIAL]+no_of_states]);
-                break;
-            }
-            case GPR_FUNCTION_MIN: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                state[sens+i] = state[(int)gp[GPRC_INITIAL]];
-                for (j = 1; j < no_of_args; j++) {
-                    if (state[(int)gp[GPRC_INITIAL+j]] < state[sens+i]) {
-                        state[sens+i] = state[(int)gp[GPRC_INITIAL+j]];
-                        state[sens+i+no_of_states] =
-                            state[(int)gp[GPRC_INITIAL+j]+no_of_states];
-                    }
-                }
-                break;
+                    (float)sqrt((a*a) + (b*b));
             }
-            case GPR_FUNCTION_MAX: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                state[sens+i] = state[(int)gp[GPRC_INITIAL]];
-                for (j = 1; j < no_of_args; j++) {
-                    if (state[(int)gp[GPRC_INITIAL+j]] > state[sens+i]) {
-                        state[sens+i] = state[(int)gp[GPRC_INITIAL+j]];
-                        state[sens+i+no_of_states] =
-                            state[(int)gp[GPRC_INITIAL+j]+no_of_states];
-                    }
-                }
-                break;
+            state[sens+i+no_of_states] = 0;
+            break;
+        }
+        case GPR_FUNCTION_SINE: {
+            k = con[0];
+            a = state[k];
+            b = state[k+no_of_states];
+            if (b == 0) {
+                state[sens+i] =
+                    (float)sin(a)*256;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_COPY_FUNCTION: {
-                if (((int)gp[GPRC_INITIAL] > sens) &&
-                    ((int)gp[1+GPRC_INITIAL] > sens)) {
-                    src = ((int)gp[GPRC_INITIAL]-sens) * gene_size;
-                    dest = ((int)gp[1+GPRC_INITIAL]-sens) * gene_size;
-                    gene[dest] = gene[src];
-                }
-                break;
+            else {
+                state[sens+i] =
+                    (float)(sin(a)*cosh(b))*256;
+                state[sens+i+no_of_states] =
+                    (float)(cos(a)*sinh(b))*256;
             }
-            case GPR_FUNCTION_COPY_CONSTANT: {
-                if (((int)gp[GPRC_INITIAL] > sens) &&
-                    ((int)gp[1+GPRC_INITIAL] > sens)) {
-                    src = ((int)gp[GPRC_INITIAL]-sens) * gene_size;
-                    dest = ((int)gp[1+GPRC_INITIAL]-sens) * gene_size;
-                    gene[dest+GPRC_GENE_CONSTANT] =
-                        gene[src+GPRC_GENE_CONSTANT];
-                    gene[dest+GPRC_GENE_IMAGINARY] =
-                        gene[src+GPRC_GENE_IMAGINARY];
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_ARCSINE: {
+            state[sens+i] =
+                (float)asin(state[con[0]]);
+            break;
+        }
+        case GPR_FUNCTION_COSINE: {
+            k = con[0];
+            a = state[k];
+            b = state[k+no_of_states];
+            if (b == 0) {
+                state[sens+i] =
+                    (float)cos(a)*256;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_COPY_STATE: {
-                state[(int)gp[1+GPRC_INITIAL]] =
-                    state[(int)gp[GPRC_INITIAL]];
-                state[(int)gp[1+GPRC_INITIAL]+no_of_states] =
-                    state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+            else {
+                state[sens+i] =
+                    (float)(cos(a)*cosh(b))*256;
+                state[sens+i+no_of_states] =
+                    (float)(sin(a)*sinh(b))*256;
             }
-            case GPR_FUNCTION_COPY_BLOCK: {
-                block_from = (int)gp[GPRC_INITIAL];
-                block_to = (int)gp[1+GPRC_INITIAL];
-                if (block_from < block_to) {
-                    block_from = (int)gp[1+GPRC_INITIAL];
-                    block_to = (int)gp[GPRC_INITIAL];
-                }
-                k = block_to - GPR_BLOCK_WIDTH;
-                for (j = block_from - GPR_BLOCK_WIDTH;
-                     j <= block_from + GPR_BLOCK_WIDTH; j++,k++) {
-                    if ((j>sens) &&
-                        (k>sens) &&
-                        (j<i) && (k<i)) {
-                        for (g = 0; g < gene_size; g++) {
-                            gene[(j-sens)*gene_size + g] =
-                                gene[(k-sens)*gene_size + g];
-                        }
-                    }
+            break;
+        }
+        case GPR_FUNCTION_ARCCOSINE: {
+            state[sens+i] =
+                (float)acos(state[con[0]]);
+            break;
+        }
+        case GPR_FUNCTION_POW: {
+            state[sens+i] =
+                (float)pow(state[con[0]],
+                           state[con[1]]);
+            state[sens+i+no_of_states] =
+                (float)pow(state[con[0]+no_of_states],
+                           state[con[1]+no_of_states]);
+            break;
+        }
+        case GPR_FUNCTION_MIN: {
+            state[sens+i] = state[con[0]];
+            for (j = 1; j < no_of_args; j++) {
+                if (state[con[j]] < state[sens+i]) {
+                    state[sens+i] = state[con[j]];
+                    state[sens+i+no_of_states] =
+                        state[con[j]+no_of_states];
                 }
-                break;
             }
-            case GPR_FUNCTION_COPY_CONNECTION1: {
-                if (gp[GPRC_INITIAL] > sens) {
-                    src = ((int)gp[GPRC_INITIAL] - sens) * gene_size;
-                    gp[1+GPRC_INITIAL] = gene[src+GPRC_INITIAL];
+            break;
+        }
+        case GPR_FUNCTION_MAX: {
+            state[sens+i] = state[con[0]];
+            for (j = 1; j < no_of_args; j++) {
+                if (state[con[j]] > state[sens+i]) {
+                    state[sens+i] = state[con[j]];
+                    state[sens+i+no_of_states] =
+                        state[con[j]+no_of_states];
                 }
-                break;
             }
-            case GPR_FUNCTION_COPY_CONNECTION2: {
-                if (gp[1+GPRC_INITIAL] > sens) {
-                    src = ((int)gp[1+GPRC_INITIAL] - sens) * gene_size;
-                    gp[GPRC_INITIAL] = gene[src+GPRC_INITIAL];
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_COPY_FUNCTION: {
+            if ((con[0] > sens) &&
+                (con[1] > sens)) {
+                src = (con[0]-sens) * gene_size;
+                dest = (con[1]-sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, con[1]-sens);
+                gene[dest] = gene[src];
             }
-            case GPR_FUNCTION_COPY_CONNECTION3: {
-                if (gp[1+GPRC_INITIAL] > sens) {
-                    src = ((int)gp[1+GPRC_INITIAL] - sens) * gene_size;
-                    gp[GPRC_INITIAL] = gene[src+1+GPRC_INITIAL];
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_COPY_CONSTANT: {
+            if ((con[0] > sens) &&
+                (con[1] > sens)) {
+                src = (con[0]-sens) * gene_size;
+                dest = (con[1]-sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, con[1]-sens);
+                gene[dest+GPRC_GENE_CONSTANT] =
+                    gene[src+GPRC_GENE_CONSTANT];
+                gene[dest+GPRC_GENE_IMAGINARY] =
+                    gene[src+GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_COPY_CONNECTION4: {
-                if (gp[GPRC_INITIAL] > sens) {
-                    src = ((int)gp[GPRC_INITIAL] - sens) * gene_size;
-                    gp[1+GPRC_INITIAL] = gene[src+1+GPRC_INITIAL];
+            break;
+        }
+        case GPR_FUNCTION_COPY_STATE: {
+            state[con[1]] =
+                state[con[0]];
+            state[con[1]+no_of_states] =
+                state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_COPY_BLOCK: {
+            block_from = con[0];
+            block_to = con[1];
+            if (block_from < block_to) {
+                block_from = con[1];
+                block_to = con[0];
+            }
+            k = block_to - GPR_BLOCK_WIDTH;
+            for (j = block_from - GPR_BLOCK_WIDTH;
+                 j <= block_from + GPR_BLOCK_WIDTH; j++,k++) {
+                if ((j>sens) &&
+                    (k>sens) &&
+                    (j<i) && (k<i)) {
+                    gprc_alter_gene(f, ADF_module, j-sens);
+                    for (g = 0; g < gene_size; g++) {
+                        gene[(j-sens)*gene_size + g] =
+                            gene[(k-sens)*gene_size + g];
+                    }
                 }
-                break;
-            }
-            }
-            /* prevent values from going out of range */
-            if (is_nan(state[sens+i])) {
-                state[sens+i] = 0;
-            }
-            if (is_nan(state[sens+i+no_of_states])) {
-                state[sens+i] = 0;
             }
-            if (state[sens+i] > GPR_MAX_CONSTANT) {
-                state[sens+i] = GPR_MAX_CONSTANT;
+            break;
+        }
+        case GPR_FUNCTION_COPY_CONNECTION1: {
+            if (gp[GPRC_INITIAL] > sens) {
+                src = (con[0] - sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, i);
+                gp[1+GPRC_INITIAL] = gene[src+GPRC_INITIAL];
             }
-            if (state[sens+i+no_of_states] >
-                GPR_MAX_CONSTANT) {
-                state[sens+i+no_of_states] = GPR_MAX_CONSTANT;
+            break;
+        }
+        case GPR_FUNCTION_COPY_CONNECTION2: {
+            if (gp[1+GPRC_INITIAL] > sens) {
+                src = (con[1] - sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, i);
+                gp[GPRC_INITIAL] = gene[src+GPRC_INITIAL];
             }
-            if (state[sens+i] < -GPR_MAX_CONSTANT) {
-                state[sens+i] = -GPR_MAX_CONSTANT;
+            break;
+        }
+        case GPR_FUNCTION_COPY_CONNECTION3: {
+            if (gp[1+GPRC_INITIAL] > sens) {
+                src = (con[1] - sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, i);
+                gp[GPRC_INITIAL] = gene[src+1+GPRC_INITIAL];
             }
-            if (state[sens+i+no_of_states] <
-                -GPR_MAX_CONSTANT) {
-                state[sens+i+no_of_states] = -GPR_MAX_CONSTANT;
+            break;
+        }
+        case GPR_FUNCTION_COPY_CONNECTION4: {
+            if (gp[GPRC_INITIAL] > sens) {
+                src = (con[0] - sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, i);
+                gp[1+GPRC_INITIAL] = gene[src+1+GPRC_INITIAL];
             }
+            break;
+        }
+        }
+        /* prevent values from going out of range */
+        if (is_nan(state[sens+i])) {
+            state[sens+i] = 0;
+        }
+        if (is_nan(state[sens+i+no_of_states])) {
+            state[sens+i] = 0;
+        }
+        if (state[sens+i] > GPR_MAX_CONSTANT) {
+            state[sens+i] = GPR_MAX_CONSTANT;
+        }
+        if (state[sens+i+no_of_states] >
+            GPR_MAX_CONSTANT) {
+            state[sens+i+no_of_states] = GPR_MAX_CONSTANT;
+        }
+        if (state[sens+i] < -GPR_MAX_CONSTANT) {
+            state[sens+i] = -GPR_MAX_CONSTANT;
+        }
+        if (state[sens+i+no_of_states] <
+            -GPR_MAX_CONSTANT) {
+            state[sens+i+no_of_states] = -GPR_MAX_CONSTANT;
         }
     }
 
     /* set the actuator values */
-    ctr = sens + i;
+    ctr = sens + (rows*columns);
+    n = rows*columns*gene_size;
     for (i = 0; i < act; i++, ctr++, n++) {
         /* real component */
         state[ctr] = state[(int)gene[n]];
@@ -3114,694 +3847,1086 @@ void gprc_run_float(gprc_function * f,
     }
 }
 
-/* an integer version of the run function */
-void gprc_run_int(gprc_function * f,
-                  int ADF_module,
-                  int rows, int columns,
-                  int connections_per_gene,
-                  int sensors, int actuators,
-                  float dropout_prob, int dynamic,
-                  float (*custom_function)(float,float,float))
+/* returns non-zero if the imaginary parts of all sensors are zero */
+static int gprc_real_sensors(gprc_function * f,
+                             int rows, int columns,
+                             int sensors, int actuators)
 {
-    int row,col,n=0,i=0,j,k,g,ctr,src,dest,no_of_args;
-    float * gp, a, b, c, d, a2, b2;
+    int i;
+    float * state = f->genome[0].state;
+    int no_of_states = (rows*columns) + sensors + actuators;
+
+    for (i = 0; i < sensors; i++) {
+        if (state[i+no_of_states] != 0) return 0;
+    }
+    return 1;
+}
+
+/* A version of the run function which only evaluates the real
+   part of each state, treating all imaginary parts as zero.
+   Only the compiled list of used genes is run, so if the
+   program is dynamic, contains ADFs or any sensor has an
+   imaginary part then the ordinary run function is used */
+void gprc_run_real(gprc_function * f,
+                   int rows, int columns,
+                   int connections_per_gene,
+                   int sensors, int actuators,
+                   float dropout_prob,
+                   float (*custom_function)(float,float,float))
+{
+    int i,j,k,n,ctr,no_of_args,instr_index,no_of_instructions;
+    int * program, * instr, * con;
+    float * gp, a, c, im;
     int gene_size = GPRC_GENE_SIZE(connections_per_gene);
-    int block_from,block_to, no_of_states;
-    int dropout = (int)(dropout_prob*10000);
-    int sens = gprc_get_sensors(ADF_module,sensors);
-    float * gene = f->genome[ADF_module].gene;
-    unsigned char * used = f->genome[ADF_module].used;
-    float * state = f->genome[ADF_module].state;
+    unsigned int dropout = gprc_dropout_threshold(dropout_prob);
+    unsigned long long dropout_key = 0, dropout_hash = 0;
+    int dropout_index = -1;
+    int no_of_states = (rows*columns) + sensors + actuators;
+    float * gene = f->genome[0].gene;
+    float * state = f->genome[0].state;
 
-    actuators = gprc_get_actuators(ADF_module,actuators);
-    no_of_states = (rows*columns) + sens + actuators;
+    program = gprc_compiled_program(f, 0, rows, columns,
+                                    connections_per_gene, sensors, 0);
+    if ((program == NULL) || (f->ADF_modules > 0) ||
+        (gprc_real_sensors(f, rows, columns,
+                           sensors, actuators) == 0)) {
+        gprc_run_float(f, 0, rows, columns,
+                       connections_per_gene,
+                       sensors, actuators,
+                       dropout_prob, 0, (*custom_function));
+        return;
+    }
+    no_of_instructions = f->genome[0].program_length;
 
-    for (col = 0; col < columns; col++) {
-        for (row = 0; row < rows; row++, i++,n+=gene_size) {
+    /* a different set of genes is dropped on each run */
+    if (dropout > 0) dropout_key = rand_num(&f->random_seed);
 
-            /* if this function is not on the path
-               between sensors and actuators then skip it
-               since it has no effect upon the program behavior */
-            if ((dynamic <= 0) && (used[i+sens] == 0)) {
-                continue;
-            }
+    for (instr_index = 0; instr_index < no_of_instructions;
+         instr_index++) {
+        instr = &program[instr_index *
+                         GPRC_INSTR_SIZE(connections_per_gene)];
+        i = instr[GPRC_INSTR_GENE];
+        no_of_args = instr[GPRC_INSTR_ARGS];
+        con = &instr[GPRC_INSTR_INITIAL];
 
-            /* occasional dropout helps to avoid overfitting*/
-            if (rand_num(&f->random_seed)%10000<dropout) continue;
+        /* occasional dropout helps to avoid overfitting*/
+        if ((dropout > 0) &&
+            gprc_dropout_gene(dropout_key, dropout, instr_index,
+                              &dropout_index, &dropout_hash)) {
+            continue;
+        }
 
-            gp = &gene[n];
-            switch((int)gp[GPRC_GENE_FUNCTION_TYPE]) {
-            case GPR_FUNCTION_DATA_PUSH: {
-                if ((f->data.size > 0) && (f->data.fields > 0)) {
-                    gpr_data_set_head(&f->data,
-                                      ((unsigned int)state[(int)gp[GPRC_INITIAL]])%f->data.fields,
-                                      (int)state[(int)gp[GPRC_INITIAL+1]],
-                                      (int)state[(int)gp[GPRC_INITIAL+1]+no_of_states]);
-                    gpr_data_push(&f->data);
-                }
-                break;
+        gp = &gene[i * gene_size];
+        switch(instr[GPRC_INSTR_FUNCTION_TYPE]) {
+        case GPR_FUNCTION_DATA_PUSH: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_set_head(&f->data,
+                                  ((unsigned int)state[con[0]])%f->data.fields,
+                                  state[con[1]], 0);
+                gpr_data_push(&f->data);
             }
-            case GPR_FUNCTION_DATA_POP: {
-                if ((f->data.size > 0) && (f->data.fields > 0)) {
-                    gpr_data_get_tail(&f->data,
-                                      ((unsigned int)state[(int)gp[GPRC_INITIAL]])%f->data.fields,
-                                      &state[sens+i],
-                                      &state[sens+i+no_of_states]);
-                    state[sens+i] = (int)state[sens+i];
-                    state[sens+i+no_of_states] = (int)state[sens+i+no_of_states];
-                    gpr_data_pop(&f->data);
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_DATA_POP: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_get_tail(&f->data,
+                                  ((unsigned int)state[con[0]])%f->data.fields,
+                                  &state[sensors+i], &im);
+                gpr_data_pop(&f->data);
             }
-            case GPR_FUNCTION_DATA_GET: {
-                if ((f->data.size > 0) && (f->data.fields > 0)) {
-                    gpr_data_get_elem(&f->data,
-                                      (unsigned int)state[(int)gp[GPRC_INITIAL]],
-                                      ((unsigned int)state[(int)gp[GPRC_INITIAL+1]])%(f->data.fields),
-                                      &state[sens+i],
-                                      &state[sens+i+no_of_states]);
-                    state[sens+i] = (int)state[sens+i];
-                    state[sens+i+no_of_states] = (int)state[sens+i+no_of_states];
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_DATA_GET: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_get_elem(&f->data,
+                                  (unsigned int)state[con[0]],
+                                  ((unsigned int)state[con[1]])%(f->data.fields),
+                                  &state[sensors+i], &im);
             }
-            case GPR_FUNCTION_DATA_SET: {
-                if ((f->data.size > 0) && (f->data.fields > 0)) {
-                    gpr_data_set_elem(&f->data,
-                                      (unsigned int)state[(int)gp[GPRC_INITIAL]],
-                                      ((unsigned int)state[(int)gp[GPRC_INITIAL+1]])%(f->data.fields),
-                                      (int)state[sens+i],
-                                      (int)state[sens+i+no_of_states]);
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_DATA_SET: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_set_elem(&f->data,
+                                  (unsigned int)state[con[0]],
+                                  ((unsigned int)state[con[1]])%(f->data.fields),
+                                  state[sensors+i], 0);
             }
-            case GPR_FUNCTION_GET: {
-                j = abs((int)state[(int)gp[GPRC_INITIAL]] +
-                        (int)state[(int)gp[1+GPRC_INITIAL]])
-                    %(rows*columns);
-                state[sens+i] = (int)state[sens+j];
-                state[sens+i+no_of_states] =
-                    (int)state[sens+j+no_of_states];
-                break;
+            break;
+        }
+        case GPR_FUNCTION_GET: {
+            j = abs((int)state[con[0]] +
+                    (int)state[con[1]])
+                %(rows*columns);
+            state[sensors+i] = state[sensors+j];
+            break;
+        }
+        case GPR_FUNCTION_SET: {
+            j = abs((int)state[con[1]])
+                %(rows*columns);
+            state[sensors+i] = gp[GPRC_GENE_CONSTANT]*
+                state[con[0]];
+            state[sensors+j] = state[sensors+i];
+            if (state[sensors+j] > GPR_MAX_CONSTANT) {
+                state[sensors+j] = GPR_MAX_CONSTANT;
             }
-            case GPR_FUNCTION_SET: {
-                j = abs((int)state[(int)gp[1+GPRC_INITIAL]])
-                    %(rows*columns);
-                state[sens+i] =
-                    (int)gp[GPRC_GENE_CONSTANT]*
-                    (int)state[(int)gp[GPRC_INITIAL]];
-                state[sens+i+no_of_states] =
-                    (int)gp[GPRC_GENE_CONSTANT]*
-                    (int)state[(int)gp[GPRC_INITIAL]+
-                               no_of_states];
-                state[sens+j] = (int)state[sens+i];
-                state[sens+j+no_of_states] =
-                    (int)state[sens+i+no_of_states];
-                if (state[sens+j] > GPR_MAX_CONSTANT) {
-                    state[sens+j] = GPR_MAX_CONSTANT;
-                }
-                if (state[sens+j+no_of_states] >
-                    GPR_MAX_CONSTANT) {
-                    state[sens+j+no_of_states] =
-                        GPR_MAX_CONSTANT;
-                }
-                if (state[sens+j] < -GPR_MAX_CONSTANT) {
-                    state[sens+j] = -GPR_MAX_CONSTANT;
-                }
-                if (state[sens+j+no_of_states] <
-                    -GPR_MAX_CONSTANT) {
-                    state[sens+j+no_of_states] =
-                        -GPR_MAX_CONSTANT;
-                }
-                break;
+            if (state[sensors+j] < -GPR_MAX_CONSTANT) {
+                state[sensors+j] = -GPR_MAX_CONSTANT;
             }
-            case GPR_FUNCTION_ADF: {
-                gprc_c_run_ADF(f, ADF_module, i,
-                               gp, rows, columns,
-                               connections_per_gene,
-                               sensors, actuators,
-                               dropout_prob, dynamic,
-                               (*custom_function),1);
-                break;
+            break;
+        }
+        case GPR_FUNCTION_CUSTOM: {
+            if (*custom_function) {
+                state[sensors+i] =
+                    (*custom_function)(gp[GPRC_GENE_CONSTANT],
+                                       gp[GPRC_INITIAL],
+                                       gp[GPRC_GENE_CONSTANT]);
             }
-            case GPR_FUNCTION_CUSTOM: {
-                if (*custom_function) {
-                    state[sens+i] =
-                        (*custom_function)((int)gp[GPRC_GENE_CONSTANT],
-                                           (int)gp[GPRC_INITIAL],
-                                           (int)gp[GPRC_GENE_CONSTANT]);
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_VALUE: {
+            state[sensors+i] = gp[GPRC_GENE_CONSTANT];
+            break;
+        }
+        case GPR_FUNCTION_SIGMOID: {
+            state[sensors+i] = 0;
+            for (j = 0; j < no_of_args; j++) {
+                state[sensors+i] +=
+                    state[con[j]]*
+                    gp[GPRC_INITIAL+j+connections_per_gene];
             }
-            case GPR_FUNCTION_VALUE: {
-                state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
-                state[sens+i+no_of_states] =
-                    (int)gp[GPRC_GENE_CONSTANT+no_of_states];
-                break;
+
+            state[sensors+i] =
+                1.0f / (1.0f + exp(-state[sensors+i]));
+            break;
+        }
+        case GPR_FUNCTION_ADD: {
+            a = 0;
+            for (j = 0; j < no_of_args; j++) {
+                a += state[con[j]];
             }
-            case GPR_FUNCTION_SIGMOID: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                state[sens+i] = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    state[sens+i] +=
-                        state[(int)gp[GPRC_INITIAL+j]]*
-                        gp[GPRC_INITIAL+j+connections_per_gene];
-                }
+            state[sensors+i] = a;
+            break;
+        }
+        case GPR_FUNCTION_SUBTRACT: {
+            a = state[con[0]];
+            for (j = 1; j < no_of_args; j++) {
+                a -= state[con[j]];
+            }
+            state[sensors+i] = a;
+            break;
+        }
+        case GPR_FUNCTION_NEGATE: {
+            state[sensors+i] = -state[con[0]];
+            break;
+        }
+        case GPR_FUNCTION_MULTIPLY: {
+            a = state[con[0]];
+            for (j = 1; j < no_of_args; j++) {
+                a *= state[con[j]];
+            }
+            state[sensors+i] = a;
+            break;
+        }
+        case GPR_FUNCTION_WEIGHT: {
+            state[sensors+i] = state[con[0]] *
+                gp[GPRC_GENE_CONSTANT];
+            break;
+        }
+        case GPR_FUNCTION_DIVIDE: {
+            a = state[con[0]];
+            c = state[con[1]];
+            if((c <= 1e-1) && (c >= -1e-1)) {
+                /* if the denominator is close to zero
+                   then just pass through */
+                state[sensors+i] = a;
+            }
+            else {
+                state[sensors+i] = (a*c) / (c*c);
+            }
+            break;
+        }
+        case GPR_FUNCTION_MODULUS: {
+            state[sensors+i] = fmod(state[con[0]], state[con[1]]);
+            break;
+        }
+        case GPR_FUNCTION_FLOOR: {
+            state[sensors+i] = floor(state[con[0]]);
+            break;
+        }
+        case GPR_FUNCTION_AVERAGE: {
+            a = state[con[0]];
+            for (j = 1; j < no_of_args; j++) {
+                a += state[con[j]];
+            }
+            state[sensors+i] = a / no_of_args;
+            break;
+        }
+        case GPR_FUNCTION_NOOP1:
+        case GPR_FUNCTION_NOOP2:
+        case GPR_FUNCTION_NOOP3:
+        case GPR_FUNCTION_NOOP4: {
+            state[sensors+i] = state[con[0]];
+            break;
+        }
+        case GPR_FUNCTION_GREATER_THAN: {
+            state[sensors+i] = 0;
+            if (state[con[0]] > state[con[1]]) {
+                state[sensors+i] = gp[GPRC_GENE_CONSTANT];
+            }
+            break;
+        }
+        case GPR_FUNCTION_LESS_THAN: {
+            state[sensors+i] = 0;
+            if (state[con[0]] < state[con[1]]) {
+                state[sensors+i] = gp[GPRC_GENE_CONSTANT];
+            }
+            break;
+        }
+        case GPR_FUNCTION_EQUALS: {
+            state[sensors+i] = 0;
+            if ((int)state[con[0]] == (int)state[con[1]]) {
+                state[sensors+i] = gp[GPRC_GENE_CONSTANT];
+            }
+            break;
+        }
+        case GPR_FUNCTION_AND: {
+            state[sensors+i] = 0;
+            if ((state[con[0]]>0) && (state[con[1]]>0)) {
+                state[sensors+i] = gp[GPRC_GENE_CONSTANT];
+            }
+            break;
+        }
+        case GPR_FUNCTION_OR: {
+            state[sensors+i] = 0;
+            if ((state[con[0]]>0) || (state[con[1]]>0)) {
+                state[sensors+i] = gp[GPRC_GENE_CONSTANT];
+            }
+            break;
+        }
+        case GPR_FUNCTION_XOR: {
+            state[sensors+i] = 0;
+            if ((state[con[0]]>0) != (state[con[1]]>0)) {
+                state[sensors+i] = gp[GPRC_GENE_CONSTANT];
+            }
+            break;
+        }
+        case GPR_FUNCTION_NOT: {
+            state[sensors+i] = 0;
+            if (((int)state[con[0]]) != ((int)state[con[1]])) {
+                state[sensors+i] = gp[GPRC_GENE_CONSTANT];
+            }
+            break;
+        }
+        case GPR_FUNCTION_HEBBIAN: {
+            gprc_snapshot_gene(f, 0, i);
+            /* update the output */
+            state[sensors+i] = 0;
+            for (j = 0; j < no_of_args; j++) {
+                state[sensors+i] +=
+                    state[con[j]] *
+                    gp[GPRC_INITIAL+j+connections_per_gene];
+            }
+            /* adjust weights */
+            for (j = 0; j < no_of_args; j++) {
+                gp[GPRC_INITIAL+j+connections_per_gene] +=
+                    state[sensors+i] * state[con[j]] *
+                    GPR_HEBBIAN_LEARNING_RATE;
+            }
+            break;
+        }
+        case GPR_FUNCTION_EXP: {
+            state[sensors+i] = (float)exp(state[con[0]]);
+            break;
+        }
+        case GPR_FUNCTION_SQUARE_ROOT: {
+            state[sensors+i] = (float)sqrt(fabs(state[con[0]]));
+            break;
+        }
+        case GPR_FUNCTION_ABS: {
+            state[sensors+i] = (float)fabs(state[con[0]]);
+            break;
+        }
+        case GPR_FUNCTION_SINE: {
+            state[sensors+i] = (float)sin(state[con[0]])*256;
+            break;
+        }
+        case GPR_FUNCTION_ARCSINE: {
+            state[sensors+i] = (float)asin(state[con[0]]);
+            break;
+        }
+        case GPR_FUNCTION_COSINE: {
+            state[sensors+i] = (float)cos(state[con[0]])*256;
+            break;
+        }
+        case GPR_FUNCTION_ARCCOSINE: {
+            state[sensors+i] = (float)acos(state[con[0]]);
+            break;
+        }
+        case GPR_FUNCTION_POW: {
+            state[sensors+i] =
+                (float)pow(state[con[0]], state[con[1]]);
+            break;
+        }
+        case GPR_FUNCTION_MIN: {
+            a = state[con[0]];
+            for (j = 1; j < no_of_args; j++) {
+                if (state[con[j]] < a) a = state[con[j]];
+            }
+            state[sensors+i] = a;
+            break;
+        }
+        case GPR_FUNCTION_MAX: {
+            a = state[con[0]];
+            for (j = 1; j < no_of_args; j++) {
+                if (state[con[j]] > a) a = state[con[j]];
+            }
+            state[sensors+i] = a;
+            break;
+        }
+        }
+        /* prevent values from going out of range */
+        if (is_nan(state[sensors+i])) {
+            state[sensors+i] = 0;
+        }
+        if (state[sensors+i] > GPR_MAX_CONSTANT) {
+            state[sensors+i] = GPR_MAX_CONSTANT;
+        }
+        if (state[sensors+i] < -GPR_MAX_CONSTANT) {
+            state[sensors+i] = -GPR_MAX_CONSTANT;
+        }
+    }
 
-                state[sens+i] =
-                    1.0f / (1.0f + exp(-state[sens+i]));
-                break;
+    /* set the actuator values, which have no imaginary part */
+    ctr = sensors + (rows*columns);
+    n = rows*columns*gene_size;
+    for (k = 0; k < actuators; k++, ctr++, n++) {
+        state[ctr] = state[(int)gene[n]];
+        state[ctr+no_of_states] = 0;
+    }
+}
+
+/* an integer version of the run function */
+void gprc_run_int(gprc_function * f,
+                  int ADF_module,
+                  int rows, int columns,
+                  int connections_per_gene,
+                  int sensors, int actuators,
+                  float dropout_prob, int dynamic,
+                  float (*custom_function)(float,float,float))
+{
+    int n=0,i=0,j,k,g,ctr,src,dest,no_of_args,instr_index;
+    int no_of_instructions, function_type;
+    int * program, * instr, * con;
+    int decoded[connections_per_gene];
+    float * gp, a, b, c, d, a2, b2;
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int block_from,block_to, no_of_states;
+    unsigned int dropout = gprc_dropout_threshold(dropout_prob);
+    unsigned long long dropout_key = 0, dropout_hash = 0;
+    int dropout_index = -1;
+    int sens = gprc_get_sensors(ADF_module,sensors);
+    float * gene = f->genome[ADF_module].gene;
+    unsigned char * used = f->genome[ADF_module].used;
+    float * state = f->genome[ADF_module].state;
+
+    actuators = gprc_get_actuators(ADF_module,actuators);
+    no_of_states = (rows*columns) + sens + actuators;
+
+    /* each run of the main program is a new time step */
+    if (ADF_module == 0) gprc_clear_ADF_calls(f);
+
+    /* if possible run only the compiled list of used genes */
+    program = gprc_compiled_program(f, ADF_module, rows, columns,
+                                    connections_per_gene, sensors,
+                                    dynamic);
+    no_of_instructions = rows*columns;
+    if (program) {
+        no_of_instructions = f->genome[ADF_module].program_length;
+    }
+
+    /* a different set of genes is dropped on each run */
+    if (dropout > 0) dropout_key = rand_num(&f->random_seed);
+
+    for (instr_index = 0; instr_index < no_of_instructions;
+         instr_index++) {
+        if (program) {
+            instr = &program[instr_index *
+                             GPRC_INSTR_SIZE(connections_per_gene)];
+            i = instr[GPRC_INSTR_GENE];
+            n = i * gene_size;
+            function_type = instr[GPRC_INSTR_FUNCTION_TYPE];
+            no_of_args = instr[GPRC_INSTR_ARGS];
+            con = &instr[GPRC_INSTR_INITIAL];
+        }
+        else {
+            i = instr_index;
+            n = i * gene_size;
+
+            /* if this function is not on the path
+               between sensors and actuators then skip it
+               since it has no effect upon the program behavior */
+            if ((dynamic <= 0) && (used[i+sens] == 0)) {
+                continue;
             }
-            case GPR_FUNCTION_ADD: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                a = 0; b = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    k = (int)gp[GPRC_INITIAL+j];
-                    c = (int)state[k];
-                    d = (int)state[k + no_of_states];
-                    a += c;
-                    b += d;
-                }
-                state[sens+i] = a;
-                state[sens+i+no_of_states] = b;
-                break;
+
+            /* decode the gene, which may have been
+               altered by a previous dynamic function */
+            function_type = (int)gene[n+GPRC_GENE_FUNCTION_TYPE];
+            no_of_args =
+                gprc_function_args(function_type,
+                                   gene[n+GPRC_GENE_CONSTANT],
+                                   connections_per_gene,
+                                   (int)gene[n+GPRC_INITIAL]);
+            for (j = 0; j < connections_per_gene; j++) {
+                decoded[j] = (int)gene[n+GPRC_INITIAL+j];
             }
-            case GPR_FUNCTION_SUBTRACT: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                a = 0; b = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    k = (int)gp[GPRC_INITIAL+j];
-                    c = (int)state[k];
-                    d = (int)state[k + no_of_states];
-                    if (j > 0) {
-                        a -= c;
-                        b -= d;
-                    }
-                    else {
-                        a = c;
-                        b = d;
-                    }
-                }
-                state[sens+i] = a;
-                state[sens+i+no_of_states] = b;
-                break;
+            con = decoded;
+        }
+
+        /* occasional dropout helps to avoid overfitting*/
+        if ((dropout > 0) &&
+            gprc_dropout_gene(dropout_key, dropout, instr_index,
+                              &dropout_index, &dropout_hash)) {
+            continue;
+        }
+
+        gp = &gene[n];
+        switch(function_type) {
+        case GPR_FUNCTION_DATA_PUSH: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_set_head(&f->data,
+                                  ((unsigned int)state[con[0]])%f->data.fields,
+                                  (int)state[con[1]],
+                                  (int)state[con[1]+no_of_states]);
+                gpr_data_push(&f->data);
             }
-            case GPR_FUNCTION_NEGATE: {
-                state[sens+i] = -(int)state[(int)gp[GPRC_INITIAL]];
-                state[sens+i+no_of_states] =
-                    -(int)state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+            break;
+        }
+        case GPR_FUNCTION_DATA_POP: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_get_tail(&f->data,
+                                  ((unsigned int)state[con[0]])%f->data.fields,
+                                  &state[sens+i],
+                                  &state[sens+i+no_of_states]);
+                state[sens+i] = (int)state[sens+i];
+                state[sens+i+no_of_states] = (int)state[sens+i+no_of_states];
+                gpr_data_pop(&f->data);
             }
-            case GPR_FUNCTION_MULTIPLY: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                a = 0; b = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    k = (int)gp[GPRC_INITIAL+j];
-                    c = (int)state[k];
-                    d = (int)state[k + no_of_states];
-                    if (j > 0) {
-                        a2 = (int)((a*c) + (b*d));
-                        b2 = (int)((b*c) + (a*d));
-                        a = a2;
-                        b = b2;
-                    }
-                    else {
-                        a = c;
-                        b = d;
-                    }
-                }
-                state[sens+i] = a;
-                state[sens+i+no_of_states] = b;
-                break;
+            break;
+        }
+        case GPR_FUNCTION_DATA_GET: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_get_elem(&f->data,
+                                  (unsigned int)state[con[0]],
+                                  ((unsigned int)state[con[1]])%(f->data.fields),
+                                  &state[sens+i],
+                                  &state[sens+i+no_of_states]);
+                state[sens+i] = (int)state[sens+i];
+                state[sens+i+no_of_states] = (int)state[sens+i+no_of_states];
             }
-            case GPR_FUNCTION_WEIGHT: {
-                state[sens+i] = state[(int)gp[GPRC_INITIAL]] *
-                    (int)gp[GPRC_GENE_CONSTANT];
-                state[sens+i+no_of_states] =
-                    state[(int)gp[GPRC_INITIAL]+no_of_states] *
-                    (int)gp[GPRC_GENE_CONSTANT];
-                break;
+            break;
+        }
+        case GPR_FUNCTION_DATA_SET: {
+            if ((f->data.size > 0) && (f->data.fields > 0)) {
+                gpr_data_set_elem(&f->data,
+                                  (unsigned int)state[con[0]],
+                                  ((unsigned int)state[con[1]])%(f->data.fields),
+                                  (int)state[sens+i],
+                                  (int)state[sens+i+no_of_states]);
             }
-            case GPR_FUNCTION_DIVIDE: {
-                j = (int)gp[GPRC_INITIAL];
-                k = (int)gp[1+GPRC_INITIAL];
-                if((state[k] <= 1e-1) &&
-                   (state[k] >= -1e-1)) {
-                    state[sens+i] = state[j];
-                    state[sens+i+no_of_states] = state[k];
+            break;
+        }
+        case GPR_FUNCTION_GET: {
+            j = abs((int)state[con[0]] +
+                    (int)state[con[1]])
+                %(rows*columns);
+            state[sens+i] = (int)state[sens+j];
+            state[sens+i+no_of_states] =
+                (int)state[sens+j+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_SET: {
+            j = abs((int)state[con[1]])
+                %(rows*columns);
+            state[sens+i] =
+                (int)gp[GPRC_GENE_CONSTANT]*
+                (int)state[con[0]];
+            state[sens+i+no_of_states] =
+                (int)gp[GPRC_GENE_CONSTANT]*
+                (int)state[con[0]+
+                           no_of_states];
+            state[sens+j] = (int)state[sens+i];
+            state[sens+j+no_of_states] =
+                (int)state[sens+i+no_of_states];
+            if (state[sens+j] > GPR_MAX_CONSTANT) {
+                state[sens+j] = GPR_MAX_CONSTANT;
+            }
+            if (state[sens+j+no_of_states] >
+                GPR_MAX_CONSTANT) {
+                state[sens+j+no_of_states] =
+                    GPR_MAX_CONSTANT;
+            }
+            if (state[sens+j] < -GPR_MAX_CONSTANT) {
+                state[sens+j] = -GPR_MAX_CONSTANT;
+            }
+            if (state[sens+j+no_of_states] <
+                -GPR_MAX_CONSTANT) {
+                state[sens+j+no_of_states] =
+                    -GPR_MAX_CONSTANT;
+            }
+            break;
+        }
+        case GPR_FUNCTION_ADF: {
+            gprc_c_run_ADF(f, ADF_module, i,
+                           gp, rows, columns,
+                           connections_per_gene,
+                           sensors, actuators,
+                           dropout_prob, dynamic,
+                           (*custom_function),1);
+            break;
+        }
+        case GPR_FUNCTION_CUSTOM: {
+            if (*custom_function) {
+                state[sens+i] =
+                    (*custom_function)((int)gp[GPRC_GENE_CONSTANT],
+                                       con[0],
+                                       (int)gp[GPRC_GENE_CONSTANT]);
+            }
+            break;
+        }
+        case GPR_FUNCTION_VALUE: {
+            state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
+            state[sens+i+no_of_states] =
+                (int)gp[GPRC_GENE_CONSTANT+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_SIGMOID: {
+            state[sens+i] = 0;
+            for (j = 0; j < no_of_args; j++) {
+                state[sens+i] +=
+                    state[con[j]]*
+                    gp[GPRC_INITIAL+j+connections_per_gene];
+            }
+
+            state[sens+i] =
+                1.0f / (1.0f + exp(-state[sens+i]));
+            break;
+        }
+        case GPR_FUNCTION_ADD: {
+            a = 0; b = 0;
+            for (j = 0; j < no_of_args; j++) {
+                k = con[j];
+                c = (int)state[k];
+                d = (int)state[k + no_of_states];
+                a += c;
+                b += d;
+            }
+            state[sens+i] = a;
+            state[sens+i+no_of_states] = b;
+            break;
+        }
+        case GPR_FUNCTION_SUBTRACT: {
+            a = 0; b = 0;
+            for (j = 0; j < no_of_args; j++) {
+                k = con[j];
+                c = (int)state[k];
+                d = (int)state[k + no_of_states];
+                if (j > 0) {
+                    a -= c;
+                    b -= d;
                 }
                 else {
-                    a = (int)state[j];
-                    b = (int)state[j + no_of_states];
-                    c = (int)state[k];
-                    d = (int)state[k + no_of_states];
-                    state[sens+i] =
-                        (int)(((a*c) + (b*d)) / ((c*c) + (d*d)));
-                    state[sens+i+no_of_states] =
-                        (int)(((b*c) - (a*d)) / ((c*c) + (d*d)));
+                    a = c;
+                    b = d;
                 }
-                break;
             }
-            case GPR_FUNCTION_MODULUS: {
-                if ((int)state[(int)gp[1+GPRC_INITIAL]] == 0) {
-                    state[sens+i] = (int)state[(int)gp[GPRC_INITIAL]];
-                    state[sens+i+no_of_states] =
-                        (int)state[(int)gp[GPRC_INITIAL]+no_of_states];
+            state[sens+i] = a;
+            state[sens+i+no_of_states] = b;
+            break;
+        }
+        case GPR_FUNCTION_NEGATE: {
+            state[sens+i] = -(int)state[con[0]];
+            state[sens+i+no_of_states] =
+                -(int)state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_MULTIPLY: {
+            a = 0; b = 0;
+            for (j = 0; j < no_of_args; j++) {
+                k = con[j];
+                c = (int)state[k];
+                d = (int)state[k + no_of_states];
+                if (j > 0) {
+                    a2 = (int)((a*c) + (b*d));
+                    b2 = (int)((b*c) + (a*d));
+                    a = a2;
+                    b = b2;
                 }
                 else {
-                    /* a is the real part of numerator,
-                       b is the imaginary part or numerator */
-                    a = (int)state[(int)gp[GPRC_INITIAL]];
-                    b = (int)state[(int)gp[GPRC_INITIAL]+no_of_states];
-                    /* c is the real part of denominator,
-                       d is the imaginary part or denominator */
-                    c = (int)state[(int)gp[1+GPRC_INITIAL]];
-                    d = (int)state[(int)gp[1+GPRC_INITIAL]+no_of_states];
-                    if (b+d == 0) {
-                        /* if there is no imaginary component */
-                        state[sens+i] = (int)a % (int)c;
-                        state[sens+i+no_of_states] = 0;
-                    }
-                    else {
-                        /* the meaning of "modulus" here is what
-                           remains when (a+ib) is divided by
-                           (c + id) */
-                        state[sens+i] =
-                            (int)((a*c) + (b*d)) % (int)((c*c) + (d*d));
-                        state[sens+i+no_of_states] =
-                            (int)((b*c) - (a*d)) % (int)((c*c) + (d*d));
-                    }
+                    a = c;
+                    b = d;
                 }
-                break;
             }
-            case GPR_FUNCTION_FLOOR: {
-                state[sens+i] = (int)state[(int)gp[GPRC_INITIAL]];
+            state[sens+i] = a;
+            state[sens+i+no_of_states] = b;
+            break;
+        }
+        case GPR_FUNCTION_WEIGHT: {
+            state[sens+i] = state[con[0]] *
+                (int)gp[GPRC_GENE_CONSTANT];
+            state[sens+i+no_of_states] =
+                state[con[0]+no_of_states] *
+                (int)gp[GPRC_GENE_CONSTANT];
+            break;
+        }
+        case GPR_FUNCTION_DIVIDE: {
+            j = con[0];
+            k = con[1];
+            if((state[k] <= 1e-1) &&
+               (state[k] >= -1e-1)) {
+                state[sens+i] = state[j];
+                state[sens+i+no_of_states] = state[k];
+            }
+            else {
+                a = (int)state[j];
+                b = (int)state[j + no_of_states];
+                c = (int)state[k];
+                d = (int)state[k + no_of_states];
+                state[sens+i] =
+                    (int)(((a*c) + (b*d)) / ((c*c) + (d*d)));
                 state[sens+i+no_of_states] =
-                    (int)state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+                    (int)(((b*c) - (a*d)) / ((c*c) + (d*d)));
             }
-            case GPR_FUNCTION_AVERAGE: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                state[sens+i] = (int)state[(int)gp[GPRC_INITIAL]];
+            break;
+        }
+        case GPR_FUNCTION_MODULUS: {
+            if ((int)state[con[1]] == 0) {
+                state[sens+i] = (int)state[con[0]];
                 state[sens+i+no_of_states] =
-                    (int)state[(int)gp[GPRC_INITIAL]+no_of_states];
-                for (j = 0; j < no_of_args; j++) {
-                    state[sens+i] += (int)state[(int)gp[GPRC_INITIAL+j]];
-                    state[sens+i+no_of_states] +=
-                        (int)state[(int)gp[GPRC_INITIAL+j]+no_of_states];
+                    (int)state[con[0]+no_of_states];
+            }
+            else {
+                /* a is the real part of numerator,
+                   b is the imaginary part or numerator */
+                a = (int)state[con[0]];
+                b = (int)state[con[0]+no_of_states];
+                /* c is the real part of denominator,
+                   d is the imaginary part or denominator */
+                c = (int)state[con[1]];
+                d = (int)state[con[1]+no_of_states];
+                if (b+d == 0) {
+                    /* if there is no imaginary component */
+                    state[sens+i] = (int)a % (int)c;
+                    state[sens+i+no_of_states] = 0;
+                }
+                else {
+                    /* the meaning of "modulus" here is what
+                       remains when (a+ib) is divided by
+                       (c + id) */
+                    state[sens+i] =
+                        (int)((a*c) + (b*d)) % (int)((c*c) + (d*d));
+                    state[sens+i+no_of_states] =
+                        (int)((b*c) - (a*d)) % (int)((c*c) + (d*d));
                 }
-                state[sens+i] /= no_of_args;
-                state[sens+i+no_of_states] /= no_of_args;
-                break;
             }
-            case GPR_FUNCTION_NOOP1: {
-                state[sens+i] = (int)state[(int)gp[GPRC_INITIAL]];
+            break;
+        }
+        case GPR_FUNCTION_FLOOR: {
+            state[sens+i] = (int)state[con[0]];
+            state[sens+i+no_of_states] =
+                (int)state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_AVERAGE: {
+            state[sens+i] = (int)state[con[0]];
+            state[sens+i+no_of_states] =
+                (int)state[con[0]+no_of_states];
+            for (j = 0; j < no_of_args; j++) {
+                state[sens+i] += (int)state[con[j]];
+                state[sens+i+no_of_states] +=
+                    (int)state[con[j]+no_of_states];
+            }
+            state[sens+i] /= no_of_args;
+            state[sens+i+no_of_states] /= no_of_args;
+            break;
+        }
+        case GPR_FUNCTION_NOOP1: {
+            state[sens+i] = (int)state[con[0]];
+            state[sens+i+no_of_states] =
+                (int)state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_NOOP2: {
+            state[sens+i] = (int)state[con[0]];
+            state[sens+i+no_of_states] =
+                (int)state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_NOOP3: {
+            state[sens+i] = (int)state[con[0]];
+            state[sens+i+no_of_states] =
+                (int)state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_NOOP4: {
+            state[sensors+i] = (int)state[con[0]];
+            state[sens+i+no_of_states] =
+                (int)state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_GREATER_THAN: {
+            if ((int)state[con[0]] >
+                (int)state[con[1]]) {
+                state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
                 state[sens+i+no_of_states] =
-                    (int)state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+                    (int)gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_NOOP2: {
-                state[sens+i] = (int)state[(int)gp[GPRC_INITIAL]];
-                state[sens+i+no_of_states] =
-                    (int)state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_NOOP3: {
-                state[sens+i] = (int)state[(int)gp[GPRC_INITIAL]];
+            break;
+        }
+        case GPR_FUNCTION_LESS_THAN: {
+            if ((int)state[con[0]] <
+                (int)state[con[1]]) {
+                state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
                 state[sens+i+no_of_states] =
-                    (int)state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+                    (int)gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_NOOP4: {
-                state[sensors+i] = (int)state[(int)gp[GPRC_INITIAL]];
-                state[sens+i+no_of_states] =
-                    (int)state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_GREATER_THAN: {
-                if ((int)state[(int)gp[GPRC_INITIAL]] >
-                    (int)state[(int)gp[1+GPRC_INITIAL]]) {
-                    state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        (int)gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_EQUALS: {
+            if (((int)state[con[0]] ==
+                 (int)state[con[1]]) &&
+                ((int)state[con[0]+no_of_states] ==
+                 (int)state[con[1]+no_of_states])) {
+                state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
+                state[sens+i+no_of_states] =
+                    (int)gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_LESS_THAN: {
-                if ((int)state[(int)gp[GPRC_INITIAL]] <
-                    (int)state[(int)gp[1+GPRC_INITIAL]]) {
-                    state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        (int)gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_EQUALS: {
-                if (((int)state[(int)gp[GPRC_INITIAL]] ==
-                     (int)state[(int)gp[1+GPRC_INITIAL]]) &&
-                    ((int)state[(int)gp[GPRC_INITIAL]+no_of_states] ==
-                     (int)state[(int)gp[1+GPRC_INITIAL]+no_of_states])) {
-                    state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        (int)gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_AND: {
+            if (((int)state[con[0]]>0) &&
+                ((int)state[con[1]]>0)) {
+                state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
+                state[sens+i+no_of_states] =
+                    (int)gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_AND: {
-                if (((int)state[(int)gp[GPRC_INITIAL]]>0) &&
-                    ((int)state[(int)gp[1+GPRC_INITIAL]]>0)) {
-                    state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        (int)gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_OR: {
-                if (((int)state[(int)gp[GPRC_INITIAL]]>0) ||
-                    ((int)state[(int)gp[1+GPRC_INITIAL]]>0)) {
-                    state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        (int)gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_OR: {
+            if (((int)state[con[0]]>0) ||
+                ((int)state[con[1]]>0)) {
+                state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
+                state[sens+i+no_of_states] =
+                    (int)gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_XOR: {
-                if (((int)state[(int)gp[GPRC_INITIAL]]>0) !=
-                    ((int)state[(int)gp[1+GPRC_INITIAL]]>0)) {
-                    state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        (int)gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_NOT: {
-                if (((int)state[(int)gp[GPRC_INITIAL]]) !=
-                    ((int)state[(int)gp[1+GPRC_INITIAL]])) {
-                    state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
-                    state[sens+i+no_of_states] =
-                        (int)gp[GPRC_GENE_IMAGINARY];
-                }
-                else {
-                    state[sens+i] = 0;
-                    state[sens+i+no_of_states] = 0;
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_XOR: {
+            if (((int)state[con[0]]>0) !=
+                ((int)state[con[1]]>0)) {
+                state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
+                state[sens+i+no_of_states] =
+                    (int)gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_HEBBIAN: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                /* update the output */
+            else {
                 state[sens+i] = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    state[sens+i] +=
-                        state[(int)gp[GPRC_INITIAL+j]] *
-                        gp[GPRC_INITIAL+j+connections_per_gene];
-                }
-                /* adjust weights.  Here the imaginary
-                   component is used to represent the total weight change */
                 state[sens+i+no_of_states] = 0;
-                for (j = 0; j < no_of_args; j++) {
-                    /* change in the weight value */
-                    a = state[sens+i] * state[(int)gp[GPRC_INITIAL+j]] *
-                        GPR_HEBBIAN_LEARNING_RATE;
-                    /* alter the weight */
-                    gp[GPRC_INITIAL+j+connections_per_gene] += a;
-                    /* store the total change */
-                    state[sens+i+no_of_states] += a;
-                }
-                break;
             }
-            case GPR_FUNCTION_EXP: {
-                state[sens+i] =
-                    (int)exp((int)state[(int)gp[GPRC_INITIAL]]);
+            break;
+        }
+        case GPR_FUNCTION_NOT: {
+            if (((int)state[con[0]]) !=
+                ((int)state[con[1]])) {
+                state[sens+i] = (int)gp[GPRC_GENE_CONSTANT];
                 state[sens+i+no_of_states] =
-                    (int)exp((int)state[(int)gp[GPRC_INITIAL]+no_of_states]);
-                break;
+                    (int)gp[GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_SQUARE_ROOT: {
-                k = (int)gp[GPRC_INITIAL];
-                a = (int)state[k];
-                b = (int)state[k+no_of_states];
-                if (b == 0) {
-                    state[sens+i] =
-                        (int)sqrt(fabs(state[k]));
-                    state[sens+i+no_of_states] = 0;
-                }
-                else {
-                    a2 = (int)sqrt((a*a) + (b*b));
-                    state[sens+i] =
-                        (int)sqrt((a + a2) * 0.5f);
-                    state[sens+i+no_of_states] =
-                        (int)sqrt((-a + a2) * 0.5f);
-                    if (b < 0) {
-                        state[sens+i+no_of_states] =
-                            -state[sens+i+no_of_states];
-                    }
-                }
-                break;
+            else {
+                state[sens+i] = 0;
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_ABS: {
-                k = (int)gp[GPRC_INITIAL];
-                a = (int)state[k];
-                b = (int)state[k+no_of_states];
-                if (b == 0) {
-                    /* if this is an ordinary number */
-                    state[sens+i] =
-                        (int)abs((int)state[(int)gp[GPRC_INITIAL]]);
-                }
-                else {
-                    /* if this is a complex number */
-                    state[sens+i] =
-                        (int)sqrt((a*a) + (b*b));
-                }
+            break;
+        }
+        case GPR_FUNCTION_HEBBIAN: {
+            gprc_snapshot_gene(f, ADF_module, i);
+            /* update the output */
+            state[sens+i] = 0;
+            for (j = 0; j < no_of_args; j++) {
+                state[sens+i] +=
+                    state[con[j]] *
+                    gp[GPRC_INITIAL+j+connections_per_gene];
+            }
+            /* adjust weights.  Here the imaginary
+               component is used to represent the total weight change */
+            state[sens+i+no_of_states] = 0;
+            for (j = 0; j < no_of_args; j++) {
+                /* change in the weight value */
+                a = state[sens+i] * state[con[j]] *
+                    GPR_HEBBIAN_LEARNING_RATE;
+                /* alter the weight */
+                gp[GPRC_INITIAL+j+connections_per_gene] += a;
+                /* store the total change */
+                state[sens+i+no_of_states] += a;
+            }
+            break;
+        }
+        case GPR_FUNCTION_EXP: {
+            state[sens+i] =
+                (int)exp((int)state[con[0]]);
+            state[sens+i+no_of_states] =
+                (int)exp((int)state[con[0]+no_of_states]);
+            break;
+        }
+        case GPR_FUNCTION_SQUARE_ROOT: {
+            k = con[0];
+            a = (int)state[k];
+            b = (int)state[k+no_of_states];
+            if (b == 0) {
+                state[sens+i] =
+                    (int)sqrt(fabs(state[k]));
                 state[sens+i+no_of_states] = 0;
-                break;
             }
-            case GPR_FUNCTION_SINE: {
-                k = (int)gp[GPRC_INITIAL];
-                a = state[k];
-                b = state[k+no_of_states];
-                if (b == 0) {
-                    state[sens+i] =
-                        (int)(sin(a)*256);
-                    state[sens+i+no_of_states] = 0;
-                }
-                else {
-                    state[sens+i] =
-                        (int)((sin(a)*cosh(b))*256);
+            else {
+                a2 = (int)sqrt((a*a) + (b*b));
+                state[sens+i] =
+                    (int)sqrt((a + a2) * 0.5f);
+                state[sens+i+no_of_states] =
+                    (int)sqrt((-a + a2) * 0.5f);
+                if (b < 0) {
                     state[sens+i+no_of_states] =
-                        (int)((cos(a)*sinh(b))*256);
+                        -state[sens+i+no_of_states];
                 }
-                break;
             }
-            case GPR_FUNCTION_ARCSINE: {
+            break;
+        }
+        case GPR_FUNCTION_ABS: {
+            k = con[0];
+            a = (int)state[k];
+            b = (int)state[k+no_of_states];
+            if (b == 0) {
+                /* if this is an ordinary number */
                 state[sens+i] =
-                    (int)asin((int)state[(int)gp[GPRC_INITIAL]]);
-                break;
+                    (int)abs((int)state[con[0]]);
             }
-            case GPR_FUNCTION_COSINE: {
-                k = (int)gp[GPRC_INITIAL];
-                a = state[k];
-                b = state[k+no_of_states];
-                if (b == 0) {
-                    state[sens+i] =
-                        (int)(cos(a)*256);
-                    state[sens+i+no_of_states] = 0;
-                }
-                else {
-                    state[sens+i] =
-                        (int)((cos(a)*cosh(b))*256);
-                    state[sens+i+no_of_states] =
-                        (int)((sin(a)*sinh(b))*256);
-                }
-                break;
+            else {
+                /* if this is a complex number */
+                state[sens+i] =
+                    (int)sqrt((a*a) + (b*b));
+            }
+            state[sens+i+no_of_states] = 0;
+            break;
+        }
+        case GPR_FUNCTION_SINE: {
+            k = con[0];
+            a = state[k];
+            b = state[k+no_of_states];
+            if (b == 0) {
+                state[sens+i] =
+                    (int)(sin(a)*256);
+                state[sens+i+no_of_states] = 0;
+            }
+            else {
+                state[sens+i] =
+                    (int)((sin(a)*cosh(b))*256);
+                state[sens+i+no_of_states] =
+                    (int)((cos(a)*sinh(b))*256);
             }
-            case GPR_FUNCTION_ARCCOSINE: {
+            break;
+        }
+        case GPR_FUNCTION_ARCSINE: {
+            state[sens+i] =
+                (int)asin((int)state[con[0]]);
+            break;
+        }
+        case GPR_FUNCTION_COSINE: {
+            k = con[0];
+            a = state[k];
+            b = state[k+no_of_states];
+            if (b == 0) {
                 state[sens+i] =
-                    (int)acos((int)state[(int)gp[GPRC_INITIAL]]);
-                break;
+                    (int)(cos(a)*256);
+                state[sens+i+no_of_states] = 0;
             }
-            case GPR_FUNCTION_POW: {
+            else {
                 state[sens+i] =
-                    (int)pow((int)state[(int)gp[GPRC_INITIAL]],
-                             (int)state[(int)gp[1+GPRC_INITIAL]]);
+                    (int)((cos(a)*cosh(b))*256);
                 state[sens+i+no_of_states] =
-                    (int)pow((int)state[(int)gp[GPRC_INITIAL]+no_of_states],
-                             (int)state[(int)gp[1+GPRC_INITIAL]+no_of_states]);
-                break;
-            }
-            case GPR_FUNCTION_MIN: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                state[sens+i] = (int)state[(int)gp[GPRC_INITIAL]];
-                for (j = 1; j < no_of_args; j++) {
-                    if ((int)state[(int)gp[GPRC_INITIAL+j]] <
-                        state[sens+i]) {
-                        state[sens+i] =
-                            (int)state[(int)gp[GPRC_INITIAL+j]];
-                        state[sens+i+no_of_states] =
-                            (int)state[(int)gp[GPRC_INITIAL+j]+no_of_states];
-                    }
-                }
-                break;
+                    (int)((sin(a)*sinh(b))*256);
             }
-            case GPR_FUNCTION_MAX: {
-                no_of_args =
-                    1 + (abs((int)gp[GPRC_GENE_CONSTANT])%
-                         (connections_per_gene-1));
-                state[sens+i] = (int)state[(int)gp[GPRC_INITIAL]];
-                for (j = 1; j < no_of_args; j++) {
-                    if ((int)state[(int)gp[GPRC_INITIAL+j]] >
-                        state[sens+i]) {
-                        state[sens+i] =
-                            (int)state[(int)gp[GPRC_INITIAL+j]];
-                        state[sens+i+no_of_states] =
-                            (int)state[(int)gp[GPRC_INITIAL+j]+no_of_states];
-                    }
+            break;
+        }
+        case GPR_FUNCTION_ARCCOSINE: {
+            state[sens+i] =
+                (int)acos((int)state[con[0]]);
+            break;
+        }
+        case GPR_FUNCTION_POW: {
+            state[sens+i] =
+                (int)pow((int)state[con[0]],
+                         (int)state[con[1]]);
+            state[sens+i+no_of_states] =
+                (int)pow((int)state[con[0]+no_of_states],
+                         (int)state[con[1]+no_of_states]);
+            break;
+        }
+        case GPR_FUNCTION_MIN: {
+            state[sens+i] = (int)state[con[0]];
+            for (j = 1; j < no_of_args; j++) {
+                if ((int)state[con[j]] <
+                    state[sens+i]) {
+                    state[sens+i] =
+                        (int)state[con[j]];
+                    state[sens+i+no_of_states] =
+                        (int)state[con[j]+no_of_states];
                 }
-                break;
             }
-            case GPR_FUNCTION_COPY_FUNCTION: {
-                if (((int)gp[GPRC_INITIAL] > sens) &&
-                    ((int)gp[1+GPRC_INITIAL] > sens)) {
-                    src = ((int)gp[GPRC_INITIAL]-sens) * gene_size;
-                    dest = ((int)gp[1+GPRC_INITIAL]-sens) * gene_size;
-                    gene[dest] = gene[src];
+            break;
+        }
+        case GPR_FUNCTION_MAX: {
+            state[sens+i] = (int)state[con[0]];
+            for (j = 1; j < no_of_args; j++) {
+                if ((int)state[con[j]] >
+                    state[sens+i]) {
+                    state[sens+i] =
+                        (int)state[con[j]];
+                    state[sens+i+no_of_states] =
+                        (int)state[con[j]+no_of_states];
                 }
-                break;
             }
-            case GPR_FUNCTION_COPY_CONSTANT: {
-                if (((int)gp[GPRC_INITIAL] > sens) &&
-                    ((int)gp[1+GPRC_INITIAL] > sens)) {
-                    src = ((int)gp[GPRC_INITIAL]-sens) * gene_size;
-                    dest = ((int)gp[1+GPRC_INITIAL]-sens) * gene_size;
-                    gene[dest+GPRC_GENE_CONSTANT] =
-                        gene[src+GPRC_GENE_CONSTANT];
-                    gene[dest+GPRC_GENE_IMAGINARY] =
-                        gene[src+GPRC_GENE_IMAGINARY];
-                }
-                break;
+            break;
+        }
+        case GPR_FUNCTION_COPY_FUNCTION: {
+            if ((con[0] > sens) &&
+                (con[1] > sens)) {
+                src = (con[0]-sens) * gene_size;
+                dest = (con[1]-sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, con[1]-sens);
+                gene[dest] = gene[src];
             }
-            case GPR_FUNCTION_COPY_STATE: {
-                state[(int)gp[1+GPRC_INITIAL]] =
-                    state[(int)gp[GPRC_INITIAL]];
-                state[(int)gp[1+GPRC_INITIAL]+no_of_states] =
-                    state[(int)gp[GPRC_INITIAL]+no_of_states];
-                break;
+            break;
+        }
+        case GPR_FUNCTION_COPY_CONSTANT: {
+            if ((con[0] > sens) &&
+                (con[1] > sens)) {
+                src = (con[0]-sens) * gene_size;
+                dest = (con[1]-sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, con[1]-sens);
+                gene[dest+GPRC_GENE_CONSTANT] =
+                    gene[src+GPRC_GENE_CONSTANT];
+                gene[dest+GPRC_GENE_IMAGINARY] =
+                    gene[src+GPRC_GENE_IMAGINARY];
             }
-            case GPR_FUNCTION_COPY_BLOCK: {
-                block_from = (int)gp[GPRC_INITIAL];
-                block_to = (int)gp[1+GPRC_INITIAL];
-                if (block_from<block_to) {
-                    block_from = (int)gp[1+GPRC_INITIAL];
-                    block_to = (int)gp[GPRC_INITIAL];
-                }
-                k = block_to - GPR_BLOCK_WIDTH;
-                for (j = block_from - GPR_BLOCK_WIDTH;
-                     j <= block_from + GPR_BLOCK_WIDTH; j++,k++) {
-                    if ((j>sens) &&
-                        (k>sens) &&
-                        (j<i) && (k<i)) {
-
-                        for (g = 0; g < gene_size; g++) {
-                            gene[(j-sens)*gene_size + g] =
-                                gene[(k-sens)*gene_size + g];
-                        }
+            break;
+        }
+        case GPR_FUNCTION_COPY_STATE: {
+            state[con[1]] =
+                state[con[0]];
+            state[con[1]+no_of_states] =
+                state[con[0]+no_of_states];
+            break;
+        }
+        case GPR_FUNCTION_COPY_BLOCK: {
+            block_from = con[0];
+            block_to = con[1];
+            if (block_from<block_to) {
+                block_from = con[1];
+                block_to = con[0];
+            }
+            k = block_to - GPR_BLOCK_WIDTH;
+            for (j = block_from - GPR_BLOCK_WIDTH;
+                 j <= block_from + GPR_BLOCK_WIDTH; j++,k++) {
+                if ((j>sens) &&
+                    (k>sens) &&
+                    (j<i) && (k<i)) {
+                    gprc_alter_gene(f, ADF_module, j-sens);
+                    for (g = 0; g < gene_size; g++) {
+                        gene[(j-sens)*gene_size + g] =
+                            gene[(k-sens)*gene_size + g];
                     }
                 }
-                break;
-            }
-            case GPR_FUNCTION_COPY_CONNECTION1: {
-                if (gp[GPRC_INITIAL] > sens) {
-                    src = ((int)gp[GPRC_INITIAL] - sens) * gene_size;
-                    gp[1+GPRC_INITIAL] = gene[src+GPRC_INITIAL];
-                }
-                break;
-            }
-            case GPR_FUNCTION_COPY_CONNECTION2: {
-                if (gp[1+GPRC_INITIAL] > sens) {
-                    src = ((int)gp[1+GPRC_INITIAL] - sens) * gene_size;
-                    gp[GPRC_INITIAL] = gene[src+GPRC_INITIAL];
-                }
-                break;
-            }
-            case GPR_FUNCTION_COPY_CONNECTION3: {
-                if (gp[1+GPRC_INITIAL] > sens) {
-                    src = ((int)gp[1+GPRC_INITIAL] - sens) * gene_size;
-                    gp[GPRC_INITIAL] = gene[src+1+GPRC_INITIAL];
-                }
-                break;
-            }
-            case GPR_FUNCTION_COPY_CONNECTION4: {
-                if (gp[GPRC_INITIAL] > sens) {
-                    src = ((int)gp[GPRC_INITIAL] - sens) * gene_size;
-                    gp[1+GPRC_INITIAL] = gene[src+1+GPRC_INITIAL];
-                }
-                break;
-            }
-            }
-            /* prevent values from going out of range */
-            if (is_nan(state[sens+i])) {
-                state[sens+i] = 0;
-            }
-            if (is_nan(state[sens+i+no_of_states])) {
-                state[sens+i+no_of_states] = 0;
             }
-            if (state[sens+i] > GPR_MAX_CONSTANT) {
-                state[sens+i] = GPR_MAX_CONSTANT;
+            break;
+        }
+        case GPR_FUNCTION_COPY_CONNECTION1: {
+            if (gp[GPRC_INITIAL] > sens) {
+                src = (con[0] - sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, i);
+                gp[1+GPRC_INITIAL] = gene[src+GPRC_INITIAL];
             }
-            if (state[sens+i+no_of_states] >
-                GPR_MAX_CONSTANT) {
-                state[sens+i+no_of_states] = GPR_MAX_CONSTANT;
+            break;
+        }
+        case GPR_FUNCTION_COPY_CONNECTION2: {
+            if (gp[1+GPRC_INITIAL] > sens) {
+                src = (con[1] - sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, i);
+                gp[GPRC_INITIAL] = gene[src+GPRC_INITIAL];
             }
-            if (state[sens+i] < -GPR_MAX_CONSTANT) {
-                state[sens+i] = -GPR_MAX_CONSTANT;
+            break;
+        }
+        case GPR_FUNCTION_COPY_CONNECTION3: {
+            if (gp[1+GPRC_INITIAL] > sens) {
+                src = (con[1] - sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, i);
+                gp[GPRC_INITIAL] = gene[src+1+GPRC_INITIAL];
             }
-            if (state[sens+i+no_of_states] <
-                -GPR_MAX_CONSTANT) {
-                state[sens+i+no_of_states] = -GPR_MAX_CONSTANT;
+            break;
+        }
+        case GPR_FUNCTION_COPY_CONNECTION4: {
+            if (gp[GPRC_INITIAL] > sens) {
+                src = (con[0] - sens) * gene_size;
+                gprc_alter_gene(f, ADF_module, i);
+                gp[1+GPRC_INITIAL] = gene[src+1+GPRC_INITIAL];
             }
+            break;
+        }
+        }
+        /* prevent values from going out of range */
+        if (is_nan(state[sens+i])) {
+            state[sens+i] = 0;
+        }
+        if (is_nan(state[sens+i+no_of_states])) {
+            state[sens+i+no_of_states] = 0;
+        }
+        if (state[sens+i] > GPR_MAX_CONSTANT) {
+            state[sens+i] = GPR_MAX_CONSTANT;
+        }
+        if (state[sens+i+no_of_states] >
+            GPR_MAX_CONSTANT) {
+            state[sens+i+no_of_states] = GPR_MAX_CONSTANT;
+        }
+        if (state[sens+i] < -GPR_MAX_CONSTANT) {
+            state[sens+i] = -GPR_MAX_CONSTANT;
+        }
+        if (state[sens+i+no_of_states] <
+            -GPR_MAX_CONSTANT) {
+            state[sens+i+no_of_states] = -GPR_MAX_CONSTANT;
         }
     }
 
     /* set the actuator values */
-    ctr = sens + i;
+    ctr = sens + (rows*columns);
+    n = rows*columns*gene_size;
     for (i = 0; i < actuators; i++, ctr++, n++) {
         /* real component */
         state[ctr] = (int)state[(int)gene[n]];
@@ -3810,11 +4935,75 @@ void gprc_run_int(gprc_function * f,
     }
 }
 
+/* Returns non-zero if none of the given instructions can produce
+   an imaginary value from real inputs.  Constants, logical
+   functions, division, exponents, powers, hebbian learning and
+   the data store can all introduce imaginary values */
+int gprc_real_only_instruction_set(int * instruction_set,
+                                   int no_of_instructions)
+{
+    int i;
+
+    for (i = 0; i < no_of_instructions; i++) {
+        switch(instruction_set[i]) {
+        case GPR_FUNCTION_ADD:
+        case GPR_FUNCTION_SUBTRACT:
+        case GPR_FUNCTION_NEGATE:
+        case GPR_FUNCTION_MULTIPLY:
+        case GPR_FUNCTION_WEIGHT:
+        case GPR_FUNCTION_MODULUS:
+        case GPR_FUNCTION_FLOOR:
+        case GPR_FUNCTION_AVERAGE:
+        case GPR_FUNCTION_NOOP1:
+        case GPR_FUNCTION_NOOP2:
+        case GPR_FUNCTION_NOOP3:
+        case GPR_FUNCTION_NOOP4:
+        case GPR_FUNCTION_GET:
+        case GPR_FUNCTION_SET:
+        case GPR_FUNCTION_SQUARE_ROOT:
+        case GPR_FUNCTION_ABS:
+        case GPR_FUNCTION_SINE:
+        case GPR_FUNCTION_ARCSINE:
+        case GPR_FUNCTION_COSINE:
+        case GPR_FUNCTION_ARCCOSINE:
+        case GPR_FUNCTION_SIGMOID:
+        case GPR_FUNCTION_MIN:
+        case GPR_FUNCTION_MAX:
+        case GPR_FUNCTION_CUSTOM: {
+            break;
+        }
+        default: {
+            return 0;
+        }
+        }
+    }
+    return 1;
+}
+
+/* Sets whether only the real parts of states are evaluated.
+   This is selected automatically when the population is
+   created if the instruction set can never produce imaginary
+   values, but may also be forced on, in which case the
+   imaginary parts of gene constants are ignored */
+void gprc_set_real_only(gprc_population * population, int real_only)
+{
+    population->real_only = real_only;
+}
+
 void gprc_run(gprc_function * f, gprc_population * population,
               float dropout_prob, int dynamic,
               float (*custom_function)(float,float,float))
 {
-    if (population->integers_only<=0) {
+    if ((population->real_only > 0) &&
+        (population->integers_only <= 0) &&
+        (dynamic <= 0)) {
+        gprc_run_real(f,
+                      population->rows, population->columns,
+                      population->connections_per_gene,
+                      population->sensors, population->actuators,
+                      dropout_prob, (*custom_function));
+    }
+    else if (population->integers_only<=0) {
         gprc_run_float(f, 0,
                        population->rows, population->columns,
                        population->connections_per_gene,
@@ -3850,7 +5039,10 @@ void gprc_run_environment(gprc_function * f, gprc_environment * population,
     }
 }
 
-/* initialize the population */
+/* Initialize the population.  The fitness cache is disabled.
+   If the fitness function is deterministic, such that it doesn't
+   use dropout or random inputs, then it can be enabled with
+   gpr_cache_enable(population->cache, 1) */
 void gprc_init_population(gprc_population * population,
                           int size,
                           int rows, int columns,
@@ -3879,6 +5071,13 @@ void gprc_init_population(gprc_population * population,
     population->min_value = min_value;
     population->max_value = max_value;
     population->integers_only = integers_only;
+    population->real_only =
+        gprc_real_only_instruction_set(instruction_set,
+                                       no_of_instructions);
+    population->offspring = 0;
+    population->neutral_offspring = 0;
+    gpr_cache_init(&population->fitness_cache, GPR_CACHE_SIZE);
+    population->cache = &population->fitness_cache;
     population->fitness = (float*)malloc(size*sizeof(float));
     population->data_size = data_size;
     population->data_fields = data_fields;
@@ -4046,6 +5245,12 @@ void gprc_init_system(gprc_system * system,
         /* clear the average fitness for the population */
         system->fitness[i] = 0;
     }
+
+    /* the islands share a single fitness cache */
+    for (i = 1; i < islands; i++) {
+        gpr_cache_free(&system->island[i].fitness_cache);
+        system->island[i].cache = &system->island[0].fitness_cache;
+    }
 }
 
 /* frees memory for a system */
@@ -4066,6 +5271,7 @@ void gprc_free_population(gprc_population * population)
     }
     free(population->individual);
     free(population->fitness);
+    gpr_cache_free(&population->fitness_cache);
 }
 
 /* deallocates memory for the given environment */
@@ -4078,6 +5284,65 @@ void gprc_free_environment(gprc_environment * population)
     free(population->mating);
 }
 
+/* Evaluates the fitness of one individual, if it has not already
+   been evaluated */
+static void gprc_evaluate_individual(gprc_population * population,
+                                     int i,
+                                     int time_steps, int reevaluate,
+                                     float (*evaluate_program)
+                                     (int,gprc_population*,int,int))
+{
+    if ((population->fitness[i]==0) ||
+        (reevaluate>0)) {
+        int s;
+        unsigned long long key = 0;
+        int length = 0;
+        gprc_function * f = &population->individual[i];
+        unsigned char * used = f->genome[0].used;
+        /* clear the retained state */
+        gprc_clear_state(f,
+                         population->rows, population->columns,
+                         population->sensors,
+                         population->actuators);
+
+        /* is there a path which links sensors to actuators? */
+        for (s = 0; s < population->sensors; s++) {
+            if (used[s] != 0) break;
+        }
+
+        if (s < population->sensors) {
+            /* has the same phenotype been evaluated previously? */
+            if (population->cache->enabled > 0) {
+                key = gprc_phenotype_hash(f,
+                                          population->rows,
+                                          population->columns,
+                                          population->connections_per_gene,
+                                          population->sensors,
+                                          population->actuators);
+                length = f->genome[0].program_length;
+                /* individuals which can't be hashed are never cached */
+                if (key != 0) {
+                    key = gpr_cache_hash(key, &time_steps, sizeof(int));
+                }
+            }
+            if ((reevaluate > 0) ||
+                (gpr_cache_get(population->cache, key, length,
+                               &population->fitness[i]) == 0)) {
+                /* run the evaluation function */
+                population->fitness[i] =
+                    (*evaluate_program)(time_steps,population,i,0);
+                gpr_cache_set(population->cache, key, length,
+                              population->fitness[i]);
+            }
+        }
+        else {
+            /* don't evaluate, since there is no path between
+               sensors and actuators */
+            population->fitness[i] = 0;
+        }
+    }
+}
+
 /* Evaluates the fitness of all individuals in the population.
    Here we use openmp to speed up the process, since each
    evaluation is independent */
@@ -4090,33 +5355,10 @@ void gprc_evaluate(gprc_population * population,
 
 #pragma omp parallel for
     for (i = 0; i < population->size; i++) {
-        if ((population->fitness[i]==0) ||
-            (reevaluate>0)) {
-            int s;
-            gprc_function * f = &population->individual[i];
-            unsigned char * used = f->genome[0].used;
-            /* clear the retained state */
-            gprc_clear_state(f,
-                             population->rows, population->columns,
-                             population->sensors,
-                             population->actuators);
-
-            /* is there a path which links sensors to actuators? */
-            for (s = 0; s < population->sensors; s++) {
-                if (used[s] != 0) break;
-            }
+        gprc_evaluate_individual(population, i,
+                                 time_steps, reevaluate,
+                                 (*evaluate_program));
 
-            if (s < population->sensors) {
-                /* run the evaluation function */
-                population->fitness[i] =
-                    (*evaluate_program)(time_steps,population,i,0);
-            }
-            else {
-                /* don't evaluate, since there is no path between
-                   sensors and actuators */
-                population->fitness[i] = 0;
-            }
-        }
         /* if individual gets too old */
         (&population->individual[i])->age++;
         if ((&population->individual[i])->age>GPR_MAX_AGE) {
@@ -4288,61 +5530,17 @@ int gprc_get_actuator_destination(gprc_function * f, int index)
 /* sorts individuals in order of fitness */
 void gprc_sort(gprc_population * population)
 {
-    int i, j, best;
-    float max, temp_fitness;
-    gprc_function temp_individual;
-
-    for (i = 0; i < population->size-1; i++) {
-        max = population->fitness[i];
-        best = i;
-        for (j = i+1; j < population->size; j++) {
-            if (population->fitness[j] > max) {
-                max = population->fitness[j];
-                best = j;
-            }
-        }
-        if (best != i) {
-            /* swap fitness */
-            temp_fitness = population->fitness[i];
-            population->fitness[i] = population->fitness[best];
-            population->fitness[best] = temp_fitness;
-
-            /* swap individual */
-            temp_individual = population->individual[i];
-            population->individual[i] = population->individual[best];
-            population->individual[best] = temp_individual;
-        }
-    }
+    gpr_sort_fitness(population->fitness, population->size,
+                     population->size,
+                     population->individual, sizeof(gprc_function),
+                     0, 0);
 }
 
 /* sorts populations in order of average fitness */
 void gprc_sort_system(gprc_system * system)
 {
-    int i, j, best;
-    float max, temp_fitness;
-    gprc_population temp_island;
-
-    for (i = 0; i < system->size-1; i++) {
-        max = system->fitness[i];
-        best = i;
-        for (j = i+1; j < system->size; j++) {
-            if (system->fitness[j] > max) {
-                max = system->fitness[j];
-                best = j;
-            }
-        }
-        if (best != i) {
-            /* swap fitness */
-            temp_fitness = system->fitness[i];
-            system->fitness[i] = system->fitness[best];
-            system->fitness[best] = temp_fitness;
-
-            /* swap island */
-            temp_island = system->island[i];
-            system->island[i] = system->island[best];
-            system->island[best] = temp_island;
-        }
-    }
+    gpr_sort_fitness(system->fitness, system->size, system->size,
+                     system->island, sizeof(gprc_population), 0, 0);
 }
 
 /* copy a ADF_module from one individual to another */
@@ -4373,6 +5571,9 @@ void gprc_copy_ADF_module(gprc_function * source, gprc_function * dest,
             gprc_get_sensors(ADF_module,sensors) +
             gprc_get_actuators(ADF_module,actuators))*
            sizeof(unsigned char));
+
+    /* the compiled program is now out of date */
+    dest->genome[ADF_module].program_length = GPRC_PROGRAM_INVALID;
 }
 
 /* copies the source genome to the destination genome */
@@ -4493,7 +5694,7 @@ void gprc_crossover(gprc_function *parent1, gprc_function *parent2,
         if (m == 0) {
             /* copy chromosomes from the parents */
             for (c = 0; c < chromosomes; c++) {
-                if (rand_num(&parent1->random_seed)%10000 > 5000) {
+                if (rand_num(&child->random_seed)%10000 > 5000) {
                     /* copy chromosome from the first parent */
                     gprc_copy_chromosome(parent1, child, sensors,
                                          rows, columns,
@@ -4540,7 +5741,7 @@ void gprc_crossover(gprc_function *parent1, gprc_function *parent2,
                         parent = parent1;
                     }
                     else {
-                        if (rand_num(&parent1->random_seed)%10000 >
+                        if (rand_num(&child->random_seed)%10000 >
                             5000) {
                             parent = parent2;
                         }
@@ -4564,7 +5765,7 @@ void gprc_crossover(gprc_function *parent1, gprc_function *parent2,
     /* actuators */
     n = rows*columns*GPRC_GENE_SIZE(connections_per_gene);
     for (i = 0; i < actuators; i++, n++) {
-        if (rand_num(&parent1->random_seed)%10000>5000) {
+        if (rand_num(&child->random_seed)%10000>5000) {
             child_gene[n] = parent1_gene[n];
         }
         else {
@@ -4576,7 +5777,7 @@ void gprc_crossover(gprc_function *parent1, gprc_function *parent2,
     if ((parent1->no_of_sensor_sources > 0) &&
         (parent2->no_of_sensor_sources > 0) &&
         (child->no_of_sensor_sources > 0)) {
-        crossover_point = rand_num(&parent1->random_seed)%sensors;
+        crossover_point = rand_num(&child->random_seed)%sensors;
         for (i = 0; i < sensors; i++) {
             if (i < sensors/2) {
                 child->sensor_source[crossover_point] =
@@ -4597,7 +5798,7 @@ void gprc_crossover(gprc_function *parent1, gprc_function *parent2,
     if ((parent1->no_of_actuator_destinations > 0) &&
         (parent2->no_of_actuator_destinations > 0) &&
         (child->no_of_actuator_destinations > 0)) {
-        crossover_point = rand_num(&parent2->random_seed)%actuators;
+        crossover_point = rand_num(&child->random_seed)%actuators;
         for (i = 0; i < actuators; i++) {
             if (i < actuators/2) {
                 child->actuator_destination[crossover_point] =
@@ -4613,6 +5814,9 @@ void gprc_crossover(gprc_function *parent1, gprc_function *parent2,
             }
         }
     }
+
+    /* the compiled programs are now out of date */
+    gprc_invalidate(child);
 }
 
 /* Kills an individual with the given array index within
@@ -4743,7 +5947,7 @@ void gprc_mate(gprc_function *parent1, gprc_function *parent2,
 
         /* clone one parent or the other */
         parent = parent1;
-        if (rand_num(&parent1->random_seed)%10000 > 5000) {
+        if (rand_num(&child->random_seed)%10000 > 5000) {
             parent = parent2;
         }
 
@@ -4916,12 +6120,24 @@ void gprc_generation(gprc_population * population,
                      int use_crossover, unsigned int * random_seed,
                      int * instruction_set, int no_of_instructions)
 {
-    int i, threshold;
+    int i, threshold, index1, index2;
+    unsigned int stream;
     float diversity,mutation_prob_range;
     gprc_function * parent1, * parent2, * child;
 
-    /* sort the population in order of fitness */
-    gprc_sort(population);
+    /* range checking */
+    if ((elitism < 0.1f) || (elitism > 0.9f)) {
+        elitism = 0.3f;
+    }
+
+    /* index setting the threshold for the fittest individuals */
+    threshold = (int)((1.0f - elitism)*(population->size-1));
+
+    /* sort the population in order of fitness.  Only the fittest
+       individuals which survive need to be in order */
+    gpr_sort_fitness(population->fitness, population->size, threshold,
+                     population->individual, sizeof(gprc_function),
+                     0, 0);
 
     diversity = gprc_diversity(population);
     mutation_prob_range = (1.0f-mutation_prob)/2;
@@ -4955,25 +6171,31 @@ void gprc_generation(gprc_population * population,
         }
     }
 
-    /* range checking */
-    if ((elitism < 0.1f) || (elitism > 0.9f)) {
-        elitism = 0.3f;
+    /* compile the parents before they are shared between threads */
+    for (i = 0; i < threshold; i++) {
+        gprc_compiled_program(&population->individual[i], 0,
+                              population->rows, population->columns,
+                              population->connections_per_gene,
+                              population->sensors, 0);
     }
 
-    /* index setting the threshold for the fittest individuals */
-    threshold = (int)((1.0f - elitism)*(population->size-1));
+    /* each child is bred from its own stream of random numbers,
+       so the results don't depend upon the number of threads */
+    stream = (unsigned int)rand_num(random_seed);
 
-#pragma omp parallel for
+#pragma omp parallel for private(index1, index2, parent1, parent2, child)
     for (i = 0; i < population->size - threshold; i++) {
+        child = &population->individual[threshold + i];
+        child->random_seed = rand_stream(stream, (unsigned int)i);
+
         /* randomly choose parents from the fittest
            section of the population */
-        parent1 =
-            &population->individual[rand_num(random_seed)%threshold];
-        parent2 =
-            &population->individual[rand_num(random_seed)%threshold];
+        index1 = rand_num(&child->random_seed)%threshold;
+        index2 = rand_num(&child->random_seed)%threshold;
+        parent1 = &population->individual[index1];
+        parent2 = &population->individual[index2];
 
         /* produce a new child */
-        child = &population->individual[threshold + i];
         gprc_mate(parent1, parent2,
                   population->rows, population->columns,
                   population->sensors, population->actuators,
@@ -4989,12 +6211,383 @@ void gprc_generation(gprc_population * population,
         /* fitness not yet evaluated */
         population->fitness[threshold + i] = 0;
 
+        /* If the mutations were neutral then the child behaves
+           in the same way as one of its parents, so it doesn't
+           need to be evaluated again */
+        if (gprc_same_phenotype(child, parent1,
+                                population->rows, population->columns,
+                                population->connections_per_gene,
+                                population->sensors,
+                                population->actuators) != 0) {
+            population->fitness[threshold + i] =
+                population->fitness[index1];
+        }
+        else if (gprc_same_phenotype(child, parent2,
+                                     population->rows,
+                                     population->columns,
+                                     population->connections_per_gene,
+                                     population->sensors,
+                                     population->actuators) != 0) {
+            population->fitness[threshold + i] =
+                population->fitness[index2];
+        }
+        if (population->fitness[threshold + i] != 0) {
+#pragma omp atomic
+            population->neutral_offspring++;
+        }
+#pragma omp atomic
+        population->offspring++;
+
         /* reset the age of the child */
         child->age = 0;
     }
 
 }
 
+/* Returns the index of the fittest, or if worst is non-zero the least
+   fit, of a number of randomly chosen individuals.  Fitness values
+   may be changed by other threads while this happens, in which case
+   the choice is merely a little out of date */
+static int gprc_tournament(gprc_population * population,
+                           int tournament_size, int worst,
+                           unsigned int * random_seed)
+{
+    int i, index, winner = rand_num(random_seed)%population->size;
+
+    for (i = 1; i < tournament_size; i++) {
+        index = rand_num(random_seed)%population->size;
+        if (worst == 0) {
+            if (population->fitness[index] > population->fitness[winner]) {
+                winner = index;
+            }
+        }
+        else {
+            if (population->fitness[index] < population->fitness[winner]) {
+                winner = index;
+            }
+        }
+    }
+    return winner;
+}
+
+/* Tries to lock the given individuals without waiting.
+   Returns non-zero if all of them were locked */
+static int gprc_steady_state_lock(omp_lock_t * lock, int * index, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (omp_test_lock(&lock[index[i]]) == 0) {
+            /* release the ones already locked */
+            while (i > 0) {
+                i--;
+                omp_unset_lock(&lock[index[i]]);
+            }
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Breeds one child from two parents chosen by tournament, replaces
+   the loser of a reverse tournament with it and then evaluates it.
+   Each individual has a lock, and a busy individual is avoided by
+   choosing again rather than waiting for it */
+static void gprc_steady_state_child(gprc_population * population,
+                                    omp_lock_t * lock,
+                                    int tournament_size,
+                                    float mutation_prob,
+                                    int use_crossover,
+                                    unsigned int random_seed,
+                                    int * instruction_set,
+                                    int no_of_instructions,
+                                    int time_steps,
+                                    float (*evaluate_program)
+                                    (int,gprc_population*,int,int))
+{
+    int index[3], n;
+    gprc_function * parent1, * parent2, * child;
+
+    do {
+        index[0] = gprc_tournament(population, tournament_size, 1,
+                                   &random_seed);
+        index[1] = gprc_tournament(population, tournament_size, 0,
+                                   &random_seed);
+        index[2] = gprc_tournament(population, tournament_size, 0,
+                                   &random_seed);
+        n = (index[2] == index[1]) ? 2 : 3;
+    } while ((index[0] == index[1]) || (index[0] == index[2]) ||
+             (gprc_steady_state_lock(lock, index, n) == 0));
+
+    parent1 = &population->individual[index[1]];
+    parent2 = &population->individual[index[2]];
+    child = &population->individual[index[0]];
+    child->random_seed = random_seed;
+
+    gprc_mate(parent1, parent2,
+              population->rows, population->columns,
+              population->sensors, population->actuators,
+              population->connections_per_gene,
+              population->min_value, population->max_value,
+              population->integers_only,
+              mutation_prob,
+              use_crossover,
+              population->chromosomes,
+              instruction_set, no_of_instructions,
+              0, child);
+    child->age = 0;
+
+    /* if the mutations were neutral then the child doesn't need
+       to be evaluated again */
+    population->fitness[index[0]] = 0;
+    if (gprc_same_phenotype(child, parent1,
+                            population->rows, population->columns,
+                            population->connections_per_gene,
+                            population->sensors,
+                            population->actuators) != 0) {
+        population->fitness[index[0]] = population->fitness[index[1]];
+    }
+    else if (gprc_same_phenotype(child, parent2,
+                                 population->rows, population->columns,
+                                 population->connections_per_gene,
+                                 population->sensors,
+                                 population->actuators) != 0) {
+        population->fitness[index[0]] = population->fitness[index[2]];
+    }
+    if (population->fitness[index[0]] != 0) {
+#pragma omp atomic
+        population->neutral_offspring++;
+    }
+#pragma omp atomic
+    population->offspring++;
+
+    /* the parents may now be chosen by other threads */
+    omp_unset_lock(&lock[index[1]]);
+    if (n == 3) omp_unset_lock(&lock[index[2]]);
+
+    gprc_evaluate_individual(population, index[0],
+                             time_steps, 0, (*evaluate_program));
+    omp_unset_lock(&lock[index[0]]);
+}
+
+/* Steady state evolution.
+   Rather than producing whole generations, each thread repeatedly
+   breeds a single child, evaluates it and places it into the
+   population, so that there is no need to wait for the slowest
+   evaluation of a generation.  The population is sorted afterwards.
+   Because threads compete for individuals the result depends upon
+   how long each evaluation takes */
+void gprc_steady_state(gprc_population * population,
+                       int evaluations,
+                       int tournament_size,
+                       float mutation_prob,
+                       int use_crossover, unsigned int * random_seed,
+                       int * instruction_set, int no_of_instructions,
+                       int time_steps,
+                       float (*evaluate_program)
+                       (int,gprc_population*,int,int))
+{
+    int i;
+    unsigned int stream;
+    omp_lock_t * lock;
+
+    if (population->size < 3) return;
+    if (tournament_size < 2) tournament_size = 2;
+
+    /* the initial population needs to be evaluated */
+    gprc_evaluate(population, time_steps, 0, (*evaluate_program));
+
+    lock = (omp_lock_t*)malloc(population->size*sizeof(omp_lock_t));
+    for (i = 0; i < population->size; i++) {
+        omp_init_lock(&lock[i]);
+    }
+
+    stream = (unsigned int)rand_num(random_seed);
+
+#pragma omp parallel for schedule(dynamic,1)
+    for (i = 0; i < evaluations; i++) {
+        gprc_steady_state_child(population, lock,
+                                tournament_size,
+                                mutation_prob, use_crossover,
+                                rand_stream(stream, (unsigned int)i),
+                                instruction_set, no_of_instructions,
+                                time_steps, (*evaluate_program));
+    }
+
+    for (i = 0; i < population->size; i++) {
+        omp_destroy_lock(&lock[i]);
+    }
+    free(lock);
+
+    gprc_sort(population);
+}
+
+/* Produces a child of an evolution strategy parent by mutation alone */
+static void gprc_es_child(gprc_population * population,
+                          gprc_function * parent, gprc_function * child,
+                          float mutation_prob, int active_mutation,
+                          int * instruction_set, int no_of_instructions)
+{
+    const int max_depth = 5;
+
+    gprc_copy(parent, child,
+              population->rows, population->columns,
+              population->connections_per_gene,
+              population->sensors, population->actuators);
+
+    if (active_mutation != 0) {
+        /* this also updates the used genes */
+        gprc_mutate_active(child,
+                           population->rows, population->columns,
+                           population->sensors, population->actuators,
+                           population->connections_per_gene,
+                           population->min_value, population->max_value,
+                           population->integers_only,
+                           instruction_set, no_of_instructions);
+    }
+    else {
+        gprc_mutate(child,
+                    population->rows, population->columns,
+                    population->sensors, population->actuators,
+                    population->connections_per_gene,
+                    population->chromosomes,
+                    mutation_prob, mutation_prob*0.5f,
+                    population->min_value, population->max_value,
+                    population->integers_only,
+                    instruction_set, no_of_instructions);
+
+        /* as for gprc_mate */
+        gprc_used_functions(child,
+                            population->rows, population->columns,
+                            population->connections_per_gene,
+                            population->sensors, population->actuators);
+    }
+
+    gprc_compress_ADF(child, 0, -1,
+                      population->rows, population->columns,
+                      population->connections_per_gene,
+                      population->sensors, population->actuators,
+                      population->min_value, population->max_value,
+                      max_depth, 1);
+    gprc_update_ADF_modules(child,
+                            population->rows, population->columns,
+                            population->connections_per_gene,
+                            population->sensors);
+    child->age = 0;
+}
+
+/* Evolves one lineage of a (1+lambda) evolution strategy */
+static void gprc_es_lineage(gprc_population * population,
+                            int lineage, int lambda, int generations,
+                            float mutation_prob, int active_mutation,
+                            unsigned int random_seed,
+                            int * instruction_set,
+                            int no_of_instructions,
+                            int time_steps,
+                            float (*evaluate_program)
+                            (int,gprc_population*,int,int))
+{
+    int gen, c, best, index;
+    int lineages = population->size/(1+lambda);
+    int first_child = lineages + (lineage*lambda);
+    gprc_function * parent, * child, temp_individual;
+    float temp_fitness;
+
+    gprc_evaluate_individual(population, lineage,
+                             time_steps, 0, (*evaluate_program));
+
+    for (gen = 0; gen < generations; gen++) {
+        parent = &population->individual[lineage];
+        best = -1;
+        for (c = 0; c < lambda; c++) {
+            index = first_child + c;
+            child = &population->individual[index];
+            child->random_seed = (unsigned int)rand_num(&random_seed);
+            gprc_es_child(population, parent, child,
+                          mutation_prob, active_mutation,
+                          instruction_set, no_of_instructions);
+
+            /* a neutral child doesn't need to be evaluated */
+            population->fitness[index] = 0;
+            if (gprc_same_phenotype(child, parent,
+                                    population->rows, population->columns,
+                                    population->connections_per_gene,
+                                    population->sensors,
+                                    population->actuators) != 0) {
+                population->fitness[index] =
+                    population->fitness[lineage];
+#pragma omp atomic
+                population->neutral_offspring++;
+            }
+            else {
+                gprc_evaluate_individual(population, index,
+                                         time_steps, 0,
+                                         (*evaluate_program));
+            }
+#pragma omp atomic
+            population->offspring++;
+
+            if ((best == -1) ||
+                (population->fitness[index] > population->fitness[best])) {
+                best = index;
+            }
+        }
+
+        /* the best child replaces the parent if it is at least as
+           fit, so that neutral changes can drift */
+        if (population->fitness[best] >= population->fitness[lineage]) {
+            temp_fitness = population->fitness[lineage];
+            population->fitness[lineage] = population->fitness[best];
+            population->fitness[best] = temp_fitness;
+
+            temp_individual = population->individual[lineage];
+            population->individual[lineage] = population->individual[best];
+            population->individual[best] = temp_individual;
+        }
+        (&population->individual[lineage])->age++;
+    }
+}
+
+/* Evolves independent lineages using a (1+lambda) evolution strategy.
+   The first size/(1+lambda) individuals of the population are the
+   parents of each lineage, and the individuals which follow them
+   hold the children.  Each lineage is evolved on its own thread.
+   If active_mutation is non-zero then each child differs from its
+   parent by a single mutation of a used gene, otherwise mutation_prob
+   is used as with gprc_generation.  Afterwards the parents are sorted
+   so that the fittest is the first individual */
+void gprc_es(gprc_population * population,
+             int lambda, int generations,
+             float mutation_prob, int active_mutation,
+             unsigned int * random_seed,
+             int * instruction_set, int no_of_instructions,
+             int time_steps,
+             float (*evaluate_program)
+             (int,gprc_population*,int,int))
+{
+    int i, lineages;
+    unsigned int stream;
+
+    if (lambda < 1) lambda = 1;
+    lineages = population->size/(1+lambda);
+    if (lineages < 1) return;
+
+    stream = (unsigned int)rand_num(random_seed);
+
+#pragma omp parallel for schedule(dynamic,1)
+    for (i = 0; i < lineages; i++) {
+        gprc_es_lineage(population, i, lambda, generations,
+                        mutation_prob, active_mutation,
+                        rand_stream(stream, (unsigned int)i),
+                        instruction_set, no_of_instructions,
+                        time_steps, (*evaluate_program));
+    }
+
+    gpr_sort_fitness(population->fitness, lineages, lineages,
+                     population->individual, sizeof(gprc_function),
+                     0, 0);
+}
+
 /* Produce the next generation for a system containing multiple
    sub-populations. This assumes that fitness has already
    been evaluated */
@@ -5008,15 +6601,21 @@ void gprc_generation_system(gprc_system * system,
                             int no_of_instructions)
 {
     int i, migrant_index;
+    unsigned int stream;
     gprc_population *population1, *population2;
     int island1_index, island2_index;
 
+    /* each island has its own stream of random numbers */
+    stream = (unsigned int)rand_num(random_seed);
+
 #pragma omp parallel for
     for (i = 0; i < system->size; i++) {
+        unsigned int island_seed = rand_stream(stream, (unsigned int)i);
+
         gprc_generation(&system->island[i],
                         elitism,
                         mutation_prob,
-                        use_crossover, random_seed,
+                        use_crossover, &island_seed,
                         instruction_set, no_of_instructions);
     }
 
@@ -6665,14 +8264,16 @@ static void gprc_c_run(FILE * fp,
     fprintf(fp,"%s","      }\n");
     fprintf(fp,"%s","      /* prevent values from going ");
     fprintf(fp,"%s","out of range */\n");
-    fprintf(fp,"%s","      if ((isnan(state[ADF_module][sens+i])) ");
-    fprintf(fp,"%s","|| (isinf(state[ADF_module][sens+i]))) {\n");
-    fprintf(fp,"%s","        state[ADF_module][sens+i] = 0;\n");
-    fprintf(fp,"%s","      }\n");
-    fprintf(fp,"%s","      if ((isnan(state[ADF_module][sens+i+no_of_states])) ");
-    fprintf(fp,"%s","|| (isinf(state[ADF_module][sens+i+no_of_states]))) {\n");
-    fprintf(fp,"%s","        state[ADF_module][sens+i+no_of_states] = 0;\n");
-    fprintf(fp,"%s","      }\n");
+    if (integers_only <= 0) {
+        fprintf(fp,"%s","      if ((isnan(state[ADF_module][sens+i])) ");
+        fprintf(fp,"%s","|| (isinf(state[ADF_module][sens+i]))) {\n");
+        fprintf(fp,"%s","        state[ADF_module][sens+i] = 0;\n");
+        fprintf(fp,"%s","      }\n");
+        fprintf(fp,"%s","      if ((isnan(state[ADF_module][sens+i+no_of_states])) ");
+        fprintf(fp,"%s","|| (isinf(state[ADF_module][sens+i+no_of_states]))) {\n");
+        fprintf(fp,"%s","        state[ADF_module][sens+i+no_of_states] = 0;\n");
+        fprintf(fp,"%s","      }\n");
+    }
     fprintf(fp,     "      if (state[ADF_module][sens+i] > %d) {\n",
             GPR_MAX_CONSTANT);
     fprintf(fp,     "        state[ADF_module][sens+i] = %d;\n",
@@ -39,6 +39,7 @@
 #include <assert.h>
 #include "globals.h"
 #include "gpr.h"
+#include "gprc_dropout.h"
 
 enum {
     GPRC_GENE_FUNCTION_TYPE = 0,
@@ -50,6 +51,10 @@ enum {
 #define GPRC_MIN_WEIGHT -1.0
 #define GPRC_MAX_WEIGHT  1.0
 
+/* the maximum number of positions tried when mutating
+   until a used gene changes */
+#define GPRC_ACTIVE_MUTATION_TRIES 1000
+
 /* the number of initial values before the list of
    connections and weights */
 #define GPRC_INITIAL     3
@@ -63,6 +68,27 @@ enum {
                                      (connections*                  \
                                       GPRC_WEIGHTS_PER_CONNECTION))
 
+/* values within each compiled instruction */
+enum {
+    GPRC_INSTR_GENE = 0,
+    GPRC_INSTR_FUNCTION_TYPE,
+    GPRC_INSTR_ARGS
+};
+
+/* the number of values before the list of source state indexes
+   within a compiled instruction */
+#define GPRC_INSTR_INITIAL 3
+
+/* the size of each compiled instruction */
+#define GPRC_INSTR_SIZE(connections) ((GPRC_INSTR_INITIAL) + (connections))
+
+/* the compiled program needs to be rebuilt from the used genes */
+#define GPRC_PROGRAM_INVALID  -1
+
+/* the used genes can modify the genome when run, so the
+   program can't be compiled */
+#define GPRC_PROGRAM_DYNAMIC  -2
+
 /* this structure contains the cartesian grid */
 struct gprc_mod {
     /* defines the grid functions, known as genes */
@@ -72,9 +98,46 @@ struct gprc_mod {
     /* whether each gene is currently being used
        as part of the inputs -> outputs transform */
     unsigned char * used;
+    /* packed list of only the used genes, with the function
+       type, number of arguments and source state indexes
+       already decoded */
+    int * program;
+    /* the number of compiled instructions, or one of
+       GPRC_PROGRAM_INVALID or GPRC_PROGRAM_DYNAMIC */
+    int program_length;
+    /* non-zero if the compiled program has no side effects,
+       so that its outputs depend only upon its sensors */
+    int program_pure;
+    /* for ADF modules, the state indexes into which
+       successive call arguments are placed */
+    int arguments;
+    int argument[GPRC_MAX_ADF_MODULE_SENSORS];
+    /* the arguments and result of the most recent call to this
+       module as an ADF, which are reused by identical calls within
+       the same time step.  call_args is -1 if nothing is stored */
+    int call_args;
+    float call_arg[GPRC_MAX_ADF_MODULE_SENSORS];
+    float call_result;
 };
 typedef struct gprc_mod gprc_ADF_module;
 
+/* records the original values of any genes which are altered by
+   dynamic functions while a program runs, so that the genome can
+   be restored afterwards without copying all of it */
+struct gprc_snap {
+    int rows, columns;
+    int connections_per_gene;
+    int ADF_modules;
+    /* the original values of the altered genes */
+    float * gene[GPRC_MAX_ADF_MODULES+1];
+    /* whether each gene has been altered */
+    unsigned char * dirty[GPRC_MAX_ADF_MODULES+1];
+    /* indexes of the altered genes */
+    int * changed[GPRC_MAX_ADF_MODULES+1];
+    int no_of_changes[GPRC_MAX_ADF_MODULES+1];
+};
+typedef struct gprc_snap gprc_snapshot;
+
 /* represents a function */
 struct gprc_func {
     /* the number of ADF modules */
@@ -106,6 +169,9 @@ struct gprc_func {
 
     /* temporary array */
     int * temp_genes;
+
+    /* if not NULL then genes altered when running are recorded */
+    gprc_snapshot * snapshot;
 };
 typedef struct gprc_func gprc_function;
 
@@ -128,11 +194,21 @@ struct gprc_pop {
     int chromosomes;
     /* whether to only use integer maths */
     int integers_only;
+    /* whether to only evaluate the real part of states */
+    int real_only;
+    /* the number of children produced, and the number of those
+       which inherited their fitness from an identical parent
+       rather than being evaluated */
+    int offspring, neutral_offspring;
     /* size of the data store for each individual */
     int data_size, data_fields;
     /* array containing individual programs */
     struct gprc_func * individual;
     float * fitness;
+    /* fitness values of previously evaluated phenotypes, which
+       may be shared with the other islands of a system */
+    gpr_cache fitness_cache;
+    gpr_cache * cache;
     /* the fitness history for the population */
     struct gpr_hist history;
 };
@@ -190,16 +266,16 @@ void gprc_tidy(gprc_function * f,
                int sensors, int actuators,
                int connections_per_gene,
                float min_value, float max_value);
-void gprc_unique_outputs(gprc_function * f,
-                         int rows, int columns,
-                         int connections_per_gene,
-                         int sensors, int actuators,
-                         unsigned int * random_seed);
-void gprc_valid_logical_operators(gprc_function * f,
-                                  int rows, int columns,
-                                  int connections_per_gene,
-                                  int sensors,
-                                  unsigned int * random_seed);
+int gprc_unique_outputs(gprc_function * f,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int sensors, int actuators,
+                        unsigned int * random_seed);
+int gprc_valid_logical_operators(gprc_function * f,
+                                 int rows, int columns,
+                                 int connections_per_gene,
+                                 int sensors,
+                                 unsigned int * random_seed);
 void gprc_dot_label(gprc_function * f,
                     int ADF_module,
                     int rows, int columns,
@@ -223,11 +299,44 @@ void gprc_used_functions(gprc_function * f,
                          int rows, int columns,
                          int connections_per_gene,
                          int sensors, int actuators);
-void gprc_valid_ADFs(gprc_function * f,
-                     int rows, int columns,
-                     int connections_per_gene,
-                     int sensors,
-                     float min_value, float max_value);
+void gprc_invalidate(gprc_function * f);
+void gprc_snapshot_init(gprc_snapshot * snapshot,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int ADF_modules);
+void gprc_snapshot_free(gprc_snapshot * snapshot);
+int gprc_snapshot_begin(gprc_function * f, gprc_snapshot * snapshot);
+int gprc_snapshot_restore(gprc_function * f);
+void gprc_snapshot_end(gprc_function * f);
+void gprc_retrace_gene(gprc_function * f, int ADF_module,
+                       int gene_index,
+                       int rows, int columns,
+                       int connections_per_gene,
+                       int sensors, int actuators);
+int gprc_compile(gprc_function * f,
+                 int ADF_module,
+                 int rows, int columns,
+                 int connections_per_gene,
+                 int sensors);
+int * gprc_compiled_program(gprc_function * f,
+                            int ADF_module,
+                            int rows, int columns,
+                            int connections_per_gene,
+                            int sensors,
+                            int dynamic);
+int gprc_same_phenotype(gprc_function * f1, gprc_function * f2,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int sensors, int actuators);
+unsigned long long gprc_phenotype_hash(gprc_function * f,
+                                       int rows, int columns,
+                                       int connections_per_gene,
+                                       int sensors, int actuators);
+int gprc_valid_ADFs(gprc_function * f,
+                    int rows, int columns,
+                    int connections_per_gene,
+                    int sensors,
+                    float min_value, float max_value);
 void gprc_remove_ADFs(gprc_function * f,
                       int rows, int columns,
                       int connections_per_gene);
@@ -263,6 +372,13 @@ void gprc_mutate(gprc_function * f,
                  float min_value, float max_value,
                  int integers_only,
                  int * instruction_set, int no_of_instructions);
+void gprc_mutate_active(gprc_function * f,
+                        int rows, int columns,
+                        int sensors, int actuators,
+                        int connections_per_gene,
+                        float min_value, float max_value,
+                        int integers_only,
+                        int * instruction_set, int no_of_instructions);
 int gprc_validate(gprc_function * f,
                   int rows, int columns,
                   int sensors, int actuators,
@@ -286,6 +402,15 @@ void gprc_run_int(gprc_function * f,
                   float dropout_prob,
                   int dynamic,
                   float (*custom_function)(float,float,float));
+void gprc_run_real(gprc_function * f,
+                   int rows, int columns,
+                   int connections_per_gene,
+                   int sensors, int actuators,
+                   float dropout_prob,
+                   float (*custom_function)(float,float,float));
+int gprc_real_only_instruction_set(int * instruction_set,
+                                   int no_of_instructions);
+void gprc_set_real_only(gprc_population * population, int real_only);
 void gprc_run(gprc_function * f, gprc_population * population,
               float dropout_prob, int dynamic,
               float (*custom_function)(float,float,float));
@@ -381,6 +506,23 @@ void gprc_generation(gprc_population * population,
                      float mutation_prob,
                      int use_crossover, unsigned int * random_seed,
                      int * instruction_set, int no_of_instructions);
+void gprc_steady_state(gprc_population * population,
+                       int evaluations,
+                       int tournament_size,
+                       float mutation_prob,
+                       int use_crossover, unsigned int * random_seed,
+                       int * instruction_set, int no_of_instructions,
+                       int time_steps,
+                       float (*evaluate_program)
+                       (int,gprc_population*,int,int));
+void gprc_es(gprc_population * population,
+             int lambda, int generations,
+             float mutation_prob, int active_mutation,
+             unsigned int * random_seed,
+             int * instruction_set, int no_of_instructions,
+             int time_steps,
+             float (*evaluate_program)
+             (int,gprc_population*,int,int));
 int gprc_save(gprc_function * f,
               int rows, int columns,
               int connections_per_gene,
@@ -0,0 +1,710 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "gprc_batch.h"
+
+/* returns the row of the given state index within a batch buffer */
+#define GPRC_BATCH_ROW(buffer,index,stride) (&(buffer)[(index)*(stride)])
+
+/* returns non-zero if the given function type can be evaluated
+   across a batch of samples.  Functions which alter the genome,
+   the data store or other states, or which call ADFs, need
+   to be run one sample at a time */
+static int gprc_batch_function(int function_type)
+{
+    switch(function_type) {
+    case GPR_FUNCTION_DATA_PUSH:
+    case GPR_FUNCTION_DATA_POP:
+    case GPR_FUNCTION_DATA_GET:
+    case GPR_FUNCTION_DATA_SET:
+    case GPR_FUNCTION_GET:
+    case GPR_FUNCTION_SET:
+    case GPR_FUNCTION_ADF:
+    case GPR_FUNCTION_HEBBIAN:
+    case GPR_FUNCTION_COPY_STATE: {
+        return 0;
+    }
+    }
+    return 1;
+}
+
+/* returns non-zero if the given individual can be evaluated
+   a whole batch at a time, otherwise the samples are run
+   individually.  Either way dropout is applied by gprc_run_batch */
+int gprc_batch_supported(gprc_function * f,
+                         int rows, int columns,
+                         int connections_per_gene,
+                         int sensors,
+                         int integers_only)
+{
+    int i, * program, * instr;
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+
+    if (integers_only > 0) return 0;
+
+    program = gprc_compiled_program(f, 0, rows, columns,
+                                    connections_per_gene,
+                                    sensors, 0);
+    if (program == NULL) return 0;
+
+    for (i = 0; i < f->genome[0].program_length; i++) {
+        instr = &program[i*instr_size];
+        if (!gprc_batch_function(instr[GPRC_INSTR_FUNCTION_TYPE])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Evaluates a single compiled gene for each sample within a block.
+   The output rows of the gene are given, together with the
+   input rows for each of its connections, so that the rows
+   don't need to be stored within a single buffer.
+   This mirrors the behavior of gprc_run_float */
+void gprc_batch_gene_rows(int * instr, float * gp,
+                          float * out_re, float * out_im,
+                          float ** in_re, float ** in_im,
+                          int samples,
+                          int connections_per_gene,
+                          float (*custom_function)(float,float,float))
+{
+    int s, j, k;
+    int no_of_args = instr[GPRC_INSTR_ARGS];
+    float a, b, c, d, a2;
+    float * in0_re = in_re[0], * in0_im = in_im[0];
+    float * in1_re = in0_re, * in1_im = in0_im;
+
+    if (connections_per_gene > 1) {
+        in1_re = in_re[1];
+        in1_im = in_im[1];
+    }
+
+    switch(instr[GPRC_INSTR_FUNCTION_TYPE]) {
+    case GPR_FUNCTION_CUSTOM: {
+        if (*custom_function) {
+            for (s = 0; s < samples; s++) {
+                out_re[s] =
+                    (*custom_function)(gp[GPRC_GENE_CONSTANT],
+                                       gp[GPRC_INITIAL],
+                                       gp[GPRC_GENE_CONSTANT]);
+            }
+        }
+        break;
+    }
+    case GPR_FUNCTION_VALUE: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = gp[GPRC_GENE_CONSTANT];
+            out_im[s] = gp[GPRC_GENE_IMAGINARY];
+        }
+        break;
+    }
+    case GPR_FUNCTION_SIGMOID: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = 0;
+        }
+        for (j = 0; j < no_of_args; j++) {
+            gprc_simd.weighted_add(out_re, in_re[j],
+                                   gp[GPRC_INITIAL+j+connections_per_gene],
+                                   samples);
+        }
+        for (s = 0; s < samples; s++) {
+            out_re[s] = 1.0f / (1.0f + exp(-out_re[s]));
+        }
+        break;
+    }
+    case GPR_FUNCTION_ADD: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = 0;
+            out_im[s] = 0;
+        }
+        for (j = 0; j < no_of_args; j++) {
+            gprc_simd.add(out_re, in_re[j], samples);
+            gprc_simd.add(out_im, in_im[j], samples);
+        }
+        break;
+    }
+    case GPR_FUNCTION_SUBTRACT: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = in0_re[s];
+            out_im[s] = in0_im[s];
+        }
+        for (j = 1; j < no_of_args; j++) {
+            gprc_simd.subtract(out_re, in_re[j], samples);
+            gprc_simd.subtract(out_im, in_im[j], samples);
+        }
+        break;
+    }
+    case GPR_FUNCTION_NEGATE: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = -in0_re[s];
+            out_im[s] = -in0_im[s];
+        }
+        break;
+    }
+    case GPR_FUNCTION_MULTIPLY: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = in0_re[s];
+            out_im[s] = in0_im[s];
+        }
+        for (j = 1; j < no_of_args; j++) {
+            gprc_simd.multiply(out_re, out_im, in_re[j], in_im[j], samples);
+        }
+        break;
+    }
+    case GPR_FUNCTION_WEIGHT: {
+        gprc_simd.weight(out_re, in0_re, gp[GPRC_GENE_CONSTANT], samples);
+        gprc_simd.weight(out_im, in0_im, gp[GPRC_GENE_CONSTANT], samples);
+        break;
+    }
+    case GPR_FUNCTION_DIVIDE: {
+        gprc_simd.divide(out_re, out_im, in0_re, in0_im,
+                         in1_re, in1_im, samples);
+        break;
+    }
+    case GPR_FUNCTION_MODULUS: {
+        for (s = 0; s < samples; s++) {
+            if (fabs(in1_re[s]) <= -1e-1) {
+                out_re[s] = in0_re[s];
+                out_im[s] = in0_im[s];
+            }
+            else {
+                a = in0_re[s];
+                b = in0_im[s];
+                c = in1_re[s];
+                d = in1_im[s];
+                if (b+d == 0) {
+                    out_re[s] = fmod(a,c);
+                    out_im[s] = 0;
+                }
+                else {
+                    out_re[s] = fmod(((a*c) + (b*d)), ((c*c) + (d*d)));
+                    out_im[s] = fmod(((b*c) - (a*d)), ((c*c) + (d*d)));
+                }
+            }
+        }
+        break;
+    }
+    case GPR_FUNCTION_FLOOR: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = floor(in0_re[s]);
+            out_im[s] = floor(in0_im[s]);
+        }
+        break;
+    }
+    case GPR_FUNCTION_AVERAGE: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = in0_re[s];
+            out_im[s] = in0_im[s];
+        }
+        for (j = 1; j < no_of_args; j++) {
+            gprc_simd.add(out_re, in_re[j], samples);
+            gprc_simd.add(out_im, in_im[j], samples);
+        }
+        for (s = 0; s < samples; s++) {
+            out_re[s] /= no_of_args;
+            out_im[s] /= no_of_args;
+        }
+        break;
+    }
+    case GPR_FUNCTION_NOOP1:
+    case GPR_FUNCTION_NOOP2:
+    case GPR_FUNCTION_NOOP3:
+    case GPR_FUNCTION_NOOP4: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = in0_re[s];
+            out_im[s] = in0_im[s];
+        }
+        break;
+    }
+    case GPR_FUNCTION_GREATER_THAN: {
+        gprc_simd.greater_than(out_re, out_im, in0_re, in1_re,
+                               gp[GPRC_GENE_CONSTANT],
+                               gp[GPRC_GENE_IMAGINARY], samples);
+        break;
+    }
+    case GPR_FUNCTION_LESS_THAN: {
+        /* a < b is the same as b > a */
+        gprc_simd.greater_than(out_re, out_im, in1_re, in0_re,
+                               gp[GPRC_GENE_CONSTANT],
+                               gp[GPRC_GENE_IMAGINARY], samples);
+        break;
+    }
+    case GPR_FUNCTION_EQUALS: {
+        for (s = 0; s < samples; s++) {
+            k = (((int)in0_re[s] == (int)in1_re[s]) &&
+                 ((int)in0_im[s] == (int)in1_im[s]));
+            out_re[s] = k ? gp[GPRC_GENE_CONSTANT] : 0;
+            out_im[s] = k ? gp[GPRC_GENE_IMAGINARY] : 0;
+        }
+        break;
+    }
+    case GPR_FUNCTION_AND: {
+        for (s = 0; s < samples; s++) {
+            k = ((in0_re[s] > 0) && (in1_re[s] > 0));
+            out_re[s] = k ? gp[GPRC_GENE_CONSTANT] : 0;
+            out_im[s] = k ? gp[GPRC_GENE_IMAGINARY] : 0;
+        }
+        break;
+    }
+    case GPR_FUNCTION_OR: {
+        for (s = 0; s < samples; s++) {
+            k = ((in0_re[s] > 0) || (in1_re[s] > 0));
+            out_re[s] = k ? gp[GPRC_GENE_CONSTANT] : 0;
+            out_im[s] = k ? gp[GPRC_GENE_IMAGINARY] : 0;
+        }
+        break;
+    }
+    case GPR_FUNCTION_XOR: {
+        for (s = 0; s < samples; s++) {
+            k = ((in0_re[s] > 0) != (in1_re[s] > 0));
+            out_re[s] = k ? gp[GPRC_GENE_CONSTANT] : 0;
+            out_im[s] = k ? gp[GPRC_GENE_IMAGINARY] : 0;
+        }
+        break;
+    }
+    case GPR_FUNCTION_NOT: {
+        for (s = 0; s < samples; s++) {
+            k = ((int)in0_re[s] != (int)in1_re[s]);
+            out_re[s] = k ? gp[GPRC_GENE_CONSTANT] : 0;
+            out_im[s] = k ? gp[GPRC_GENE_IMAGINARY] : 0;
+        }
+        break;
+    }
+    case GPR_FUNCTION_EXP: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = (float)exp(in0_re[s]);
+            out_im[s] = (float)exp(in0_im[s]);
+        }
+        break;
+    }
+    case GPR_FUNCTION_SQUARE_ROOT: {
+        for (s = 0; s < samples; s++) {
+            a = in0_re[s];
+            b = in0_im[s];
+            if (b == 0) {
+                out_re[s] = (float)sqrt(fabs(a));
+                out_im[s] = 0;
+            }
+            else {
+                a2 = (float)sqrt((a*a) + (b*b));
+                out_re[s] = (float)sqrt((a + a2) * 0.5f);
+                out_im[s] = (float)sqrt((-a + a2) * 0.5f);
+                if (b < 0) {
+                    out_im[s] = -out_im[s];
+                }
+            }
+        }
+        break;
+    }
+    case GPR_FUNCTION_ABS: {
+        for (s = 0; s < samples; s++) {
+            a = in0_re[s];
+            b = in0_im[s];
+            if (b == 0) {
+                out_re[s] = (float)fabs(a);
+            }
+            else {
+                out_re[s] = (float)sqrt((a*a) + (b*b));
+            }
+            out_im[s] = 0;
+        }
+        break;
+    }
+    case GPR_FUNCTION_SINE: {
+        for (s = 0; s < samples; s++) {
+            a = in0_re[s];
+            b = in0_im[s];
+            if (b == 0) {
+                out_re[s] = (float)sin(a)*256;
+                out_im[s] = 0;
+            }
+            else {
+                out_re[s] = (float)(sin(a)*cosh(b))*256;
+                out_im[s] = (float)(cos(a)*sinh(b))*256;
+            }
+        }
+        break;
+    }
+    case GPR_FUNCTION_ARCSINE: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = (float)asin(in0_re[s]);
+        }
+        break;
+    }
+    case GPR_FUNCTION_COSINE: {
+        for (s = 0; s < samples; s++) {
+            a = in0_re[s];
+            b = in0_im[s];
+            if (b == 0) {
+                out_re[s] = (float)cos(a)*256;
+                out_im[s] = 0;
+            }
+            else {
+                out_re[s] = (float)(cos(a)*cosh(b))*256;
+                out_im[s] = (float)(sin(a)*sinh(b))*256;
+            }
+        }
+        break;
+    }
+    case GPR_FUNCTION_ARCCOSINE: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = (float)acos(in0_re[s]);
+        }
+        break;
+    }
+    case GPR_FUNCTION_POW: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = (float)pow(in0_re[s], in1_re[s]);
+            out_im[s] = (float)pow(in0_im[s], in1_im[s]);
+        }
+        break;
+    }
+    case GPR_FUNCTION_MIN: {
+        /* as with gprc_run_float the imaginary part is only
+           updated when a later argument is selected */
+        for (s = 0; s < samples; s++) {
+            out_re[s] = in0_re[s];
+        }
+        for (j = 1; j < no_of_args; j++) {
+            gprc_simd.min(out_re, out_im, in_re[j], in_im[j], samples);
+        }
+        break;
+    }
+    case GPR_FUNCTION_MAX: {
+        for (s = 0; s < samples; s++) {
+            out_re[s] = in0_re[s];
+        }
+        for (j = 1; j < no_of_args; j++) {
+            gprc_simd.max(out_re, out_im, in_re[j], in_im[j], samples);
+        }
+        break;
+    }
+    }
+
+    /* prevent values from going out of range */
+    gprc_simd.clamp(out_re, out_im, samples);
+}
+
+/* Evaluates a single compiled gene for each sample within a block.
+   Each state occupies a row of the re and im buffers, with the
+   given stride between rows */
+void gprc_batch_gene(int * instr, float * gp,
+                     float * re, float * im,
+                     int samples, int stride,
+                     int sens,
+                     int connections_per_gene,
+                     float (*custom_function)(float,float,float))
+{
+    int j, i = instr[GPRC_INSTR_GENE];
+    int * con = &instr[GPRC_INSTR_INITIAL];
+    float * rows[GPRC_BATCH_CONNECTIONS*2];
+    float ** in_re = rows, ** in_im;
+
+    if (connections_per_gene > GPRC_BATCH_CONNECTIONS) {
+        in_re = (float**)malloc(connections_per_gene*2*sizeof(float*));
+    }
+    in_im = &in_re[connections_per_gene];
+
+    for (j = 0; j < connections_per_gene; j++) {
+        in_re[j] = GPRC_BATCH_ROW(re, con[j], stride);
+        in_im[j] = GPRC_BATCH_ROW(im, con[j], stride);
+    }
+
+    gprc_batch_gene_rows(instr, gp,
+                         GPRC_BATCH_ROW(re, sens+i, stride),
+                         GPRC_BATCH_ROW(im, sens+i, stride),
+                         in_re, in_im, samples,
+                         connections_per_gene,
+                         (*custom_function));
+
+    if (in_re != rows) free(in_re);
+}
+
+/* runs each sample individually.  This is used when the
+   program contains functions which can't be batched */
+static void gprc_run_batch_samples(gprc_function * f,
+                                   int rows, int columns,
+                                   int connections_per_gene,
+                                   int sensors, int actuators,
+                                   int integers_only,
+                                   float dropout_prob,
+                                   int time_steps,
+                                   int no_of_samples,
+                                   float * inputs,
+                                   float * outputs,
+                                   float (*custom_function)(float,float,float))
+{
+    int s, i, t;
+
+    for (s = 0; s < no_of_samples; s++) {
+        gprc_clear_state(f, rows, columns, sensors, actuators);
+        for (i = 0; i < sensors; i++) {
+            gprc_set_sensor(f, i, inputs[i*no_of_samples + s]);
+        }
+        for (t = 0; t < time_steps; t++) {
+            if (integers_only <= 0) {
+                gprc_run_float(f, 0, rows, columns,
+                               connections_per_gene,
+                               sensors, actuators,
+                               dropout_prob, 0,
+                               (*custom_function));
+            }
+            else {
+                gprc_run_int(f, 0, rows, columns,
+                             connections_per_gene,
+                             sensors, actuators,
+                             dropout_prob, 0,
+                             (*custom_function));
+            }
+        }
+        for (i = 0; i < actuators; i++) {
+            outputs[i*no_of_samples + s] =
+                gprc_get_actuator(f, i, rows, columns, sensors);
+        }
+    }
+}
+
+/* Runs an individual over a number of samples.
+   The inputs array is in column major order, with the values
+   for each sensor stored contiguously (sensors x no_of_samples),
+   and the outputs array is arranged in the same way
+   (actuators x no_of_samples).
+   Each sample begins from a cleared state and is run for the
+   given number of time steps, so that the result is the same as
+   calling gprc_clear_state, gprc_set_sensor and gprc_run for
+   each sample in turn.  Each used gene is evaluated over a block
+   of samples before moving on to the next gene.  With dropout each
+   gene is dropped with the same probability, although not for the
+   same samples as when they are run in turn */
+void gprc_run_batch_base(gprc_function * f,
+                         int rows, int columns,
+                         int connections_per_gene,
+                         int sensors, int actuators,
+                         int integers_only,
+                         float dropout_prob,
+                         int time_steps,
+                         int no_of_samples,
+                         float * inputs,
+                         float * outputs,
+                         float (*custom_function)(float,float,float))
+{
+    int i, j, k, s, t, w, start, samples, no_of_rows = 0;
+    int * program, * instr, * rows_used;
+    unsigned int dropout = gprc_dropout_threshold(dropout_prob);
+    unsigned long long dropout_key = 0, counter;
+    unsigned long long mask[GPRC_BATCH_SIZE/GPRC_DROPOUT_WORD];
+    float dropped_re[GPRC_BATCH_SIZE], dropped_im[GPRC_BATCH_SIZE];
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int no_of_states = (rows*columns) + sensors + actuators;
+    int actuators_start = sensors + (rows*columns);
+    float * gene = f->genome[0].gene;
+    float * state = f->genome[0].state;
+    float * re, * im, * src_re, * src_im;
+    unsigned char * marked;
+
+    if (no_of_samples <= 0) return;
+
+    if (!gprc_batch_supported(f, rows, columns,
+                              connections_per_gene, sensors,
+                              integers_only)) {
+        gprc_run_batch_samples(f, rows, columns,
+                               connections_per_gene,
+                               sensors, actuators,
+                               integers_only, dropout_prob,
+                               time_steps, no_of_samples,
+                               inputs, outputs,
+                               (*custom_function));
+        return;
+    }
+
+    program = f->genome[0].program;
+
+    /* find the non-sensor rows of the state which are used,
+       since these need to begin from a cleared state */
+    marked = (unsigned char*)malloc(no_of_states*sizeof(unsigned char));
+    rows_used = (int*)malloc(no_of_states*sizeof(int));
+    memset((void*)marked, '\0', no_of_states*sizeof(unsigned char));
+    for (i = 0; i < f->genome[0].program_length; i++) {
+        instr = &program[i*instr_size];
+        k = sensors + instr[GPRC_INSTR_GENE];
+        if (marked[k] == 0) {
+            marked[k] = 1;
+            rows_used[no_of_rows++] = k;
+        }
+        for (j = 0; j < connections_per_gene; j++) {
+            k = instr[GPRC_INSTR_INITIAL+j];
+            if ((k >= sensors) && (k < no_of_states) &&
+                (marked[k] == 0)) {
+                marked[k] = 1;
+                rows_used[no_of_rows++] = k;
+            }
+        }
+    }
+
+    /* a different set of genes is dropped on each run */
+    if (dropout > 0) dropout_key = rand_num(&f->random_seed);
+
+    re = (float*)malloc(no_of_states*2*GPRC_BATCH_SIZE*sizeof(float));
+    im = &re[no_of_states*GPRC_BATCH_SIZE];
+
+    for (start = 0; start < no_of_samples; start += GPRC_BATCH_SIZE) {
+        samples = no_of_samples - start;
+        if (samples > GPRC_BATCH_SIZE) samples = GPRC_BATCH_SIZE;
+
+        /* set the sensors */
+        for (i = 0; i < sensors; i++) {
+            memcpy((void*)GPRC_BATCH_ROW(re, i, GPRC_BATCH_SIZE),
+                   (void*)&inputs[i*no_of_samples + start],
+                   samples*sizeof(float));
+            memset((void*)GPRC_BATCH_ROW(im, i, GPRC_BATCH_SIZE),
+                   '\0', samples*sizeof(float));
+        }
+
+        /* clear the state */
+        for (i = 0; i < no_of_rows; i++) {
+            memset((void*)GPRC_BATCH_ROW(re, rows_used[i],
+                                         GPRC_BATCH_SIZE),
+                   '\0', samples*sizeof(float));
+            memset((void*)GPRC_BATCH_ROW(im, rows_used[i],
+                                         GPRC_BATCH_SIZE),
+                   '\0', samples*sizeof(float));
+        }
+
+        /* run each gene over the block of samples */
+        for (t = 0; t < time_steps; t++) {
+            for (i = 0; i < f->genome[0].program_length; i++) {
+                instr = &program[i*instr_size];
+                k = sensors + instr[GPRC_INSTR_GENE];
+                if (dropout > 0) {
+                    /* each sample drops the gene independently, and
+                       a dropped gene keeps its previous state */
+                    counter =
+                        (((unsigned long long)t *
+                          f->genome[0].program_length + i) << 32) +
+                        (start / GPRC_DROPOUT_WORD);
+                    gprc_dropout_mask(dropout_key, counter, dropout,
+                                      (samples + GPRC_DROPOUT_WORD - 1) /
+                                      GPRC_DROPOUT_WORD, mask);
+                    memcpy((void*)dropped_re,
+                           (void*)GPRC_BATCH_ROW(re, k, GPRC_BATCH_SIZE),
+                           samples*sizeof(float));
+                    memcpy((void*)dropped_im,
+                           (void*)GPRC_BATCH_ROW(im, k, GPRC_BATCH_SIZE),
+                           samples*sizeof(float));
+                }
+                gprc_batch_gene(instr,
+                                &gene[instr[GPRC_INSTR_GENE]*gene_size],
+                                re, im, samples, GPRC_BATCH_SIZE,
+                                sensors, connections_per_gene,
+                                (*custom_function));
+                if (dropout > 0) {
+                    for (s = 0; s < samples; s++) {
+                        w = s / GPRC_DROPOUT_WORD;
+                        if ((mask[w] >> (s % GPRC_DROPOUT_WORD)) & 1) {
+                            GPRC_BATCH_ROW(re, k, GPRC_BATCH_SIZE)[s] =
+                                dropped_re[s];
+                            GPRC_BATCH_ROW(im, k, GPRC_BATCH_SIZE)[s] =
+                                dropped_im[s];
+                        }
+                    }
+                }
+            }
+        }
+
+        /* get the actuator values */
+        for (i = 0; i < actuators; i++) {
+            src_re = GPRC_BATCH_ROW(re,
+                                    (int)gene[(rows*columns*gene_size)+i],
+                                    GPRC_BATCH_SIZE);
+            memcpy((void*)&outputs[i*no_of_samples + start],
+                   (void*)src_re, samples*sizeof(float));
+        }
+    }
+
+    /* leave the state of the individual as it would be
+       after running the last sample */
+    if (time_steps > 0) {
+        s = samples - 1;
+        gprc_clear_state(f, rows, columns, sensors, actuators);
+        for (i = 0; i < sensors; i++) {
+            state[i] = GPRC_BATCH_ROW(re, i, GPRC_BATCH_SIZE)[s];
+        }
+        for (i = 0; i < no_of_rows; i++) {
+            k = rows_used[i];
+            state[k] = GPRC_BATCH_ROW(re, k, GPRC_BATCH_SIZE)[s];
+            state[k+no_of_states] = GPRC_BATCH_ROW(im, k, GPRC_BATCH_SIZE)[s];
+        }
+        for (i = 0; i < actuators; i++) {
+            k = (int)gene[(rows*columns*gene_size)+i];
+            src_re = GPRC_BATCH_ROW(re, k, GPRC_BATCH_SIZE);
+            src_im = GPRC_BATCH_ROW(im, k, GPRC_BATCH_SIZE);
+            state[actuators_start+i] = src_re[s];
+            state[actuators_start+i+no_of_states] = src_im[s];
+        }
+    }
+
+    free(re);
+    free(rows_used);
+    free(marked);
+}
+
+/* runs an individual within a population over a batch of samples */
+void gprc_run_batch(gprc_function * f, gprc_population * population,
+                    float dropout_prob, int time_steps,
+                    int no_of_samples,
+                    float * inputs, float * outputs,
+                    float (*custom_function)(float,float,float))
+{
+    gprc_run_batch_base(f, population->rows, population->columns,
+                        population->connections_per_gene,
+                        population->sensors, population->actuators,
+                        population->integers_only,
+                        dropout_prob, time_steps,
+                        no_of_samples, inputs, outputs,
+                        (*custom_function));
+}
+
+/* runs an individual within a morphology population
+   over a batch of samples */
+void gprcm_run_batch(gprcm_function * f, gprcm_population * population,
+                     float dropout_prob, int time_steps,
+                     int no_of_samples,
+                     float * inputs, float * outputs,
+                     float (*custom_function)(float,float,float))
+{
+    gprc_run_batch_base(&f->program,
+                        population->rows, population->columns,
+                        population->connections_per_gene,
+                        population->sensors, population->actuators,
+                        population->integers_only,
+                        dropout_prob, time_steps,
+                        no_of_samples, inputs, outputs,
+                        (*custom_function));
+}
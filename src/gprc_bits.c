@@ -0,0 +1,317 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Bit sliced evaluation of boolean programs.
+
+   With integer maths the logical functions output either the
+   gene constant or zero, so if every sensor is either zero or one
+   then each state takes one of only two values.  A state can then
+   be stored as a single bit per fitness case, together with the
+   value which it takes when the bit is set, and each gene
+   becomes one bitwise operation over many fitness cases */
+
+#include "gprc_bits.h"
+
+/* clamps a value as within gprc_run_int */
+static float gprc_bits_clamp(float value)
+{
+    if (value > GPR_MAX_CONSTANT) return GPR_MAX_CONSTANT;
+    if (value < -GPR_MAX_CONSTANT) return -GPR_MAX_CONSTANT;
+    return value;
+}
+
+/* returns the output of a two argument logical function
+   for the given real and imaginary input values */
+static int gprc_bits_function(int function_type,
+                              int a_re, int a_im, int b_re, int b_im)
+{
+    switch(function_type) {
+    case GPR_FUNCTION_GREATER_THAN: return (a_re > b_re);
+    case GPR_FUNCTION_LESS_THAN: return (a_re < b_re);
+    case GPR_FUNCTION_EQUALS: return ((a_re == b_re) && (a_im == b_im));
+    case GPR_FUNCTION_AND: return ((a_re > 0) && (b_re > 0));
+    case GPR_FUNCTION_OR: return ((a_re > 0) || (b_re > 0));
+    case GPR_FUNCTION_XOR: return ((a_re > 0) != (b_re > 0));
+    case GPR_FUNCTION_NOT: return (a_re != b_re);
+    }
+    return 0;
+}
+
+/* returns non-zero if the given function can be bit sliced */
+static int gprc_bits_function_supported(int function_type)
+{
+    switch(function_type) {
+    case GPR_FUNCTION_VALUE:
+    case GPR_FUNCTION_NOOP1:
+    case GPR_FUNCTION_NOOP2:
+    case GPR_FUNCTION_NOOP3:
+    case GPR_FUNCTION_NOOP4:
+    case GPR_FUNCTION_GREATER_THAN:
+    case GPR_FUNCTION_LESS_THAN:
+    case GPR_FUNCTION_EQUALS:
+    case GPR_FUNCTION_AND:
+    case GPR_FUNCTION_OR:
+    case GPR_FUNCTION_XOR:
+    case GPR_FUNCTION_NOT: {
+        return 1;
+    }
+    }
+    return 0;
+}
+
+/* Returns non-zero if the given individual can be evaluated
+   using bit sliced fitness cases.  This requires integer maths,
+   no dropout and only logical functions within the used genes */
+int gprc_bits_supported(gprc_function * f,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int sensors, int actuators,
+                        int integers_only,
+                        float dropout_prob)
+{
+    int i, n, function_type, * program, * instr;
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int no_of_states = (rows*columns) + sensors + actuators;
+
+    if ((integers_only <= 0) || (dropout_prob > 0) ||
+        (connections_per_gene < 2) || (f->ADF_modules > 0)) {
+        return 0;
+    }
+
+    program = gprc_compiled_program(f, 0, rows, columns,
+                                    connections_per_gene,
+                                    sensors, 0);
+    if (program == NULL) return 0;
+
+    for (i = 0; i < f->genome[0].program_length; i++) {
+        instr = &program[i*instr_size];
+        function_type = instr[GPRC_INSTR_FUNCTION_TYPE];
+        if (!gprc_bits_function_supported(function_type)) {
+            return 0;
+        }
+        if (function_type == GPR_FUNCTION_VALUE) {
+            /* the imaginary part of a value is read from
+               further along the genome */
+            n = instr[GPRC_INSTR_GENE]*gene_size +
+                GPRC_GENE_CONSTANT + no_of_states;
+            if (n >= (rows*columns*gene_size) + actuators) return 0;
+        }
+    }
+    return 1;
+}
+
+/* Runs a program over bit sliced fitness cases.  Bit k of word w
+   within inputs[s*no_of_words + w] gives the value of sensor s,
+   either zero or one, for fitness case (w*GPRC_BITS_WORD)+k.
+   The outputs have the same layout, with a bit set where the
+   actuator is non-zero.  If values isn't NULL then it returns
+   the value of each actuator where its bits are set.
+   This gives the same results as gprc_run_int */
+void gprc_run_bits_base(gprc_function * f,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int sensors, int actuators,
+                        int no_of_words,
+                        unsigned long long * inputs,
+                        unsigned long long * outputs,
+                        float * values)
+{
+    int i, j, k, n, w, words, src, table;
+    int * program, * instr, * con;
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int no_of_states = (rows*columns) + sensors + actuators;
+    int length, function_type;
+    float * gene = f->genome[0].gene;
+    float * re, * im, * gp;
+    unsigned long long * bits, * out, * all;
+
+    program = gprc_compiled_program(f, 0, rows, columns,
+                                    connections_per_gene,
+                                    sensors, 0);
+    length = f->genome[0].program_length;
+
+    /* the value of each state where its bits are set */
+    re = (float*)malloc((sensors + (rows*columns))*sizeof(float));
+    im = (float*)malloc((sensors + (rows*columns))*sizeof(float));
+    bits = (unsigned long long*)
+        malloc((sensors + (rows*columns))*GPRC_BITS_BLOCK*
+               sizeof(unsigned long long));
+    all = (unsigned long long*)
+        malloc(GPRC_BITS_BLOCK*sizeof(unsigned long long));
+    memset((void*)all, 0xff, GPRC_BITS_BLOCK*sizeof(unsigned long long));
+
+    for (i = 0; i < sensors; i++) {
+        re[i] = 1;
+        im[i] = 0;
+    }
+    for (i = 0; i < length; i++) {
+        instr = &program[i*instr_size];
+        n = instr[GPRC_INSTR_GENE]*gene_size;
+        gp = &gene[n];
+        k = sensors + instr[GPRC_INSTR_GENE];
+        function_type = instr[GPRC_INSTR_FUNCTION_TYPE];
+        if ((function_type >= GPR_FUNCTION_NOOP1) &&
+            (function_type <= GPR_FUNCTION_NOOP4)) {
+            re[k] = re[instr[GPRC_INSTR_INITIAL]];
+            im[k] = im[instr[GPRC_INSTR_INITIAL]];
+        }
+        else if (function_type == GPR_FUNCTION_VALUE) {
+            re[k] = gprc_bits_clamp((int)gp[GPRC_GENE_CONSTANT]);
+            im[k] = gprc_bits_clamp((int)gp[GPRC_GENE_CONSTANT+
+                                            no_of_states]);
+        }
+        else {
+            re[k] = gprc_bits_clamp((int)gp[GPRC_GENE_CONSTANT]);
+            im[k] = gprc_bits_clamp((int)gp[GPRC_GENE_IMAGINARY]);
+        }
+    }
+
+    for (w = 0; w < no_of_words; w += GPRC_BITS_BLOCK) {
+        words = no_of_words - w;
+        if (words > GPRC_BITS_BLOCK) words = GPRC_BITS_BLOCK;
+
+        /* sensors */
+        for (i = 0; i < sensors; i++) {
+            memcpy((void*)&bits[i*GPRC_BITS_BLOCK],
+                   (void*)&inputs[i*no_of_words + w],
+                   words*sizeof(unsigned long long));
+        }
+
+        for (i = 0; i < length; i++) {
+            instr = &program[i*instr_size];
+            con = &instr[GPRC_INSTR_INITIAL];
+            k = sensors + instr[GPRC_INSTR_GENE];
+            out = &bits[k*GPRC_BITS_BLOCK];
+            function_type = instr[GPRC_INSTR_FUNCTION_TYPE];
+            if (function_type == GPR_FUNCTION_VALUE) {
+                memcpy((void*)out, (void*)all,
+                       words*sizeof(unsigned long long));
+                continue;
+            }
+            if ((function_type >= GPR_FUNCTION_NOOP1) &&
+                (function_type <= GPR_FUNCTION_NOOP4)) {
+                memcpy((void*)out, (void*)&bits[con[0]*GPRC_BITS_BLOCK],
+                       words*sizeof(unsigned long long));
+                continue;
+            }
+
+            /* truth table over whether each input is set */
+            table = 0;
+            for (j = 0; j < 4; j++) {
+                if (gprc_bits_function(function_type,
+                                       (j&1) ? (int)re[con[0]] : 0,
+                                       (j&1) ? (int)im[con[0]] : 0,
+                                       (j&2) ? (int)re[con[1]] : 0,
+                                       (j&2) ? (int)im[con[1]] : 0)) {
+                    table |= (1<<j);
+                }
+            }
+            gprc_simd.truth(out,
+                            &bits[con[0]*GPRC_BITS_BLOCK],
+                            &bits[con[1]*GPRC_BITS_BLOCK],
+                            table, words);
+        }
+
+        /* actuators */
+        n = rows*columns*gene_size;
+        for (i = 0; i < actuators; i++) {
+            src = (int)gene[n+i];
+            if (re[src] != 0) {
+                memcpy((void*)&outputs[i*no_of_words + w],
+                       (void*)&bits[src*GPRC_BITS_BLOCK],
+                       words*sizeof(unsigned long long));
+            }
+            else {
+                memset((void*)&outputs[i*no_of_words + w], '\0',
+                       words*sizeof(unsigned long long));
+            }
+        }
+    }
+
+    if (values != NULL) {
+        n = rows*columns*gene_size;
+        for (i = 0; i < actuators; i++) {
+            values[i] = re[(int)gene[n+i]];
+        }
+    }
+
+    free(re);
+    free(im);
+    free(bits);
+    free(all);
+}
+
+/* Runs an individual from the given population over bit sliced
+   fitness cases.  Returns zero if the individual can't be
+   bit sliced, in which case nothing is evaluated */
+int gprc_run_bits(gprc_function * f, gprc_population * population,
+                  float dropout_prob, int no_of_words,
+                  unsigned long long * inputs,
+                  unsigned long long * outputs,
+                  float * values)
+{
+    if (gprc_bits_supported(f, population->rows, population->columns,
+                            population->connections_per_gene,
+                            population->sensors, population->actuators,
+                            population->integers_only,
+                            dropout_prob) == 0) {
+        return 0;
+    }
+    gprc_run_bits_base(f, population->rows, population->columns,
+                       population->connections_per_gene,
+                       population->sensors, population->actuators,
+                       no_of_words, inputs, outputs, values);
+    return 1;
+}
+
+/* Runs an individual from the given morphological population
+   over bit sliced fitness cases */
+int gprcm_run_bits(gprcm_function * f, gprcm_population * population,
+                   float dropout_prob, int no_of_words,
+                   unsigned long long * inputs,
+                   unsigned long long * outputs,
+                   float * values)
+{
+    if (gprc_bits_supported(&f->program,
+                            population->rows, population->columns,
+                            population->connections_per_gene,
+                            population->sensors, population->actuators,
+                            population->integers_only,
+                            dropout_prob) == 0) {
+        return 0;
+    }
+    gprc_run_bits_base(&f->program,
+                       population->rows, population->columns,
+                       population->connections_per_gene,
+                       population->sensors, population->actuators,
+                       no_of_words, inputs, outputs, values);
+    return 1;
+}
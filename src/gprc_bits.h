@@ -0,0 +1,74 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPRC_BITS_H
+#define GPRC_BITS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "globals.h"
+#include "gpr.h"
+#include "gprc.h"
+#include "gprcm.h"
+#include "gprc_simd.h"
+
+/* the number of fitness cases packed into each word */
+#define GPRC_BITS_WORD   64
+
+/* the number of words evaluated together within each block */
+#define GPRC_BITS_BLOCK  64
+
+int gprc_bits_supported(gprc_function * f,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int sensors, int actuators,
+                        int integers_only,
+                        float dropout_prob);
+void gprc_run_bits_base(gprc_function * f,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int sensors, int actuators,
+                        int no_of_words,
+                        unsigned long long * inputs,
+                        unsigned long long * outputs,
+                        float * values);
+int gprc_run_bits(gprc_function * f, gprc_population * population,
+                  float dropout_prob, int no_of_words,
+                  unsigned long long * inputs,
+                  unsigned long long * outputs,
+                  float * values);
+int gprcm_run_bits(gprcm_function * f, gprcm_population * population,
+                   float dropout_prob, int no_of_words,
+                   unsigned long long * inputs,
+                   unsigned long long * outputs,
+                   float * values);
+
+#endif
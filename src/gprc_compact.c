@@ -0,0 +1,352 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Compact genome encoding.
+
+   Within gprc_function each gene is a run of floats, with the
+   function type, constant, imaginary part, connections and weights
+   interleaved.  Here the fields are held in separate arrays, with
+   function types as bytes and connections as 16 bit indexes.
+   Weights are only read by the sigmoid and hebbian functions, so
+   when the instruction set contains neither of those they need not
+   be stored at all.  The compact form is several times smaller,
+   which makes copying and crossover cheaper, and it can be
+   converted back into a gprc_function for evaluation or saving */
+
+#include "gprc_compact.h"
+
+/* allocates the arrays for a compact genome */
+void gprc_compact_init(gprc_compact * c,
+                       int rows, int columns,
+                       int connections_per_gene,
+                       int sensors, int actuators,
+                       int ADF_modules, int weights)
+{
+    int m, genes = rows*columns;
+
+    c->rows = rows;
+    c->columns = columns;
+    c->connections_per_gene = connections_per_gene;
+    c->sensors = sensors;
+    c->actuators = actuators;
+    c->ADF_modules = ADF_modules;
+    c->weights = weights;
+
+    for (m = 0; m < GPRC_MAX_ADF_MODULES+1; m++) {
+        c->module[m].function_type = NULL;
+        c->module[m].constant = NULL;
+        c->module[m].imaginary = NULL;
+        c->module[m].connection = NULL;
+        c->module[m].weight = NULL;
+        c->module[m].actuator = NULL;
+    }
+
+    for (m = 0; m < ADF_modules+1; m++) {
+        c->module[m].function_type =
+            (unsigned char*)malloc(genes*sizeof(unsigned char));
+        c->module[m].constant = (float*)malloc(genes*sizeof(float));
+        c->module[m].imaginary = (float*)malloc(genes*sizeof(float));
+        c->module[m].connection =
+            (unsigned short*)malloc(genes*connections_per_gene*
+                                    sizeof(unsigned short));
+        if (weights > 0) {
+            c->module[m].weight =
+                (float*)malloc(genes*connections_per_gene*
+                               sizeof(float));
+        }
+        c->module[m].actuator =
+            (unsigned short*)malloc(gprc_get_actuators(m, actuators)*
+                                    sizeof(unsigned short));
+    }
+}
+
+/* frees memory for a compact genome */
+void gprc_compact_free(gprc_compact * c)
+{
+    for (int m = 0; m < c->ADF_modules+1; m++) {
+        free(c->module[m].function_type);
+        free(c->module[m].constant);
+        free(c->module[m].imaginary);
+        free(c->module[m].connection);
+        if (c->module[m].weight != NULL) {
+            free(c->module[m].weight);
+        }
+        free(c->module[m].actuator);
+    }
+}
+
+/* returns non-zero if the given instruction set contains
+   any function which reads the connection weights */
+int gprc_compact_uses_weights(int * instruction_set,
+                              int no_of_instructions)
+{
+    for (int i = 0; i < no_of_instructions; i++) {
+        if ((instruction_set[i] == GPR_FUNCTION_SIGMOID) ||
+            (instruction_set[i] == GPR_FUNCTION_HEBBIAN)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* returns the number of bytes used to store the genes */
+int gprc_compact_size(gprc_compact * c)
+{
+    int m, size = 0, genes = c->rows*c->columns;
+    int gene_size = sizeof(unsigned char) + (2*sizeof(float)) +
+        (c->connections_per_gene*sizeof(unsigned short));
+
+    if (c->weights > 0) {
+        gene_size += c->connections_per_gene*sizeof(float);
+    }
+
+    for (m = 0; m < c->ADF_modules+1; m++) {
+        size += genes*gene_size +
+            gprc_get_actuators(m, c->actuators)*sizeof(unsigned short);
+    }
+    return size;
+}
+
+/* returns non-zero if the given gene value can be
+   stored as an index of at most the given maximum */
+static int gprc_compact_valid(float value, int max)
+{
+    return ((value >= 0) && (value <= max) &&
+            (value == (float)((int)value)));
+}
+
+/* converts the genes of the given program into the compact form.
+   Returns zero on success or -1 if any function type or connection
+   has a value which cannot be represented */
+int gprc_compact_encode(gprc_function * f, gprc_compact * c)
+{
+    int m, i, j, n, actuators;
+    int genes = c->rows*c->columns;
+    int connections_per_gene = c->connections_per_gene;
+    int step = GPRC_GENE_SIZE(connections_per_gene);
+    float * gene;
+    gprc_compact_module * module;
+
+    if (f->ADF_modules != c->ADF_modules) return -1;
+
+    for (m = 0; m < c->ADF_modules+1; m++) {
+        gene = f->genome[m].gene;
+        module = &c->module[m];
+        for (i = 0, n = 0; i < genes; i++, n += step) {
+            if (!gprc_compact_valid(gene[n+GPRC_GENE_FUNCTION_TYPE],
+                                    GPRC_COMPACT_MAX_FUNCTION)) {
+                return -1;
+            }
+            module->function_type[i] =
+                (unsigned char)gene[n+GPRC_GENE_FUNCTION_TYPE];
+            module->constant[i] = gene[n+GPRC_GENE_CONSTANT];
+            module->imaginary[i] = gene[n+GPRC_GENE_IMAGINARY];
+            for (j = 0; j < connections_per_gene; j++) {
+                if (!gprc_compact_valid(gene[n+GPRC_INITIAL+j],
+                                        GPRC_COMPACT_MAX_CONNECTION)) {
+                    return -1;
+                }
+                module->connection[i*connections_per_gene+j] =
+                    (unsigned short)gene[n+GPRC_INITIAL+j];
+                if (module->weight != NULL) {
+                    module->weight[i*connections_per_gene+j] =
+                        gene[n+GPRC_INITIAL+connections_per_gene+j];
+                }
+            }
+        }
+
+        /* actuator sources follow the grid */
+        actuators = gprc_get_actuators(m, c->actuators);
+        for (i = 0; i < actuators; i++, n++) {
+            if (!gprc_compact_valid(gene[n],
+                                    GPRC_COMPACT_MAX_CONNECTION)) {
+                return -1;
+            }
+            module->actuator[i] = (unsigned short)gene[n];
+        }
+    }
+    return 0;
+}
+
+/* converts a compact genome back into the given program, which
+   should have been initialised with the same dimensions.
+   If weights were not stored then they are set to one */
+void gprc_compact_decode(gprc_compact * c, gprc_function * f)
+{
+    int m, i, j, n, actuators;
+    int genes = c->rows*c->columns;
+    int connections_per_gene = c->connections_per_gene;
+    int step = GPRC_GENE_SIZE(connections_per_gene);
+    float * gene;
+    gprc_compact_module * module;
+
+    for (m = 0; m < c->ADF_modules+1; m++) {
+        gene = f->genome[m].gene;
+        module = &c->module[m];
+        for (i = 0, n = 0; i < genes; i++, n += step) {
+            gene[n+GPRC_GENE_FUNCTION_TYPE] = module->function_type[i];
+            gene[n+GPRC_GENE_CONSTANT] = module->constant[i];
+            gene[n+GPRC_GENE_IMAGINARY] = module->imaginary[i];
+            for (j = 0; j < connections_per_gene; j++) {
+                gene[n+GPRC_INITIAL+j] =
+                    module->connection[i*connections_per_gene+j];
+                if (module->weight != NULL) {
+                    gene[n+GPRC_INITIAL+connections_per_gene+j] =
+                        module->weight[i*connections_per_gene+j];
+                }
+                else {
+                    gene[n+GPRC_INITIAL+connections_per_gene+j] = 1;
+                }
+            }
+        }
+
+        actuators = gprc_get_actuators(m, c->actuators);
+        for (i = 0; i < actuators; i++, n++) {
+            gene[n] = module->actuator[i];
+        }
+    }
+
+    /* retrace the genes which are used */
+    gprc_used_functions(f, c->rows, c->columns,
+                        connections_per_gene,
+                        c->sensors, c->actuators);
+}
+
+/* copies a compact genome.  Both should have the same dimensions */
+void gprc_compact_copy(gprc_compact * source, gprc_compact * dest)
+{
+    int m, genes = source->rows*source->columns;
+    int connections = genes*source->connections_per_gene;
+
+    for (m = 0; m < source->ADF_modules+1; m++) {
+        memcpy((void*)dest->module[m].function_type,
+               (void*)source->module[m].function_type,
+               genes*sizeof(unsigned char));
+        memcpy((void*)dest->module[m].constant,
+               (void*)source->module[m].constant,
+               genes*sizeof(float));
+        memcpy((void*)dest->module[m].imaginary,
+               (void*)source->module[m].imaginary,
+               genes*sizeof(float));
+        memcpy((void*)dest->module[m].connection,
+               (void*)source->module[m].connection,
+               connections*sizeof(unsigned short));
+        if ((source->module[m].weight != NULL) &&
+            (dest->module[m].weight != NULL)) {
+            memcpy((void*)dest->module[m].weight,
+                   (void*)source->module[m].weight,
+                   connections*sizeof(float));
+        }
+        memcpy((void*)dest->module[m].actuator,
+               (void*)source->module[m].actuator,
+               gprc_get_actuators(m, source->actuators)*
+               sizeof(unsigned short));
+    }
+}
+
+/* copies a range of genes between compact modules */
+static void gprc_compact_copy_genes(gprc_compact_module * source,
+                                    gprc_compact_module * dest,
+                                    int start, int length,
+                                    int connections_per_gene)
+{
+    memcpy((void*)&dest->function_type[start],
+           (void*)&source->function_type[start],
+           length*sizeof(unsigned char));
+    memcpy((void*)&dest->constant[start],
+           (void*)&source->constant[start],
+           length*sizeof(float));
+    memcpy((void*)&dest->imaginary[start],
+           (void*)&source->imaginary[start],
+           length*sizeof(float));
+    memcpy((void*)&dest->connection[start*connections_per_gene],
+           (void*)&source->connection[start*connections_per_gene],
+           length*connections_per_gene*sizeof(unsigned short));
+    if ((source->weight != NULL) && (dest->weight != NULL)) {
+        memcpy((void*)&dest->weight[start*connections_per_gene],
+               (void*)&source->weight[start*connections_per_gene],
+               length*connections_per_gene*sizeof(float));
+    }
+}
+
+/* Produces a child by crossing two compact parents.  As with
+   gprc_crossover the main program is split into chromosomes, each
+   being a band of rows copied from one parent or the other, and each
+   actuator source is taken from either parent.  Since the compact
+   form does not record which genes are used each ADF module is
+   copied whole from a randomly chosen parent */
+void gprc_compact_crossover(gprc_compact * parent1,
+                            gprc_compact * parent2,
+                            int chromosomes,
+                            gprc_compact * child,
+                            unsigned int * random_seed)
+{
+    int m, c, col, i, start_row, end_row;
+    int rows = child->rows, columns = child->columns;
+    gprc_compact * parent;
+
+    /* chromosomes of the main program */
+    for (c = 0; c < chromosomes; c++) {
+        parent = parent2;
+        if (rand_num(random_seed)%10000 > 5000) {
+            parent = parent1;
+        }
+        start_row = c * rows / chromosomes;
+        end_row = (c+1) * rows / chromosomes;
+        if (end_row <= start_row) continue;
+        for (col = 0; col < columns; col++) {
+            gprc_compact_copy_genes(&parent->module[0], &child->module[0],
+                                    (col*rows) + start_row,
+                                    end_row - start_row,
+                                    child->connections_per_gene);
+        }
+    }
+
+    /* actuators */
+    for (i = 0; i < child->actuators; i++) {
+        if (rand_num(random_seed)%10000 > 5000) {
+            child->module[0].actuator[i] = parent1->module[0].actuator[i];
+        }
+        else {
+            child->module[0].actuator[i] = parent2->module[0].actuator[i];
+        }
+    }
+
+    /* ADF modules */
+    for (m = 1; m < child->ADF_modules+1; m++) {
+        parent = parent2;
+        if (rand_num(random_seed)%10000 > 5000) {
+            parent = parent1;
+        }
+        gprc_compact_copy_genes(&parent->module[m], &child->module[m],
+                                0, rows*columns,
+                                child->connections_per_gene);
+        child->module[m].actuator[0] = parent->module[m].actuator[0];
+    }
+}
@@ -0,0 +1,93 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPRC_COMPACT_H
+#define GPRC_COMPACT_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "globals.h"
+#include "gpr.h"
+#include "gprc.h"
+
+/* the largest connection index which can be stored */
+#define GPRC_COMPACT_MAX_CONNECTION  65535
+
+/* the largest function type which can be stored */
+#define GPRC_COMPACT_MAX_FUNCTION    255
+
+/* the genes of a grid stored as separate arrays for
+   each field, rather than as interleaved floats */
+struct gprc_compact_mod {
+    unsigned char * function_type;
+    float * constant;
+    float * imaginary;
+    /* connections_per_gene entries for each gene */
+    unsigned short * connection;
+    /* connections_per_gene weights for each gene,
+       or NULL if weights are not stored */
+    float * weight;
+    /* the source of each actuator */
+    unsigned short * actuator;
+};
+typedef struct gprc_compact_mod gprc_compact_module;
+
+/* a compact encoding of the genome of a program */
+struct gprc_comp {
+    int rows, columns;
+    int connections_per_gene;
+    int sensors, actuators;
+    int ADF_modules;
+    /* whether connection weights are stored */
+    int weights;
+    gprc_compact_module module[GPRC_MAX_ADF_MODULES+1];
+};
+typedef struct gprc_comp gprc_compact;
+
+void gprc_compact_init(gprc_compact * c,
+                       int rows, int columns,
+                       int connections_per_gene,
+                       int sensors, int actuators,
+                       int ADF_modules, int weights);
+void gprc_compact_free(gprc_compact * c);
+int gprc_compact_uses_weights(int * instruction_set,
+                              int no_of_instructions);
+int gprc_compact_size(gprc_compact * c);
+int gprc_compact_encode(gprc_function * f, gprc_compact * c);
+void gprc_compact_decode(gprc_compact * c, gprc_function * f);
+void gprc_compact_copy(gprc_compact * source, gprc_compact * dest);
+void gprc_compact_crossover(gprc_compact * parent1,
+                            gprc_compact * parent2,
+                            int chromosomes,
+                            gprc_compact * child,
+                            unsigned int * random_seed);
+
+#endif
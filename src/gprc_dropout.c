@@ -0,0 +1,100 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Dropout masks.
+
+   Rather than drawing a random number for every gene each time a
+   program runs, the genes to be skipped are given by words of mask
+   bits.  The bits come from a counter based generator, which hashes
+   a key and a counter, so any word can be produced independently of
+   the others.  Each hash gives four 16 bit values, each of which is
+   compared against the dropout threshold to give one mask bit.
+   Gene n of a program uses lane n%4 of hash n/4, so the interpreters
+   can test genes one at a time and get the same bits as a mask */
+
+#include "gprc_dropout.h"
+
+/* returns the threshold below which a 16 bit
+   random value causes a gene to be dropped */
+unsigned int gprc_dropout_threshold(float dropout_prob)
+{
+    if (dropout_prob <= 0) return 0;
+    if (dropout_prob >= 1) return GPRC_DROPOUT_LEVELS;
+    return (unsigned int)(dropout_prob*GPRC_DROPOUT_LEVELS);
+}
+
+/* returns a pseudo-random value for the given key and counter,
+   using the splitmix64 finaliser */
+unsigned long long gprc_dropout_hash(unsigned long long key,
+                                     unsigned long long counter)
+{
+    unsigned long long z = key + (counter+1)*0x9E3779B97F4A7C15ULL;
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* returns a word in which each bit is set with a probability
+   of threshold/GPRC_DROPOUT_LEVELS */
+unsigned long long gprc_dropout_word(unsigned long long key,
+                                     unsigned long long counter,
+                                     unsigned int threshold)
+{
+    int i, j;
+    unsigned long long r, word = 0, bit = 1;
+
+    if (threshold == 0) return 0;
+    if (threshold >= GPRC_DROPOUT_LEVELS) return ~0ULL;
+
+    for (i = 0; i < GPRC_DROPOUT_WORD/GPRC_DROPOUT_LANES; i++) {
+        r = gprc_dropout_hash(key,
+                              counter*(GPRC_DROPOUT_WORD/GPRC_DROPOUT_LANES) +
+                              i);
+        for (j = 0; j < GPRC_DROPOUT_LANES; j++, bit <<= 1) {
+            if (gprc_dropout_lane(r, j) < threshold) {
+                word |= bit;
+            }
+        }
+    }
+    return word;
+}
+
+/* fills a mask with the given number of words,
+   beginning from the given counter */
+void gprc_dropout_mask(unsigned long long key,
+                       unsigned long long counter,
+                       unsigned int threshold,
+                       int no_of_words,
+                       unsigned long long * mask)
+{
+    for (int i = 0; i < no_of_words; i++) {
+        mask[i] = gprc_dropout_word(key, counter + i, threshold);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPRC_DROPOUT_H
+#define GPRC_DROPOUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the number of genes covered by each dropout mask word */
+#define GPRC_DROPOUT_WORD  64
+
+/* the number of 16 bit random values given by each hash */
+#define GPRC_DROPOUT_LANES  4
+
+/* resolution of the dropout probability */
+#define GPRC_DROPOUT_LEVELS  65536
+
+unsigned int gprc_dropout_threshold(float dropout_prob);
+unsigned long long gprc_dropout_hash(unsigned long long key,
+                                     unsigned long long counter);
+unsigned long long gprc_dropout_word(unsigned long long key,
+                                     unsigned long long counter,
+                                     unsigned int threshold);
+void gprc_dropout_mask(unsigned long long key,
+                       unsigned long long counter,
+                       unsigned int threshold,
+                       int no_of_words,
+                       unsigned long long * mask);
+
+/* returns the 16 bit random value within the given lane of a hash */
+static inline unsigned int gprc_dropout_lane(unsigned long long hash,
+                                             int lane)
+{
+    return (unsigned int)((hash >> (lane*16)) & 0xffff);
+}
+
+/* Returns non-zero if gene n of a program is dropped, giving the same
+   result as bit n of a mask.  The most recent hash and its index are
+   kept so that genes can be tested one at a time, in order, with one
+   hash for each group of GPRC_DROPOUT_LANES genes.  The index should
+   initially be -1 */
+static inline int gprc_dropout_gene(unsigned long long key,
+                                    unsigned int threshold, int n,
+                                    int * index,
+                                    unsigned long long * hash)
+{
+    if (n / GPRC_DROPOUT_LANES != *index) {
+        *index = n / GPRC_DROPOUT_LANES;
+        *hash = gprc_dropout_hash(key, *index);
+    }
+    return gprc_dropout_lane(*hash, n % GPRC_DROPOUT_LANES) < threshold;
+}
+
+#endif
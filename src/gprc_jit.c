@@ -0,0 +1,877 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* needed for mkdtemp when compiling with -std=c99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <dlfcn.h>
+#include "gprc_jit.h"
+
+extern char ** environ;
+
+/* name of the function within each compiled shared object */
+#define GPRC_JIT_FUNCTION "gprc_native_run"
+
+/* returns non-zero if the given function type can be
+   compiled to native code */
+static int gprc_jit_function(int function_type)
+{
+    /* the custom function is a pointer within the calling program */
+    if (function_type == GPR_FUNCTION_CUSTOM) return 0;
+    return 1;
+}
+
+/* Initialises a cache of compiled programs, with a temporary
+   directory in which they are built.  The compiler is the name
+   or path of a single program, which is run directly rather than
+   through a shell.  If no compiler is given then gcc is used.
+   Returns zero on success */
+int gprc_jit_init(gprc_jit * jit, int max_entries, char * compiler)
+{
+    char * tmpdir = getenv("TMPDIR");
+
+    memset((void*)jit, '\0', sizeof(gprc_jit));
+    omp_init_lock(&jit->lock);
+    if (max_entries < 1) max_entries = 1;
+
+    if (compiler == NULL) compiler = "gcc";
+    if (strlen(compiler) >= GPRC_JIT_MAX_PATH) return -1;
+    sprintf(jit->compiler, "%s", compiler);
+
+    if (tmpdir == NULL) tmpdir = "/tmp";
+    if (strlen(tmpdir) + 16 >= GPRC_JIT_MAX_PATH) return -1;
+    sprintf(jit->directory, "%s/libgpr_XXXXXX", tmpdir);
+    if (mkdtemp(jit->directory) == NULL) {
+        jit->directory[0] = 0;
+        return -1;
+    }
+
+    jit->entry =
+        (gprc_jit_entry*)malloc(max_entries*sizeof(gprc_jit_entry));
+    if (jit->entry == NULL) {
+        rmdir(jit->directory);
+        jit->directory[0] = 0;
+        return -1;
+    }
+    jit->max_entries = max_entries;
+    return 0;
+}
+
+/* releases a cache entry */
+static void gprc_jit_free_entry(gprc_jit_entry * e)
+{
+    free(e->key);
+    e->key = NULL;
+    if (e->handle != NULL) {
+        dlclose(e->handle);
+        e->handle = NULL;
+    }
+    e->run = NULL;
+}
+
+/* Frees the cache.  Any native functions which were returned
+   can no longer be used after this */
+void gprc_jit_free(gprc_jit * jit)
+{
+    int i;
+
+    for (i = 0; i < jit->no_of_entries; i++) {
+        gprc_jit_free_entry(&jit->entry[i]);
+    }
+    if (jit->entry != NULL) {
+        free(jit->entry);
+        jit->entry = NULL;
+    }
+    jit->no_of_entries = 0;
+    jit->max_entries = 0;
+
+    if (jit->directory[0] != 0) {
+        rmdir(jit->directory);
+        jit->directory[0] = 0;
+    }
+    omp_destroy_lock(&jit->lock);
+}
+
+/* returns non-zero if the given individual can be compiled
+   to native code */
+int gprc_jit_supported(gprc_function * f,
+                       int rows, int columns,
+                       int connections_per_gene,
+                       int sensors, int integers_only)
+{
+    int i, * instr;
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+
+    if (!gprc_batch_supported(f, rows, columns,
+                              connections_per_gene, sensors,
+                              integers_only)) {
+        return 0;
+    }
+
+    for (i = 0; i < f->genome[0].program_length; i++) {
+        instr = &f->genome[0].program[i*instr_size];
+        if (!gprc_jit_function(instr[GPRC_INSTR_FUNCTION_TYPE])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* writes a float constant so that it is reproduced exactly */
+static void gprc_jit_float(FILE * fp, float value)
+{
+    fprintf(fp, "((float)%a)", value);
+}
+
+/* writes the assignment of a constant to a state */
+static void gprc_jit_assign(FILE * fp, char * plane, int index,
+                            float value)
+{
+    fprintf(fp, "      %s[%d] = ", plane, index);
+    gprc_jit_float(fp, value);
+    fprintf(fp, "%s", ";\n");
+}
+
+/* writes a logical function, which outputs the gene constants
+   if the given condition is true */
+static void gprc_jit_logical(FILE * fp, int k, float * gp,
+                             char * condition)
+{
+    fprintf(fp, "      if (%s) {\n  ", condition);
+    gprc_jit_assign(fp, "re", k, gp[GPRC_GENE_CONSTANT]);
+    fprintf(fp, "%s", "  ");
+    gprc_jit_assign(fp, "im", k, gp[GPRC_GENE_IMAGINARY]);
+    fprintf(fp, "%s", "      }\n");
+    fprintf(fp, "      else {\n");
+    fprintf(fp, "        re[%d] = 0;\n", k);
+    fprintf(fp, "        im[%d] = 0;\n", k);
+    fprintf(fp, "%s", "      }\n");
+}
+
+/* writes the code for a single compiled gene.
+   This mirrors the behavior of gprc_run_float */
+static void gprc_jit_gene(FILE * fp, int * instr, float * gp,
+                          int sens, int connections_per_gene)
+{
+    int j;
+    int k = sens + instr[GPRC_INSTR_GENE];
+    int no_of_args = instr[GPRC_INSTR_ARGS];
+    int * con = &instr[GPRC_INSTR_INITIAL];
+    int a = con[0], b = con[0];
+    char condition[128];
+
+    if (connections_per_gene > 1) b = con[1];
+
+    fprintf(fp, "      /* gene %d, function %d */\n",
+            instr[GPRC_INSTR_GENE], instr[GPRC_INSTR_FUNCTION_TYPE]);
+
+    switch(instr[GPRC_INSTR_FUNCTION_TYPE]) {
+    case GPR_FUNCTION_VALUE: {
+        gprc_jit_assign(fp, "re", k, gp[GPRC_GENE_CONSTANT]);
+        gprc_jit_assign(fp, "im", k, gp[GPRC_GENE_IMAGINARY]);
+        break;
+    }
+    case GPR_FUNCTION_SIGMOID: {
+        fprintf(fp, "      re[%d] = 0;\n", k);
+        for (j = 0; j < no_of_args; j++) {
+            fprintf(fp, "      re[%d] += re[%d]*", k, con[j]);
+            gprc_jit_float(fp, gp[GPRC_INITIAL+j+connections_per_gene]);
+            fprintf(fp, "%s", ";\n");
+        }
+        fprintf(fp, "      re[%d] = 1.0f / (1.0f + exp(-re[%d]));\n",
+                k, k);
+        break;
+    }
+    case GPR_FUNCTION_ADD: {
+        fprintf(fp, "      re[%d] = 0;\n", k);
+        fprintf(fp, "      im[%d] = 0;\n", k);
+        for (j = 0; j < no_of_args; j++) {
+            fprintf(fp, "      re[%d] += re[%d];\n", k, con[j]);
+            fprintf(fp, "      im[%d] += im[%d];\n", k, con[j]);
+        }
+        break;
+    }
+    case GPR_FUNCTION_SUBTRACT: {
+        fprintf(fp, "      re[%d] = re[%d];\n", k, a);
+        fprintf(fp, "      im[%d] = im[%d];\n", k, a);
+        for (j = 1; j < no_of_args; j++) {
+            fprintf(fp, "      re[%d] -= re[%d];\n", k, con[j]);
+            fprintf(fp, "      im[%d] -= im[%d];\n", k, con[j]);
+        }
+        break;
+    }
+    case GPR_FUNCTION_NEGATE: {
+        fprintf(fp, "      re[%d] = -re[%d];\n", k, a);
+        fprintf(fp, "      im[%d] = -im[%d];\n", k, a);
+        break;
+    }
+    case GPR_FUNCTION_MULTIPLY: {
+        fprintf(fp, "      re[%d] = re[%d];\n", k, a);
+        fprintf(fp, "      im[%d] = im[%d];\n", k, a);
+        for (j = 1; j < no_of_args; j++) {
+            fprintf(fp, "      a = re[%d]; b = im[%d];\n", k, k);
+            fprintf(fp, "      c = re[%d]; d = im[%d];\n",
+                    con[j], con[j]);
+            fprintf(fp, "      re[%d] = (a*c) + (b*d);\n", k);
+            fprintf(fp, "      im[%d] = (b*c) + (a*d);\n", k);
+        }
+        break;
+    }
+    case GPR_FUNCTION_WEIGHT: {
+        fprintf(fp, "      re[%d] = re[%d] * ", k, a);
+        gprc_jit_float(fp, gp[GPRC_GENE_CONSTANT]);
+        fprintf(fp, "%s", ";\n");
+        fprintf(fp, "      im[%d] = im[%d] * ", k, a);
+        gprc_jit_float(fp, gp[GPRC_GENE_CONSTANT]);
+        fprintf(fp, "%s", ";\n");
+        break;
+    }
+    case GPR_FUNCTION_DIVIDE: {
+        fprintf(fp, "      c = re[%d];\n", b);
+        fprintf(fp, "%s", "      if ((c <= 1e-1) && (c >= -1e-1)) {\n");
+        fprintf(fp, "        re[%d] = re[%d];\n", k, a);
+        fprintf(fp, "        im[%d] = c;\n", k);
+        fprintf(fp, "%s", "      }\n      else {\n");
+        fprintf(fp, "        a = re[%d]; b = im[%d]; d = im[%d];\n",
+                a, a, b);
+        fprintf(fp, "        re[%d] = ((a*c) + (b*d)) / "
+                "((c*c) + (d*d));\n", k);
+        fprintf(fp, "        im[%d] = ((b*c) - (a*d)) / "
+                "((c*c) + (d*d));\n", k);
+        fprintf(fp, "%s", "      }\n");
+        break;
+    }
+    case GPR_FUNCTION_MODULUS: {
+        fprintf(fp, "      if (fabs(re[%d]) <= -1e-1) {\n", b);
+        fprintf(fp, "        re[%d] = re[%d];\n", k, a);
+        fprintf(fp, "        im[%d] = im[%d];\n", k, a);
+        fprintf(fp, "%s", "      }\n      else {\n");
+        fprintf(fp, "        a = re[%d]; b = im[%d];\n", a, a);
+        fprintf(fp, "        c = re[%d]; d = im[%d];\n", b, b);
+        fprintf(fp, "%s", "        if (b+d == 0) {\n");
+        fprintf(fp, "          re[%d] = fmod(a,c);\n", k);
+        fprintf(fp, "          im[%d] = 0;\n", k);
+        fprintf(fp, "%s", "        }\n        else {\n");
+        fprintf(fp, "          re[%d] = fmod(((a*c) + (b*d)), "
+                "((c*c) + (d*d)));\n", k);
+        fprintf(fp, "          im[%d] = fmod(((b*c) - (a*d)), "
+                "((c*c) + (d*d)));\n", k);
+        fprintf(fp, "%s", "        }\n      }\n");
+        break;
+    }
+    case GPR_FUNCTION_FLOOR: {
+        fprintf(fp, "      re[%d] = floor(re[%d]);\n", k, a);
+        fprintf(fp, "      im[%d] = floor(im[%d]);\n", k, a);
+        break;
+    }
+    case GPR_FUNCTION_AVERAGE: {
+        fprintf(fp, "      re[%d] = re[%d];\n", k, a);
+        fprintf(fp, "      im[%d] = im[%d];\n", k, a);
+        for (j = 1; j < no_of_args; j++) {
+            fprintf(fp, "      re[%d] += re[%d];\n", k, con[j]);
+            fprintf(fp, "      im[%d] += im[%d];\n", k, con[j]);
+        }
+        fprintf(fp, "      re[%d] /= %d;\n", k, no_of_args);
+        fprintf(fp, "      im[%d] /= %d;\n", k, no_of_args);
+        break;
+    }
+    case GPR_FUNCTION_NOOP1:
+    case GPR_FUNCTION_NOOP2:
+    case GPR_FUNCTION_NOOP3:
+    case GPR_FUNCTION_NOOP4: {
+        fprintf(fp, "      re[%d] = re[%d];\n", k, a);
+        fprintf(fp, "      im[%d] = im[%d];\n", k, a);
+        break;
+    }
+    case GPR_FUNCTION_GREATER_THAN: {
+        sprintf(condition, "re[%d] > re[%d]", a, b);
+        gprc_jit_logical(fp, k, gp, condition);
+        break;
+    }
+    case GPR_FUNCTION_LESS_THAN: {
+        sprintf(condition, "re[%d] < re[%d]", a, b);
+        gprc_jit_logical(fp, k, gp, condition);
+        break;
+    }
+    case GPR_FUNCTION_EQUALS: {
+        sprintf(condition, "((int)re[%d] == (int)re[%d]) && "
+                "((int)im[%d] == (int)im[%d])", a, b, a, b);
+        gprc_jit_logical(fp, k, gp, condition);
+        break;
+    }
+    case GPR_FUNCTION_AND: {
+        sprintf(condition, "(re[%d] > 0) && (re[%d] > 0)", a, b);
+        gprc_jit_logical(fp, k, gp, condition);
+        break;
+    }
+    case GPR_FUNCTION_OR: {
+        sprintf(condition, "(re[%d] > 0) || (re[%d] > 0)", a, b);
+        gprc_jit_logical(fp, k, gp, condition);
+        break;
+    }
+    case GPR_FUNCTION_XOR: {
+        sprintf(condition, "(re[%d] > 0) != (re[%d] > 0)", a, b);
+        gprc_jit_logical(fp, k, gp, condition);
+        break;
+    }
+    case GPR_FUNCTION_NOT: {
+        sprintf(condition, "(int)re[%d] != (int)re[%d]", a, b);
+        gprc_jit_logical(fp, k, gp, condition);
+        break;
+    }
+    case GPR_FUNCTION_EXP: {
+        fprintf(fp, "      re[%d] = (float)exp(re[%d]);\n", k, a);
+        fprintf(fp, "      im[%d] = (float)exp(im[%d]);\n", k, a);
+        break;
+    }
+    case GPR_FUNCTION_SQUARE_ROOT: {
+        fprintf(fp, "      a = re[%d]; b = im[%d];\n", a, a);
+        fprintf(fp, "%s", "      if (b == 0) {\n");
+        fprintf(fp, "        re[%d] = (float)sqrt(fabs(a));\n", k);
+        fprintf(fp, "        im[%d] = 0;\n", k);
+        fprintf(fp, "%s", "      }\n      else {\n");
+        fprintf(fp, "%s", "        a2 = (float)sqrt((a*a) + (b*b));\n");
+        fprintf(fp, "        re[%d] = (float)sqrt((a + a2) * 0.5f);\n", k);
+        fprintf(fp, "        im[%d] = (float)sqrt((-a + a2) * 0.5f);\n", k);
+        fprintf(fp, "        if (b < 0) im[%d] = -im[%d];\n", k, k);
+        fprintf(fp, "%s", "      }\n");
+        break;
+    }
+    case GPR_FUNCTION_ABS: {
+        fprintf(fp, "      a = re[%d]; b = im[%d];\n", a, a);
+        fprintf(fp, "      if (b == 0) re[%d] = (float)fabs(a);\n", k);
+        fprintf(fp, "      else re[%d] = (float)sqrt((a*a) + (b*b));\n",
+                k);
+        fprintf(fp, "      im[%d] = 0;\n", k);
+        break;
+    }
+    case GPR_FUNCTION_SINE: {
+        fprintf(fp, "      a = re[%d]; b = im[%d];\n", a, a);
+        fprintf(fp, "%s", "      if (b == 0) {\n");
+        fprintf(fp, "        re[%d] = (float)sin(a)*256;\n", k);
+        fprintf(fp, "        im[%d] = 0;\n", k);
+        fprintf(fp, "%s", "      }\n      else {\n");
+        fprintf(fp, "        re[%d] = (float)(sin(a)*cosh(b))*256;\n", k);
+        fprintf(fp, "        im[%d] = (float)(cos(a)*sinh(b))*256;\n", k);
+        fprintf(fp, "%s", "      }\n");
+        break;
+    }
+    case GPR_FUNCTION_ARCSINE: {
+        fprintf(fp, "      re[%d] = (float)asin(re[%d]);\n", k, a);
+        break;
+    }
+    case GPR_FUNCTION_COSINE: {
+        fprintf(fp, "      a = re[%d]; b = im[%d];\n", a, a);
+        fprintf(fp, "%s", "      if (b == 0) {\n");
+        fprintf(fp, "        re[%d] = (float)cos(a)*256;\n", k);
+        fprintf(fp, "        im[%d] = 0;\n", k);
+        fprintf(fp, "%s", "      }\n      else {\n");
+        fprintf(fp, "        re[%d] = (float)(cos(a)*cosh(b))*256;\n", k);
+        fprintf(fp, "        im[%d] = (float)(sin(a)*sinh(b))*256;\n", k);
+        fprintf(fp, "%s", "      }\n");
+        break;
+    }
+    case GPR_FUNCTION_ARCCOSINE: {
+        fprintf(fp, "      re[%d] = (float)acos(re[%d]);\n", k, a);
+        break;
+    }
+    case GPR_FUNCTION_POW: {
+        fprintf(fp, "      re[%d] = (float)pow(re[%d], re[%d]);\n",
+                k, a, b);
+        fprintf(fp, "      im[%d] = (float)pow(im[%d], im[%d]);\n",
+                k, a, b);
+        break;
+    }
+    case GPR_FUNCTION_MIN:
+    case GPR_FUNCTION_MAX: {
+        /* the imaginary part is only updated when a later
+           argument is selected */
+        fprintf(fp, "      re[%d] = re[%d];\n", k, a);
+        for (j = 1; j < no_of_args; j++) {
+            fprintf(fp, "      if (re[%d] %c re[%d]) {\n", con[j],
+                    (instr[GPRC_INSTR_FUNCTION_TYPE] ==
+                     GPR_FUNCTION_MIN) ? '<' : '>', k);
+            fprintf(fp, "        re[%d] = re[%d];\n", k, con[j]);
+            fprintf(fp, "        im[%d] = im[%d];\n", k, con[j]);
+            fprintf(fp, "%s", "      }\n");
+        }
+        break;
+    }
+    }
+
+    fprintf(fp, "      GPRC_CLAMP(%d);\n", k);
+}
+
+/* Writes a C source file containing a single function which runs
+   the given individual over a batch of samples.  Only the genes
+   which are used are included, as straight line code */
+void gprc_jit_source(gprc_function * f,
+                     int rows, int columns,
+                     int connections_per_gene,
+                     int sensors, int actuators,
+                     FILE * fp)
+{
+    int i, j, k, * instr;
+    int * program = f->genome[0].program;
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int no_of_states = (rows*columns) + sensors + actuators;
+    float * gene = f->genome[0].gene;
+    unsigned char * cleared;
+
+    fprintf(fp, "%s", "/* Cartesian Genetic Program\n");
+    fprintf(fp, "%s", "   Evolved using libgpr\n");
+    fprintf(fp, "   %s */\n\n", GPR_WEB);
+
+    fprintf(fp, "%s", "#include <math.h>\n\n");
+
+    fprintf(fp, "%s", "#define GPRC_CLAMP(k) { \\\n");
+    fprintf(fp, "%s", "  if (re[k] != re[k]) re[k] = 0; \\\n");
+    fprintf(fp, "%s", "  if (im[k] != im[k]) re[k] = 0; \\\n");
+    fprintf(fp, "  if (re[k] > %d) re[k] = %d; \\\n",
+            GPR_MAX_CONSTANT, GPR_MAX_CONSTANT);
+    fprintf(fp, "  if (im[k] > %d) im[k] = %d; \\\n",
+            GPR_MAX_CONSTANT, GPR_MAX_CONSTANT);
+    fprintf(fp, "  if (re[k] < -%d) re[k] = -%d; \\\n",
+            GPR_MAX_CONSTANT, GPR_MAX_CONSTANT);
+    fprintf(fp, "  if (im[k] < -%d) im[k] = -%d; \\\n",
+            GPR_MAX_CONSTANT, GPR_MAX_CONSTANT);
+    fprintf(fp, "%s", "}\n\n");
+
+    fprintf(fp, "void %s(int no_of_samples,\n", GPRC_JIT_FUNCTION);
+    fprintf(fp, "%s", "  float * inputs, float * outputs, int time_steps)\n");
+    fprintf(fp, "%s", "{\n");
+    fprintf(fp, "  float re[%d], im[%d];\n", no_of_states, no_of_states);
+    fprintf(fp, "%s", "  float a, b, c, d, a2;\n");
+    fprintf(fp, "%s", "  int s, t;\n\n");
+    fprintf(fp, "%s", "  (void)a; (void)b; (void)c; (void)d; (void)a2;\n\n");
+    fprintf(fp, "%s", "  for (s = 0; s < no_of_samples; s++) {\n");
+
+    /* set the sensors */
+    for (i = 0; i < sensors; i++) {
+        fprintf(fp, "    re[%d] = inputs[%d*no_of_samples + s];\n", i, i);
+        fprintf(fp, "    im[%d] = 0;\n", i);
+    }
+
+    /* clear the states which are used */
+    cleared = (unsigned char*)malloc(no_of_states*sizeof(unsigned char));
+    memset((void*)cleared, '\0', no_of_states*sizeof(unsigned char));
+    for (i = 0; i < f->genome[0].program_length; i++) {
+        instr = &program[i*instr_size];
+        for (j = -1; j < connections_per_gene; j++) {
+            if (j < 0) {
+                k = sensors + instr[GPRC_INSTR_GENE];
+            }
+            else {
+                k = instr[GPRC_INSTR_INITIAL+j];
+            }
+            if ((k >= sensors) && (k < no_of_states) &&
+                (cleared[k] == 0)) {
+                cleared[k] = 1;
+                fprintf(fp, "    re[%d] = 0; im[%d] = 0;\n", k, k);
+            }
+        }
+    }
+    for (i = 0; i < actuators; i++) {
+        k = (int)gene[(rows*columns*gene_size)+i];
+        if ((k >= sensors) && (k < no_of_states) && (cleared[k] == 0)) {
+            cleared[k] = 1;
+            fprintf(fp, "    re[%d] = 0; im[%d] = 0;\n", k, k);
+        }
+    }
+    free(cleared);
+
+    /* run the used genes */
+    fprintf(fp, "%s", "    for (t = 0; t < time_steps; t++) {\n");
+    for (i = 0; i < f->genome[0].program_length; i++) {
+        instr = &program[i*instr_size];
+        gprc_jit_gene(fp, instr, &gene[instr[GPRC_INSTR_GENE]*gene_size],
+                      sensors, connections_per_gene);
+    }
+    fprintf(fp, "%s", "    }\n");
+
+    /* get the actuator values */
+    for (i = 0; i < actuators; i++) {
+        fprintf(fp, "    outputs[%d*no_of_samples + s] = re[%d];\n",
+                i, (int)gene[(rows*columns*gene_size)+i]);
+    }
+    fprintf(fp, "%s", "  }\n}\n");
+}
+
+/* Returns the parts of the genome which determine the phenotype,
+   so that individuals which behave in the same way can share
+   compiled code */
+static unsigned char * gprc_jit_key(gprc_function * f,
+                                    int rows, int columns,
+                                    int connections_per_gene,
+                                    int sensors, int actuators,
+                                    int * key_length)
+{
+    int i, n = 0, * instr;
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int length = f->genome[0].program_length;
+    int dimensions[4];
+    float * gene = f->genome[0].gene;
+    unsigned char * key;
+
+    *key_length = sizeof(dimensions) +
+        (length*instr_size*sizeof(int)) +
+        (length*gene_size*sizeof(float)) +
+        (actuators*sizeof(float));
+    key = (unsigned char*)malloc(*key_length);
+
+    dimensions[0] = rows*columns;
+    dimensions[1] = connections_per_gene;
+    dimensions[2] = sensors;
+    dimensions[3] = actuators;
+    memcpy((void*)&key[n], (void*)dimensions, sizeof(dimensions));
+    n += sizeof(dimensions);
+
+    memcpy((void*)&key[n], (void*)f->genome[0].program,
+           length*instr_size*sizeof(int));
+    n += length*instr_size*sizeof(int);
+
+    for (i = 0; i < length; i++) {
+        instr = &f->genome[0].program[i*instr_size];
+        memcpy((void*)&key[n],
+               (void*)&gene[instr[GPRC_INSTR_GENE]*gene_size],
+               gene_size*sizeof(float));
+        n += gene_size*sizeof(float);
+    }
+
+    memcpy((void*)&key[n], (void*)&gene[rows*columns*gene_size],
+           actuators*sizeof(float));
+    return key;
+}
+
+/* FNV-1a hash */
+static unsigned int gprc_jit_hash(unsigned char * key, int key_length)
+{
+    int i;
+    unsigned int hash = 2166136261u;
+
+    for (i = 0; i < key_length; i++) {
+        hash ^= key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Runs the compiler to build a shared object from the given source.
+   The paths are passed as separate arguments rather than through
+   a shell, so that they don't need to be quoted.
+   Returns zero on success */
+static int gprc_jit_run_compiler(gprc_jit * jit,
+                                 char * object, char * source)
+{
+    /* floating point contraction is disabled so that the results
+       are the same as running the program within the library */
+    char * argv[] = {
+        jit->compiler, "-std=c99", "-O2", "-ffp-contract=off",
+        "-fPIC", "-shared", "-o", object, source, "-lm", NULL
+    };
+    posix_spawn_file_actions_t actions;
+    pid_t pid;
+    int status, retval;
+
+    /* discard any compiler messages */
+    if (posix_spawn_file_actions_init(&actions) != 0) return -1;
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO,
+                                     "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO,
+                                     STDERR_FILENO);
+
+    retval = posix_spawnp(&pid, jit->compiler, &actions, NULL,
+                          argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (retval != 0) return -1;
+
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) return -1;
+    }
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) return -1;
+    return 0;
+}
+
+/* writes, compiles and loads a shared object for the given individual.
+   Returns the loaded handle, or NULL if this fails */
+static void * gprc_jit_build(gprc_jit * jit, int index,
+                             gprc_function * f,
+                             int rows, int columns,
+                             int connections_per_gene,
+                             int sensors, int actuators)
+{
+    char source[GPRC_JIT_MAX_PATH*2], object[GPRC_JIT_MAX_PATH*2];
+    void * handle = NULL;
+    FILE * fp;
+
+    sprintf(source, "%s/gprc%d.c", jit->directory, index);
+    sprintf(object, "%s/gprc%d.so", jit->directory, index);
+
+    fp = fopen(source, "w");
+    if (!fp) return NULL;
+    gprc_jit_source(f, rows, columns, connections_per_gene,
+                    sensors, actuators, fp);
+    fclose(fp);
+
+    if (gprc_jit_run_compiler(jit, object, source) == 0) {
+        handle = dlopen(object, RTLD_NOW | RTLD_LOCAL);
+    }
+
+    /* once loaded the files are no longer needed */
+    remove(source);
+    remove(object);
+    return handle;
+}
+
+/* returns the cache entry with the given key, or NULL.
+   The cache should be locked */
+static gprc_jit_entry * gprc_jit_find(gprc_jit * jit,
+                                      unsigned char * key,
+                                      int key_length,
+                                      unsigned int hash)
+{
+    int i;
+    gprc_jit_entry * e;
+
+    for (i = 0; i < jit->no_of_entries; i++) {
+        e = &jit->entry[i];
+        if ((e->hash == hash) && (e->key_length == key_length) &&
+            (memcmp((void*)e->key, (void*)key, key_length) == 0)) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Returns an entry in which to store a new program, replacing the
+   oldest entry which isn't being run if the cache is full.
+   NULL is returned if every entry is being run.
+   The cache should be locked */
+static gprc_jit_entry * gprc_jit_free_slot(gprc_jit * jit)
+{
+    int i, index;
+    gprc_jit_entry * e;
+
+    if (jit->no_of_entries < jit->max_entries) {
+        return &jit->entry[jit->no_of_entries++];
+    }
+    for (i = 0; i < jit->max_entries; i++) {
+        index = (jit->next_entry + i) % jit->max_entries;
+        e = &jit->entry[index];
+        if (e->users == 0) {
+            gprc_jit_free_entry(e);
+            jit->next_entry = (index + 1) % jit->max_entries;
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Returns the cache entry for the given individual, compiling it
+   if necessary, or NULL if it can't be compiled.  The entry won't
+   be replaced until it is released with gprc_jit_release.
+   Compilation takes place without holding the lock, so that
+   several threads can compile different programs at once */
+static gprc_jit_entry * gprc_jit_acquire(gprc_jit * jit,
+                                         gprc_function * f,
+                                         int rows, int columns,
+                                         int connections_per_gene,
+                                         int sensors, int actuators,
+                                         int integers_only)
+{
+    int key_length, index;
+    unsigned int hash;
+    unsigned char * key;
+    void * handle;
+    gprc_native run;
+    gprc_jit_entry * e;
+
+    if (jit->max_entries == 0) return NULL;
+
+    if (!gprc_jit_supported(f, rows, columns,
+                            connections_per_gene, sensors,
+                            integers_only)) {
+        return NULL;
+    }
+
+    key = gprc_jit_key(f, rows, columns, connections_per_gene,
+                       sensors, actuators, &key_length);
+    hash = gprc_jit_hash(key, key_length);
+
+    /* is this program already compiled? */
+    omp_set_lock(&jit->lock);
+    e = gprc_jit_find(jit, key, key_length, hash);
+    if (e != NULL) {
+        e->users++;
+        jit->hits++;
+        omp_unset_lock(&jit->lock);
+        free(key);
+        return e;
+    }
+    jit->misses++;
+    index = jit->compiled++;
+    omp_unset_lock(&jit->lock);
+
+    handle = gprc_jit_build(jit, index, f, rows, columns,
+                            connections_per_gene,
+                            sensors, actuators);
+    run = NULL;
+    if (handle != NULL) {
+        /* conversion from the object pointer returned by dlsym,
+           as recommended by POSIX */
+        *(void **)(&run) = dlsym(handle, GPRC_JIT_FUNCTION);
+    }
+
+    omp_set_lock(&jit->lock);
+    e = NULL;
+    if (run != NULL) {
+        /* another thread may have compiled the same program */
+        e = gprc_jit_find(jit, key, key_length, hash);
+        if (e == NULL) {
+            e = gprc_jit_free_slot(jit);
+            if (e != NULL) {
+                e->hash = hash;
+                e->key = key;
+                e->key_length = key_length;
+                e->handle = handle;
+                e->run = run;
+                e->users = 0;
+                key = NULL;
+                handle = NULL;
+            }
+        }
+    }
+    if (e != NULL) {
+        e->users++;
+    }
+    else {
+        jit->failures++;
+    }
+    omp_unset_lock(&jit->lock);
+
+    if (handle != NULL) dlclose(handle);
+    if (key != NULL) free(key);
+    return e;
+}
+
+/* allows a cache entry to be replaced once it is no longer run */
+static void gprc_jit_release(gprc_jit * jit, gprc_jit_entry * e)
+{
+    omp_set_lock(&jit->lock);
+    e->users--;
+    omp_unset_lock(&jit->lock);
+}
+
+/* Returns a native version of the given individual, compiling it
+   if there is no existing version within the cache.
+   NULL is returned if the program can't be compiled, in which case
+   gprc_run_batch can be used instead.  The returned function
+   remains valid until it is replaced within the cache or
+   the cache is freed.  If other threads are using the same cache
+   then it could be replaced at any time, so use gprc_jit_run */
+gprc_native gprc_jit_compile_base(gprc_jit * jit,
+                                  gprc_function * f,
+                                  int rows, int columns,
+                                  int connections_per_gene,
+                                  int sensors, int actuators,
+                                  int integers_only)
+{
+    gprc_native run;
+    gprc_jit_entry * e =
+        gprc_jit_acquire(jit, f, rows, columns,
+                         connections_per_gene,
+                         sensors, actuators, integers_only);
+
+    if (e == NULL) return NULL;
+    run = e->run;
+    gprc_jit_release(jit, e);
+    return run;
+}
+
+/* returns a native version of an individual within a population */
+gprc_native gprc_jit_compile(gprc_jit * jit,
+                             gprc_function * f,
+                             gprc_population * population)
+{
+    return gprc_jit_compile_base(jit, f,
+                                 population->rows, population->columns,
+                                 population->connections_per_gene,
+                                 population->sensors,
+                                 population->actuators,
+                                 population->integers_only);
+}
+
+/* returns a native version of an individual within
+   a morphology population */
+gprc_native gprcm_jit_compile(gprc_jit * jit,
+                              gprcm_function * f,
+                              gprcm_population * population)
+{
+    return gprc_jit_compile_base(jit, &f->program,
+                                 population->rows, population->columns,
+                                 population->connections_per_gene,
+                                 population->sensors,
+                                 population->actuators,
+                                 population->integers_only);
+}
+
+/* Runs an individual over a batch of samples, using native code
+   where possible and otherwise gprc_run_batch.  This may be called
+   from several threads sharing the same cache */
+void gprc_jit_run(gprc_jit * jit,
+                  gprc_function * f,
+                  gprc_population * population,
+                  int time_steps,
+                  int no_of_samples,
+                  float * inputs, float * outputs,
+                  float (*custom_function)(float,float,float))
+{
+    gprc_jit_entry * e =
+        gprc_jit_acquire(jit, f,
+                         population->rows, population->columns,
+                         population->connections_per_gene,
+                         population->sensors, population->actuators,
+                         population->integers_only);
+
+    if (e != NULL) {
+        (*e->run)(no_of_samples, inputs, outputs, time_steps);
+        gprc_jit_release(jit, e);
+        return;
+    }
+    gprc_run_batch(f, population, 0, time_steps,
+                   no_of_samples, inputs, outputs,
+                   (*custom_function));
+}
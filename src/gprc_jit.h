@@ -0,0 +1,128 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPRC_JIT_H
+#define GPRC_JIT_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "globals.h"
+#include "gpr.h"
+#include "gprc.h"
+#include "gprcm.h"
+#include "gprc_batch.h"
+
+/* the maximum length of the compiler command and directory names */
+#define GPRC_JIT_MAX_PATH 256
+
+/* A natively compiled program.  Each of the samples is run from
+   a cleared state for the given number of time steps, with the
+   inputs and outputs arranged as for gprc_run_batch */
+typedef void (*gprc_native)(int no_of_samples,
+                            float * inputs, float * outputs,
+                            int time_steps);
+
+struct gprc_jit_ent {
+    /* hash of the key */
+    unsigned int hash;
+
+    /* the parts of the genome which affect the phenotype */
+    int key_length;
+    unsigned char * key;
+
+    /* the loaded shared object */
+    void * handle;
+    gprc_native run;
+
+    /* number of threads currently running this program */
+    int users;
+};
+typedef struct gprc_jit_ent gprc_jit_entry;
+
+/* Cache of compiled programs.  This may be shared between threads,
+   for example within the evaluation function of gprc_evaluate */
+struct gprc_jit_cache {
+    /* temporary directory where programs are compiled */
+    char directory[GPRC_JIT_MAX_PATH];
+
+    /* the C compiler to use */
+    char compiler[GPRC_JIT_MAX_PATH];
+
+    int max_entries, no_of_entries;
+
+    /* the entry to be replaced next when the cache is full */
+    int next_entry;
+
+    /* number of shared objects created so far */
+    int compiled;
+
+    gprc_jit_entry * entry;
+
+    /* statistics */
+    int hits, misses, failures;
+
+    /* protects the entries and statistics */
+    omp_lock_t lock;
+};
+typedef struct gprc_jit_cache gprc_jit;
+
+int gprc_jit_init(gprc_jit * jit, int max_entries, char * compiler);
+void gprc_jit_free(gprc_jit * jit);
+int gprc_jit_supported(gprc_function * f,
+                       int rows, int columns,
+                       int connections_per_gene,
+                       int sensors, int integers_only);
+void gprc_jit_source(gprc_function * f,
+                     int rows, int columns,
+                     int connections_per_gene,
+                     int sensors, int actuators,
+                     FILE * fp);
+gprc_native gprc_jit_compile_base(gprc_jit * jit,
+                                  gprc_function * f,
+                                  int rows, int columns,
+                                  int connections_per_gene,
+                                  int sensors, int actuators,
+                                  int integers_only);
+gprc_native gprc_jit_compile(gprc_jit * jit,
+                             gprc_function * f,
+                             gprc_population * population);
+gprc_native gprcm_jit_compile(gprc_jit * jit,
+                              gprcm_function * f,
+                              gprcm_population * population);
+void gprc_jit_run(gprc_jit * jit,
+                  gprc_function * f,
+                  gprc_population * population,
+                  int time_steps,
+                  int no_of_samples,
+                  float * inputs, float * outputs,
+                  float (*custom_function)(float,float,float));
+
+#endif
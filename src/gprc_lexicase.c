@@ -0,0 +1,423 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Lexicase selection.
+
+   Rather than reducing the errors upon all test cases to a single
+   fitness value, lexicase selection considers the cases one at a
+   time in a random order, keeping only the candidates which are
+   best upon each, until a single candidate remains.  Individuals
+   which are good at unusual cases can then be selected even if
+   their total error is poor, which helps to maintain diversity.
+   Epsilon lexicase also keeps candidates within a tolerance of the
+   best, based upon the median absolute deviation of each case.
+
+   The errors are stored with one row per case, and the candidates
+   are a bitset, so that each case is applied to all remaining
+   candidates with vector comparisons.  Words of the bitset which
+   contain no candidates are skipped, so later cases become cheaper
+   as the candidates are filtered. */
+
+#include "gprc_lexicase.h"
+
+/* the error of an individual which could not be evaluated */
+#define GPRC_LEXICASE_MAX_ERROR 3.4e38f
+
+void gprc_lexicase_init(gprc_lexicase * lexicase,
+                        int cases, int individuals)
+{
+    int i;
+    int words = (individuals + 63)/64;
+
+    lexicase->cases = cases;
+    lexicase->individuals = individuals;
+    lexicase->error =
+        (float*)malloc((size_t)cases*individuals*sizeof(float));
+    lexicase->epsilon = (float*)malloc(cases*sizeof(float));
+    lexicase->candidates =
+        (unsigned long long*)malloc(words*sizeof(unsigned long long));
+    lexicase->order = (int*)malloc(cases*sizeof(int));
+#ifdef DEBUG
+    assert(lexicase->error != 0);
+#endif
+
+    for (i = 0; i < cases*individuals; i++) {
+        lexicase->error[i] = GPRC_LEXICASE_MAX_ERROR;
+    }
+    for (i = 0; i < cases; i++) {
+        lexicase->epsilon[i] = 0;
+        lexicase->order[i] = i;
+    }
+}
+
+void gprc_lexicase_free(gprc_lexicase * lexicase)
+{
+    free(lexicase->error);
+    free(lexicase->epsilon);
+    free(lexicase->candidates);
+    free(lexicase->order);
+}
+
+/* sets the errors of an individual upon each case */
+void gprc_lexicase_set(gprc_lexicase * lexicase,
+                       int individual, float * errors)
+{
+    int c;
+    float e;
+
+    for (c = 0; c < lexicase->cases; c++) {
+        e = fabs(errors[c]);
+        if ((e != e) || (e > GPRC_LEXICASE_MAX_ERROR)) {
+            e = GPRC_LEXICASE_MAX_ERROR;
+        }
+        lexicase->error[(size_t)c*lexicase->individuals + individual] = e;
+    }
+}
+
+/* copies the errors of one individual to another */
+void gprc_lexicase_copy(gprc_lexicase * lexicase,
+                        int source, int dest)
+{
+    int c;
+    float * row;
+
+    for (c = 0; c < lexicase->cases; c++) {
+        row = &lexicase->error[(size_t)c*lexicase->individuals];
+        row[dest] = row[source];
+    }
+}
+
+/* exchanges the errors of two individuals */
+void gprc_lexicase_swap(gprc_lexicase * lexicase, int a, int b)
+{
+    int c;
+    float * row, temp;
+
+    for (c = 0; c < lexicase->cases; c++) {
+        row = &lexicase->error[(size_t)c*lexicase->individuals];
+        temp = row[a];
+        row[a] = row[b];
+        row[b] = temp;
+    }
+}
+
+/* returns the value which would be at index k if sorted */
+static float gprc_lexicase_nth(float * v, int n, int k)
+{
+    int left = 0, right = n-1, i, j;
+    float pivot, temp;
+
+    while (left < right) {
+        pivot = v[left + (right-left)/2];
+        i = left;
+        j = right;
+        while (i <= j) {
+            while (v[i] < pivot) i++;
+            while (v[j] > pivot) j--;
+            if (i <= j) {
+                temp = v[i];
+                v[i] = v[j];
+                v[j] = temp;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j) {
+            right = j;
+        }
+        else if (k >= i) {
+            left = i;
+        }
+        else {
+            break;
+        }
+    }
+    return v[k];
+}
+
+/* Sets the tolerance of each case to the median absolute deviation
+   of the errors upon it */
+void gprc_lexicase_update_epsilon(gprc_lexicase * lexicase)
+{
+    int c, i, n = lexicase->individuals;
+    float median, * work;
+
+    if (n < 1) return;
+    work = (float*)malloc(n*sizeof(float));
+
+    for (c = 0; c < lexicase->cases; c++) {
+        memcpy((void*)work,
+               (void*)&lexicase->error[(size_t)c*n], n*sizeof(float));
+        median = gprc_lexicase_nth(work, n, n/2);
+        for (i = 0; i < n; i++) {
+            work[i] = fabs(work[i] - median);
+        }
+        lexicase->epsilon[c] = gprc_lexicase_nth(work, n, n/2);
+    }
+    free(work);
+}
+
+/* Returns the index of an individual chosen by lexicase selection.
+   If use_epsilon is non-zero then candidates within the tolerance
+   of the best upon each case are kept */
+int gprc_lexicase_select(gprc_lexicase * lexicase, int use_epsilon,
+                         unsigned int * random_seed)
+{
+    int s, c, w, r, count;
+    int n = lexicase->individuals;
+    int words = (n + 63)/64;
+    unsigned long long * candidates = lexicase->candidates;
+    unsigned long long bits;
+    float * row, limit;
+
+    /* initially every individual is a candidate */
+    for (w = 0; w < words; w++) {
+        candidates[w] = ~0ULL;
+    }
+    if (n % 64 != 0) {
+        candidates[words-1] = (1ULL << (n % 64)) - 1;
+    }
+    count = n;
+
+    for (s = 0; (s < lexicase->cases) && (count > 1); s++) {
+        /* choose the next case at random */
+        r = s + rand_num(random_seed)%(lexicase->cases - s);
+        c = lexicase->order[r];
+        lexicase->order[r] = lexicase->order[s];
+        lexicase->order[s] = c;
+
+        /* keep only the candidates which are best upon this case */
+        row = &lexicase->error[(size_t)c*n];
+        limit = gprc_simd.masked_min(row, candidates, n);
+        if (use_epsilon != 0) limit += lexicase->epsilon[c];
+        count = gprc_simd.filter(candidates, row, limit, n);
+    }
+
+    if (count < 1) return rand_num(random_seed)%n;
+
+    /* pick one of the remaining candidates */
+    r = rand_num(random_seed)%count;
+    for (w = 0; w < words; w++) {
+        bits = candidates[w];
+        if (r < __builtin_popcountll(bits)) {
+            while (r > 0) {
+                bits &= bits - 1;
+                r--;
+            }
+            return (w*64) + __builtin_ctzll(bits);
+        }
+        r -= __builtin_popcountll(bits);
+    }
+    return 0;
+}
+
+/* Evaluates the errors of each individual upon every case.
+   The evaluation function fills an array with the error upon each
+   case, and returns the fitness of the individual */
+void gprc_evaluate_cases(gprc_population * population,
+                         gprc_lexicase * lexicase,
+                         int time_steps, int reevaluate,
+                         float (*evaluate_cases)
+                         (int,gprc_population*,int,float*))
+{
+    int i;
+
+#pragma omp parallel for
+    for (i = 0; i < population->size; i++) {
+        if ((population->fitness[i]==0) ||
+            (reevaluate>0)) {
+            int s, c;
+            gprc_function * f = &population->individual[i];
+            unsigned char * used = f->genome[0].used;
+            float * errors =
+                (float*)malloc(lexicase->cases*sizeof(float));
+
+            /* clear the retained state */
+            gprc_clear_state(f,
+                             population->rows, population->columns,
+                             population->sensors,
+                             population->actuators);
+
+            /* is there a path which links sensors to actuators? */
+            for (s = 0; s < population->sensors; s++) {
+                if (used[s] != 0) break;
+            }
+
+            if (s < population->sensors) {
+                population->fitness[i] =
+                    (*evaluate_cases)(time_steps, population, i, errors);
+            }
+            else {
+                population->fitness[i] = 0;
+                for (c = 0; c < lexicase->cases; c++) {
+                    errors[c] = GPRC_LEXICASE_MAX_ERROR;
+                }
+            }
+            gprc_lexicase_set(lexicase, i, errors);
+            free(errors);
+        }
+        /* if individual gets too old */
+        (&population->individual[i])->age++;
+        if ((&population->individual[i])->age>GPR_MAX_AGE) {
+            population->fitness[i] = 0;
+        }
+    }
+}
+
+/* Produce the next generation using lexicase selection.
+   Parents are chosen by lexicase selection until there are enough
+   pairs of them to replace every individual which wasn't chosen.
+   The chosen individuals survive, together with the fittest, and
+   the rest are replaced by children.  This assumes that errors have
+   already been evaluated with gprc_evaluate_cases */
+void gprc_generation_lexicase(gprc_population * population,
+                              gprc_lexicase * lexicase,
+                              int use_epsilon,
+                              float mutation_prob,
+                              int use_crossover,
+                              unsigned int * random_seed,
+                              int * instruction_set,
+                              int no_of_instructions)
+{
+    int i, k, p, index, best = 0, survivors = 1, children;
+    int * parent, * slot;
+    unsigned int stream;
+    unsigned char * selected;
+    float temp_fitness;
+    gprc_function temp_individual;
+
+    /* the fittest individual is kept as the first */
+    for (i = 1; i < population->size; i++) {
+        if (population->fitness[i] > population->fitness[best]) {
+            best = i;
+        }
+    }
+    if (best != 0) {
+        temp_fitness = population->fitness[0];
+        population->fitness[0] = population->fitness[best];
+        population->fitness[best] = temp_fitness;
+        temp_individual = population->individual[0];
+        population->individual[0] = population->individual[best];
+        population->individual[best] = temp_individual;
+        gprc_lexicase_swap(lexicase, 0, best);
+    }
+
+    if (use_epsilon != 0) {
+        gprc_lexicase_update_epsilon(lexicase);
+    }
+
+    /* choose pairs of parents */
+    selected = (unsigned char*)malloc(population->size);
+    memset((void*)selected, '\0', population->size);
+    selected[0] = 1;
+    parent = (int*)malloc(population->size*2*sizeof(int));
+    for (k = 0; k < population->size - survivors; k++) {
+        for (p = 0; p < 2; p++) {
+            index = gprc_lexicase_select(lexicase, use_epsilon,
+                                         random_seed);
+            parent[k*2 + p] = index;
+            if (selected[index] == 0) {
+                selected[index] = 1;
+                survivors++;
+            }
+        }
+    }
+
+    /* individuals which weren't chosen are replaced */
+    children = population->size - survivors;
+    slot = (int*)malloc((children+1)*sizeof(int));
+    k = 0;
+    for (i = 0; i < population->size; i++) {
+        if (selected[i] == 0) {
+            slot[k++] = i;
+        }
+        else {
+            /* compile the parents before they are shared
+               between threads */
+            gprc_compiled_program(&population->individual[i], 0,
+                                  population->rows, population->columns,
+                                  population->connections_per_gene,
+                                  population->sensors, 0);
+        }
+    }
+
+    stream = (unsigned int)rand_num(random_seed);
+
+#pragma omp parallel for
+    for (i = 0; i < children; i++) {
+        int p1 = parent[i*2], p2 = parent[i*2 + 1];
+        gprc_function * child = &population->individual[slot[i]];
+
+        child->random_seed = rand_stream(stream, (unsigned int)i);
+        gprc_mate(&population->individual[p1],
+                  &population->individual[p2],
+                  population->rows, population->columns,
+                  population->sensors, population->actuators,
+                  population->connections_per_gene,
+                  population->min_value, population->max_value,
+                  population->integers_only,
+                  mutation_prob,
+                  use_crossover,
+                  population->chromosomes,
+                  instruction_set, no_of_instructions,
+                  0, child);
+        child->age = 0;
+
+        /* a child which behaves in the same way as one of its
+           parents has the same errors */
+        population->fitness[slot[i]] = 0;
+        if (gprc_same_phenotype(child, &population->individual[p1],
+                                population->rows, population->columns,
+                                population->connections_per_gene,
+                                population->sensors,
+                                population->actuators) != 0) {
+            population->fitness[slot[i]] = population->fitness[p1];
+            gprc_lexicase_copy(lexicase, p1, slot[i]);
+        }
+        else if (gprc_same_phenotype(child, &population->individual[p2],
+                                     population->rows,
+                                     population->columns,
+                                     population->connections_per_gene,
+                                     population->sensors,
+                                     population->actuators) != 0) {
+            population->fitness[slot[i]] = population->fitness[p2];
+            gprc_lexicase_copy(lexicase, p2, slot[i]);
+        }
+        if (population->fitness[slot[i]] != 0) {
+#pragma omp atomic
+            population->neutral_offspring++;
+        }
+#pragma omp atomic
+        population->offspring++;
+    }
+
+    free(selected);
+    free(parent);
+    free(slot);
+}
@@ -0,0 +1,85 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPRC_LEXICASE_H
+#define GPRC_LEXICASE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "globals.h"
+#include "gpr.h"
+#include "gprc.h"
+#include "gprc_simd.h"
+
+/* errors of each individual of a population upon each
+   of a number of test cases */
+struct gprc_lexicase_struct {
+    int cases;
+    int individuals;
+    /* one row of errors per case, so that the errors of all
+       individuals upon a case are adjacent */
+    float * error;
+    /* the tolerance for each case used by epsilon lexicase */
+    float * epsilon;
+    /* one bit per individual which remains a candidate
+       during selection */
+    unsigned long long * candidates;
+    /* the order in which cases are considered */
+    int * order;
+};
+typedef struct gprc_lexicase_struct gprc_lexicase;
+
+void gprc_lexicase_init(gprc_lexicase * lexicase,
+                        int cases, int individuals);
+void gprc_lexicase_free(gprc_lexicase * lexicase);
+void gprc_lexicase_set(gprc_lexicase * lexicase,
+                       int individual, float * errors);
+void gprc_lexicase_copy(gprc_lexicase * lexicase,
+                        int source, int dest);
+void gprc_lexicase_swap(gprc_lexicase * lexicase, int a, int b);
+void gprc_lexicase_update_epsilon(gprc_lexicase * lexicase);
+int gprc_lexicase_select(gprc_lexicase * lexicase, int use_epsilon,
+                         unsigned int * random_seed);
+void gprc_evaluate_cases(gprc_population * population,
+                         gprc_lexicase * lexicase,
+                         int time_steps, int reevaluate,
+                         float (*evaluate_cases)
+                         (int,gprc_population*,int,float*));
+void gprc_generation_lexicase(gprc_population * population,
+                              gprc_lexicase * lexicase,
+                              int use_epsilon,
+                              float mutation_prob,
+                              int use_crossover,
+                              unsigned int * random_seed,
+                              int * instruction_set,
+                              int no_of_instructions);
+
+#endif
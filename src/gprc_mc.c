@@ -0,0 +1,986 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* needed for mmap when compiling with -std=c99 */
+#define _DEFAULT_SOURCE
+
+#include <stdint.h>
+#include "gprc_mc.h"
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define GPRC_MC_X86_64
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+#ifdef GPRC_MC_X86_64
+
+/* SSE opcodes, which follow the 0x0f escape byte */
+#define GPRC_MC_LOAD      0x10
+#define GPRC_MC_STORE     0x11
+#define GPRC_MC_MOVE      0x28
+#define GPRC_MC_SQRT      0x51
+#define GPRC_MC_AND       0x54
+#define GPRC_MC_ANDNOT    0x55
+#define GPRC_MC_OR        0x56
+#define GPRC_MC_XOR       0x57
+#define GPRC_MC_ADD       0x58
+#define GPRC_MC_MUL       0x59
+#define GPRC_MC_TRUNCATE  0x5b
+#define GPRC_MC_SUB       0x5c
+#define GPRC_MC_MIN       0x5d
+#define GPRC_MC_DIV       0x5e
+#define GPRC_MC_MAX       0x5f
+#define GPRC_MC_INT_EQUAL 0x76
+#define GPRC_MC_COMPARE   0xc2
+
+/* predicates for GPRC_MC_COMPARE */
+#define GPRC_MC_EQ        0
+#define GPRC_MC_LT        1
+#define GPRC_MC_LE        2
+#define GPRC_MC_UNORD     3
+
+/* no immediate byte follows the instruction */
+#define GPRC_MC_NONE      -1
+
+/* bit patterns of constants */
+#define GPRC_MC_SIGN      0x80000000u
+#define GPRC_MC_ABS       0x7fffffffu
+
+/* code being assembled */
+struct gprc_mc_asm {
+    unsigned char * code;
+    int length, size;
+
+    /* values which are loaded from the constant pool */
+    unsigned int * constant;
+    int no_of_constants, max_constants;
+
+    /* references to the constant pool, which are patched once
+       its position is known */
+    int * fixup;
+    int no_of_fixups, max_fixups;
+
+    int no_of_states;
+
+    /* the number of samples within each register.  For 8 lanes
+       AVX2 instructions are used, otherwise SSE */
+    int lanes;
+};
+typedef struct gprc_mc_asm gprc_mc_assembler;
+
+static void gprc_mc_byte(gprc_mc_assembler * a, unsigned char value)
+{
+    if (a->length >= a->size) {
+        a->size = (a->size*2) + 256;
+        a->code = (unsigned char*)realloc(a->code, a->size);
+    }
+    a->code[a->length++] = value;
+}
+
+static void gprc_mc_int32(gprc_mc_assembler * a, int value)
+{
+    unsigned int v = (unsigned int)value;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        gprc_mc_byte(a, (unsigned char)((v >> (i*8)) & 0xff));
+    }
+}
+
+static void gprc_mc_pointer(gprc_mc_assembler * a, void * ptr, int size)
+{
+    unsigned char bytes[8];
+    int i;
+
+    memset((void*)bytes, '\0', 8);
+    memcpy((void*)bytes, ptr, size);
+    for (i = 0; i < 8; i++) {
+        gprc_mc_byte(a, bytes[i]);
+    }
+}
+
+/* returns non-zero for instructions which have a single
+   source operand */
+static int gprc_mc_two_operand(int opcode)
+{
+    return ((opcode == GPRC_MC_LOAD) || (opcode == GPRC_MC_STORE) ||
+            (opcode == GPRC_MC_MOVE) || (opcode == GPRC_MC_SQRT) ||
+            (opcode == GPRC_MC_TRUNCATE));
+}
+
+/* Emits the prefix and opcode of an instruction.  With AVX the
+   destination register is also used as the first source, so that
+   instructions behave in the same way as their SSE versions */
+static void gprc_mc_opcode(gprc_mc_assembler * a,
+                           int prefix, int opcode, int reg)
+{
+    int pp = 0, vvvv = 0xf;
+
+    if (a->lanes == 4) {
+        if (prefix != 0) gprc_mc_byte(a, (unsigned char)prefix);
+        gprc_mc_byte(a, 0x0f);
+        gprc_mc_byte(a, (unsigned char)opcode);
+        return;
+    }
+
+    /* two byte VEX prefix with 256 bit vectors */
+    if (prefix == 0x66) pp = 1;
+    if (prefix == 0xf3) pp = 2;
+    if (!gprc_mc_two_operand(opcode)) vvvv = (~reg) & 0xf;
+    gprc_mc_byte(a, 0xc5);
+    gprc_mc_byte(a, (unsigned char)(0x80 | (vvvv << 3) | 0x04 | pp));
+    gprc_mc_byte(a, (unsigned char)opcode);
+}
+
+/* clears the upper halves of the AVX registers before calling
+   or returning to code which may use SSE */
+static void gprc_mc_vzeroupper(gprc_mc_assembler * a)
+{
+    if (a->lanes == 4) return;
+    gprc_mc_byte(a, 0xc5);
+    gprc_mc_byte(a, 0xf8);
+    gprc_mc_byte(a, 0x77);
+}
+
+/* op xmm, xmm */
+static void gprc_mc_reg(gprc_mc_assembler * a,
+                        int prefix, int opcode,
+                        int dest, int src, int imm)
+{
+    gprc_mc_opcode(a, prefix, opcode, dest);
+    gprc_mc_byte(a, (unsigned char)(0xc0 | (dest << 3) | src));
+    if (imm != GPRC_MC_NONE) gprc_mc_byte(a, (unsigned char)imm);
+}
+
+/* op xmm, [rbx + rcx + disp], where rbx points to the state
+   and rcx is the offset of the current group of samples */
+static void gprc_mc_mem(gprc_mc_assembler * a,
+                        int prefix, int opcode,
+                        int reg, int disp, int imm)
+{
+    gprc_mc_opcode(a, prefix, opcode, reg);
+    gprc_mc_byte(a, (unsigned char)(0x84 | (reg << 3)));
+    gprc_mc_byte(a, 0x0b);
+    gprc_mc_int32(a, disp);
+    if (imm != GPRC_MC_NONE) gprc_mc_byte(a, (unsigned char)imm);
+}
+
+/* op xmm, [rip + disp], referring to the constant pool */
+static void gprc_mc_const_bits(gprc_mc_assembler * a,
+                               int prefix, int opcode,
+                               int reg, unsigned int value, int imm)
+{
+    int i;
+
+    for (i = 0; i < a->no_of_constants; i++) {
+        if (a->constant[i] == value) break;
+    }
+    if (i == a->no_of_constants) {
+        if (a->no_of_constants >= a->max_constants) {
+            a->max_constants = (a->max_constants*2) + 16;
+            a->constant =
+                (unsigned int*)realloc(a->constant,
+                                       a->max_constants*
+                                       sizeof(unsigned int));
+        }
+        a->constant[a->no_of_constants++] = value;
+    }
+    if (a->no_of_fixups*3 >= a->max_fixups) {
+        a->max_fixups = (a->max_fixups*2) + 48;
+        a->fixup = (int*)realloc(a->fixup, a->max_fixups*sizeof(int));
+    }
+
+    gprc_mc_opcode(a, prefix, opcode, reg);
+    gprc_mc_byte(a, (unsigned char)(0x05 | (reg << 3)));
+
+    /* position of the displacement, the constant and the end
+       of the instruction which the displacement is relative to */
+    a->fixup[a->no_of_fixups*3] = a->length;
+    a->fixup[a->no_of_fixups*3+1] = i;
+    a->fixup[a->no_of_fixups*3+2] =
+        a->length + 4 + ((imm != GPRC_MC_NONE) ? 1 : 0);
+    a->no_of_fixups++;
+
+    gprc_mc_int32(a, 0);
+    if (imm != GPRC_MC_NONE) gprc_mc_byte(a, (unsigned char)imm);
+}
+
+static void gprc_mc_const(gprc_mc_assembler * a,
+                          int opcode, int reg, float value)
+{
+    unsigned int bits;
+
+    memcpy((void*)&bits, (void*)&value, sizeof(float));
+    gprc_mc_const_bits(a, 0, opcode, reg, bits, GPRC_MC_NONE);
+}
+
+/* operations on the real and imaginary parts of a state */
+static void gprc_mc_re(gprc_mc_assembler * a, int opcode,
+                       int reg, int index)
+{
+    gprc_mc_mem(a, 0, opcode, reg, index*GPRC_MC_BLOCK*4, GPRC_MC_NONE);
+}
+
+static void gprc_mc_im(gprc_mc_assembler * a, int opcode,
+                       int reg, int index)
+{
+    gprc_mc_mem(a, 0, opcode, reg,
+                (a->no_of_states + index)*GPRC_MC_BLOCK*4,
+                GPRC_MC_NONE);
+}
+
+static void gprc_mc_move(gprc_mc_assembler * a, int dest, int src)
+{
+    gprc_mc_reg(a, 0, GPRC_MC_MOVE, dest, src, GPRC_MC_NONE);
+}
+
+static void gprc_mc_op(gprc_mc_assembler * a, int opcode,
+                       int dest, int src)
+{
+    gprc_mc_reg(a, 0, opcode, dest, src, GPRC_MC_NONE);
+}
+
+static void gprc_mc_zero(gprc_mc_assembler * a, int reg)
+{
+    gprc_mc_op(a, GPRC_MC_XOR, reg, reg);
+}
+
+/* dest = (mask & dest) | (~mask & src), using a temporary register */
+static void gprc_mc_blend(gprc_mc_assembler * a,
+                          int dest, int src, int mask, int temp)
+{
+    gprc_mc_move(a, temp, mask);
+    gprc_mc_op(a, GPRC_MC_ANDNOT, temp, src);
+    gprc_mc_op(a, GPRC_MC_AND, dest, mask);
+    gprc_mc_op(a, GPRC_MC_OR, dest, temp);
+}
+
+/* outputs the gene constants where the mask in xmm0 is set */
+static void gprc_mc_logical(gprc_mc_assembler * a, float * gp)
+{
+    gprc_mc_move(a, 1, 0);
+    gprc_mc_const(a, GPRC_MC_AND, 0, gp[GPRC_GENE_CONSTANT]);
+    gprc_mc_const(a, GPRC_MC_AND, 1, gp[GPRC_GENE_IMAGINARY]);
+}
+
+/* removes NaN values from the output in xmm0 and xmm1, clamps it
+   to GPR_MAX_CONSTANT as with gprc_run_float and then stores it */
+static void gprc_mc_clamp(gprc_mc_assembler * a, int k)
+{
+    /* the real part is zeroed if either part is NaN */
+    gprc_mc_move(a, 2, 0);
+    gprc_mc_reg(a, 0, GPRC_MC_COMPARE, 2, 0, GPRC_MC_UNORD);
+    gprc_mc_move(a, 3, 1);
+    gprc_mc_reg(a, 0, GPRC_MC_COMPARE, 3, 1, GPRC_MC_UNORD);
+    gprc_mc_op(a, GPRC_MC_OR, 2, 3);
+    gprc_mc_op(a, GPRC_MC_ANDNOT, 2, 0);
+
+    /* the operand order leaves NaN values unchanged */
+    gprc_mc_const(a, GPRC_MC_LOAD, 4, GPR_MAX_CONSTANT);
+    gprc_mc_op(a, GPRC_MC_MIN, 4, 2);
+    gprc_mc_const(a, GPRC_MC_LOAD, 5, -GPR_MAX_CONSTANT);
+    gprc_mc_op(a, GPRC_MC_MAX, 5, 4);
+    gprc_mc_re(a, GPRC_MC_STORE, 5, k);
+
+    gprc_mc_const(a, GPRC_MC_LOAD, 4, GPR_MAX_CONSTANT);
+    gprc_mc_op(a, GPRC_MC_MIN, 4, 1);
+    gprc_mc_const(a, GPRC_MC_LOAD, 5, -GPR_MAX_CONSTANT);
+    gprc_mc_op(a, GPRC_MC_MAX, 5, 4);
+    gprc_mc_im(a, GPRC_MC_STORE, 5, k);
+}
+
+/* the largest float which compares as being less than or equal
+   to the 1e-1 limit used by the divide function */
+static float gprc_mc_divide_limit()
+{
+    float limit = (float)1e-1;
+
+    if (limit > 1e-1) {
+        limit = nextafterf(limit, 0);
+    }
+    return limit;
+}
+
+/* evaluates a gene by calling gprc_batch_gene */
+static void gprc_mc_call_gene(float * state, gprc_mc_call * call)
+{
+    gprc_batch_gene(call->instr, call->gp,
+                    state,
+                    &state[call->no_of_states*GPRC_MC_BLOCK],
+                    GPRC_MC_BLOCK, GPRC_MC_BLOCK,
+                    call->sensors, call->connections_per_gene,
+                    call->custom_function);
+}
+
+/* emits code for a single compiled gene, for one group of samples.
+   Returns non-zero if the gene needs to be evaluated by a call
+   to gprc_batch_gene */
+static int gprc_mc_gene(gprc_mc_assembler * a, int * instr, float * gp,
+                        int sens, int connections_per_gene)
+{
+    int j, mask, k = sens + instr[GPRC_INSTR_GENE];
+    int no_of_args = instr[GPRC_INSTR_ARGS];
+    int * con = &instr[GPRC_INSTR_INITIAL];
+    int in0 = con[0], in1 = con[0];
+    int function_type = instr[GPRC_INSTR_FUNCTION_TYPE];
+    unsigned int bits;
+    float limit;
+
+    if (connections_per_gene > 1) in1 = con[1];
+
+    switch(function_type) {
+    case GPR_FUNCTION_VALUE: {
+        gprc_mc_const(a, GPRC_MC_LOAD, 0, gp[GPRC_GENE_CONSTANT]);
+        gprc_mc_const(a, GPRC_MC_LOAD, 1, gp[GPRC_GENE_IMAGINARY]);
+        break;
+    }
+    case GPR_FUNCTION_ADD: {
+        gprc_mc_zero(a, 0);
+        gprc_mc_zero(a, 1);
+        for (j = 0; j < no_of_args; j++) {
+            gprc_mc_re(a, GPRC_MC_ADD, 0, con[j]);
+            gprc_mc_im(a, GPRC_MC_ADD, 1, con[j]);
+        }
+        break;
+    }
+    case GPR_FUNCTION_SUBTRACT:
+    case GPR_FUNCTION_AVERAGE: {
+        gprc_mc_re(a, GPRC_MC_LOAD, 0, in0);
+        gprc_mc_im(a, GPRC_MC_LOAD, 1, in0);
+        for (j = 1; j < no_of_args; j++) {
+            if (function_type == GPR_FUNCTION_SUBTRACT) {
+                gprc_mc_re(a, GPRC_MC_SUB, 0, con[j]);
+                gprc_mc_im(a, GPRC_MC_SUB, 1, con[j]);
+            }
+            else {
+                gprc_mc_re(a, GPRC_MC_ADD, 0, con[j]);
+                gprc_mc_im(a, GPRC_MC_ADD, 1, con[j]);
+            }
+        }
+        if (function_type == GPR_FUNCTION_AVERAGE) {
+            gprc_mc_const(a, GPRC_MC_DIV, 0, (float)no_of_args);
+            gprc_mc_const(a, GPRC_MC_DIV, 1, (float)no_of_args);
+        }
+        break;
+    }
+    case GPR_FUNCTION_NEGATE: {
+        gprc_mc_re(a, GPRC_MC_LOAD, 0, in0);
+        gprc_mc_im(a, GPRC_MC_LOAD, 1, in0);
+        gprc_mc_const_bits(a, 0, GPRC_MC_XOR, 0,
+                           GPRC_MC_SIGN, GPRC_MC_NONE);
+        gprc_mc_const_bits(a, 0, GPRC_MC_XOR, 1,
+                           GPRC_MC_SIGN, GPRC_MC_NONE);
+        break;
+    }
+    case GPR_FUNCTION_MULTIPLY: {
+        gprc_mc_re(a, GPRC_MC_LOAD, 0, in0);
+        gprc_mc_im(a, GPRC_MC_LOAD, 1, in0);
+        for (j = 1; j < no_of_args; j++) {
+            gprc_mc_re(a, GPRC_MC_LOAD, 2, con[j]);
+            gprc_mc_im(a, GPRC_MC_LOAD, 3, con[j]);
+            /* (a*c) + (b*d) */
+            gprc_mc_move(a, 4, 0);
+            gprc_mc_op(a, GPRC_MC_MUL, 4, 2);
+            gprc_mc_move(a, 5, 1);
+            gprc_mc_op(a, GPRC_MC_MUL, 5, 3);
+            gprc_mc_op(a, GPRC_MC_ADD, 4, 5);
+            /* (b*c) + (a*d) */
+            gprc_mc_op(a, GPRC_MC_MUL, 2, 1);
+            gprc_mc_op(a, GPRC_MC_MUL, 3, 0);
+            gprc_mc_op(a, GPRC_MC_ADD, 2, 3);
+            gprc_mc_move(a, 0, 4);
+            gprc_mc_move(a, 1, 2);
+        }
+        break;
+    }
+    case GPR_FUNCTION_WEIGHT: {
+        gprc_mc_re(a, GPRC_MC_LOAD, 0, in0);
+        gprc_mc_im(a, GPRC_MC_LOAD, 1, in0);
+        gprc_mc_const(a, GPRC_MC_MUL, 0, gp[GPRC_GENE_CONSTANT]);
+        gprc_mc_const(a, GPRC_MC_MUL, 1, gp[GPRC_GENE_CONSTANT]);
+        break;
+    }
+    case GPR_FUNCTION_DIVIDE: {
+        gprc_mc_re(a, GPRC_MC_LOAD, 0, in0);
+        gprc_mc_im(a, GPRC_MC_LOAD, 1, in0);
+        gprc_mc_re(a, GPRC_MC_LOAD, 2, in1);
+        gprc_mc_im(a, GPRC_MC_LOAD, 3, in1);
+        /* (c*c) + (d*d) */
+        gprc_mc_move(a, 4, 2);
+        gprc_mc_op(a, GPRC_MC_MUL, 4, 2);
+        gprc_mc_move(a, 5, 3);
+        gprc_mc_op(a, GPRC_MC_MUL, 5, 3);
+        gprc_mc_op(a, GPRC_MC_ADD, 4, 5);
+        /* ((a*c) + (b*d)) / denominator */
+        gprc_mc_move(a, 5, 0);
+        gprc_mc_op(a, GPRC_MC_MUL, 5, 2);
+        gprc_mc_move(a, 6, 1);
+        gprc_mc_op(a, GPRC_MC_MUL, 6, 3);
+        gprc_mc_op(a, GPRC_MC_ADD, 5, 6);
+        gprc_mc_op(a, GPRC_MC_DIV, 5, 4);
+        /* ((b*c) - (a*d)) / denominator */
+        gprc_mc_move(a, 6, 1);
+        gprc_mc_op(a, GPRC_MC_MUL, 6, 2);
+        gprc_mc_move(a, 7, 0);
+        gprc_mc_op(a, GPRC_MC_MUL, 7, 3);
+        gprc_mc_op(a, GPRC_MC_SUB, 6, 7);
+        gprc_mc_op(a, GPRC_MC_DIV, 6, 4);
+        /* pass through where the real denominator is close to zero */
+        gprc_mc_move(a, 4, 2);
+        limit = gprc_mc_divide_limit();
+        memcpy((void*)&bits, (void*)&limit, sizeof(float));
+        gprc_mc_const_bits(a, 0, GPRC_MC_COMPARE, 4, bits, GPRC_MC_LE);
+        gprc_mc_const(a, GPRC_MC_LOAD, 7, -limit);
+        gprc_mc_reg(a, 0, GPRC_MC_COMPARE, 7, 2, GPRC_MC_LE);
+        gprc_mc_op(a, GPRC_MC_AND, 4, 7);
+        gprc_mc_blend(a, 0, 5, 4, 7);
+        gprc_mc_blend(a, 2, 6, 4, 7);
+        gprc_mc_move(a, 1, 2);
+        break;
+    }
+    case GPR_FUNCTION_NOOP1:
+    case GPR_FUNCTION_NOOP2:
+    case GPR_FUNCTION_NOOP3:
+    case GPR_FUNCTION_NOOP4: {
+        gprc_mc_re(a, GPRC_MC_LOAD, 0, in0);
+        gprc_mc_im(a, GPRC_MC_LOAD, 1, in0);
+        break;
+    }
+    case GPR_FUNCTION_GREATER_THAN:
+    case GPR_FUNCTION_LESS_THAN: {
+        /* a > b is the same as b < a */
+        if (function_type == GPR_FUNCTION_GREATER_THAN) {
+            gprc_mc_re(a, GPRC_MC_LOAD, 0, in1);
+            gprc_mc_mem(a, 0, GPRC_MC_COMPARE, 0,
+                        in0*GPRC_MC_BLOCK*4, GPRC_MC_LT);
+        }
+        else {
+            gprc_mc_re(a, GPRC_MC_LOAD, 0, in0);
+            gprc_mc_mem(a, 0, GPRC_MC_COMPARE, 0,
+                        in1*GPRC_MC_BLOCK*4, GPRC_MC_LT);
+        }
+        gprc_mc_logical(a, gp);
+        break;
+    }
+    case GPR_FUNCTION_AND:
+    case GPR_FUNCTION_OR:
+    case GPR_FUNCTION_XOR: {
+        /* 0 < a */
+        gprc_mc_zero(a, 0);
+        gprc_mc_mem(a, 0, GPRC_MC_COMPARE, 0,
+                    in0*GPRC_MC_BLOCK*4, GPRC_MC_LT);
+        gprc_mc_zero(a, 1);
+        gprc_mc_mem(a, 0, GPRC_MC_COMPARE, 1,
+                    in1*GPRC_MC_BLOCK*4, GPRC_MC_LT);
+        if (function_type == GPR_FUNCTION_AND) {
+            gprc_mc_op(a, GPRC_MC_AND, 0, 1);
+        }
+        else if (function_type == GPR_FUNCTION_OR) {
+            gprc_mc_op(a, GPRC_MC_OR, 0, 1);
+        }
+        else {
+            gprc_mc_op(a, GPRC_MC_XOR, 0, 1);
+        }
+        gprc_mc_logical(a, gp);
+        break;
+    }
+    case GPR_FUNCTION_EQUALS:
+    case GPR_FUNCTION_NOT: {
+        /* compare the values converted to integers */
+        gprc_mc_mem(a, 0xf3, GPRC_MC_TRUNCATE, 0,
+                    in0*GPRC_MC_BLOCK*4, GPRC_MC_NONE);
+        gprc_mc_mem(a, 0xf3, GPRC_MC_TRUNCATE, 1,
+                    in1*GPRC_MC_BLOCK*4, GPRC_MC_NONE);
+        gprc_mc_reg(a, 0x66, GPRC_MC_INT_EQUAL, 0, 1, GPRC_MC_NONE);
+        if (function_type == GPR_FUNCTION_EQUALS) {
+            gprc_mc_mem(a, 0xf3, GPRC_MC_TRUNCATE, 2,
+                        (a->no_of_states + in0)*GPRC_MC_BLOCK*4,
+                        GPRC_MC_NONE);
+            gprc_mc_mem(a, 0xf3, GPRC_MC_TRUNCATE, 3,
+                        (a->no_of_states + in1)*GPRC_MC_BLOCK*4,
+                        GPRC_MC_NONE);
+            gprc_mc_reg(a, 0x66, GPRC_MC_INT_EQUAL, 2, 3, GPRC_MC_NONE);
+            gprc_mc_op(a, GPRC_MC_AND, 0, 2);
+            gprc_mc_logical(a, gp);
+        }
+        else {
+            gprc_mc_move(a, 1, 0);
+            gprc_mc_const(a, GPRC_MC_ANDNOT, 0, gp[GPRC_GENE_CONSTANT]);
+            gprc_mc_const(a, GPRC_MC_ANDNOT, 1, gp[GPRC_GENE_IMAGINARY]);
+        }
+        break;
+    }
+    case GPR_FUNCTION_ABS: {
+        gprc_mc_re(a, GPRC_MC_LOAD, 0, in0);
+        gprc_mc_im(a, GPRC_MC_LOAD, 1, in0);
+        /* sqrt((a*a) + (b*b)) */
+        gprc_mc_move(a, 2, 0);
+        gprc_mc_op(a, GPRC_MC_MUL, 2, 0);
+        gprc_mc_move(a, 3, 1);
+        gprc_mc_op(a, GPRC_MC_MUL, 3, 1);
+        gprc_mc_op(a, GPRC_MC_ADD, 2, 3);
+        gprc_mc_op(a, GPRC_MC_SQRT, 2, 2);
+        /* fabs(a) where b == 0 */
+        gprc_mc_const_bits(a, 0, GPRC_MC_AND, 0,
+                           GPRC_MC_ABS, GPRC_MC_NONE);
+        gprc_mc_move(a, 3, 1);
+        gprc_mc_const_bits(a, 0, GPRC_MC_COMPARE, 3, 0, GPRC_MC_EQ);
+        gprc_mc_blend(a, 0, 2, 3, 4);
+        gprc_mc_zero(a, 1);
+        break;
+    }
+    case GPR_FUNCTION_SQUARE_ROOT: {
+        gprc_mc_re(a, GPRC_MC_LOAD, 0, in0);
+        gprc_mc_im(a, GPRC_MC_LOAD, 1, in0);
+        /* sqrt(fabs(a)) where b == 0 */
+        gprc_mc_move(a, 2, 0);
+        gprc_mc_const_bits(a, 0, GPRC_MC_AND, 2,
+                           GPRC_MC_ABS, GPRC_MC_NONE);
+        gprc_mc_op(a, GPRC_MC_SQRT, 2, 2);
+        /* a2 = sqrt((a*a) + (b*b)) */
+        gprc_mc_move(a, 3, 0);
+        gprc_mc_op(a, GPRC_MC_MUL, 3, 0);
+        gprc_mc_move(a, 4, 1);
+        gprc_mc_op(a, GPRC_MC_MUL, 4, 1);
+        gprc_mc_op(a, GPRC_MC_ADD, 3, 4);
+        gprc_mc_op(a, GPRC_MC_SQRT, 3, 3);
+        /* sqrt((a + a2) * 0.5) */
+        gprc_mc_move(a, 4, 0);
+        gprc_mc_op(a, GPRC_MC_ADD, 4, 3);
+        gprc_mc_const(a, GPRC_MC_MUL, 4, 0.5f);
+        gprc_mc_op(a, GPRC_MC_SQRT, 4, 4);
+        /* sqrt((-a + a2) * 0.5), negated where b < 0 */
+        gprc_mc_move(a, 5, 0);
+        gprc_mc_const_bits(a, 0, GPRC_MC_XOR, 5,
+                           GPRC_MC_SIGN, GPRC_MC_NONE);
+        gprc_mc_op(a, GPRC_MC_ADD, 5, 3);
+        gprc_mc_const(a, GPRC_MC_MUL, 5, 0.5f);
+        gprc_mc_op(a, GPRC_MC_SQRT, 5, 5);
+        gprc_mc_move(a, 6, 1);
+        gprc_mc_const_bits(a, 0, GPRC_MC_COMPARE, 6, 0, GPRC_MC_LT);
+        gprc_mc_const_bits(a, 0, GPRC_MC_AND, 6,
+                           GPRC_MC_SIGN, GPRC_MC_NONE);
+        gprc_mc_op(a, GPRC_MC_XOR, 5, 6);
+        /* select according to whether b == 0 */
+        gprc_mc_move(a, 6, 1);
+        gprc_mc_const_bits(a, 0, GPRC_MC_COMPARE, 6, 0, GPRC_MC_EQ);
+        gprc_mc_blend(a, 2, 4, 6, 7);
+        gprc_mc_move(a, 0, 2);
+        gprc_mc_op(a, GPRC_MC_ANDNOT, 6, 5);
+        gprc_mc_move(a, 1, 6);
+        break;
+    }
+    case GPR_FUNCTION_MIN:
+    case GPR_FUNCTION_MAX: {
+        /* the imaginary part is only updated when a later
+           argument is selected */
+        gprc_mc_re(a, GPRC_MC_LOAD, 0, in0);
+        gprc_mc_im(a, GPRC_MC_LOAD, 1, k);
+        for (j = 1; j < no_of_args; j++) {
+            gprc_mc_re(a, GPRC_MC_LOAD, 2, con[j]);
+            gprc_mc_im(a, GPRC_MC_LOAD, 5, con[j]);
+            if (function_type == GPR_FUNCTION_MIN) {
+                /* in < out */
+                gprc_mc_move(a, 3, 2);
+                gprc_mc_reg(a, 0, GPRC_MC_COMPARE, 3, 0, GPRC_MC_LT);
+            }
+            else {
+                /* out < in */
+                gprc_mc_move(a, 3, 0);
+                gprc_mc_reg(a, 0, GPRC_MC_COMPARE, 3, 2, GPRC_MC_LT);
+            }
+            mask = 3;
+            gprc_mc_blend(a, 2, 0, mask, 4);
+            gprc_mc_move(a, 0, 2);
+            gprc_mc_blend(a, 5, 1, mask, 4);
+            gprc_mc_move(a, 1, 5);
+        }
+        break;
+    }
+    default: {
+        return 1;
+    }
+    }
+
+    gprc_mc_clamp(a, k);
+    return 0;
+}
+
+/* xor ecx, ecx.  Returns the start of the loop over
+   groups of samples within the block */
+static int gprc_mc_loop_start(gprc_mc_assembler * a)
+{
+    gprc_mc_byte(a, 0x31);
+    gprc_mc_byte(a, 0xc9);
+    return a->length;
+}
+
+/* moves on to the next group of samples */
+static void gprc_mc_loop_end(gprc_mc_assembler * a, int start)
+{
+    /* add rcx, 16 */
+    gprc_mc_byte(a, 0x48);
+    gprc_mc_byte(a, 0x83);
+    gprc_mc_byte(a, 0xc1);
+    gprc_mc_byte(a, (unsigned char)(a->lanes*4));
+    /* cmp rcx, block */
+    gprc_mc_byte(a, 0x48);
+    gprc_mc_byte(a, 0x81);
+    gprc_mc_byte(a, 0xf9);
+    gprc_mc_int32(a, GPRC_MC_BLOCK*4);
+    /* jb start */
+    gprc_mc_byte(a, 0x0f);
+    gprc_mc_byte(a, 0x82);
+    gprc_mc_int32(a, start - (a->length + 4));
+}
+
+/* emits a call to gprc_mc_call_gene */
+static void gprc_mc_call_function(gprc_mc_assembler * a,
+                                  gprc_mc_call * call)
+{
+    void (*function)(float*,gprc_mc_call*) = gprc_mc_call_gene;
+
+    gprc_mc_vzeroupper(a);
+    /* mov rdi, rbx */
+    gprc_mc_byte(a, 0x48);
+    gprc_mc_byte(a, 0x89);
+    gprc_mc_byte(a, 0xdf);
+    /* mov rsi, call */
+    gprc_mc_byte(a, 0x48);
+    gprc_mc_byte(a, 0xbe);
+    gprc_mc_pointer(a, (void*)&call, sizeof(call));
+    /* mov rax, function */
+    gprc_mc_byte(a, 0x48);
+    gprc_mc_byte(a, 0xb8);
+    gprc_mc_pointer(a, (void*)&function, sizeof(function));
+    /* call rax */
+    gprc_mc_byte(a, 0xff);
+    gprc_mc_byte(a, 0xd0);
+}
+
+/* copies the assembled code and its constant pool into an
+   executable buffer. Returns zero on success */
+static int gprc_mc_load(gprc_mc_program * p, gprc_mc_assembler * a)
+{
+    int i, j, constants_start, disp;
+    unsigned char * code;
+
+    /* the constant pool is aligned to the vector size */
+    while (a->length % (a->lanes*4) != 0) {
+        gprc_mc_byte(a, 0xcc);
+    }
+    constants_start = a->length;
+
+    for (i = 0; i < a->no_of_fixups; i++) {
+        disp = constants_start +
+            (a->fixup[i*3+1]*a->lanes*4) - a->fixup[i*3+2];
+        memcpy((void*)&a->code[a->fixup[i*3]], (void*)&disp, 4);
+    }
+
+    for (i = 0; i < a->no_of_constants; i++) {
+        for (j = 0; j < a->lanes; j++) {
+            gprc_mc_int32(a, (int)a->constant[i]);
+        }
+    }
+
+    /* the buffer is made executable once it has been written */
+    code = (unsigned char*)mmap(NULL, a->length,
+                                PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == (unsigned char*)MAP_FAILED) return -1;
+    memcpy((void*)code, (void*)a->code, a->length);
+    if (mprotect((void*)code, a->length, PROT_READ | PROT_EXEC) != 0) {
+        munmap((void*)code, a->length);
+        return -1;
+    }
+
+    p->code = code;
+    p->code_length = a->length;
+    /* conversion from an object pointer, as with dlsym */
+    *(void **)(&p->run) = (void*)code;
+    return 0;
+}
+
+#endif
+
+/* returns non-zero if machine code can be generated
+   on this platform */
+int gprc_mc_available()
+{
+#ifdef GPRC_MC_X86_64
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/* Compiles an individual to machine code which evaluates a block
+   of GPRC_MC_BLOCK samples at a time.  AVX2 instructions are used
+   if selected by gprc_simd_set_level, otherwise SSE.
+   Functions which have no direct translation are evaluated by
+   calling back into the library.  Returns zero on success, or -1
+   if the program can't be compiled, in which case gprc_run_batch
+   can be used instead */
+int gprc_mc_compile_base(gprc_mc_program * p,
+                         gprc_function * f,
+                         int rows, int columns,
+                         int connections_per_gene,
+                         int sensors, int actuators,
+                         int integers_only,
+                         float (*custom_function)(float,float,float))
+{
+#ifdef GPRC_MC_X86_64
+    int i, j, k, length, result, start, * instr;
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int no_of_states = (rows*columns) + sensors + actuators;
+    float * gene = f->genome[0].gene;
+    unsigned char * marked;
+    gprc_mc_assembler a;
+    gprc_mc_call * call;
+#endif
+
+    memset((void*)p, '\0', sizeof(gprc_mc_program));
+
+#ifdef GPRC_MC_X86_64
+    if (!gprc_batch_supported(f, rows, columns,
+                              connections_per_gene, sensors,
+                              integers_only)) {
+        return -1;
+    }
+
+    length = f->genome[0].program_length;
+    p->sensors = sensors;
+    p->actuators = actuators;
+    p->no_of_states = no_of_states;
+
+    /* take copies of the compiled genes, so that the individual
+       may change after it has been compiled */
+    p->instr = (int*)malloc((length*instr_size + 1)*sizeof(int));
+    p->genes = (float*)malloc((length*gene_size + 1)*sizeof(float));
+    p->call = (gprc_mc_call*)malloc((length+1)*sizeof(gprc_mc_call));
+    p->actuator = (int*)malloc((actuators+1)*sizeof(int));
+    p->cleared = (int*)malloc(no_of_states*sizeof(int));
+    memcpy((void*)p->instr, (void*)f->genome[0].program,
+           length*instr_size*sizeof(int));
+    for (i = 0; i < length; i++) {
+        memcpy((void*)&p->genes[i*gene_size],
+               (void*)&gene[p->instr[i*instr_size+GPRC_INSTR_GENE]*
+                            gene_size],
+               gene_size*sizeof(float));
+    }
+    for (i = 0; i < actuators; i++) {
+        p->actuator[i] = (int)gene[(rows*columns*gene_size)+i];
+    }
+
+    /* the non-sensor states which are used need to begin
+       from a cleared state */
+    marked = (unsigned char*)malloc(no_of_states*sizeof(unsigned char));
+    memset((void*)marked, '\0', no_of_states*sizeof(unsigned char));
+    for (i = 0; i < length; i++) {
+        instr = &p->instr[i*instr_size];
+        for (j = -1; j < connections_per_gene; j++) {
+            if (j < 0) {
+                k = sensors + instr[GPRC_INSTR_GENE];
+            }
+            else {
+                k = instr[GPRC_INSTR_INITIAL+j];
+            }
+            if ((k >= sensors) && (k < no_of_states) &&
+                (marked[k] == 0)) {
+                marked[k] = 1;
+                p->cleared[p->no_of_cleared++] = k;
+            }
+        }
+    }
+    free(marked);
+
+    memset((void*)&a, '\0', sizeof(gprc_mc_assembler));
+    a.no_of_states = no_of_states;
+    a.lanes = GPRC_MC_LANES;
+    if (gprc_simd_level() >= GPRC_SIMD_AVX2) a.lanes = 8;
+
+    /* push rbx, mov rbx, rdi */
+    gprc_mc_byte(&a, 0x53);
+    gprc_mc_byte(&a, 0x48);
+    gprc_mc_byte(&a, 0x89);
+    gprc_mc_byte(&a, 0xfb);
+
+    for (i = 0; i < length; i++) {
+        instr = &p->instr[i*instr_size];
+        start = gprc_mc_loop_start(&a);
+        if (gprc_mc_gene(&a, instr, &p->genes[i*gene_size],
+                         sensors, connections_per_gene) != 0) {
+            /* no loop is needed */
+            a.length = start - 2;
+            call = &p->call[p->no_of_calls++];
+            call->instr = instr;
+            call->gp = &p->genes[i*gene_size];
+            call->sensors = sensors;
+            call->no_of_states = no_of_states;
+            call->connections_per_gene = connections_per_gene;
+            call->custom_function = custom_function;
+            gprc_mc_call_function(&a, call);
+        }
+        else {
+            gprc_mc_loop_end(&a, start);
+        }
+    }
+
+    gprc_mc_vzeroupper(&a);
+
+    /* pop rbx, ret */
+    gprc_mc_byte(&a, 0x5b);
+    gprc_mc_byte(&a, 0xc3);
+
+    result = gprc_mc_load(p, &a);
+
+    free(a.code);
+    free(a.constant);
+    free(a.fixup);
+
+    if (result != 0) {
+        gprc_mc_free(p);
+    }
+    return result;
+#else
+    return -1;
+#endif
+}
+
+/* compiles an individual within a population to machine code */
+int gprc_mc_compile(gprc_mc_program * p,
+                    gprc_function * f,
+                    gprc_population * population,
+                    float (*custom_function)(float,float,float))
+{
+    return gprc_mc_compile_base(p, f,
+                                population->rows, population->columns,
+                                population->connections_per_gene,
+                                population->sensors,
+                                population->actuators,
+                                population->integers_only,
+                                custom_function);
+}
+
+/* frees a compiled program */
+void gprc_mc_free(gprc_mc_program * p)
+{
+#ifdef GPRC_MC_X86_64
+    if (p->code != NULL) {
+        munmap((void*)p->code, p->code_length);
+    }
+#endif
+    free(p->instr);
+    free(p->genes);
+    free(p->call);
+    free(p->actuator);
+    free(p->cleared);
+    memset((void*)p, '\0', sizeof(gprc_mc_program));
+}
+
+/* Runs a compiled program over a number of samples.  The inputs
+   and outputs are arranged as for gprc_run_batch, and each sample
+   begins from a cleared state */
+void gprc_mc_run(gprc_mc_program * p,
+                 int time_steps,
+                 int no_of_samples,
+                 float * inputs, float * outputs)
+{
+    int i, l, t, start, samples, k;
+    int block = p->no_of_states*GPRC_MC_BLOCK;
+    float * buffer, * state;
+
+    if ((p->run == NULL) || (no_of_samples <= 0)) return;
+
+    /* SSE memory operands need to be aligned to 16 bytes */
+    buffer = (float*)malloc((block*2*sizeof(float)) + 32);
+    state = (float*)(((uintptr_t)buffer + 31) & ~(uintptr_t)31);
+    memset((void*)state, '\0', block*2*sizeof(float));
+
+    for (start = 0; start < no_of_samples; start += GPRC_MC_BLOCK) {
+        samples = no_of_samples - start;
+        if (samples > GPRC_MC_BLOCK) samples = GPRC_MC_BLOCK;
+
+        /* set the sensors.  Within the final block any values after
+           the last sample are left over from the previous block,
+           and are ignored */
+        for (i = 0; i < p->sensors; i++) {
+            memcpy((void*)&state[i*GPRC_MC_BLOCK],
+                   (void*)&inputs[i*no_of_samples + start],
+                   samples*sizeof(float));
+        }
+
+        /* clear the state */
+        for (i = 0; i < p->no_of_cleared; i++) {
+            k = p->cleared[i]*GPRC_MC_BLOCK;
+            memset((void*)&state[k], '\0', GPRC_MC_BLOCK*sizeof(float));
+            memset((void*)&state[block + k], '\0',
+                   GPRC_MC_BLOCK*sizeof(float));
+        }
+
+        for (t = 0; t < time_steps; t++) {
+            (*p->run)(state);
+        }
+
+        /* get the actuator values */
+        for (i = 0; i < p->actuators; i++) {
+            k = p->actuator[i]*GPRC_MC_BLOCK;
+            for (l = 0; l < samples; l++) {
+                outputs[i*no_of_samples + start + l] = state[k + l];
+            }
+        }
+    }
+
+    free(buffer);
+}
+
+/* Runs an individual over a batch of samples using machine code
+   where possible, and otherwise gprc_run_batch */
+void gprc_mc_run_batch(gprc_function * f,
+                       gprc_population * population,
+                       int time_steps,
+                       int no_of_samples,
+                       float * inputs, float * outputs,
+                       float (*custom_function)(float,float,float))
+{
+    gprc_mc_program p;
+
+    if (gprc_mc_compile(&p, f, population, custom_function) == 0) {
+        gprc_mc_run(&p, time_steps, no_of_samples, inputs, outputs);
+        gprc_mc_free(&p);
+        return;
+    }
+    gprc_run_batch(f, population, 0, time_steps,
+                   no_of_samples, inputs, outputs,
+                   (*custom_function));
+}
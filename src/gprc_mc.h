@@ -0,0 +1,112 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPRC_MC_H
+#define GPRC_MC_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "globals.h"
+#include "gpr.h"
+#include "gprc.h"
+#include "gprcm.h"
+#include "gprc_batch.h"
+
+/* the number of samples within each SSE register.
+   With AVX2 there are twice as many */
+#define GPRC_MC_LANES 4
+
+/* the number of samples evaluated by each call to the generated code */
+#define GPRC_MC_BLOCK 64
+
+/* a gene which the generated code evaluates by calling
+   back into gprc_batch_gene */
+struct gprc_mc_cll {
+    int * instr;
+    float * gp;
+    int sensors;
+    int no_of_states;
+    int connections_per_gene;
+    float (*custom_function)(float,float,float);
+};
+typedef struct gprc_mc_cll gprc_mc_call;
+
+/* an individual compiled to machine code */
+struct gprc_mc_prog {
+    /* executable buffer containing the code and its constants */
+    unsigned char * code;
+    int code_length;
+
+    /* runs a single time step over a block of samples */
+    void (*run)(float * state);
+
+    int sensors, actuators, no_of_states;
+
+    /* the state index read by each actuator */
+    int * actuator;
+
+    /* states which are cleared before each block of samples */
+    int * cleared;
+    int no_of_cleared;
+
+    /* copies of the compiled genes, used by calls */
+    int * instr;
+    float * genes;
+    gprc_mc_call * call;
+    int no_of_calls;
+};
+typedef struct gprc_mc_prog gprc_mc_program;
+
+int gprc_mc_available();
+int gprc_mc_compile_base(gprc_mc_program * p,
+                         gprc_function * f,
+                         int rows, int columns,
+                         int connections_per_gene,
+                         int sensors, int actuators,
+                         int integers_only,
+                         float (*custom_function)(float,float,float));
+int gprc_mc_compile(gprc_mc_program * p,
+                    gprc_function * f,
+                    gprc_population * population,
+                    float (*custom_function)(float,float,float));
+void gprc_mc_free(gprc_mc_program * p);
+void gprc_mc_run(gprc_mc_program * p,
+                 int time_steps,
+                 int no_of_samples,
+                 float * inputs, float * outputs);
+void gprc_mc_run_batch(gprc_function * f,
+                       gprc_population * population,
+                       int time_steps,
+                       int no_of_samples,
+                       float * inputs, float * outputs,
+                       float (*custom_function)(float,float,float));
+
+#endif
@@ -0,0 +1,838 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Incremental evaluation using stored gene outputs.
+
+   A child produced by gprc_mate usually differs from its parent
+   in only a few genes, so most of its used genes produce exactly
+   the same outputs over a data set as they did for the parent.
+   Here the outputs of each used gene are kept for the fittest
+   individuals, and when a child is evaluated only the genes which
+   have changed, or which are downstream of a changed gene, are
+   run.  The outputs of the remaining genes are read from whichever
+   stored individual requires the fewest genes to be run, and are
+   shared rather than copied when the child's outputs are kept.
+   This applies to programs which can be run as a batch and in
+   which each gene only connects to earlier genes, so that the
+   outputs don't depend upon the number of time steps.  Other
+   programs are run by gprc_run_batch_base */
+
+#include "gprc_nodes.h"
+
+/* returns the number of bytes used by the outputs of one gene */
+static size_t gprc_nodes_row_bytes(int no_of_samples)
+{
+    return sizeof(gprc_node_row) +
+        (size_t)no_of_samples*2*sizeof(float);
+}
+
+/* creates the outputs of a gene, with a single reference */
+static gprc_node_row * gprc_nodes_row(int no_of_samples)
+{
+    gprc_node_row * row =
+        (gprc_node_row*)malloc(gprc_nodes_row_bytes(no_of_samples));
+
+    row->references = 1;
+    row->mark = 0;
+    return row;
+}
+
+/* adds a reference to the outputs of a gene.  Stores may be
+   shared between threads during evaluation */
+static void gprc_nodes_share(gprc_node_row * row)
+{
+#pragma omp atomic
+    row->references++;
+}
+
+/* removes a reference to the outputs of a gene, freeing them
+   when the last reference is removed */
+static void gprc_nodes_release(gprc_node_row * row)
+{
+    int references;
+
+#pragma omp atomic capture
+    references = --row->references;
+
+    if (references <= 0) free(row);
+}
+
+/* allocates an empty store for the outputs of the genes
+   of an individual */
+void gprc_nodes_init(gprc_nodes * n,
+                     int rows, int columns,
+                     int connections_per_gene,
+                     int sensors, int actuators,
+                     int no_of_samples)
+{
+    int i;
+
+    n->rows = rows;
+    n->columns = columns;
+    n->connections_per_gene = connections_per_gene;
+    n->sensors = sensors;
+    n->actuators = actuators;
+    n->no_of_samples = no_of_samples;
+    n->no_of_nodes = 0;
+    n->gene = (float*)malloc(rows*columns*
+                             GPRC_GENE_SIZE(connections_per_gene)*
+                             sizeof(float));
+    n->node = (gprc_node_row**)malloc(rows*columns*
+                                      sizeof(gprc_node_row*));
+    for (i = 0; i < rows*columns; i++) {
+        n->node[i] = NULL;
+    }
+}
+
+/* removes all outputs from a store */
+void gprc_nodes_clear(gprc_nodes * n)
+{
+    int i;
+
+    if (n->no_of_nodes == 0) return;
+
+    for (i = 0; i < n->rows*n->columns; i++) {
+        if (n->node[i] != NULL) {
+            gprc_nodes_release(n->node[i]);
+            n->node[i] = NULL;
+        }
+    }
+    n->no_of_nodes = 0;
+}
+
+/* frees memory for a store */
+void gprc_nodes_free(gprc_nodes * n)
+{
+    gprc_nodes_clear(n);
+    free(n->gene);
+    free(n->node);
+}
+
+/* returns the number of bytes used by a store, including
+   any outputs which are shared with other stores */
+size_t gprc_nodes_bytes(gprc_nodes * n)
+{
+    int genes = n->rows*n->columns;
+
+    return (size_t)genes*GPRC_GENE_SIZE(n->connections_per_gene)*
+        sizeof(float) +
+        (size_t)genes*sizeof(gprc_node_row*) +
+        (size_t)n->no_of_nodes*gprc_nodes_row_bytes(n->no_of_samples);
+}
+
+/* returns non-zero if the outputs of an individual can be
+   obtained from the outputs of each of its genes.  The program
+   needs to be able to run as a batch, and each gene may only
+   connect to earlier genes, so that further time steps
+   leave the outputs unchanged */
+int gprc_nodes_supported(gprc_function * f,
+                         int rows, int columns,
+                         int connections_per_gene,
+                         int sensors,
+                         int integers_only,
+                         int time_steps)
+{
+    int i, j, k, * instr;
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int * program;
+
+    if (time_steps < 1) return 0;
+
+    if (!gprc_batch_supported(f, rows, columns,
+                              connections_per_gene, sensors,
+                              integers_only)) {
+        return 0;
+    }
+
+    program = f->genome[0].program;
+    for (i = 0; i < f->genome[0].program_length; i++) {
+        instr = &program[i*instr_size];
+        k = sensors + instr[GPRC_INSTR_GENE];
+        for (j = 0; j < connections_per_gene; j++) {
+            if ((instr[GPRC_INSTR_INITIAL+j] >= k) &&
+                (instr[GPRC_INSTR_INITIAL+j] < sensors + (rows*columns))) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* returns non-zero if a gene is the same as the stored one in
+   each of the values which gprc_batch_gene_rows reads */
+static int gprc_nodes_same_gene(int * instr,
+                                float * gene, float * stored,
+                                int connections_per_gene)
+{
+    int j, no_of_connections = instr[GPRC_INSTR_ARGS];
+
+    if ((gene[GPRC_GENE_FUNCTION_TYPE] !=
+         stored[GPRC_GENE_FUNCTION_TYPE]) ||
+        (gene[GPRC_GENE_CONSTANT] != stored[GPRC_GENE_CONSTANT]) ||
+        (gene[GPRC_GENE_IMAGINARY] != stored[GPRC_GENE_IMAGINARY])) {
+        return 0;
+    }
+
+    /* the first two connections are always read */
+    if (no_of_connections < 2) no_of_connections = 2;
+    if (no_of_connections > connections_per_gene) {
+        no_of_connections = connections_per_gene;
+    }
+    for (j = 0; j < no_of_connections; j++) {
+        if ((gene[GPRC_INITIAL+j] != stored[GPRC_INITIAL+j]) ||
+            (gene[GPRC_INITIAL+j+connections_per_gene] !=
+             stored[GPRC_INITIAL+j+connections_per_gene])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Marks the used genes whose outputs are not available from
+   the store, either because the gene is not stored, has changed,
+   or one of its inputs has changed.
+   Returns the number of changed genes */
+static int gprc_nodes_changed(gprc_function * f,
+                              gprc_nodes * source,
+                              int rows, int columns,
+                              int connections_per_gene,
+                              int sensors,
+                              int no_of_samples,
+                              unsigned char * changed)
+{
+    int i, j, k, p, * instr, no_of_changes = 0;
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int * program = f->genome[0].program;
+    float * gene = f->genome[0].gene;
+
+    if (source != NULL) {
+        if ((source->no_of_samples != no_of_samples) ||
+            (source->no_of_nodes == 0)) {
+            source = NULL;
+        }
+    }
+
+    for (p = 0; p < f->genome[0].program_length; p++) {
+        instr = &program[p*instr_size];
+        i = instr[GPRC_INSTR_GENE];
+        changed[i] = 1;
+        if ((source != NULL) && (source->node[i] != NULL) &&
+            (gprc_nodes_same_gene(instr, &gene[i*gene_size],
+                                  &source->gene[i*gene_size],
+                                  connections_per_gene) != 0)) {
+            /* since each gene only connects to earlier genes
+               its inputs have already been marked */
+            for (j = 0; j < connections_per_gene; j++) {
+                k = instr[GPRC_INSTR_INITIAL+j] - sensors;
+                if ((k >= 0) && (k < rows*columns) &&
+                    (changed[k] != 0)) {
+                    break;
+                }
+            }
+            if (j == connections_per_gene) changed[i] = 0;
+        }
+        if (changed[i] != 0) no_of_changes++;
+    }
+    return no_of_changes;
+}
+
+/* Runs an individual over a data set, in the same arrangement
+   as gprc_run_batch_base, evaluating only those genes whose
+   outputs are not available from the source store.
+   If a result store is given then the outputs of all used genes
+   are kept within it, so that it can become the source for later
+   evaluations.  Outputs from the source are shared with the result
+   rather than copied.  The source may be NULL, and the result may
+   be NULL or a different store to the source.
+   The outputs array may be NULL if only the result is needed.
+   As with a batch, genes are run over blocks of samples.
+   The state of the individual is not altered.
+   Returns the number of genes which were evaluated */
+int gprc_run_nodes_base(gprc_function * f,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int sensors, int actuators,
+                        int integers_only,
+                        int time_steps,
+                        gprc_nodes * source,
+                        gprc_nodes * result,
+                        int no_of_samples,
+                        float * inputs,
+                        float * outputs,
+                        float (*custom_function)(float,float,float))
+{
+    int i, j, k, p, n, start, samples, no_of_changes;
+    int * instr, * program;
+    int instr_size = GPRC_INSTR_SIZE(connections_per_gene);
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    int genes = rows*columns;
+    int no_of_states = sensors + genes;
+    float * gene = f->genome[0].gene;
+    float ** row_re, ** row_im, ** in_re, ** in_im;
+    float * zero, * work = NULL, * out_re, * out_im;
+    gprc_node_row * row;
+    unsigned char * changed;
+
+    if (result != NULL) gprc_nodes_clear(result);
+
+    if (!gprc_nodes_supported(f, rows, columns,
+                              connections_per_gene, sensors,
+                              integers_only, time_steps)) {
+        if (outputs != NULL) {
+            gprc_run_batch_base(f, rows, columns,
+                                connections_per_gene,
+                                sensors, actuators,
+                                integers_only, 0, time_steps,
+                                no_of_samples, inputs, outputs,
+                                (*custom_function));
+        }
+        return f->genome[0].program_length;
+    }
+
+    program = f->genome[0].program;
+
+    changed = (unsigned char*)calloc(genes, sizeof(unsigned char));
+    no_of_changes =
+        gprc_nodes_changed(f, source, rows, columns,
+                           connections_per_gene, sensors,
+                           no_of_samples, changed);
+
+    /* rows of the state, which for unused genes remain cleared */
+    zero = (float*)malloc(GPRC_BATCH_SIZE*sizeof(float));
+    memset((void*)zero, '\0', GPRC_BATCH_SIZE*sizeof(float));
+    row_re = (float**)malloc((no_of_states + connections_per_gene)*2*
+                             sizeof(float*));
+    row_im = &row_re[no_of_states];
+    in_re = &row_re[no_of_states*2];
+    in_im = &in_re[connections_per_gene];
+    for (i = 0; i < no_of_states; i++) {
+        row_re[i] = zero;
+        row_im[i] = zero;
+    }
+
+    if (result != NULL) {
+        /* the result refers to the outputs of every used gene */
+        result->no_of_samples = no_of_samples;
+        memcpy((void*)result->gene, (void*)gene,
+               genes*gene_size*sizeof(float));
+        for (p = 0; p < f->genome[0].program_length; p++) {
+            i = program[p*instr_size + GPRC_INSTR_GENE];
+            if (changed[i] != 0) {
+                result->node[i] = gprc_nodes_row(no_of_samples);
+            }
+            else {
+                result->node[i] = source->node[i];
+                gprc_nodes_share(result->node[i]);
+            }
+        }
+        result->no_of_nodes = f->genome[0].program_length;
+    }
+    else if (no_of_changes > 0) {
+        /* only the changed genes need rows */
+        work = (float*)malloc((size_t)no_of_changes*
+                              GPRC_BATCH_SIZE*2*sizeof(float));
+    }
+
+    for (start = 0; start < no_of_samples; start += GPRC_BATCH_SIZE) {
+        samples = no_of_samples - start;
+        if (samples > GPRC_BATCH_SIZE) samples = GPRC_BATCH_SIZE;
+
+        for (i = 0; i < sensors; i++) {
+            row_re[i] = &inputs[i*no_of_samples + start];
+        }
+
+        /* run each changed gene over the block of samples */
+        n = 0;
+        for (p = 0; p < f->genome[0].program_length; p++) {
+            instr = &program[p*instr_size];
+            i = instr[GPRC_INSTR_GENE];
+            if ((changed[i] != 0) && (result == NULL)) {
+                out_re = &work[(size_t)n*2*GPRC_BATCH_SIZE];
+                out_im = &out_re[GPRC_BATCH_SIZE];
+                n++;
+            }
+            else {
+                row = (result != NULL) ? result->node[i] : source->node[i];
+                out_re = &row->value[start];
+                out_im = &row->value[no_of_samples + start];
+            }
+
+            if (changed[i] != 0) {
+                for (j = 0; j < connections_per_gene; j++) {
+                    k = instr[GPRC_INSTR_INITIAL+j];
+                    in_re[j] = zero;
+                    in_im[j] = zero;
+                    if ((k >= 0) && (k < no_of_states)) {
+                        in_re[j] = row_re[k];
+                        in_im[j] = row_im[k];
+                    }
+                }
+                /* begin from a cleared state, as a batch does */
+                memset((void*)out_re, '\0', samples*sizeof(float));
+                memset((void*)out_im, '\0', samples*sizeof(float));
+                gprc_batch_gene_rows(instr, &gene[i*gene_size],
+                                     out_re, out_im, in_re, in_im,
+                                     samples, connections_per_gene,
+                                     (*custom_function));
+            }
+            row_re[sensors+i] = out_re;
+            row_im[sensors+i] = out_im;
+        }
+
+        /* get the actuator values */
+        if (outputs != NULL) {
+            for (i = 0; i < actuators; i++) {
+                k = (int)gene[(genes*gene_size)+i];
+                out_re = zero;
+                if ((k >= 0) && (k < no_of_states)) out_re = row_re[k];
+                memcpy((void*)&outputs[i*no_of_samples + start],
+                       (void*)out_re, samples*sizeof(float));
+            }
+        }
+    }
+
+    if (work != NULL) free(work);
+    free(row_re);
+    free(zero);
+    free(changed);
+    return no_of_changes;
+}
+
+/* The default reducer, which returns a fitness from the mean
+   squared error between the outputs and the targets, both
+   arranged as actuators x no_of_samples.  A perfect fit has
+   a fitness of 100 */
+float gprc_nodes_fitness(int no_of_samples, int actuators,
+                         float * outputs, float * targets)
+{
+    int i;
+    float diff;
+    double error = 0;
+
+    if (no_of_samples*actuators <= 0) return 0;
+
+    for (i = 0; i < no_of_samples*actuators; i++) {
+        diff = outputs[i] - targets[i];
+        error += diff*diff;
+    }
+    error /= no_of_samples*actuators;
+    return (float)(100.0 / (1.0 + error));
+}
+
+/* creates a cache which stores the outputs of up to the
+   given number of individuals, within a memory limit */
+void gprc_node_cache_init(gprc_node_cache * cache,
+                          int size, size_t max_bytes)
+{
+    cache->size = size;
+    cache->no_of_stores = 0;
+    cache->max_bytes = max_bytes;
+    cache->store = (gprc_nodes*)malloc(size*sizeof(gprc_nodes));
+    cache->no_of_pending = 0;
+    cache->pending = NULL;
+    cache->pending_bytes = 0;
+    cache->mark = 0;
+    cache->reused = 0;
+    cache->evaluated = 0;
+}
+
+/* Removes all stored outputs.  This is needed whenever the data set
+   changes.  If the fitness cache of the population is enabled then
+   it should also be cleared with gpr_cache_clear, since its entries
+   are matched by phenotype alone and not by data set */
+void gprc_node_cache_clear(gprc_node_cache * cache)
+{
+    int i;
+
+    for (i = 0; i < cache->no_of_stores; i++) {
+        gprc_nodes_free(&cache->store[i]);
+    }
+    cache->no_of_stores = 0;
+
+    for (i = 0; i < cache->no_of_pending; i++) {
+        if (cache->pending[i].gene != NULL) {
+            gprc_nodes_free(&cache->pending[i]);
+        }
+    }
+    if (cache->pending != NULL) free(cache->pending);
+    cache->pending = NULL;
+    cache->no_of_pending = 0;
+    cache->pending_bytes = 0;
+}
+
+/* frees memory for a cache */
+void gprc_node_cache_free(gprc_node_cache * cache)
+{
+    gprc_node_cache_clear(cache);
+    free(cache->store);
+}
+
+/* returns the stored individual from which the outputs of the
+   given individual can be obtained by evaluating the fewest
+   genes, or -1 if there are no stored individuals */
+static int gprc_node_cache_source(gprc_node_cache * cache,
+                                  gprc_function * f,
+                                  int rows, int columns,
+                                  int connections_per_gene,
+                                  int sensors,
+                                  int no_of_samples,
+                                  unsigned char * changed,
+                                  int * no_of_changes)
+{
+    int i, n, best = -1;
+
+    *no_of_changes = f->genome[0].program_length;
+    for (i = 0; i < cache->no_of_stores; i++) {
+        n = gprc_nodes_changed(f, &cache->store[i],
+                               rows, columns,
+                               connections_per_gene, sensors,
+                               no_of_samples, changed);
+        if ((best == -1) || (n < *no_of_changes)) {
+            best = i;
+            *no_of_changes = n;
+            if (n == 0) break;
+        }
+    }
+    return best;
+}
+
+/* returns the number of bytes used by a store which are not
+   already counted within the current mark */
+static size_t gprc_node_cache_bytes(gprc_node_cache * cache,
+                                    gprc_nodes * n)
+{
+    int i, genes = n->rows*n->columns;
+    size_t bytes = (size_t)genes*
+        (GPRC_GENE_SIZE(n->connections_per_gene)*sizeof(float) +
+         sizeof(gprc_node_row*));
+
+    for (i = 0; i < genes; i++) {
+        if ((n->node[i] != NULL) && (n->node[i]->mark != cache->mark)) {
+            n->node[i]->mark = cache->mark;
+            bytes += gprc_nodes_row_bytes(n->no_of_samples);
+        }
+    }
+    return bytes;
+}
+
+/* Stores the outputs of the fittest individuals in the population,
+   in order of fitness, until either the maximum number of
+   individuals or the memory limit is reached.  Only individuals
+   whose outputs are available, either from evaluation or from
+   a previous store, are stored, so that no genes need to be run.
+   Outputs which are shared between stores are only counted once */
+static void gprc_node_cache_update(gprc_node_cache * cache,
+                                   gprc_population * population,
+                                   int time_steps,
+                                   int no_of_samples)
+{
+    int i, j, k, index, no_of_changes, no_of_stores = 0;
+    int rows = population->rows, columns = population->columns;
+    int connections_per_gene = population->connections_per_gene;
+    int sensors = population->sensors;
+    int * claimed, * nearest;
+    size_t bytes = 0;
+    gprc_nodes * store, * n;
+    gprc_function * f;
+    unsigned char * changed, * selected;
+
+    store = (gprc_nodes*)malloc((cache->size + 1)*sizeof(gprc_nodes));
+    claimed = (int*)malloc((cache->no_of_stores + population->size)*
+                           sizeof(int));
+    nearest = &claimed[cache->no_of_stores];
+    changed = (unsigned char*)malloc(rows*columns*sizeof(unsigned char));
+    selected = (unsigned char*)malloc(population->size*
+                                      sizeof(unsigned char));
+    memset((void*)claimed, '\0', cache->no_of_stores*sizeof(int));
+
+    /* find the individuals whose outputs are available */
+    for (i = 0; i < population->size; i++) {
+        f = &population->individual[i];
+        selected[i] = 1;
+        nearest[i] = -1;
+        if (population->fitness[i] <= 0) continue;
+        if (cache->pending[i].no_of_nodes > 0) {
+            selected[i] = 0;
+            continue;
+        }
+        if (!gprc_nodes_supported(f, rows, columns,
+                                  connections_per_gene, sensors,
+                                  population->integers_only,
+                                  time_steps)) {
+            continue;
+        }
+        k = gprc_node_cache_source(cache, f, rows, columns,
+                                   connections_per_gene, sensors,
+                                   no_of_samples, changed,
+                                   &no_of_changes);
+        if ((k > -1) && (no_of_changes == 0)) {
+            selected[i] = 0;
+            nearest[i] = k;
+        }
+    }
+
+    cache->mark++;
+    while (no_of_stores < cache->size) {
+        /* the fittest individual not yet considered */
+        index = -1;
+        for (j = 0; j < population->size; j++) {
+            if ((selected[j] == 0) &&
+                ((index == -1) ||
+                 (population->fitness[j] > population->fitness[index]))) {
+                index = j;
+            }
+        }
+        if (index == -1) break;
+        selected[index] = 1;
+
+        k = nearest[index];
+        if (k > -1) {
+            /* this individual is already stored */
+            if (claimed[k] != 0) continue;
+            n = &cache->store[k];
+        }
+        else {
+            n = &cache->pending[index];
+        }
+
+        bytes += gprc_node_cache_bytes(cache, n);
+        if (bytes > cache->max_bytes) break;
+
+        store[no_of_stores++] = *n;
+        if (k > -1) {
+            claimed[k] = 1;
+        }
+        else {
+            /* the outputs are moved into the cache */
+            n->gene = NULL;
+            n->node = NULL;
+            n->no_of_nodes = 0;
+        }
+    }
+
+    /* remove any previous stores which were not kept */
+    for (i = 0; i < cache->no_of_stores; i++) {
+        if (claimed[i] == 0) gprc_nodes_free(&cache->store[i]);
+    }
+    free(cache->store);
+    cache->store = store;
+    cache->no_of_stores = no_of_stores;
+
+    /* remove the outputs of evaluations which were not kept */
+    for (i = 0; i < cache->no_of_pending; i++) {
+        if (cache->pending[i].gene != NULL) {
+            gprc_nodes_clear(&cache->pending[i]);
+        }
+    }
+    cache->pending_bytes = 0;
+
+    free(selected);
+    free(changed);
+    free(claimed);
+}
+
+/* Evaluates the fitness of each individual in the population over
+   a data set, in the same way as gprc_evaluate.  The inputs are
+   arranged as sensors x no_of_samples and the targets as
+   actuators x no_of_samples.  The outputs of each individual are
+   passed to the reducer, which returns its fitness.  If no reducer
+   is given then gprc_nodes_fitness is used.  Afterwards the cache
+   is updated with the outputs of the fittest individuals, which
+   are likely to become the parents of the next generation.
+   The outputs of each evaluated individual are kept until then,
+   within the same memory limit as the cache, so that they don't
+   need to be obtained again.  Fitness values are also looked up
+   within the fitness cache of the population, if it is enabled,
+   which has the limitations described in gpr_cache.h */
+void gprc_evaluate_nodes(gprc_population * population,
+                         gprc_node_cache * cache,
+                         int time_steps, int reevaluate,
+                         int no_of_samples,
+                         float * inputs, float * targets,
+                         float (*reduce)(int,int,float*,float*),
+                         float (*custom_function)(float,float,float))
+{
+    int i;
+
+    /* a store for the outputs of each individual */
+    if (cache->no_of_pending != population->size) {
+        for (i = 0; i < cache->no_of_pending; i++) {
+            if (cache->pending[i].gene != NULL) {
+                gprc_nodes_free(&cache->pending[i]);
+            }
+        }
+        if (cache->pending != NULL) free(cache->pending);
+        cache->no_of_pending = population->size;
+        cache->pending =
+            (gprc_nodes*)malloc(population->size*sizeof(gprc_nodes));
+        for (i = 0; i < population->size; i++) {
+            cache->pending[i].gene = NULL;
+        }
+    }
+    for (i = 0; i < population->size; i++) {
+        if (cache->pending[i].gene == NULL) {
+            gprc_nodes_init(&cache->pending[i],
+                            population->rows, population->columns,
+                            population->connections_per_gene,
+                            population->sensors, population->actuators,
+                            no_of_samples);
+        }
+    }
+    cache->pending_bytes = 0;
+
+#pragma omp parallel for
+    for (i = 0; i < population->size; i++) {
+        if ((population->fitness[i]==0) ||
+            (reevaluate>0)) {
+            int s, best, no_of_changes;
+            size_t bytes;
+            unsigned long long key = 0;
+            int length = 0;
+            gprc_nodes * result = NULL;
+            gprc_function * f = &population->individual[i];
+            unsigned char * used = f->genome[0].used;
+            unsigned char * changed;
+            float * outputs;
+
+            /* is there a path which links sensors to actuators? */
+            for (s = 0; s < population->sensors; s++) {
+                if (used[s] != 0) break;
+            }
+
+            /* has the same phenotype been evaluated previously? */
+            if ((s < population->sensors) &&
+                (population->cache->enabled > 0)) {
+                key = gprc_phenotype_hash(f,
+                                          population->rows,
+                                          population->columns,
+                                          population->connections_per_gene,
+                                          population->sensors,
+                                          population->actuators);
+                length = f->genome[0].program_length;
+                /* individuals which can't be hashed are never cached */
+                if (key != 0) {
+                    key = gpr_cache_hash(key, &time_steps, sizeof(int));
+                }
+                if ((reevaluate <= 0) &&
+                    (gpr_cache_get(population->cache, key, length,
+                                   &population->fitness[i]) != 0)) {
+                    s = -1;
+                }
+            }
+
+            if ((s >= 0) && (s < population->sensors)) {
+                outputs =
+                    (float*)malloc(population->actuators*no_of_samples*
+                                   sizeof(float));
+                changed =
+                    (unsigned char*)malloc(population->rows*
+                                           population->columns*
+                                           sizeof(unsigned char));
+                best = -1;
+                if (gprc_nodes_supported(f, population->rows,
+                                         population->columns,
+                                         population->connections_per_gene,
+                                         population->sensors,
+                                         population->integers_only,
+                                         time_steps)) {
+                    best =
+                        gprc_node_cache_source(cache, f,
+                                               population->rows,
+                                               population->columns,
+                                               population->connections_per_gene,
+                                               population->sensors,
+                                               no_of_samples, changed,
+                                               &no_of_changes);
+
+                    /* keep the outputs in case this individual
+                       is among the fittest */
+                    bytes = (size_t)no_of_changes*
+                        gprc_nodes_row_bytes(no_of_samples);
+#pragma omp critical (gprc_nodes)
+                    {
+                        if ((cache->size > 0) &&
+                            (cache->pending_bytes + bytes <=
+                             cache->max_bytes)) {
+                            cache->pending_bytes += bytes;
+                            result = &cache->pending[i];
+                        }
+                    }
+                }
+                no_of_changes =
+                    gprc_run_nodes_base(f, population->rows,
+                                        population->columns,
+                                        population->connections_per_gene,
+                                        population->sensors,
+                                        population->actuators,
+                                        population->integers_only,
+                                        time_steps,
+                                        (best > -1) ?
+                                        &cache->store[best] : NULL,
+                                        result, no_of_samples,
+                                        inputs, outputs,
+                                        (*custom_function));
+#pragma omp atomic
+                cache->evaluated += no_of_changes;
+#pragma omp atomic
+                cache->reused +=
+                    f->genome[0].program_length - no_of_changes;
+
+                if (*reduce) {
+                    population->fitness[i] =
+                        (*reduce)(no_of_samples, population->actuators,
+                                  outputs, targets);
+                }
+                else {
+                    population->fitness[i] =
+                        gprc_nodes_fitness(no_of_samples,
+                                           population->actuators,
+                                           outputs, targets);
+                }
+                gpr_cache_set(population->cache, key, length,
+                              population->fitness[i]);
+                free(changed);
+                free(outputs);
+            }
+            else if (s >= 0) {
+                /* don't evaluate, since there is no path between
+                   sensors and actuators */
+                population->fitness[i] = 0;
+            }
+        }
+        /* if individual gets too old */
+        (&population->individual[i])->age++;
+        if ((&population->individual[i])->age>GPR_MAX_AGE) {
+            population->fitness[i] = 0;
+        }
+    }
+
+    gprc_node_cache_update(cache, population, time_steps,
+                           no_of_samples);
+}
@@ -0,0 +1,130 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPRC_NODES_H
+#define GPRC_NODES_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "globals.h"
+#include "gpr.h"
+#include "gprc.h"
+#include "gprc_batch.h"
+
+/* the outputs of a gene over a data set, which may be
+   shared between the stores of several individuals */
+struct gprc_node_output {
+    /* the number of stores which refer to these outputs */
+    int references;
+    /* used when counting the memory of a set of stores */
+    int mark;
+    /* real outputs followed by imaginary outputs */
+    float value[];
+};
+typedef struct gprc_node_output gprc_node_row;
+
+/* the outputs of each used gene of an individual over a data set */
+struct gprc_nodes_struct {
+    int rows, columns, connections_per_gene;
+    int sensors, actuators;
+    int no_of_samples;
+    /* the number of genes whose outputs are stored */
+    int no_of_nodes;
+    /* the genes of the individual which the outputs belong to */
+    float * gene;
+    /* for each gene its outputs, or NULL if not stored */
+    gprc_node_row ** node;
+};
+typedef struct gprc_nodes_struct gprc_nodes;
+
+/* stored gene outputs for the fittest individuals of a
+   population, within a limited amount of memory */
+struct gprc_node_cache_struct {
+    /* the maximum number of individuals stored */
+    int size;
+    /* the number of individuals currently stored */
+    int no_of_stores;
+    /* the maximum number of bytes used by the stored outputs */
+    size_t max_bytes;
+    gprc_nodes * store;
+    /* outputs of each individual of the population which were
+       obtained during evaluation, and which may then be stored */
+    int no_of_pending;
+    gprc_nodes * pending;
+    size_t pending_bytes;
+    /* the current mark used when counting memory */
+    int mark;
+    /* the number of gene outputs which were reused or evaluated */
+    unsigned int reused, evaluated;
+};
+typedef struct gprc_node_cache_struct gprc_node_cache;
+
+void gprc_nodes_init(gprc_nodes * n,
+                     int rows, int columns,
+                     int connections_per_gene,
+                     int sensors, int actuators,
+                     int no_of_samples);
+void gprc_nodes_clear(gprc_nodes * n);
+void gprc_nodes_free(gprc_nodes * n);
+size_t gprc_nodes_bytes(gprc_nodes * n);
+int gprc_nodes_supported(gprc_function * f,
+                         int rows, int columns,
+                         int connections_per_gene,
+                         int sensors,
+                         int integers_only,
+                         int time_steps);
+int gprc_run_nodes_base(gprc_function * f,
+                        int rows, int columns,
+                        int connections_per_gene,
+                        int sensors, int actuators,
+                        int integers_only,
+                        int time_steps,
+                        gprc_nodes * source,
+                        gprc_nodes * result,
+                        int no_of_samples,
+                        float * inputs,
+                        float * outputs,
+                        float (*custom_function)(float,float,float));
+float gprc_nodes_fitness(int no_of_samples, int actuators,
+                         float * outputs, float * targets);
+void gprc_node_cache_init(gprc_node_cache * cache,
+                          int size, size_t max_bytes);
+void gprc_node_cache_free(gprc_node_cache * cache);
+void gprc_node_cache_clear(gprc_node_cache * cache);
+void gprc_evaluate_nodes(gprc_population * population,
+                         gprc_node_cache * cache,
+                         int time_steps, int reevaluate,
+                         int no_of_samples,
+                         float * inputs, float * targets,
+                         float (*reduce)(int,int,float*,float*),
+                         float (*custom_function)(float,float,float));
+
+#endif
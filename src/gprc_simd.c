@@ -0,0 +1,919 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "gprc_simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GPRC_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/* the largest float which compares as being less than or equal
+   to the 1e-1 limit used by the divide function */
+static float gprc_simd_divide_limit()
+{
+    float limit = (float)1e-1;
+
+    if (limit > 1e-1) {
+        limit = nextafterf(limit, 0);
+    }
+    return limit;
+}
+
+/* scalar versions */
+
+static void gprc_scalar_add(float * out, float * in, int n)
+{
+    for (int s = 0; s < n; s++) {
+        out[s] += in[s];
+    }
+}
+
+static void gprc_scalar_subtract(float * out, float * in, int n)
+{
+    for (int s = 0; s < n; s++) {
+        out[s] -= in[s];
+    }
+}
+
+static void gprc_scalar_weight(float * out, float * in,
+                               float weight, int n)
+{
+    for (int s = 0; s < n; s++) {
+        out[s] = in[s] * weight;
+    }
+}
+
+static void gprc_scalar_weighted_add(float * out, float * in,
+                                     float weight, int n)
+{
+    for (int s = 0; s < n; s++) {
+        out[s] += in[s] * weight;
+    }
+}
+
+static void gprc_scalar_multiply(float * out_re, float * out_im,
+                                 float * in_re, float * in_im, int n)
+{
+    float a, b, c, d;
+
+    for (int s = 0; s < n; s++) {
+        a = out_re[s];
+        b = out_im[s];
+        c = in_re[s];
+        d = in_im[s];
+        out_re[s] = (a*c) + (b*d);
+        out_im[s] = (b*c) + (a*d);
+    }
+}
+
+static void gprc_scalar_divide(float * out_re, float * out_im,
+                               float * a_re, float * a_im,
+                               float * c_re, float * c_im, int n)
+{
+    float a, b, c, d;
+
+    for (int s = 0; s < n; s++) {
+        c = c_re[s];
+        if ((c <= 1e-1) && (c >= -1e-1)) {
+            /* if the real denominator is close to zero
+               then just pass through */
+            out_re[s] = a_re[s];
+            out_im[s] = c;
+        }
+        else {
+            a = a_re[s];
+            b = a_im[s];
+            d = c_im[s];
+            out_re[s] = ((a*c) + (b*d)) / ((c*c) + (d*d));
+            out_im[s] = ((b*c) - (a*d)) / ((c*c) + (d*d));
+        }
+    }
+}
+
+static void gprc_scalar_min(float * out_re, float * out_im,
+                            float * in_re, float * in_im, int n)
+{
+    for (int s = 0; s < n; s++) {
+        if (in_re[s] < out_re[s]) {
+            out_re[s] = in_re[s];
+            out_im[s] = in_im[s];
+        }
+    }
+}
+
+static void gprc_scalar_max(float * out_re, float * out_im,
+                            float * in_re, float * in_im, int n)
+{
+    for (int s = 0; s < n; s++) {
+        if (in_re[s] > out_re[s]) {
+            out_re[s] = in_re[s];
+            out_im[s] = in_im[s];
+        }
+    }
+}
+
+static void gprc_scalar_greater_than(float * out_re, float * out_im,
+                                     float * a, float * b,
+                                     float real, float imaginary, int n)
+{
+    for (int s = 0; s < n; s++) {
+        if (a[s] > b[s]) {
+            out_re[s] = real;
+            out_im[s] = imaginary;
+        }
+        else {
+            out_re[s] = 0;
+            out_im[s] = 0;
+        }
+    }
+}
+
+static void gprc_scalar_clamp(float * re, float * im, int n)
+{
+    for (int s = 0; s < n; s++) {
+        if (re[s] != re[s]) {
+            re[s] = 0;
+        }
+        if (im[s] != im[s]) {
+            re[s] = 0;
+        }
+        if (re[s] > GPR_MAX_CONSTANT) {
+            re[s] = GPR_MAX_CONSTANT;
+        }
+        if (im[s] > GPR_MAX_CONSTANT) {
+            im[s] = GPR_MAX_CONSTANT;
+        }
+        if (re[s] < -GPR_MAX_CONSTANT) {
+            re[s] = -GPR_MAX_CONSTANT;
+        }
+        if (im[s] < -GPR_MAX_CONSTANT) {
+            im[s] = -GPR_MAX_CONSTANT;
+        }
+    }
+}
+
+/* returns all bits set if the given bit of the truth table is set */
+#define GPRC_SIMD_TRUTH(table,bit)                                    \
+    ((((table)>>(bit))&1) ? ~0ULL : 0ULL)
+
+static void gprc_scalar_truth(unsigned long long * out,
+                              unsigned long long * a,
+                              unsigned long long * b,
+                              int table, int n)
+{
+    unsigned long long t0 = GPRC_SIMD_TRUTH(table,0);
+    unsigned long long t1 = GPRC_SIMD_TRUTH(table,1);
+    unsigned long long t2 = GPRC_SIMD_TRUTH(table,2);
+    unsigned long long t3 = GPRC_SIMD_TRUTH(table,3);
+
+    for (int s = 0; s < n; s++) {
+        out[s] =
+            (~a[s] & ~b[s] & t0) | (a[s] & ~b[s] & t1) |
+            (~a[s] & b[s] & t2) | (a[s] & b[s] & t3);
+    }
+}
+
+/* the smallest value at the positions whose bits are set */
+static float gprc_scalar_masked_min(float * in, unsigned long long * mask,
+                                    int n)
+{
+    float result = INFINITY;
+    unsigned long long m;
+    int s;
+
+    for (int w = 0; w*64 < n; w++) {
+        m = mask[w];
+        while (m != 0) {
+            s = (w*64) + __builtin_ctzll(m);
+            if (in[s] < result) result = in[s];
+            m &= m - 1;
+        }
+    }
+    return result;
+}
+
+/* clears the bits of positions whose value is above the limit,
+   and returns the number of bits which remain set */
+static int gprc_scalar_filter(unsigned long long * mask, float * in,
+                              float limit, int n)
+{
+    int count = 0;
+    unsigned long long m, bits;
+
+    for (int w = 0; w*64 < n; w++) {
+        m = mask[w];
+        bits = m;
+        while (bits != 0) {
+            if (!(in[(w*64) + __builtin_ctzll(bits)] <= limit)) {
+                m &= ~(bits & -bits);
+            }
+            bits &= bits - 1;
+        }
+        mask[w] = m;
+        count += __builtin_popcountll(m);
+    }
+    return count;
+}
+
+#ifdef GPRC_SIMD_X86
+
+/* AVX2 versions.  Multiplies and adds are kept separate so
+   that the results are the same as the scalar versions */
+
+__attribute__((target("avx2")))
+static void gprc_avx2_add(float * out, float * in, int n)
+{
+    int s = 0;
+
+    for (; s + 8 <= n; s += 8) {
+        _mm256_storeu_ps(&out[s],
+                         _mm256_add_ps(_mm256_loadu_ps(&out[s]),
+                                       _mm256_loadu_ps(&in[s])));
+    }
+    gprc_scalar_add(&out[s], &in[s], n - s);
+}
+
+__attribute__((target("avx2")))
+static void gprc_avx2_subtract(float * out, float * in, int n)
+{
+    int s = 0;
+
+    for (; s + 8 <= n; s += 8) {
+        _mm256_storeu_ps(&out[s],
+                         _mm256_sub_ps(_mm256_loadu_ps(&out[s]),
+                                       _mm256_loadu_ps(&in[s])));
+    }
+    gprc_scalar_subtract(&out[s], &in[s], n - s);
+}
+
+__attribute__((target("avx2")))
+static void gprc_avx2_weight(float * out, float * in,
+                             float weight, int n)
+{
+    int s = 0;
+    __m256 w = _mm256_set1_ps(weight);
+
+    for (; s + 8 <= n; s += 8) {
+        _mm256_storeu_ps(&out[s],
+                         _mm256_mul_ps(_mm256_loadu_ps(&in[s]), w));
+    }
+    gprc_scalar_weight(&out[s], &in[s], weight, n - s);
+}
+
+__attribute__((target("avx2")))
+static void gprc_avx2_weighted_add(float * out, float * in,
+                                   float weight, int n)
+{
+    int s = 0;
+    __m256 w = _mm256_set1_ps(weight);
+
+    for (; s + 8 <= n; s += 8) {
+        _mm256_storeu_ps(&out[s],
+                         _mm256_add_ps(_mm256_loadu_ps(&out[s]),
+                                       _mm256_mul_ps(_mm256_loadu_ps(&in[s]),
+                                                     w)));
+    }
+    gprc_scalar_weighted_add(&out[s], &in[s], weight, n - s);
+}
+
+__attribute__((target("avx2")))
+static void gprc_avx2_multiply(float * out_re, float * out_im,
+                               float * in_re, float * in_im, int n)
+{
+    int s = 0;
+    __m256 a, b, c, d;
+
+    for (; s + 8 <= n; s += 8) {
+        a = _mm256_loadu_ps(&out_re[s]);
+        b = _mm256_loadu_ps(&out_im[s]);
+        c = _mm256_loadu_ps(&in_re[s]);
+        d = _mm256_loadu_ps(&in_im[s]);
+        _mm256_storeu_ps(&out_re[s],
+                         _mm256_add_ps(_mm256_mul_ps(a, c),
+                                       _mm256_mul_ps(b, d)));
+        _mm256_storeu_ps(&out_im[s],
+                         _mm256_add_ps(_mm256_mul_ps(b, c),
+                                       _mm256_mul_ps(a, d)));
+    }
+    gprc_scalar_multiply(&out_re[s], &out_im[s],
+                         &in_re[s], &in_im[s], n - s);
+}
+
+__attribute__((target("avx2")))
+static void gprc_avx2_divide(float * out_re, float * out_im,
+                             float * a_re, float * a_im,
+                             float * c_re, float * c_im, int n)
+{
+    int s = 0;
+    __m256 a, b, c, d, denom, re, im, near;
+    __m256 limit = _mm256_set1_ps(gprc_simd_divide_limit());
+    __m256 neg_limit = _mm256_set1_ps(-gprc_simd_divide_limit());
+
+    for (; s + 8 <= n; s += 8) {
+        a = _mm256_loadu_ps(&a_re[s]);
+        b = _mm256_loadu_ps(&a_im[s]);
+        c = _mm256_loadu_ps(&c_re[s]);
+        d = _mm256_loadu_ps(&c_im[s]);
+        denom = _mm256_add_ps(_mm256_mul_ps(c, c), _mm256_mul_ps(d, d));
+        re = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(a, c),
+                                         _mm256_mul_ps(b, d)), denom);
+        im = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(b, c),
+                                         _mm256_mul_ps(a, d)), denom);
+        near = _mm256_and_ps(_mm256_cmp_ps(c, limit, _CMP_LE_OQ),
+                             _mm256_cmp_ps(c, neg_limit, _CMP_GE_OQ));
+        _mm256_storeu_ps(&out_re[s], _mm256_blendv_ps(re, a, near));
+        _mm256_storeu_ps(&out_im[s], _mm256_blendv_ps(im, c, near));
+    }
+    gprc_scalar_divide(&out_re[s], &out_im[s], &a_re[s], &a_im[s],
+                       &c_re[s], &c_im[s], n - s);
+}
+
+__attribute__((target("avx2")))
+static void gprc_avx2_min(float * out_re, float * out_im,
+                          float * in_re, float * in_im, int n)
+{
+    int s = 0;
+    __m256 re, mask;
+
+    for (; s + 8 <= n; s += 8) {
+        re = _mm256_loadu_ps(&in_re[s]);
+        mask = _mm256_cmp_ps(re, _mm256_loadu_ps(&out_re[s]), _CMP_LT_OQ);
+        _mm256_storeu_ps(&out_re[s],
+                         _mm256_blendv_ps(_mm256_loadu_ps(&out_re[s]),
+                                          re, mask));
+        _mm256_storeu_ps(&out_im[s],
+                         _mm256_blendv_ps(_mm256_loadu_ps(&out_im[s]),
+                                          _mm256_loadu_ps(&in_im[s]),
+                                          mask));
+    }
+    gprc_scalar_min(&out_re[s], &out_im[s], &in_re[s], &in_im[s], n - s);
+}
+
+__attribute__((target("avx2")))
+static void gprc_avx2_max(float * out_re, float * out_im,
+                          float * in_re, float * in_im, int n)
+{
+    int s = 0;
+    __m256 re, mask;
+
+    for (; s + 8 <= n; s += 8) {
+        re = _mm256_loadu_ps(&in_re[s]);
+        mask = _mm256_cmp_ps(re, _mm256_loadu_ps(&out_re[s]), _CMP_GT_OQ);
+        _mm256_storeu_ps(&out_re[s],
+                         _mm256_blendv_ps(_mm256_loadu_ps(&out_re[s]),
+                                          re, mask));
+        _mm256_storeu_ps(&out_im[s],
+                         _mm256_blendv_ps(_mm256_loadu_ps(&out_im[s]),
+                                          _mm256_loadu_ps(&in_im[s]),
+                                          mask));
+    }
+    gprc_scalar_max(&out_re[s], &out_im[s], &in_re[s], &in_im[s], n - s);
+}
+
+__attribute__((target("avx2")))
+static void gprc_avx2_greater_than(float * out_re, float * out_im,
+                                   float * a, float * b,
+                                   float real, float imaginary, int n)
+{
+    int s = 0;
+    __m256 mask;
+    __m256 re = _mm256_set1_ps(real);
+    __m256 im = _mm256_set1_ps(imaginary);
+
+    for (; s + 8 <= n; s += 8) {
+        mask = _mm256_cmp_ps(_mm256_loadu_ps(&a[s]),
+                             _mm256_loadu_ps(&b[s]), _CMP_GT_OQ);
+        _mm256_storeu_ps(&out_re[s], _mm256_and_ps(mask, re));
+        _mm256_storeu_ps(&out_im[s], _mm256_and_ps(mask, im));
+    }
+    gprc_scalar_greater_than(&out_re[s], &out_im[s], &a[s], &b[s],
+                             real, imaginary, n - s);
+}
+
+__attribute__((target("avx2")))
+static void gprc_avx2_clamp(float * re, float * im, int n)
+{
+    int s = 0;
+    __m256 r, i, nan;
+    __m256 max = _mm256_set1_ps(GPR_MAX_CONSTANT);
+    __m256 min = _mm256_set1_ps(-GPR_MAX_CONSTANT);
+
+    for (; s + 8 <= n; s += 8) {
+        r = _mm256_loadu_ps(&re[s]);
+        i = _mm256_loadu_ps(&im[s]);
+        /* the real part is zeroed if either part is NaN */
+        nan = _mm256_or_ps(_mm256_cmp_ps(r, r, _CMP_UNORD_Q),
+                           _mm256_cmp_ps(i, i, _CMP_UNORD_Q));
+        r = _mm256_andnot_ps(nan, r);
+        /* the operand order leaves NaN values unchanged */
+        r = _mm256_max_ps(min, _mm256_min_ps(max, r));
+        i = _mm256_max_ps(min, _mm256_min_ps(max, i));
+        _mm256_storeu_ps(&re[s], r);
+        _mm256_storeu_ps(&im[s], i);
+    }
+    gprc_scalar_clamp(&re[s], &im[s], n - s);
+}
+
+__attribute__((target("avx2")))
+static void gprc_avx2_truth(unsigned long long * out,
+                            unsigned long long * a,
+                            unsigned long long * b,
+                            int table, int n)
+{
+    int s = 0;
+    __m256i x, y, r;
+    __m256i t0 = _mm256_set1_epi64x(GPRC_SIMD_TRUTH(table,0));
+    __m256i t1 = _mm256_set1_epi64x(GPRC_SIMD_TRUTH(table,1));
+    __m256i t2 = _mm256_set1_epi64x(GPRC_SIMD_TRUTH(table,2));
+    __m256i t3 = _mm256_set1_epi64x(GPRC_SIMD_TRUTH(table,3));
+
+    for (; s + 4 <= n; s += 4) {
+        x = _mm256_loadu_si256((__m256i*)&a[s]);
+        y = _mm256_loadu_si256((__m256i*)&b[s]);
+        /* select between the table entries using x, then y */
+        r = _mm256_or_si256(
+                _mm256_andnot_si256(y,
+                    _mm256_or_si256(_mm256_andnot_si256(x, t0),
+                                    _mm256_and_si256(x, t1))),
+                _mm256_and_si256(y,
+                    _mm256_or_si256(_mm256_andnot_si256(x, t2),
+                                    _mm256_and_si256(x, t3))));
+        _mm256_storeu_si256((__m256i*)&out[s], r);
+    }
+    gprc_scalar_truth(&out[s], &a[s], &b[s], table, n - s);
+}
+
+__attribute__((target("avx2")))
+static float gprc_avx2_masked_min(float * in, unsigned long long * mask,
+                                  int n)
+{
+    int w = 0, k;
+    unsigned int bits;
+    float lane[8], result;
+    __m256 v, inf = _mm256_set1_ps(INFINITY), acc = inf;
+    __m256i lanes, bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+    for (; (w+1)*64 <= n; w++) {
+        if (mask[w] == 0) continue;
+        for (k = 0; k < 8; k++) {
+            bits = (unsigned int)(mask[w] >> (k*8)) & 0xff;
+            if (bits == 0) continue;
+            /* a lane is used if its bit is set */
+            lanes = _mm256_and_si256(_mm256_set1_epi32((int)bits), bit);
+            lanes = _mm256_cmpeq_epi32(lanes, bit);
+            v = _mm256_blendv_ps(inf, _mm256_loadu_ps(&in[(w*64) + (k*8)]),
+                                 _mm256_castsi256_ps(lanes));
+            /* a NaN value leaves the minimum unchanged */
+            acc = _mm256_min_ps(v, acc);
+        }
+    }
+    _mm256_storeu_ps(lane, acc);
+    result = gprc_scalar_masked_min(&in[w*64], &mask[w], n - (w*64));
+    for (k = 0; k < 8; k++) {
+        if (lane[k] < result) result = lane[k];
+    }
+    return result;
+}
+
+__attribute__((target("avx2")))
+static int gprc_avx2_filter(unsigned long long * mask, float * in,
+                            float limit, int n)
+{
+    int w = 0, k, count = 0;
+    unsigned long long bits;
+    __m256 l = _mm256_set1_ps(limit);
+
+    for (; (w+1)*64 <= n; w++) {
+        if (mask[w] == 0) continue;
+        bits = 0;
+        for (k = 0; k < 8; k++) {
+            bits |= (unsigned long long)
+                _mm256_movemask_ps(
+                    _mm256_cmp_ps(_mm256_loadu_ps(&in[(w*64) + (k*8)]),
+                                  l, _CMP_LE_OQ)) << (k*8);
+        }
+        mask[w] &= bits;
+        count += __builtin_popcountll(mask[w]);
+    }
+    return count + gprc_scalar_filter(&mask[w], &in[w*64], limit,
+                                      n - (w*64));
+}
+
+/* AVX-512 versions */
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_add(float * out, float * in, int n)
+{
+    int s = 0;
+
+    for (; s + 16 <= n; s += 16) {
+        _mm512_storeu_ps(&out[s],
+                         _mm512_add_ps(_mm512_loadu_ps(&out[s]),
+                                       _mm512_loadu_ps(&in[s])));
+    }
+    gprc_scalar_add(&out[s], &in[s], n - s);
+}
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_subtract(float * out, float * in, int n)
+{
+    int s = 0;
+
+    for (; s + 16 <= n; s += 16) {
+        _mm512_storeu_ps(&out[s],
+                         _mm512_sub_ps(_mm512_loadu_ps(&out[s]),
+                                       _mm512_loadu_ps(&in[s])));
+    }
+    gprc_scalar_subtract(&out[s], &in[s], n - s);
+}
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_weight(float * out, float * in,
+                               float weight, int n)
+{
+    int s = 0;
+    __m512 w = _mm512_set1_ps(weight);
+
+    for (; s + 16 <= n; s += 16) {
+        _mm512_storeu_ps(&out[s],
+                         _mm512_mul_ps(_mm512_loadu_ps(&in[s]), w));
+    }
+    gprc_scalar_weight(&out[s], &in[s], weight, n - s);
+}
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_weighted_add(float * out, float * in,
+                                     float weight, int n)
+{
+    int s = 0;
+    __m512 w = _mm512_set1_ps(weight);
+
+    for (; s + 16 <= n; s += 16) {
+        _mm512_storeu_ps(&out[s],
+                         _mm512_add_ps(_mm512_loadu_ps(&out[s]),
+                                       _mm512_mul_ps(_mm512_loadu_ps(&in[s]),
+                                                     w)));
+    }
+    gprc_scalar_weighted_add(&out[s], &in[s], weight, n - s);
+}
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_multiply(float * out_re, float * out_im,
+                                 float * in_re, float * in_im, int n)
+{
+    int s = 0;
+    __m512 a, b, c, d;
+
+    for (; s + 16 <= n; s += 16) {
+        a = _mm512_loadu_ps(&out_re[s]);
+        b = _mm512_loadu_ps(&out_im[s]);
+        c = _mm512_loadu_ps(&in_re[s]);
+        d = _mm512_loadu_ps(&in_im[s]);
+        _mm512_storeu_ps(&out_re[s],
+                         _mm512_add_ps(_mm512_mul_ps(a, c),
+                                       _mm512_mul_ps(b, d)));
+        _mm512_storeu_ps(&out_im[s],
+                         _mm512_add_ps(_mm512_mul_ps(b, c),
+                                       _mm512_mul_ps(a, d)));
+    }
+    gprc_scalar_multiply(&out_re[s], &out_im[s],
+                         &in_re[s], &in_im[s], n - s);
+}
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_divide(float * out_re, float * out_im,
+                               float * a_re, float * a_im,
+                               float * c_re, float * c_im, int n)
+{
+    int s = 0;
+    __m512 a, b, c, d, denom, re, im;
+    __mmask16 near;
+    __m512 limit = _mm512_set1_ps(gprc_simd_divide_limit());
+    __m512 neg_limit = _mm512_set1_ps(-gprc_simd_divide_limit());
+
+    for (; s + 16 <= n; s += 16) {
+        a = _mm512_loadu_ps(&a_re[s]);
+        b = _mm512_loadu_ps(&a_im[s]);
+        c = _mm512_loadu_ps(&c_re[s]);
+        d = _mm512_loadu_ps(&c_im[s]);
+        denom = _mm512_add_ps(_mm512_mul_ps(c, c), _mm512_mul_ps(d, d));
+        re = _mm512_div_ps(_mm512_add_ps(_mm512_mul_ps(a, c),
+                                         _mm512_mul_ps(b, d)), denom);
+        im = _mm512_div_ps(_mm512_sub_ps(_mm512_mul_ps(b, c),
+                                         _mm512_mul_ps(a, d)), denom);
+        near = _mm512_cmp_ps_mask(c, limit, _CMP_LE_OQ) &
+            _mm512_cmp_ps_mask(c, neg_limit, _CMP_GE_OQ);
+        _mm512_storeu_ps(&out_re[s], _mm512_mask_blend_ps(near, re, a));
+        _mm512_storeu_ps(&out_im[s], _mm512_mask_blend_ps(near, im, c));
+    }
+    gprc_scalar_divide(&out_re[s], &out_im[s], &a_re[s], &a_im[s],
+                       &c_re[s], &c_im[s], n - s);
+}
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_min(float * out_re, float * out_im,
+                            float * in_re, float * in_im, int n)
+{
+    int s = 0;
+    __m512 re, out;
+    __mmask16 mask;
+
+    for (; s + 16 <= n; s += 16) {
+        re = _mm512_loadu_ps(&in_re[s]);
+        out = _mm512_loadu_ps(&out_re[s]);
+        mask = _mm512_cmp_ps_mask(re, out, _CMP_LT_OQ);
+        _mm512_storeu_ps(&out_re[s], _mm512_mask_blend_ps(mask, out, re));
+        _mm512_storeu_ps(&out_im[s],
+                         _mm512_mask_blend_ps(mask,
+                                              _mm512_loadu_ps(&out_im[s]),
+                                              _mm512_loadu_ps(&in_im[s])));
+    }
+    gprc_scalar_min(&out_re[s], &out_im[s], &in_re[s], &in_im[s], n - s);
+}
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_max(float * out_re, float * out_im,
+                            float * in_re, float * in_im, int n)
+{
+    int s = 0;
+    __m512 re, out;
+    __mmask16 mask;
+
+    for (; s + 16 <= n; s += 16) {
+        re = _mm512_loadu_ps(&in_re[s]);
+        out = _mm512_loadu_ps(&out_re[s]);
+        mask = _mm512_cmp_ps_mask(re, out, _CMP_GT_OQ);
+        _mm512_storeu_ps(&out_re[s], _mm512_mask_blend_ps(mask, out, re));
+        _mm512_storeu_ps(&out_im[s],
+                         _mm512_mask_blend_ps(mask,
+                                              _mm512_loadu_ps(&out_im[s]),
+                                              _mm512_loadu_ps(&in_im[s])));
+    }
+    gprc_scalar_max(&out_re[s], &out_im[s], &in_re[s], &in_im[s], n - s);
+}
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_greater_than(float * out_re, float * out_im,
+                                     float * a, float * b,
+                                     float real, float imaginary, int n)
+{
+    int s = 0;
+    __mmask16 mask;
+    __m512 re = _mm512_set1_ps(real);
+    __m512 im = _mm512_set1_ps(imaginary);
+
+    for (; s + 16 <= n; s += 16) {
+        mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(&a[s]),
+                                  _mm512_loadu_ps(&b[s]), _CMP_GT_OQ);
+        _mm512_storeu_ps(&out_re[s], _mm512_maskz_mov_ps(mask, re));
+        _mm512_storeu_ps(&out_im[s], _mm512_maskz_mov_ps(mask, im));
+    }
+    gprc_scalar_greater_than(&out_re[s], &out_im[s], &a[s], &b[s],
+                             real, imaginary, n - s);
+}
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_clamp(float * re, float * im, int n)
+{
+    int s = 0;
+    __m512 r, i;
+    __mmask16 nan;
+    __m512 max = _mm512_set1_ps(GPR_MAX_CONSTANT);
+    __m512 min = _mm512_set1_ps(-GPR_MAX_CONSTANT);
+
+    for (; s + 16 <= n; s += 16) {
+        r = _mm512_loadu_ps(&re[s]);
+        i = _mm512_loadu_ps(&im[s]);
+        /* the real part is zeroed if either part is NaN */
+        nan = _mm512_cmp_ps_mask(r, r, _CMP_UNORD_Q) |
+            _mm512_cmp_ps_mask(i, i, _CMP_UNORD_Q);
+        r = _mm512_maskz_mov_ps((__mmask16)~nan, r);
+        /* the operand order leaves NaN values unchanged */
+        r = _mm512_max_ps(min, _mm512_min_ps(max, r));
+        i = _mm512_max_ps(min, _mm512_min_ps(max, i));
+        _mm512_storeu_ps(&re[s], r);
+        _mm512_storeu_ps(&im[s], i);
+    }
+    gprc_scalar_clamp(&re[s], &im[s], n - s);
+}
+
+__attribute__((target("avx512f")))
+static void gprc_avx512_truth(unsigned long long * out,
+                              unsigned long long * a,
+                              unsigned long long * b,
+                              int table, int n)
+{
+    int s = 0;
+    __m512i x, y, r;
+    __m512i t0 = _mm512_set1_epi64(GPRC_SIMD_TRUTH(table,0));
+    __m512i t1 = _mm512_set1_epi64(GPRC_SIMD_TRUTH(table,1));
+    __m512i t2 = _mm512_set1_epi64(GPRC_SIMD_TRUTH(table,2));
+    __m512i t3 = _mm512_set1_epi64(GPRC_SIMD_TRUTH(table,3));
+
+    for (; s + 8 <= n; s += 8) {
+        x = _mm512_loadu_si512(&a[s]);
+        y = _mm512_loadu_si512(&b[s]);
+        /* select between the table entries using x, then y */
+        r = _mm512_or_si512(
+                _mm512_andnot_si512(y,
+                    _mm512_or_si512(_mm512_andnot_si512(x, t0),
+                                    _mm512_and_si512(x, t1))),
+                _mm512_and_si512(y,
+                    _mm512_or_si512(_mm512_andnot_si512(x, t2),
+                                    _mm512_and_si512(x, t3))));
+        _mm512_storeu_si512(&out[s], r);
+    }
+    gprc_scalar_truth(&out[s], &a[s], &b[s], table, n - s);
+}
+
+__attribute__((target("avx512f")))
+static float gprc_avx512_masked_min(float * in, unsigned long long * mask,
+                                    int n)
+{
+    int w = 0, k;
+    float result;
+    __m512 acc = _mm512_set1_ps(INFINITY);
+
+    for (; (w+1)*64 <= n; w++) {
+        if (mask[w] == 0) continue;
+        for (k = 0; k < 4; k++) {
+            /* a NaN value leaves the minimum unchanged */
+            acc = _mm512_mask_min_ps(acc,
+                                     (__mmask16)(mask[w] >> (k*16)),
+                                     _mm512_loadu_ps(&in[(w*64) + (k*16)]),
+                                     acc);
+        }
+    }
+    result = gprc_scalar_masked_min(&in[w*64], &mask[w], n - (w*64));
+    if (_mm512_reduce_min_ps(acc) < result) {
+        result = _mm512_reduce_min_ps(acc);
+    }
+    return result;
+}
+
+__attribute__((target("avx512f")))
+static int gprc_avx512_filter(unsigned long long * mask, float * in,
+                              float limit, int n)
+{
+    int w = 0, k, count = 0;
+    unsigned long long bits;
+    __m512 l = _mm512_set1_ps(limit);
+
+    for (; (w+1)*64 <= n; w++) {
+        if (mask[w] == 0) continue;
+        bits = 0;
+        for (k = 0; k < 4; k++) {
+            bits |= (unsigned long long)
+                _mm512_cmp_ps_mask(_mm512_loadu_ps(&in[(w*64) + (k*16)]),
+                                   l, _CMP_LE_OQ) << (k*16);
+        }
+        mask[w] &= bits;
+        count += __builtin_popcountll(mask[w]);
+    }
+    return count + gprc_scalar_filter(&mask[w], &in[w*64], limit,
+                                      n - (w*64));
+}
+
+#endif
+
+/* the kernels currently in use */
+gprc_simd_kernels gprc_simd = {
+    gprc_scalar_add,
+    gprc_scalar_subtract,
+    gprc_scalar_weight,
+    gprc_scalar_weighted_add,
+    gprc_scalar_multiply,
+    gprc_scalar_divide,
+    gprc_scalar_min,
+    gprc_scalar_max,
+    gprc_scalar_greater_than,
+    gprc_scalar_clamp,
+    gprc_scalar_truth,
+    gprc_scalar_masked_min,
+    gprc_scalar_filter
+};
+
+/* the level of vector instructions currently in use */
+static int gprc_simd_current_level = GPRC_SIMD_NONE;
+
+/* returns non-zero if the CPU supports the given level
+   of vector instructions */
+int gprc_simd_supported(int level)
+{
+    if (level == GPRC_SIMD_NONE) return 1;
+#ifdef GPRC_SIMD_X86
+    __builtin_cpu_init();
+    if (level == GPRC_SIMD_AVX2) {
+        return __builtin_cpu_supports("avx2");
+    }
+    if (level == GPRC_SIMD_AVX512) {
+        return __builtin_cpu_supports("avx512f");
+    }
+#endif
+    return 0;
+}
+
+/* returns the level of vector instructions currently in use */
+int gprc_simd_level()
+{
+    return gprc_simd_current_level;
+}
+
+/* Selects the kernels for the given level of vector instructions.
+   If the CPU doesn't support that level then the best available
+   lower level is used.  Returns the level selected */
+int gprc_simd_set_level(int level)
+{
+    while ((level > GPRC_SIMD_NONE) && (!gprc_simd_supported(level))) {
+        level--;
+    }
+
+#ifdef GPRC_SIMD_X86
+    if (level == GPRC_SIMD_AVX512) {
+        gprc_simd.add = gprc_avx512_add;
+        gprc_simd.subtract = gprc_avx512_subtract;
+        gprc_simd.weight = gprc_avx512_weight;
+        gprc_simd.weighted_add = gprc_avx512_weighted_add;
+        gprc_simd.multiply = gprc_avx512_multiply;
+        gprc_simd.divide = gprc_avx512_divide;
+        gprc_simd.min = gprc_avx512_min;
+        gprc_simd.max = gprc_avx512_max;
+        gprc_simd.greater_than = gprc_avx512_greater_than;
+        gprc_simd.clamp = gprc_avx512_clamp;
+        gprc_simd.truth = gprc_avx512_truth;
+        gprc_simd.masked_min = gprc_avx512_masked_min;
+        gprc_simd.filter = gprc_avx512_filter;
+        gprc_simd_current_level = level;
+        return level;
+    }
+    if (level == GPRC_SIMD_AVX2) {
+        gprc_simd.add = gprc_avx2_add;
+        gprc_simd.subtract = gprc_avx2_subtract;
+        gprc_simd.weight = gprc_avx2_weight;
+        gprc_simd.weighted_add = gprc_avx2_weighted_add;
+        gprc_simd.multiply = gprc_avx2_multiply;
+        gprc_simd.divide = gprc_avx2_divide;
+        gprc_simd.min = gprc_avx2_min;
+        gprc_simd.max = gprc_avx2_max;
+        gprc_simd.greater_than = gprc_avx2_greater_than;
+        gprc_simd.clamp = gprc_avx2_clamp;
+        gprc_simd.truth = gprc_avx2_truth;
+        gprc_simd.masked_min = gprc_avx2_masked_min;
+        gprc_simd.filter = gprc_avx2_filter;
+        gprc_simd_current_level = level;
+        return level;
+    }
+#endif
+
+    gprc_simd.add = gprc_scalar_add;
+    gprc_simd.subtract = gprc_scalar_subtract;
+    gprc_simd.weight = gprc_scalar_weight;
+    gprc_simd.weighted_add = gprc_scalar_weighted_add;
+    gprc_simd.multiply = gprc_scalar_multiply;
+    gprc_simd.divide = gprc_scalar_divide;
+    gprc_simd.min = gprc_scalar_min;
+    gprc_simd.max = gprc_scalar_max;
+    gprc_simd.greater_than = gprc_scalar_greater_than;
+    gprc_simd.clamp = gprc_scalar_clamp;
+    gprc_simd.truth = gprc_scalar_truth;
+    gprc_simd.masked_min = gprc_scalar_masked_min;
+    gprc_simd.filter = gprc_scalar_filter;
+    gprc_simd_current_level = GPRC_SIMD_NONE;
+    return GPRC_SIMD_NONE;
+}
+
+#ifdef GPRC_SIMD_X86
+/* select the best kernels for this CPU when the library is loaded */
+__attribute__((constructor))
+static void gprc_simd_init()
+{
+    gprc_simd_set_level(GPRC_SIMD_AVX512);
+}
+#endif
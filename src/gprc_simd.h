@@ -0,0 +1,97 @@
+/*
+  libgpr - a library for genetic programming
+  Copyright (C) 2013  Bob Mottram <bob@robotics.uk.to>
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  3. Neither the name of the University nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+  .
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE HOLDERS OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GPRC_SIMD_H
+#define GPRC_SIMD_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "globals.h"
+
+/* levels of vector instructions which may be used
+   by the batch evaluator */
+#define GPRC_SIMD_NONE    0
+#define GPRC_SIMD_AVX2    1
+#define GPRC_SIMD_AVX512  2
+
+/* kernels which operate on rows of batch values.
+   Each has a scalar version together with vectorized
+   versions which are selected according to the CPU */
+struct gprc_simd_kern {
+    /* out += in */
+    void (*add)(float * out, float * in, int n);
+    /* out -= in */
+    void (*subtract)(float * out, float * in, int n);
+    /* out = in * weight */
+    void (*weight)(float * out, float * in, float weight, int n);
+    /* out += in * weight */
+    void (*weighted_add)(float * out, float * in, float weight, int n);
+    /* product of complex numbers, as in gprc_run_float */
+    void (*multiply)(float * out_re, float * out_im,
+                     float * in_re, float * in_im, int n);
+    /* division of complex numbers with a pass through
+       when the real denominator is close to zero */
+    void (*divide)(float * out_re, float * out_im,
+                   float * a_re, float * a_im,
+                   float * c_re, float * c_im, int n);
+    /* replaces the output where the input is smaller */
+    void (*min)(float * out_re, float * out_im,
+                float * in_re, float * in_im, int n);
+    /* replaces the output where the input is larger */
+    void (*max)(float * out_re, float * out_im,
+                float * in_re, float * in_im, int n);
+    /* output is the given value where a > b, otherwise zero */
+    void (*greater_than)(float * out_re, float * out_im,
+                         float * a, float * b,
+                         float real, float imaginary, int n);
+    /* removes NaN values and clamps to GPR_MAX_CONSTANT */
+    void (*clamp)(float * re, float * im, int n);
+    /* bitwise function of two bit sliced inputs, where bit
+       (a + 2b) of the truth table is the output for inputs a, b */
+    void (*truth)(unsigned long long * out,
+                  unsigned long long * a, unsigned long long * b,
+                  int table, int n);
+    /* the smallest value at the positions whose bits are set */
+    float (*masked_min)(float * in, unsigned long long * mask, int n);
+    /* clears the bits of positions whose value is above the limit,
+       returning the number of bits which remain set */
+    int (*filter)(unsigned long long * mask, float * in,
+                  float limit, int n);
+};
+typedef struct gprc_simd_kern gprc_simd_kernels;
+
+extern gprc_simd_kernels gprc_simd;
+
+int gprc_simd_supported(int level);
+int gprc_simd_level();
+int gprc_simd_set_level(int level);
+
+#endif
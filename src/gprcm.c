@@ -448,6 +448,9 @@ void gprcm_run_environment(gprcm_function * f,
     }
 }
 
+/* Initialize the population.  As with gprc_init_population
+   the fitness cache is disabled unless enabled with
+   gpr_cache_enable */
 void gprcm_init_population(gprcm_population * population,
                            int size,
                            int rows, int columns,
@@ -478,6 +481,8 @@ void gprcm_init_population(gprcm_population * population,
     population->min_value = min_value;
     population->max_value = max_value;
     population->integers_only = integers_only;
+    gpr_cache_init(&population->fitness_cache, GPR_CACHE_SIZE);
+    population->cache = &population->fitness_cache;
     population->fitness = (float*)malloc(size*sizeof(float));
 
     population->history.index = 0;
@@ -610,6 +615,7 @@ void gprcm_free_population(gprcm_population * population)
     }
     free(population->individual);
     free(population->fitness);
+    gpr_cache_free(&population->fitness_cache);
 }
 
 /* free memory for the given environment population */
@@ -654,6 +660,8 @@ void gprcm_evaluate(gprcm_population * population,
         if ((population->fitness[i]==0) ||
             (reevaluate>0)) {
             int s;
+            unsigned long long key = 0;
+            int length = 0;
             gprc_function * f = &(&population->individual[i])->program;
             unsigned char * used = f->genome[0].used;           
             /* clear the retained state */
@@ -668,9 +676,29 @@ void gprcm_evaluate(gprcm_population * population,
             }
             
             if (s < population->sensors) {
-                /* run the evaluation function */
-                population->fitness[i] =
-                    (*evaluate_program)(time_steps,population,i,0);
+                /* has the same phenotype been evaluated previously? */
+                if (population->cache->enabled > 0) {
+                    key = gprc_phenotype_hash(f,
+                                              population->rows,
+                                              population->columns,
+                                              population->connections_per_gene,
+                                              population->sensors,
+                                              population->actuators);
+                    length = f->genome[0].program_length;
+                    /* individuals which can't be hashed are never cached */
+                    if (key != 0) {
+                        key = gpr_cache_hash(key, &time_steps, sizeof(int));
+                    }
+                }
+                if ((reevaluate > 0) ||
+                    (gpr_cache_get(population->cache, key, length,
+                                   &population->fitness[i]) == 0)) {
+                    /* run the evaluation function */
+                    population->fitness[i] =
+                        (*evaluate_program)(time_steps,population,i,0);
+                    gpr_cache_set(population->cache, key, length,
+                                  population->fitness[i]);
+                }
             }
             else {
                 /* don't evaluate, since there is no path between
@@ -801,31 +829,10 @@ int gprcm_get_actuator_destination(gprcm_function * f, int index)
 /* sorts individuals in order of fitness */
 void gprcm_sort(gprcm_population * population)
 {
-    int i, j, best;
-    float max, temp_fitness;
-    gprcm_function temp_individual;
-
-    for (i = 0; i < population->size-1; i++) {
-        max = population->fitness[i];
-        best = i;
-        for (j = i+1; j < population->size; j++) {
-            if (population->fitness[j] > max) {
-                max = population->fitness[j];
-                best = j;
-            }
-        }
-        if (best != i) {
-            /* swap fitness */
-            temp_fitness = population->fitness[i];
-            population->fitness[i] = population->fitness[best];
-            population->fitness[best] = temp_fitness;
-
-            /* swap individual */
-            temp_individual = population->individual[i];
-            population->individual[i] = population->individual[best];
-            population->individual[best] = temp_individual;
-        }
-    }
+    gpr_sort_fitness(population->fitness, population->size,
+                     population->size,
+                     population->individual, sizeof(gprcm_function),
+                     0, 0);
 }
 
 /* two parents mate and produce a child */
@@ -967,11 +974,23 @@ void gprcm_generation(gprcm_population * population,
                       int * instruction_set, int no_of_instructions)
 {
     int i, threshold;
+    unsigned int stream, * seed;
     float diversity,mutation_prob_range;
     gprcm_function * parent1, * parent2, * child;
 
-    /* sort the population in order of fitness */
-    gprcm_sort(population);
+    /* range checking */
+    if ((elitism < 0.1f) || (elitism > 0.9f)) {
+        elitism = 0.3f;
+    }
+
+    /* index setting the threshold for the fittest individuals */
+    threshold = (int)((1.0f - elitism)*(population->size-1));
+
+    /* sort the population in order of fitness.  Only the fittest
+       individuals which survive need to be in order */
+    gpr_sort_fitness(population->fitness, population->size, threshold,
+                     population->individual, sizeof(gprcm_function),
+                     0, 0);
 
     diversity = gprcm_diversity(population);
     mutation_prob_range = (1.0f - mutation_prob) / 2;
@@ -1005,25 +1024,24 @@ void gprcm_generation(gprcm_population * population,
         }
     }
 
-    /* range checking */
-    if ((elitism < 0.1f) || (elitism > 0.9f)) {
-        elitism = 0.3f;
-    }
-
-    /* index setting the threshold for the fittest individuals */
-    threshold = (int)((1.0f - elitism)*(population->size-1));
+    /* each child is bred from its own streams of random numbers,
+       so the results don't depend upon the number of threads */
+    stream = (unsigned int)rand_num(random_seed);
 
-#pragma omp parallel for
+#pragma omp parallel for private(parent1, parent2, child, seed)
     for (i = 0; i < population->size - threshold; i++) {
+        child = &population->individual[threshold + i];
+        seed = &(&child->program)->random_seed;
+        *seed = rand_stream(stream, (unsigned int)i);
+        (&child->morphology)->random_seed =
+            rand_stream(stream, (unsigned int)(population->size + i));
+
         /* randomly choose parents from the fittest
            section of the population */
-        parent1 =
-            &population->individual[rand_num(random_seed)%threshold];
-        parent2 =
-            &population->individual[rand_num(random_seed)%threshold];
+        parent1 = &population->individual[rand_num(seed)%threshold];
+        parent2 = &population->individual[rand_num(seed)%threshold];
 
         /* produce a new child */
-        child = &population->individual[threshold + i];
         gprcm_mate(parent1, parent2,
                    population->rows, population->columns,
                    population->sensors, population->actuators,
@@ -1514,6 +1532,12 @@ void gprcm_init_system(gprcm_system * system,
         /* clear the average fitness for the population */
         system->fitness[i] = 0;
     }
+
+    /* the islands share a single fitness cache */
+    for (i = 1; i < islands; i++) {
+        gpr_cache_free(&system->island[i].fitness_cache);
+        system->island[i].cache = &system->island[0].fitness_cache;
+    }
 }
 
 /* frees memory for a system */
@@ -1558,15 +1582,21 @@ void gprcm_generation_system(gprcm_system * system,
                              int no_of_instructions)
 {
     int i, migrant_index;
+    unsigned int stream;
     gprcm_population *population1, *population2;
     int island1_index, island2_index;
 
+    /* each island has its own stream of random numbers */
+    stream = (unsigned int)rand_num(random_seed);
+
 #pragma omp parallel for
     for (i = 0; i < system->size; i++) {
+        unsigned int island_seed = rand_stream(stream, (unsigned int)i);
+
         gprcm_generation(&system->island[i],
                          elitism,
                          mutation_prob,
-                         use_crossover, random_seed,
+                         use_crossover, &island_seed,
                          instruction_set, no_of_instructions);
     }
 
@@ -1637,31 +1667,8 @@ void gprcm_generation_system(gprcm_system * system,
 /* sorts populations in order of average fitness */
 void gprcm_sort_system(gprcm_system * system)
 {
-    int i, j, best;
-    float max, temp_fitness;
-    gprcm_population temp_island;
-
-    for (i = 0; i < system->size-1; i++) {
-        max = system->fitness[i];
-        best = i;
-        for (j = i+1; j < system->size; j++) {
-            if (system->fitness[j] > max) {
-                max = system->fitness[j];
-                best = j;
-            }
-        }
-        if (best != i) {
-            /* swap fitness */
-            temp_fitness = system->fitness[i];
-            system->fitness[i] = system->fitness[best];
-            system->fitness[best] = temp_fitness;
-
-            /* swap island */
-            temp_island = system->island[i];
-            system->island[i] = system->island[best];
-            system->island[best] = temp_island;
-        }
-    }
+    gpr_sort_fitness(system->fitness, system->size, system->size,
+                     system->island, sizeof(gprcm_population), 0, 0);
 }
 
 /* returns the highest fitness value for the given system */
@@ -85,6 +85,10 @@ struct gprcm_pop {
     /* array containing individual programs */
     struct gprcm_func * individual;
     float * fitness;
+    /* fitness values of previously evaluated phenotypes, which
+       may be shared with the other islands of a system */
+    gpr_cache fitness_cache;
+    gpr_cache * cache;
     /* the fitness history for the population */
     struct gpr_hist history;
 };
@@ -144,6 +144,39 @@ static  void test_gpr_random_value()
     printf("Ok\n");
 }
 
+static void test_rand_stream()
+{
+    unsigned int seed = 123, stream_seed[4];
+    int i, j, same = 0;
+
+    printf("test_rand_stream...");
+
+    /* streams are reproducible */
+    assert(rand_stream(seed, 7) == rand_stream(seed, 7));
+
+    /* values from different streams don't coincide */
+    for (i = 0; i < 4; i++) {
+        stream_seed[i] = rand_stream(seed, (unsigned int)i);
+    }
+    for (j = 0; j < 1000; j++) {
+        int v[4];
+        for (i = 0; i < 4; i++) {
+            v[i] = rand_num(&stream_seed[i]);
+            assert(v[i] >= 0);
+        }
+        if ((v[0] == v[1]) || (v[1] == v[2]) || (v[2] == v[3])) {
+            same++;
+        }
+    }
+    assert(same < 2);
+
+    /* every seed is usable, including zero */
+    seed = 0;
+    assert(rand_num(&seed) != rand_num(&seed));
+
+    printf("Ok\n");
+}
+
 static void test_gpr_init()
 {
     gpr_function f;
@@ -371,6 +404,80 @@ static void test_gpr_copy()
     printf("Ok\n");
 }
 
+static void test_gpr_flat()
+{
+    gpr_function f, f2;
+    gpr_flat t, t2;
+    int i, j, ctr, depth, result;
+    int min_depth=2, max_depth=10;
+    float branching_prob=0.8f;
+    unsigned int random_seed = 7321;
+    int integers_only=0;
+    int instruction_set[64], no_of_instructions=0;
+
+    printf("test_gpr_flat...");
+
+    no_of_instructions =
+        gpr_default_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gpr_flat_init(&t);
+    gpr_flat_init(&t2);
+
+    for (i = 0; i < GPR_MAX_TESTS; i++) {
+        gpr_random(&f, 0, min_depth, max_depth, branching_prob,
+                   100, 200, integers_only, &random_seed,
+                   (int*)instruction_set, no_of_instructions);
+        assert(gpr_flat_encode(&f, &t) == t.length);
+        assert(t.node[0].size == t.length);
+
+        /* the same number of nodes and depth */
+        ctr = 0;
+        gpr_nodes(&f, &ctr);
+        assert(gpr_flat_nodes(&t) == ctr);
+        depth = 0;
+        gpr_max_depth(&f, 0, &depth);
+        assert(gpr_flat_max_depth(&t) == depth);
+
+        /* arguments of the top level function */
+        for (j = 0; j < f.argc; j++) {
+            if (f.argv[j] == 0) {
+                assert(gpr_flat_child(&t, 0, j) == -1);
+            }
+            else {
+                assert(t.node[gpr_flat_child(&t, 0, j)].function_type ==
+                       f.argv[j]->function_type);
+            }
+        }
+        assert(gpr_flat_child(&t, 0, f.argc) == -1);
+
+        /* copying is the same as for the original tree */
+        gpr_flat_copy(&t, &t2);
+        assert(t2.length == t.length);
+        gpr_flat_decode(&t2, &f2);
+        result = 0;
+        gpr_functions_are_equal(&f, &f2, &result);
+        assert(result == 0);
+        ctr = 0;
+        gpr_nodes(&f2, &ctr);
+        assert(gpr_flat_nodes(&t) == ctr);
+
+        /* encoding the decoded tree gives the same nodes */
+        gpr_flat_encode(&f2, &t2);
+        assert(t2.length == t.length);
+        assert(memcmp(t.node, t2.node,
+                      t.length*sizeof(gpr_flat_node)) == 0);
+
+        gpr_free(&f);
+        gpr_free(&f2);
+    }
+
+    gpr_flat_free(&t);
+    gpr_flat_free(&t2);
+
+    printf("Ok\n");
+}
+
 static void test_gpr_mutate()
 {
     gpr_function f,f2;
@@ -620,6 +727,80 @@ static void test_gpr_crossover()
     printf("Ok\n");
 }
 
+/* checks that the number of nodes and the height recorded within
+   each node of a tree are the same as those of a full walk */
+static void test_gpr_annotations(gpr_function * f)
+{
+    int i, ctr = 0, height = 0;
+
+    gpr_nodes(f, &ctr);
+    assert(f->nodes == ctr);
+    gpr_max_depth(f, 0, &height);
+    assert(f->height == height);
+
+    for (i = 0; i < GPR_MAX_ARGUMENTS; i++) {
+        if (f->argv[i] != 0) {
+            test_gpr_annotations(f->argv[i]);
+        }
+    }
+}
+
+static void test_gpr_annotate()
+{
+    gpr_function parent1,parent2,child;
+    int i, min_depth=2, max_depth=10, depth=0;
+    float branching_prob=0.8f;
+    float min_value = -10;
+    float max_value = 10;
+    float mutation_prob = 0.2f;
+    unsigned int random_seed = 8461;
+    int integers_only = 0;
+    int ADFs=0;
+    int instruction_set[64], no_of_instructions=0;
+
+    printf("test_gpr_annotate...");
+
+    no_of_instructions =
+        gpr_default_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    for (i = 0; i < GPR_MAX_TESTS; i++) {
+        gpr_random(&parent1,depth,min_depth,max_depth,branching_prob,
+                   min_value, max_value, integers_only, &random_seed,
+                   (int*)instruction_set, no_of_instructions);
+        test_gpr_annotations(&parent1);
+        gpr_random(&parent2,depth,min_depth,max_depth,branching_prob,
+                   min_value, max_value, integers_only, &random_seed,
+                   (int*)instruction_set, no_of_instructions);
+        test_gpr_annotations(&parent2);
+
+        /* annotations are kept up to date as trees change */
+        gpr_crossover(&parent1, &parent2, &child, max_depth,
+                      min_value, max_value, &random_seed);
+        test_gpr_annotations(&child);
+        gpr_mutate(&child, depth, max_depth, mutation_prob,
+                   min_value, max_value, integers_only, ADFs,
+                   0, 0, &random_seed,
+                   (int*)instruction_set, no_of_instructions);
+        test_gpr_annotations(&child);
+        gpr_prune(&child, depth, max_depth/2,
+                  min_value, max_value, &random_seed);
+        test_gpr_annotations(&child);
+        assert(child.height <= max_depth/2);
+
+        /* a tree changed by hand may be annotated again */
+        if (child.argv[0] != 0) gpr_free(child.argv[0]);
+        gpr_annotate(&child);
+        test_gpr_annotations(&child);
+
+        gpr_free(&parent1);
+        gpr_free(&parent2);
+        gpr_free(&child);
+    }
+
+    printf("Ok\n");
+}
+
 static void test_gpr_mate()
 {
     gpr_function parent1,parent2,child;
@@ -815,6 +996,236 @@ static void test_gpr_run()
     printf("Ok\n");
 }
 
+/* sets the type of a node, giving it arguments if it has none */
+static gpr_function * test_gpr_node(gpr_function * f, int function_type,
+                                    int argc, float value)
+{
+    if (f->argv[0] == 0) gpr_init(f);
+    f->function_type = function_type;
+    f->argc = argc;
+    f->value = value;
+    return f;
+}
+
+static void test_gpr_vm()
+{
+    gpr_function f, * defun, * call, * set;
+    gpr_state state, state_vm;
+    gpr_vm vm;
+    int i, j, k;
+    int min_depth=2, max_depth=10;
+    float branching_prob=0.8f;
+    unsigned int random_seed = 6317, state_seed = 51, state_vm_seed = 51;
+    int integers_only=0;
+    int instruction_set[64], no_of_instructions=0;
+
+    printf("test_gpr_vm...");
+
+    no_of_instructions =
+        gpr_default_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gpr_init_state(&state, 4, 2, 2, 8, 2, &state_seed);
+    gpr_init_state(&state_vm, 4, 2, 2, 8, 2, &state_vm_seed);
+    gpr_vm_init(&vm);
+
+    /* compiled programs change the state in the same way */
+    for (i = 0; i < GPR_MAX_TESTS; i++) {
+        gpr_random(&f, 0, min_depth, max_depth, branching_prob,
+                   -10, 10, integers_only, &random_seed,
+                   (int*)instruction_set, no_of_instructions);
+        assert(gpr_vm_compile(&f, &state_vm, &vm) == vm.length);
+        assert(vm.code[vm.length-1].opcode != GPR_VM_CALL);
+
+        for (j = 0; j < 10; j++) {
+            gpr_set_sensor(&state, 0, j*0.3f);
+            gpr_set_sensor(&state_vm, 0, j*0.3f);
+            assert(gpr_run(&f, &state, 0) ==
+                   gpr_vm_run(&vm, &state_vm, 0));
+            for (k = 0; k < state.no_of_registers; k++) {
+                assert(state.registers[k] == state_vm.registers[k]);
+            }
+            for (k = 0; k < state.no_of_actuators; k++) {
+                assert(state.actuators[k] == state_vm.actuators[k]);
+            }
+        }
+        gpr_free(&f);
+    }
+
+    /* an ADF which multiplies its arguments and then calls itself
+       until the maximum call depth is reached */
+    gpr_init(&f);
+    test_gpr_node(&f, GPR_FUNCTION_PROGRAM, 2, 0);
+    defun = test_gpr_node(f.argv[0], GPR_FUNCTION_DEFUN, 2, 0);
+    test_gpr_node(defun->argv[0], GPR_FUNCTION_MULTIPLY, 2, 0);
+    test_gpr_node(defun->argv[0]->argv[0], GPR_FUNCTION_ARG, 2, 0);
+    test_gpr_node(defun->argv[0]->argv[1], GPR_FUNCTION_ARG, 2, 1);
+    call = test_gpr_node(defun->argv[1], GPR_FUNCTION_ADF, 2, 0);
+    test_gpr_node(call->argv[0], GPR_FUNCTION_VALUE, 2, 2);
+    test_gpr_node(call->argv[1], GPR_FUNCTION_VALUE, 2, 3);
+
+    /* the main program stores the result of calling the ADF */
+    test_gpr_node(f.argv[1], GPR_FUNCTION_MAIN, 1, 0);
+    set = test_gpr_node(f.argv[1]->argv[0], GPR_FUNCTION_SET, 2, 0);
+    test_gpr_node(set->argv[0], GPR_FUNCTION_VALUE, 2, 1);
+    call = test_gpr_node(set->argv[1], GPR_FUNCTION_ADF, 2, 0);
+    test_gpr_node(call->argv[0], GPR_FUNCTION_VALUE, 2, 4);
+    test_gpr_node(call->argv[1], GPR_FUNCTION_VALUE, 2, 5);
+
+    state.ADF[0] = defun;
+    state_vm.ADF[0] = defun;
+    gpr_vm_compile(&f, &state_vm, &vm);
+    assert(gpr_run(&f, &state, 0) == 0);
+    assert(gpr_vm_run(&vm, &state_vm, 0) == 0);
+    assert((int)state.actuators[1] == 4*5 + 2*3 + 2*3);
+    assert(state_vm.actuators[1] == state.actuators[1]);
+
+    gpr_free(&f);
+    gpr_vm_free(&vm);
+    gpr_free_state(&state);
+    gpr_free_state(&state_vm);
+
+    printf("Ok\n");
+}
+
+/* returns non-zero if the given values are the same, or both NaN */
+static int test_gpr_same_value(float v1, float v2)
+{
+    return ((v1 == v2) || ((v1 != v1) && (v2 != v2)));
+}
+
+static void test_gpr_simplify()
+{
+    gpr_function f, simplified, * set, * negate, * get;
+    gpr_state state, state_simplified;
+    int i, j, k, ctr, ctr_simplified;
+    int min_depth=2, max_depth=8;
+    float branching_prob=0.8f;
+    unsigned int random_seed = 2713, state_seed = 9;
+    unsigned int state_simplified_seed = 9;
+    int integers_only=0;
+    int instruction_set[64], no_of_instructions=0;
+
+    printf("test_gpr_simplify...");
+
+    no_of_instructions =
+        gpr_default_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gpr_init_state(&state, 4, 2, 2, 8, 2, &state_seed);
+    gpr_init_state(&state_simplified, 4, 2, 2, 8, 2,
+                   &state_simplified_seed);
+
+    /* simplified programs are no larger and change
+       the state in the same way */
+    for (i = 0; i < GPR_MAX_TESTS; i++) {
+        gpr_random(&f, 0, min_depth, max_depth, branching_prob,
+                   -10, 10, integers_only, &random_seed,
+                   (int*)instruction_set, no_of_instructions);
+        f.function_type = GPR_TOP_LEVEL_FUNCTION;
+        gpr_simplify(&f, &simplified);
+
+        ctr = 0;
+        gpr_nodes(&f, &ctr);
+        ctr_simplified = 0;
+        gpr_nodes(&simplified, &ctr_simplified);
+        assert(ctr_simplified <= ctr);
+        assert(simplified.nodes == ctr_simplified);
+
+        for (j = 0; j < 10; j++) {
+            gpr_set_sensor(&state, 0, j*0.3f);
+            gpr_set_sensor(&state_simplified, 0, j*0.3f);
+            assert(test_gpr_same_value(gpr_run(&f, &state, 0),
+                                       gpr_run(&simplified,
+                                               &state_simplified, 0)));
+            for (k = 0; k < state.no_of_registers; k++) {
+                assert(test_gpr_same_value(state.registers[k],
+                                           state_simplified.registers[k]));
+            }
+            for (k = 0; k < state.no_of_actuators; k++) {
+                assert(test_gpr_same_value(state.actuators[k],
+                                           state_simplified.actuators[k]));
+            }
+        }
+        gpr_free(&f);
+        gpr_free(&simplified);
+    }
+
+    /* set(1, -(-(get(sensor, 0) + 0) + 0) + get(sensor, 1) * 0) */
+    gpr_init(&f);
+    test_gpr_node(&f, GPR_FUNCTION_PROGRAM, 2, 0);
+    set = test_gpr_node(f.argv[0], GPR_FUNCTION_SET, 2, 0);
+    test_gpr_node(set->argv[0], GPR_FUNCTION_VALUE, 2, 1);
+    test_gpr_node(set->argv[1], GPR_FUNCTION_ADD, 2, 0);
+    negate = test_gpr_node(set->argv[1]->argv[0],
+                           GPR_FUNCTION_NEGATE, 2, 0);
+    test_gpr_node(negate->argv[1], GPR_FUNCTION_VALUE, 2, 0);
+    negate = test_gpr_node(negate->argv[0], GPR_FUNCTION_NEGATE, 2, 0);
+    test_gpr_node(negate->argv[1], GPR_FUNCTION_VALUE, 2, 0);
+    get = test_gpr_node(negate->argv[0], GPR_FUNCTION_GET, 2, 0);
+    test_gpr_node(get->argv[0], GPR_FUNCTION_VALUE, 2,
+                  GPR_ORACLE_SENSOR);
+    test_gpr_node(get->argv[1], GPR_FUNCTION_VALUE, 2, 0);
+    test_gpr_node(set->argv[1]->argv[1], GPR_FUNCTION_MULTIPLY, 2, 0);
+    get = test_gpr_node(set->argv[1]->argv[1]->argv[0],
+                        GPR_FUNCTION_GET, 2, 0);
+    test_gpr_node(get->argv[0], GPR_FUNCTION_VALUE, 2,
+                  GPR_ORACLE_SENSOR);
+    test_gpr_node(get->argv[1], GPR_FUNCTION_VALUE, 2, 1);
+    test_gpr_node(set->argv[1]->argv[1]->argv[1],
+                  GPR_FUNCTION_VALUE, 2, 0);
+
+    /* set(0, get(sensor, 1) / 0.001) with the divisor being too
+       small, and a pass-through of x - x */
+    test_gpr_node(f.argv[1], GPR_FUNCTION_NOOP1, 2, 0);
+    set = test_gpr_node(f.argv[1]->argv[0], GPR_FUNCTION_SET, 2, 0);
+    test_gpr_node(set->argv[0], GPR_FUNCTION_VALUE, 2, 0);
+    test_gpr_node(set->argv[1], GPR_FUNCTION_DIVIDE, 2, 0);
+    get = test_gpr_node(set->argv[1]->argv[0], GPR_FUNCTION_GET, 2, 0);
+    test_gpr_node(get->argv[0], GPR_FUNCTION_VALUE, 2,
+                  GPR_ORACLE_SENSOR);
+    test_gpr_node(get->argv[1], GPR_FUNCTION_VALUE, 2, 1);
+    test_gpr_node(set->argv[1]->argv[1], GPR_FUNCTION_VALUE, 2, 0.001f);
+    test_gpr_node(f.argv[1]->argv[1], GPR_FUNCTION_SUBTRACT, 2, 0);
+    test_gpr_node(f.argv[1]->argv[1]->argv[0], GPR_FUNCTION_VALUE, 2, 3);
+    test_gpr_node(f.argv[1]->argv[1]->argv[1], GPR_FUNCTION_VALUE, 2, 3);
+    gpr_annotate(&f);
+
+    gpr_simplify(&f, &simplified);
+
+    /* set(1, get(sensor, 0)) */
+    set = simplified.argv[0];
+    assert(set->function_type == GPR_FUNCTION_SET);
+    assert(set->argv[1]->function_type == GPR_FUNCTION_ADD);
+    assert(set->argv[1]->argc == 1);
+    assert(set->argv[1]->argv[0]->function_type == GPR_FUNCTION_GET);
+
+    /* noop(set(0, 0)) */
+    assert(simplified.argv[1]->function_type == GPR_FUNCTION_NOOP1);
+    assert(simplified.argv[1]->argc == 1);
+    set = simplified.argv[1]->argv[0];
+    assert(set->function_type == GPR_FUNCTION_SET);
+    assert(set->argv[1]->function_type == GPR_FUNCTION_VALUE);
+    assert(set->argv[1]->value == 0);
+
+    gpr_set_sensor(&state, 0, 2.5f);
+    gpr_set_sensor(&state, 1, 7);
+    gpr_set_sensor(&state_simplified, 0, 2.5f);
+    gpr_set_sensor(&state_simplified, 1, 7);
+    gpr_run(&f, &state, 0);
+    gpr_run(&simplified, &state_simplified, 0);
+    assert(state.actuators[1] == 2.5f);
+    assert(state_simplified.actuators[1] == 2.5f);
+    assert(state_simplified.actuators[0] == state.actuators[0]);
+
+    gpr_free(&f);
+    gpr_free(&simplified);
+    gpr_free_state(&state);
+    gpr_free_state(&state_simplified);
+
+    printf("Ok\n");
+}
+
 static void test_gpr_sort()
 {
     int population_size = 1000;
@@ -938,6 +1349,52 @@ static void test_gpr_sort_system()
     printf("Ok\n");
 }
 
+static void test_gpr_rank()
+{
+    int size = 1000, k = 100;
+    int i, rank[1000], partial[1000], items[1000], found[1000];
+    float fitness[1000];
+    unsigned int random_seed = 123;
+
+    printf("test_gpr_rank...");
+
+    /* fitness values with many ties and some NaN */
+    for (i = 0; i < size; i++) {
+        fitness[i] = (float)(rand_num(&random_seed)%50);
+        if (i%97 == 0) fitness[i] = NAN;
+        items[i] = i;
+    }
+
+    gpr_rank(fitness, size, size, rank);
+    for (i = 1; i < size; i++) {
+        if (isnan(fitness[rank[i]])) continue;
+        assert(!isnan(fitness[rank[i-1]]));
+        assert(fitness[rank[i-1]] >= fitness[rank[i]]);
+        if (fitness[rank[i-1]] == fitness[rank[i]]) {
+            assert(rank[i-1] < rank[i]);
+        }
+    }
+    assert(isnan(fitness[rank[size-1]]));
+
+    /* the fittest k are the same as for a full sort */
+    gpr_rank(fitness, size, k, partial);
+    memset(found, 0, sizeof(found));
+    for (i = 0; i < size; i++) {
+        if (i < k) assert(partial[i] == rank[i]);
+        assert((partial[i] >= 0) && (partial[i] < size));
+        assert(found[partial[i]] == 0);
+        found[partial[i]] = 1;
+    }
+
+    /* items follow the ranks */
+    gpr_permute(items, sizeof(int), rank, size);
+    for (i = 0; i < size; i++) {
+        assert(items[i] == rank[i]);
+    }
+
+    printf("Ok\n");
+}
+
 /* A test evaluation function.
    This tests how close the output is to the
    equation y = 3x^2 + 2x - 5 */
@@ -1154,6 +1611,114 @@ static void test_gpr_generation()
     printf("Ok\n");
 }
 
+/* returns the number of nodes of a tree, excluding the root,
+   which are not within an arena */
+static int test_gpr_heap_nodes(gpr_function * f)
+{
+    int i, heap_nodes = 0;
+
+    for (i = 0; i < f->argc; i++) {
+        if (f->argv[i] == 0) continue;
+        if (f->argv[i]->arena == 0) heap_nodes++;
+        heap_nodes += test_gpr_heap_nodes(f->argv[i]);
+    }
+    return heap_nodes;
+}
+
+static void test_gpr_arena()
+{
+    int population_size = 256;
+    int i, gen, max_depth = 5, moves = 0;
+    gpr_population population;
+    gpr_arena arena;
+    gpr_arena_block * block;
+    gpr_function * node;
+    float min_value = -5;
+    float max_value = 5;
+    float elitism = 0.2f;
+    float mutation_prob=0.5f;
+    float pure_mutant_prob=0.2f;
+    int time_steps = 10;
+    unsigned int random_seed = 93;
+    int integers_only = 0;
+    int ADFs = 0;
+    int instruction_set[64], no_of_instructions=0;
+    int data_size = 8, data_fields = 2;
+
+    printf("test_gpr_arena...");
+
+    /* nodes come from the heap unless an arena is selected */
+    assert(gpr_arena_selected() == 0);
+    node = gpr_node_alloc();
+    assert(node->arena == 0);
+    gpr_node_free(node);
+
+    gpr_arena_init(&arena);
+    assert(gpr_arena_select(&arena) == 0);
+    for (i = 0; i < GPR_ARENA_BLOCK_NODES*3; i++) {
+        node = gpr_node_alloc();
+        assert(node->arena == 1);
+        gpr_node_free(node);
+    }
+    assert(arena.nodes == GPR_ARENA_BLOCK_NODES*3);
+    assert(gpr_arena_select(0) == &arena);
+
+    /* released blocks are used again */
+    block = arena.block;
+    gpr_arena_clear(&arena);
+    assert(arena.nodes == 0);
+    assert(arena.block == 0);
+    assert(arena.spare == block);
+    gpr_arena_alloc(&arena);
+    assert(arena.block == block);
+    assert(arena.nodes == 1);
+    gpr_arena_free(&arena);
+
+    no_of_instructions =
+        gpr_default_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gpr_init_population(&population, population_size, 4, 1, 1,
+                        max_depth, min_value, max_value,
+                        integers_only, ADFs,
+                        data_size, data_fields,
+                        &random_seed,
+                        (int*)instruction_set,no_of_instructions);
+    assert(gpr_arena_selected() == 0);
+
+    for (gen = 0; gen < 20; gen++) {
+        i = population.arena_index;
+        gpr_evaluate(&population,
+                     time_steps,0,
+                     (*test_evaluate_program));
+        gpr_generation(&population,
+                       elitism,
+                       max_depth,
+                       min_value, max_value,
+                       mutation_prob, pure_mutant_prob,
+                       integers_only, ADFs,
+                       (int*)instruction_set, no_of_instructions);
+        if (population.arena_index != i) {
+            /* the previous arena has been released */
+            assert(population.arena[i].nodes == 0);
+            moves++;
+        }
+        assert(gpr_arena_selected() == 0);
+
+        /* all trees are within the arenas */
+        for (i = 0; i < population_size; i++) {
+            assert(test_gpr_heap_nodes(&population.individual[i]) == 0);
+        }
+    }
+
+    /* the population has moved between arenas */
+    assert(moves > 0);
+
+    gpr_free_population(&population);
+
+    printf("Ok\n");
+}
+
 static void test_gpr_environment()
 {
     int result, i, n, max_population_size = 64;
@@ -1965,20 +2530,27 @@ int run_tests()
 
     test_gpr_data();
     test_rand_num();
+    test_rand_stream();
     test_gpr_mutate_value();
     test_gpr_random_value();
     test_gpr_init();
     test_gpr_random();
     test_gpr_prune();
     test_gpr_copy();
+    test_gpr_flat();
     test_gpr_mutate();
     test_gpr_crossover();
+    test_gpr_annotate();
     test_gpr_mate();
     test_gpr_run();
+    test_gpr_vm();
+    test_gpr_simplify();
     test_gpr_sort();
     test_gpr_sort_system();
+    test_gpr_rank();
     test_gpr_init_state();
     test_gpr_generation();
+    test_gpr_arena();
     test_gpr_generation_system();
     test_gpr_dot();
     test_gpr_save_load();
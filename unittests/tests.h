@@ -38,6 +38,8 @@
 #include <math.h>
 #include "globals.h"
 #include "gpr.h"
+#include "gpr_flat.h"
+#include "gpr_vm.h"
 
 int run_tests();
 
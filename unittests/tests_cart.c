@@ -317,6 +317,1395 @@ static void test_gprc_run()
     printf("Ok\n");
 }
 
+static void test_gprc_run_batch()
+{
+    int rows=9, columns=16, sensors=4, actuators=2;
+    int connections_per_gene=4, i, j, k, s, step;
+    int chromosomes=1, modules=0, integers_only=0;
+    int no_of_samples = GPRC_BATCH_SIZE + 37;
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 4721;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    gprc_function * f;
+    float * inputs, * outputs, value;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_run_batch...");
+
+    /* create an instruction set */
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    /* create a population */
+    gprc_init_population(&population,
+                         10,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+
+    inputs = (float*)malloc(sensors*no_of_samples*sizeof(float));
+    outputs = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    for (i = 0; i < sensors*no_of_samples; i++) {
+        inputs[i] = (rand_num(&random_seed)%2000)/100.0f - 10.0f;
+    }
+
+    for (i = 0; i < population.size; i++) {
+        f = &population.individual[i];
+        assert(gprc_batch_supported(f, rows, columns,
+                                    connections_per_gene, sensors,
+                                    integers_only) != 0);
+        for (step = 1; step <= 2; step++) {
+            gprc_run_batch(f, &population, 0, step,
+                           no_of_samples, inputs, outputs, 0);
+
+            /* compare against running each sample in turn */
+            for (s = 0; s < no_of_samples; s++) {
+                gprc_clear_state(f, rows, columns, sensors, actuators);
+                for (j = 0; j < sensors; j++) {
+                    gprc_set_sensor(f, j, inputs[j*no_of_samples + s]);
+                }
+                for (k = 0; k < step; k++) {
+                    gprc_run(f, &population, 0, 0, 0);
+                }
+                for (j = 0; j < actuators; j++) {
+                    value = gprc_get_actuator(f, j, rows, columns,
+                                              sensors);
+                    assert(value == outputs[j*no_of_samples + s]);
+                }
+            }
+        }
+    }
+
+    /* dropout can also be batched */
+    f = &population.individual[0];
+    assert(gprc_batch_supported(f, rows, columns,
+                                connections_per_gene, sensors,
+                                integers_only) != 0);
+    gprc_run_batch(f, &population, 0.1f, 1,
+                   no_of_samples, inputs, outputs, 0);
+
+    free(inputs);
+    free(outputs);
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_simd()
+{
+    int rows=9, columns=16, sensors=4, actuators=2;
+    int connections_per_gene=4, i, k, level, initial_level;
+    int chromosomes=1, modules=0, integers_only=0;
+    int no_of_samples = GPRC_BATCH_SIZE + 37;
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 8351;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    float * inputs, * outputs, * expected;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_simd...");
+
+    initial_level = gprc_simd_level();
+
+    /* unsupported levels fall back to a lower one */
+    assert(gprc_simd_supported(GPRC_SIMD_NONE) != 0);
+    assert(gprc_simd_set_level(GPRC_SIMD_NONE) == GPRC_SIMD_NONE);
+    assert(gprc_simd_level() == GPRC_SIMD_NONE);
+    level = gprc_simd_set_level(GPRC_SIMD_AVX512);
+    assert(gprc_simd_supported(level) != 0);
+    assert(level <= GPRC_SIMD_AVX512);
+
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gprc_init_population(&population,
+                         10,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+
+    inputs = (float*)malloc(sensors*no_of_samples*sizeof(float));
+    outputs = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    expected = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    for (i = 0; i < sensors*no_of_samples; i++) {
+        inputs[i] = (rand_num(&random_seed)%2000)/100.0f - 10.0f;
+    }
+    /* include some values close to zero for the divide function */
+    for (i = 0; i < no_of_samples; i += 5) {
+        inputs[i] = (rand_num(&random_seed)%21)/100.0f - 0.1f;
+    }
+
+    /* each level should give the same results as the scalar version */
+    for (i = 0; i < population.size; i++) {
+        gprc_simd_set_level(GPRC_SIMD_NONE);
+        gprc_run_batch(&population.individual[i], &population, 0, 2,
+                       no_of_samples, inputs, expected, 0);
+        for (level = GPRC_SIMD_AVX2; level <= GPRC_SIMD_AVX512; level++) {
+            if (!gprc_simd_supported(level)) continue;
+            assert(gprc_simd_set_level(level) == level);
+            gprc_run_batch(&population.individual[i], &population, 0, 2,
+                           no_of_samples, inputs, outputs, 0);
+            for (k = 0; k < actuators*no_of_samples; k++) {
+                assert(memcmp(&outputs[k], &expected[k],
+                              sizeof(float)) == 0);
+            }
+        }
+    }
+
+    gprc_simd_set_level(initial_level);
+
+    free(inputs);
+    free(outputs);
+    free(expected);
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_jit()
+{
+    int rows=6, columns=8, sensors=3, actuators=2;
+    int connections_per_gene=3, i, k, hits, errors=0;
+    int chromosomes=1, modules=0, integers_only=0;
+    int no_of_samples = 100;
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 2856;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    gprc_function * f;
+    gprc_jit jit;
+    gprc_native run;
+    float * inputs, * outputs, * expected, * all;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_jit...");
+
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gprc_init_population(&population,
+                         4,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+
+    inputs = (float*)malloc(sensors*no_of_samples*sizeof(float));
+    outputs = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    expected = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    for (i = 0; i < sensors*no_of_samples; i++) {
+        inputs[i] = (rand_num(&random_seed)%2000)/100.0f - 10.0f;
+    }
+
+    assert(gprc_jit_init(&jit, 2, NULL) == 0);
+
+    for (i = 0; i < population.size; i++) {
+        f = &population.individual[i];
+        gprc_run_batch(f, &population, 0, 2,
+                       no_of_samples, inputs, expected, 0);
+
+        /* if a compiler is available the native version should
+           give the same results */
+        run = gprc_jit_compile(&jit, f, &population);
+        if (run != NULL) {
+            (*run)(no_of_samples, inputs, outputs, 2);
+            for (k = 0; k < actuators*no_of_samples; k++) {
+                assert(memcmp(&outputs[k], &expected[k],
+                              sizeof(float)) == 0);
+            }
+
+            /* the second time the cached version is returned */
+            hits = jit.hits;
+            assert(gprc_jit_compile(&jit, f, &population) == run);
+            assert(jit.hits == hits + 1);
+        }
+
+        gprc_jit_run(&jit, f, &population, 2,
+                     no_of_samples, inputs, outputs, 0);
+        for (k = 0; k < actuators*no_of_samples; k++) {
+            assert(memcmp(&outputs[k], &expected[k],
+                          sizeof(float)) == 0);
+        }
+    }
+    assert(jit.no_of_entries <= 2);
+
+    /* the cache can be shared between threads, each running its
+       own individual, even when there are fewer entries than
+       programs being run */
+    all = (float*)malloc(population.size*actuators*no_of_samples*
+                         sizeof(float));
+    for (i = 0; i < population.size; i++) {
+        gprc_run_batch(&population.individual[i], &population, 0, 2,
+                       no_of_samples, inputs,
+                       &all[i*actuators*no_of_samples], 0);
+    }
+#pragma omp parallel for num_threads(4) schedule(static,1) \
+    reduction(+:errors)
+    for (i = 0; i < 32; i++) {
+        int n = i % population.size;
+        float result[actuators*no_of_samples];
+
+        gprc_jit_run(&jit, &population.individual[n], &population, 2,
+                     no_of_samples, inputs, result, 0);
+        if (memcmp(result, &all[n*actuators*no_of_samples],
+                   actuators*no_of_samples*sizeof(float)) != 0) {
+            errors++;
+        }
+    }
+    assert(errors == 0);
+    assert(jit.no_of_entries <= 2);
+
+    gprc_jit_free(&jit);
+
+    free(all);
+    free(inputs);
+    free(outputs);
+    free(expected);
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_mc()
+{
+    int rows=6, columns=10, sensors=3, actuators=2;
+    int connections_per_gene=3, i, k, level, initial_level;
+    int chromosomes=1, modules=0, integers_only=0;
+    int no_of_samples = GPRC_MC_BLOCK*2 + 5;
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 7312;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    gprc_function * f;
+    gprc_mc_program program;
+    float * inputs, * outputs, * expected;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_mc...");
+
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gprc_init_population(&population,
+                         20,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+
+    inputs = (float*)malloc(sensors*no_of_samples*sizeof(float));
+    outputs = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    expected = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    for (i = 0; i < sensors*no_of_samples; i++) {
+        inputs[i] = (rand_num(&random_seed)%2000)/100.0f - 10.0f;
+    }
+
+    initial_level = gprc_simd_level();
+
+    for (i = 0; i < population.size; i++) {
+        f = &population.individual[i];
+        gprc_run_batch(f, &population, 0, 2,
+                       no_of_samples, inputs, expected, 0);
+
+        /* SSE and, if available, AVX2 versions should give the
+           same results as the interpreter */
+        for (level = GPRC_SIMD_NONE; level <= GPRC_SIMD_AVX2; level++) {
+            if (gprc_simd_set_level(level) != level) continue;
+            if (gprc_mc_compile(&program, f, &population, 0) != 0) {
+                assert(gprc_mc_available() == 0);
+                continue;
+            }
+            gprc_mc_run(&program, 2, no_of_samples, inputs, outputs);
+            for (k = 0; k < actuators*no_of_samples; k++) {
+                assert(memcmp(&outputs[k], &expected[k],
+                              sizeof(float)) == 0);
+            }
+            gprc_mc_free(&program);
+        }
+        gprc_simd_set_level(initial_level);
+
+        gprc_mc_run_batch(f, &population, 2,
+                          no_of_samples, inputs, outputs, 0);
+        for (k = 0; k < actuators*no_of_samples; k++) {
+            assert(memcmp(&outputs[k], &expected[k],
+                          sizeof(float)) == 0);
+        }
+    }
+
+    free(inputs);
+    free(outputs);
+    free(expected);
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_real_only()
+{
+    int rows=9, columns=16, sensors=4, actuators=2;
+    int connections_per_gene=4, i, j, k, s;
+    int chromosomes=1, modules=0, integers_only=0;
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 3512;
+    int instruction_set[64], no_of_instructions=0;
+    int real_instruction_set[] = {
+        GPR_FUNCTION_ADD, GPR_FUNCTION_SUBTRACT,
+        GPR_FUNCTION_NEGATE, GPR_FUNCTION_MULTIPLY,
+        GPR_FUNCTION_WEIGHT, GPR_FUNCTION_AVERAGE,
+        GPR_FUNCTION_SQUARE_ROOT, GPR_FUNCTION_SINE,
+        GPR_FUNCTION_SIGMOID, GPR_FUNCTION_MIN,
+        GPR_FUNCTION_MAX
+    };
+    gprc_population population;
+    gprc_function * f;
+    float expected[2], value, imaginary;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_real_only...");
+
+    /* constants can have imaginary parts */
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(gprc_real_only_instruction_set(instruction_set,
+                                          no_of_instructions) == 0);
+
+    /* create a population which can't produce imaginary values */
+    no_of_instructions = sizeof(real_instruction_set)/sizeof(int);
+    gprc_init_population(&population,
+                         10,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         real_instruction_set, no_of_instructions);
+    assert(population.real_only != 0);
+
+    for (i = 0; i < population.size; i++) {
+        f = &population.individual[i];
+        for (s = 0; s < 20; s++) {
+            /* run with both real and imaginary parts */
+            gprc_clear_state(f, rows, columns, sensors, actuators);
+            for (j = 0; j < sensors; j++) {
+                gprc_set_sensor(f, j, ((s*37 + j*11)%101)/7.0f - 6.0f);
+            }
+            for (k = 0; k < 2; k++) {
+                gprc_run_float(f, 0, rows, columns,
+                               connections_per_gene,
+                               sensors, actuators, 0, 0, 0);
+            }
+            for (j = 0; j < actuators; j++) {
+                expected[j] = gprc_get_actuator(f, j, rows, columns,
+                                                sensors);
+            }
+
+            /* the real only run should give the same result */
+            gprc_clear_state(f, rows, columns, sensors, actuators);
+            for (j = 0; j < sensors; j++) {
+                gprc_set_sensor(f, j, ((s*37 + j*11)%101)/7.0f - 6.0f);
+            }
+            for (k = 0; k < 2; k++) {
+                gprc_run(f, &population, 0, 0, 0);
+            }
+            for (j = 0; j < actuators; j++) {
+                value = gprc_get_actuator(f, j, rows, columns, sensors);
+                assert(value == expected[j]);
+                gprc_get_actuator_complex(f, j, rows, columns,
+                                          sensors, actuators,
+                                          &value, &imaginary);
+                assert(imaginary == 0);
+            }
+        }
+    }
+
+    /* complex sensors use the ordinary run function */
+    f = &population.individual[0];
+    gprc_clear_state(f, rows, columns, sensors, actuators);
+    for (j = 0; j < sensors; j++) {
+        gprc_set_sensor_complex(f, j, j+1, 2, sensors, actuators,
+                                rows, columns);
+    }
+    gprc_run_float(f, 0, rows, columns, connections_per_gene,
+                   sensors, actuators, 0, 0, 0);
+    for (j = 0; j < actuators; j++) {
+        expected[j] = gprc_get_actuator(f, j, rows, columns, sensors);
+    }
+    gprc_clear_state(f, rows, columns, sensors, actuators);
+    for (j = 0; j < sensors; j++) {
+        gprc_set_sensor_complex(f, j, j+1, 2, sensors, actuators,
+                                rows, columns);
+    }
+    gprc_run(f, &population, 0, 0, 0);
+    for (j = 0; j < actuators; j++) {
+        assert(gprc_get_actuator(f, j, rows, columns, sensors) ==
+               expected[j]);
+    }
+
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_neutral_offspring()
+{
+    int rows=9, columns=16, sensors=4, actuators=2;
+    int connections_per_gene=4, i, unused=-1, used=-1;
+    int chromosomes=1, modules=0, integers_only=0;
+    int gene_size = GPRC_GENE_SIZE(connections_per_gene);
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 6215;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    gprc_function * f1, * f2;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_neutral_offspring...");
+
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gprc_init_population(&population,
+                         20,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+    assert(population.offspring == 0);
+    assert(population.neutral_offspring == 0);
+
+    /* an exact copy has the same phenotype */
+    f1 = &population.individual[0];
+    f2 = &population.individual[1];
+    gprc_copy(f1, f2, rows, columns, connections_per_gene,
+              sensors, actuators);
+    gprc_used_functions(f2, rows, columns, connections_per_gene,
+                        sensors, actuators);
+
+    /* the decoded program behaves the same */
+    gprc_clear_state(f1, rows, columns, sensors, actuators);
+    gprc_clear_state(f2, rows, columns, sensors, actuators);
+    for (i = 0; i < sensors; i++) {
+        gprc_set_sensor(f1, i, i+1);
+        gprc_set_sensor(f2, i, i+1);
+    }
+    gprc_run(f1, &population, 0, 0, 0);
+    gprc_run(f2, &population, 0, 0, 0);
+    for (i = 0; i < actuators; i++) {
+        assert(gprc_get_actuator(f1, i, rows, columns, sensors) ==
+               gprc_get_actuator(f2, i, rows, columns, sensors));
+    }
+
+    for (i = 0; i < rows*columns; i++) {
+        if (f2->genome[0].used[sensors+i] == 0) {
+            if (unused == -1) unused = i;
+        }
+        else {
+            used = i;
+        }
+    }
+    assert(unused > -1);
+    assert(used > -1);
+
+    /* changing an inactive gene has no effect */
+    f2->genome[0].gene[unused*gene_size + GPRC_GENE_CONSTANT] += 1;
+    gprc_invalidate(f2);
+
+    /* the decoded program behaves the same */
+    gprc_clear_state(f1, rows, columns, sensors, actuators);
+    gprc_clear_state(f2, rows, columns, sensors, actuators);
+    for (i = 0; i < sensors; i++) {
+        gprc_set_sensor(f1, i, i+1);
+        gprc_set_sensor(f2, i, i+1);
+    }
+    gprc_run(f1, &population, 0, 0, 0);
+    gprc_run(f2, &population, 0, 0, 0);
+    for (i = 0; i < actuators; i++) {
+        assert(gprc_get_actuator(f1, i, rows, columns, sensors) ==
+               gprc_get_actuator(f2, i, rows, columns, sensors));
+    }
+
+    /* but changing an active gene does */
+    f2->genome[0].gene[used*gene_size + GPRC_GENE_CONSTANT] += 1;
+    gprc_invalidate(f2);
+    assert(gprc_same_phenotype(f1, f2, rows, columns,
+                               connections_per_gene,
+                               sensors, actuators) == 0);
+
+    /* with a low mutation rate many children are identical
+       to their parents and inherit their fitness */
+    for (i = 0; i < population.size; i++) {
+        population.fitness[i] = 1 + i;
+    }
+    gprc_generation(&population, 0.3f, 0.01f, 0, &random_seed,
+                    instruction_set, no_of_instructions);
+    assert(population.offspring > 0);
+    assert(population.neutral_offspring > 0);
+    assert(population.neutral_offspring <= population.offspring);
+
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+/* counts the number of times that individuals are evaluated */
+static int test_cache_evaluations = 0;
+
+static float test_cache_evaluate_program(int time_steps,
+                                         gprc_population * population,
+                                         int individual_index,
+                                         int custom_command)
+{
+    gprc_function * f = &population->individual[individual_index];
+
+#pragma omp atomic
+    test_cache_evaluations++;
+
+    gprc_set_sensor(f, 0, 2);
+    gprc_run(f, population, 0, 0, 0);
+    return 1 + fabs(gprc_get_actuator(f, 0,
+                                      population->rows,
+                                      population->columns,
+                                      population->sensors));
+}
+
+static void test_gprc_fitness_cache()
+{
+    int rows=9, columns=16, sensors=4, actuators=2;
+    int connections_per_gene=4, i, s, evaluations;
+    int chromosomes=1, modules=0, integers_only=0;
+    int step = GPRC_GENE_SIZE(connections_per_gene);
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 2953;
+    gprc_function * f;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    float fitness[20];
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_fitness_cache...");
+
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gprc_init_population(&population,
+                         20,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+    /* the cache is only used if enabled */
+    assert(population.cache->enabled == 0);
+    gpr_cache_enable(population.cache, 1);
+
+    /* a hit needs the same phenotype length as well as the same hash */
+    gpr_cache_set(population.cache, 12345, 7, 3.0f);
+    assert(gpr_cache_get(population.cache, 12345, 8, &fitness[0]) == 0);
+    assert(gpr_cache_get(population.cache, 12345, 7, &fitness[0]) != 0);
+    assert(fitness[0] == 3.0f);
+    gpr_cache_clear(population.cache);
+
+    /* copies have the same hash */
+    gprc_copy(&population.individual[0], &population.individual[1],
+              rows, columns, connections_per_gene, sensors, actuators);
+    assert(gprc_phenotype_hash(&population.individual[0],
+                               rows, columns, connections_per_gene,
+                               sensors, actuators) ==
+           gprc_phenotype_hash(&population.individual[1],
+                               rows, columns, connections_per_gene,
+                               sensors, actuators));
+
+    gprc_evaluate(&population, 1, 0, test_cache_evaluate_program);
+    evaluations = test_cache_evaluations;
+    assert(evaluations > 0);
+    assert(population.cache->misses > 0);
+    for (i = 0; i < population.size; i++) {
+        fitness[i] = population.fitness[i];
+        population.fitness[i] = 0;
+    }
+
+    /* the second time the fitness values come from the cache */
+    gprc_evaluate(&population, 1, 0, test_cache_evaluate_program);
+    assert(test_cache_evaluations == evaluations);
+    assert(population.cache->hits > 0);
+    for (i = 0; i < population.size; i++) {
+        assert(population.fitness[i] == fitness[i]);
+        population.fitness[i] = 0;
+    }
+
+    /* a different number of time steps is a different evaluation */
+    gprc_evaluate(&population, 2, 0, test_cache_evaluate_program);
+    assert(test_cache_evaluations > evaluations);
+    evaluations = test_cache_evaluations;
+
+    /* without the cache everything is evaluated */
+    gpr_cache_enable(population.cache, 0);
+    for (i = 0; i < population.size; i++) {
+        population.fitness[i] = 0;
+    }
+    gprc_evaluate(&population, 2, 0, test_cache_evaluate_program);
+    assert(test_cache_evaluations > evaluations);
+
+    /* individuals which can modify their own genome can't be hashed,
+       so each copy is evaluated separately */
+    gpr_cache_enable(population.cache, 1);
+    gpr_cache_clear(population.cache);
+    f = &population.individual[2];
+    for (i = 0; i < rows*columns; i++) {
+        if (f->genome[0].used[sensors+i] != 0) break;
+    }
+    assert(i < rows*columns);
+    f->genome[0].gene[i*step + GPRC_GENE_FUNCTION_TYPE] =
+        GPR_FUNCTION_COPY_CONSTANT;
+    gprc_invalidate(f);
+    gprc_used_functions(f, rows, columns, connections_per_gene,
+                        sensors, actuators);
+    gprc_copy(f, &population.individual[3],
+              rows, columns, connections_per_gene, sensors, actuators);
+    assert(gprc_phenotype_hash(f, rows, columns, connections_per_gene,
+                               sensors, actuators) == 0);
+    for (i = 0; i < population.size; i++) {
+        population.fitness[i] = 1;
+    }
+    population.fitness[2] = 0;
+    population.fitness[3] = 0;
+    for (s = 0; s < sensors; s++) {
+        if (f->genome[0].used[s] != 0) break;
+    }
+    evaluations = test_cache_evaluations;
+    gprc_evaluate(&population, 1, 0, test_cache_evaluate_program);
+    if (s < sensors) {
+        assert(test_cache_evaluations == evaluations + 2);
+    }
+    assert(population.cache->hits == 0);
+
+    gprc_free_population(&population);
+
+    /* individuals with ADFs can't be hashed either */
+    random_seed = 7145;
+    gprc_init_population(&population,
+                         20,
+                         4, 6,
+                         sensors, actuators,
+                         connections_per_gene,
+                         2,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+    gpr_cache_enable(population.cache, 1);
+    for (i = 1; i < population.size; i++) {
+        gprc_copy(&population.individual[0], &population.individual[i],
+                  4, 6, connections_per_gene, sensors, actuators);
+    }
+    assert(gprc_phenotype_hash(&population.individual[0],
+                               4, 6, connections_per_gene,
+                               sensors, actuators) == 0);
+    evaluations = test_cache_evaluations;
+    gprc_evaluate(&population, 1, 0, test_cache_evaluate_program);
+    assert((test_cache_evaluations - evaluations) % population.size == 0);
+    assert(population.cache->hits == 0);
+
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_run_bits()
+{
+    int rows=8, columns=12, sensors=6, actuators=2;
+    int connections_per_gene=2, i, j, k, s, supported=0;
+    int chromosomes=1, modules=0, integers_only=1;
+    int no_of_words = GPRC_BITS_BLOCK + 3;
+    float min_value=-3, max_value=3, value, expected;
+    unsigned int random_seed = 8612;
+    int instruction_set[] = {
+        GPR_FUNCTION_VALUE, GPR_FUNCTION_NOOP1,
+        GPR_FUNCTION_GREATER_THAN, GPR_FUNCTION_LESS_THAN,
+        GPR_FUNCTION_EQUALS, GPR_FUNCTION_AND,
+        GPR_FUNCTION_OR, GPR_FUNCTION_XOR, GPR_FUNCTION_NOT
+    };
+    int no_of_instructions = sizeof(instruction_set)/sizeof(int);
+    gprc_population population;
+    gprc_function * f;
+    unsigned long long * inputs, * outputs;
+    float values[2];
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_run_bits...");
+
+    gprc_init_population(&population,
+                         20,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+
+    inputs = (unsigned long long*)
+        malloc(sensors*no_of_words*sizeof(unsigned long long));
+    outputs = (unsigned long long*)
+        malloc(actuators*no_of_words*sizeof(unsigned long long));
+    for (i = 0; i < sensors*no_of_words; i++) {
+        inputs[i] = 0;
+        for (j = 0; j < 4; j++) {
+            inputs[i] = (inputs[i] << 16) ^ rand_num(&random_seed);
+        }
+    }
+
+    for (i = 0; i < population.size; i++) {
+        f = &population.individual[i];
+        if (gprc_run_bits(f, &population, 0, no_of_words,
+                          inputs, outputs, values) == 0) {
+            continue;
+        }
+        supported++;
+
+        /* compare against running each fitness case in turn */
+        for (s = 0; s < no_of_words*GPRC_BITS_WORD; s += 5) {
+            gprc_clear_state(f, rows, columns, sensors, actuators);
+            for (j = 0; j < sensors; j++) {
+                gprc_set_sensor(f, j,
+                                (inputs[j*no_of_words +
+                                        s/GPRC_BITS_WORD] >>
+                                 (s%GPRC_BITS_WORD)) & 1);
+            }
+            gprc_run(f, &population, 0, 0, 0);
+            for (k = 0; k < actuators; k++) {
+                value = gprc_get_actuator(f, k, rows, columns, sensors);
+                expected = 0;
+                if ((outputs[k*no_of_words + s/GPRC_BITS_WORD] >>
+                     (s%GPRC_BITS_WORD)) & 1) {
+                    expected = values[k];
+                }
+                assert(value == expected);
+            }
+        }
+    }
+    assert(supported > 0);
+
+    /* dropout can't be bit sliced */
+    assert(gprc_run_bits(&population.individual[0], &population,
+                         0.1f, no_of_words,
+                         inputs, outputs, values) == 0);
+
+    free(inputs);
+    free(outputs);
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_compact()
+{
+    int rows=9, columns=16, sensors=4, actuators=2;
+    int connections_per_gene=4, i, j, n, weights;
+    int chromosomes=3, modules=0, integers_only=0;
+    int step = GPRC_GENE_SIZE(connections_per_gene);
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 7240;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    gprc_function * f1, * f2;
+    gprc_compact c1, c2, child;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_compact...");
+
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+    weights = gprc_compact_uses_weights(instruction_set,
+                                        no_of_instructions);
+
+    gprc_init_population(&population,
+                         4,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+    f1 = &population.individual[0];
+    f2 = &population.individual[1];
+
+    gprc_compact_init(&c1, rows, columns, connections_per_gene,
+                      sensors, actuators, modules, weights);
+    gprc_compact_init(&c2, rows, columns, connections_per_gene,
+                      sensors, actuators, modules, weights);
+    gprc_compact_init(&child, rows, columns, connections_per_gene,
+                      sensors, actuators, modules, weights);
+
+    /* smaller than the float encoding */
+    assert(gprc_compact_size(&c1) <
+           (rows*columns*step + actuators)*(int)sizeof(float));
+
+    /* round trip */
+    assert(gprc_compact_encode(f1, &c1) == 0);
+    gprc_compact_copy(&c1, &c2);
+    gprc_compact_decode(&c2, f2);
+    for (i = 0, n = 0; i < rows*columns; i++, n += step) {
+        for (j = 0; j < GPRC_INITIAL+connections_per_gene; j++) {
+            assert(f1->genome[0].gene[n+j] == f2->genome[0].gene[n+j]);
+        }
+    }
+    for (i = 0; i < actuators; i++, n++) {
+        assert(f1->genome[0].gene[n] == f2->genome[0].gene[n]);
+    }
+
+    /* the decoded program behaves the same */
+    gprc_clear_state(f1, rows, columns, sensors, actuators);
+    gprc_clear_state(f2, rows, columns, sensors, actuators);
+    for (i = 0; i < sensors; i++) {
+        gprc_set_sensor(f1, i, i+1);
+        gprc_set_sensor(f2, i, i+1);
+    }
+    gprc_run(f1, &population, 0, 0, 0);
+    gprc_run(f2, &population, 0, 0, 0);
+    for (i = 0; i < actuators; i++) {
+        assert(gprc_get_actuator(f1, i, rows, columns, sensors) ==
+               gprc_get_actuator(f2, i, rows, columns, sensors));
+    }
+
+    /* each gene of the child comes from one of the parents */
+    assert(gprc_compact_encode(&population.individual[2], &c2) == 0);
+    gprc_compact_crossover(&c1, &c2, chromosomes, &child, &random_seed);
+    for (i = 0; i < rows*columns; i++) {
+        assert((child.module[0].constant[i] == c1.module[0].constant[i]) ||
+               (child.module[0].constant[i] == c2.module[0].constant[i]));
+    }
+    gprc_compact_decode(&child, &population.individual[3]);
+
+    /* connections which can't be stored */
+    f1->genome[0].gene[GPRC_INITIAL] = 0.5f;
+    assert(gprc_compact_encode(f1, &c1) == -1);
+
+    gprc_compact_free(&c1);
+    gprc_compact_free(&c2);
+    gprc_compact_free(&child);
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_retrace_gene()
+{
+    int rows=8, columns=20, sensors=4, actuators=3;
+    int connections_per_gene=3, i, j, m, n, index, col, changed=0;
+    int chromosomes=1, modules=0, integers_only=0;
+    int step = GPRC_GENE_SIZE(connections_per_gene);
+    int states = sensors + actuators + (rows*columns);
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 3381;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    gprc_function * f1, * f2;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_retrace_gene...");
+
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gprc_init_population(&population,
+                         2,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+    f1 = &population.individual[0];
+    f2 = &population.individual[1];
+    gprc_copy(f1, f2, rows, columns, connections_per_gene,
+              sensors, actuators);
+
+    for (i = 0; i < 500; i++) {
+        /* change a connection of a random gene */
+        index = rand_num(&random_seed)%(rows*columns);
+        col = index / rows;
+        n = index*step + GPRC_INITIAL +
+            rand_num(&random_seed)%connections_per_gene;
+        f1->genome[0].gene[n] =
+            rand_num(&random_seed)%((col*rows) + sensors);
+        f2->genome[0].gene[n] = f1->genome[0].gene[n];
+        if (f1->genome[0].used[sensors+index] != 0) changed++;
+
+        /* the same as tracing the whole grid */
+        gprc_retrace_gene(f1, 0, index, rows, columns,
+                          connections_per_gene, sensors, actuators);
+        gprc_used_functions(f2, rows, columns, connections_per_gene,
+                            sensors, actuators);
+        for (j = 0; j < states; j++) {
+            assert(f1->genome[0].used[j] == f2->genome[0].used[j]);
+        }
+    }
+    assert(changed > 0);
+
+    gprc_free_population(&population);
+
+    /* active mutations retrace the used genes, with and without ADFs */
+    for (modules = 0; modules <= 2; modules += 2) {
+        gprc_init_population(&population,
+                             2,
+                             rows, columns,
+                             sensors, actuators,
+                             connections_per_gene,
+                             modules,
+                             chromosomes,
+                             min_value, max_value,
+                             integers_only,
+                             data_size, data_fields,
+                             &random_seed,
+                             instruction_set, no_of_instructions);
+        f1 = &population.individual[0];
+        f2 = &population.individual[1];
+
+        for (i = 0; i < 500; i++) {
+            gprc_mutate_active(f1, rows, columns, sensors, actuators,
+                               connections_per_gene,
+                               min_value, max_value, integers_only,
+                               instruction_set, no_of_instructions);
+            gprc_copy(f1, f2, rows, columns, connections_per_gene,
+                      sensors, actuators);
+            gprc_used_functions(f2, rows, columns, connections_per_gene,
+                                sensors, actuators);
+            for (m = 0; m < modules+1; m++) {
+                for (j = 0; j < states; j++) {
+                    assert(f1->genome[m].used[j] ==
+                           f2->genome[m].used[j]);
+                }
+            }
+        }
+
+        gprc_free_population(&population);
+    }
+
+    printf("Ok\n");
+}
+
+static void test_gprc_ADF_calls()
+{
+    int rows=8, columns=10, sensors=4, actuators=2;
+    int connections_per_gene=4, i, k, calls=0;
+    int chromosomes=1, modules=2, integers_only=0;
+    int step = GPRC_GENE_SIZE(connections_per_gene);
+    float min_value=-10, max_value=10, value;
+    unsigned int random_seed = 5123;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    gprc_function * f;
+    float * gp;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_ADF_calls...");
+
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gprc_init_population(&population,
+                         4,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+    f = &population.individual[0];
+
+    /* make every third used gene call the first ADF module */
+    for (k = 0; k < rows*columns; k++) {
+        if ((f->genome[0].used[sensors+k] == 0) || (k%3 != 0)) continue;
+        gp = &f->genome[0].gene[k*step];
+        gp[GPRC_GENE_FUNCTION_TYPE] = GPR_FUNCTION_ADF;
+        gp[GPRC_GENE_CONSTANT] = 0;
+        gp[GPRC_INITIAL] = 1;
+        calls++;
+    }
+    assert(calls > 0);
+    gprc_used_functions(f, rows, columns, connections_per_gene,
+                        sensors, actuators);
+    assert(gprc_compiled_program(f, 1, rows, columns,
+                                 connections_per_gene, sensors,
+                                 0) != NULL);
+    assert(f->genome[1].program_pure != 0);
+
+    for (i = 0; i < sensors; i++) {
+        gprc_set_sensor(f, i, i);
+    }
+    gprc_run(f, &population, 0, 0, 0);
+    value = gprc_get_actuator(f, 0, rows, columns, sensors);
+
+    /* the most recent call was remembered */
+    assert(f->genome[1].call_args == 2);
+
+    /* the same result each time step */
+    gprc_run(f, &population, 0, 0, 0);
+    assert(gprc_get_actuator(f, 0, rows, columns, sensors) == value);
+
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_snapshot()
+{
+    int rows=10, columns=10, sensors=4, actuators=2;
+    int connections_per_gene=2, i, j, t, changed=0, restored=0;
+    int chromosomes=1, modules=0, integers_only=0;
+    int genes = rows*columns*GPRC_GENE_SIZE(connections_per_gene);
+    float min_value=-10, max_value=10, value[2];
+    unsigned int random_seed = 6310;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    gprc_snapshot snapshot;
+    gprc_function * f;
+    float * original;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_snapshot...");
+
+    no_of_instructions =
+        gprc_dynamic_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gprc_init_population(&population,
+                         20,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+    gprc_snapshot_init(&snapshot, rows, columns,
+                       connections_per_gene, modules);
+    original = (float*)malloc(genes*sizeof(float));
+
+    for (i = 0; i < population.size; i++) {
+        f = &population.individual[i];
+        memcpy((void*)original, (void*)f->genome[0].gene,
+               genes*sizeof(float));
+        assert(gprc_snapshot_begin(f, &snapshot) == 0);
+
+        for (t = 0; t < 2; t++) {
+            gprc_clear_state(f, rows, columns, sensors, actuators);
+            for (j = 0; j < sensors; j++) {
+                gprc_set_sensor(f, j, j+1);
+            }
+            for (j = 0; j < 4; j++) {
+                gprc_run(f, &population, 0, 1, 0);
+            }
+            for (j = 0; j < genes; j++) {
+                if (f->genome[0].gene[j] != original[j]) break;
+            }
+            if (j < genes) changed++;
+
+            /* each trial starts from the original genome */
+            if (t == 0) {
+                value[0] = gprc_get_actuator(f, 0, rows, columns, sensors);
+                value[1] = gprc_get_actuator(f, 1, rows, columns, sensors);
+            }
+            else {
+                assert(gprc_get_actuator(f, 0, rows, columns, sensors) ==
+                       value[0]);
+                assert(gprc_get_actuator(f, 1, rows, columns, sensors) ==
+                       value[1]);
+            }
+
+            restored += gprc_snapshot_restore(f);
+            for (j = 0; j < genes; j++) {
+                assert(f->genome[0].gene[j] == original[j]);
+            }
+        }
+        gprc_snapshot_end(f);
+        assert(f->snapshot == NULL);
+    }
+    assert(changed > 0);
+    assert(restored > 0);
+
+    free(original);
+    gprc_snapshot_free(&snapshot);
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_dropout()
+{
+    int rows=9, columns=16, sensors=4, actuators=2;
+    int connections_per_gene=4, i, j, bits=0, index=-1;
+    int chromosomes=1, modules=0, integers_only=0;
+    int no_of_samples = GPRC_BATCH_SIZE + 11;
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 4417;
+    int instruction_set[64], no_of_instructions=0;
+    unsigned long long mask[100], hash=0;
+    gprc_population population;
+    gprc_function * f;
+    float * inputs, * outputs;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_dropout...");
+
+    /* the proportion of bits set is close to the probability */
+    gprc_dropout_mask(1234, 0, gprc_dropout_threshold(0.1f), 100, mask);
+    for (i = 0; i < 100; i++) {
+        for (j = 0; j < GPRC_DROPOUT_WORD; j++) {
+            bits += (mask[i] >> j) & 1;
+        }
+    }
+    assert(bits > 100*GPRC_DROPOUT_WORD*0.08f);
+    assert(bits < 100*GPRC_DROPOUT_WORD*0.12f);
+
+    /* any word can be produced on its own */
+    assert(gprc_dropout_word(1234, 7, gprc_dropout_threshold(0.1f)) ==
+           mask[7]);
+    assert(gprc_dropout_word(1234, 7, gprc_dropout_threshold(0)) == 0);
+    assert(gprc_dropout_word(1234, 7, gprc_dropout_threshold(1)) ==
+           ~0ULL);
+
+    /* testing genes one at a time gives the same bits as the mask */
+    for (i = 0; i < 10*GPRC_DROPOUT_WORD; i++) {
+        assert(gprc_dropout_gene(1234, gprc_dropout_threshold(0.1f), i,
+                                 &index, &hash) ==
+               (int)((mask[i/GPRC_DROPOUT_WORD] >>
+                      (i%GPRC_DROPOUT_WORD)) & 1));
+    }
+
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gprc_init_population(&population,
+                         4,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+
+    inputs = (float*)malloc(sensors*no_of_samples*sizeof(float));
+    outputs = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    for (i = 0; i < sensors*no_of_samples; i++) {
+        inputs[i] = (rand_num(&random_seed)%1000)/100.0f;
+    }
+
+    /* when every gene is dropped the outputs remain cleared */
+    f = &population.individual[0];
+    gprc_clear_state(f, rows, columns, sensors, actuators);
+    for (i = 0; i < sensors; i++) {
+        gprc_set_sensor(f, i, i+1);
+    }
+    gprc_run(f, &population, 1, 0, 0);
+    for (i = 0; i < actuators; i++) {
+        assert(gprc_get_actuator(f, i, rows, columns, sensors) == 0);
+    }
+    gprc_run_batch(f, &population, 1, 2,
+                   no_of_samples, inputs, outputs, 0);
+    for (i = 0; i < actuators*no_of_samples; i++) {
+        assert(outputs[i] == 0);
+    }
+
+    free(inputs);
+    free(outputs);
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_evaluate_nodes()
+{
+    int rows=6, columns=10, sensors=3, actuators=1;
+    int connections_per_gene=2, i, j, generation;
+    int chromosomes=1, modules=0, integers_only=0;
+    int no_of_samples = 300;
+    float min_value=-10, max_value=10;
+    unsigned int random_seed = 6173;
+    int instruction_set[64], no_of_instructions=0;
+    gprc_population population;
+    gprc_node_cache cache, small;
+    gprc_nodes nodes;
+    gprc_function * f;
+    float * inputs, * targets, * outputs, * expected;
+    int data_size=0, data_fields=0;
+
+    printf("test_gprc_evaluate_nodes...");
+
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    assert(no_of_instructions>0);
+
+    gprc_init_population(&population,
+                         20,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules,
+                         chromosomes,
+                         min_value, max_value,
+                         integers_only,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+
+    inputs = (float*)malloc(sensors*no_of_samples*sizeof(float));
+    targets = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    outputs = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    expected = (float*)malloc(actuators*no_of_samples*sizeof(float));
+    for (i = 0; i < sensors*no_of_samples; i++) {
+        inputs[i] = (rand_num(&random_seed)%2000)/100.0f - 10.0f;
+    }
+    for (i = 0; i < no_of_samples; i++) {
+        targets[i] = inputs[i]*inputs[no_of_samples+i] -
+            inputs[no_of_samples*2+i];
+    }
+
+    gprc_node_cache_init(&cache, 8, 64*1024*1024);
+
+    for (generation = 0; generation < 6; generation++) {
+        gprc_evaluate_nodes(&population, &cache, 1, 1,
+                            no_of_samples, inputs, targets,
+                            0, 0);
+        assert(cache.no_of_stores > 0);
+        assert(cache.no_of_stores <= cache.size);
+
+        /* the fitness is the same as when running the whole program */
+        for (i = 0; i < population.size; i++) {
+            f = &population.individual[i];
+            for (j = 0; j < sensors; j++) {
+                if (f->genome[0].used[j] != 0) break;
+            }
+            if (j == sensors) continue;
+            gprc_run_batch(f, &population, 0, 1,
+                           no_of_samples, inputs, expected, 0);
+            assert(population.fitness[i] ==
+                   gprc_nodes_fitness(no_of_samples, actuators,
+                                      expected, targets));
+        }
+
+        gprc_generation(&population, 0.3f, 0.2f, 1, &random_seed,
+                        instruction_set, no_of_instructions);
+    }
+    /* some gene outputs of the children came from the cache */
+    assert(cache.reused > 0);
+
+    /* a stored individual doesn't need any genes to be evaluated */
+    f = &population.individual[0];
+    if (gprc_nodes_supported(f, rows, columns, connections_per_gene,
+                             sensors, integers_only, 1)) {
+        gprc_nodes_init(&nodes, rows, columns, connections_per_gene,
+                        sensors, actuators, no_of_samples);
+        gprc_run_nodes_base(f, rows, columns, connections_per_gene,
+                            sensors, actuators, integers_only, 1,
+                            NULL, &nodes, no_of_samples,
+                            inputs, expected, 0);
+        assert(gprc_run_nodes_base(f, rows, columns,
+                                   connections_per_gene,
+                                   sensors, actuators, integers_only, 1,
+                                   &nodes, NULL, no_of_samples,
+                                   inputs, outputs, 0) == 0);
+        for (i = 0; i < actuators*no_of_samples; i++) {
+            assert(outputs[i] == expected[i]);
+        }
+        gprc_nodes_free(&nodes);
+    }
+
+    /* nothing is stored if the memory limit is too small */
+    gprc_node_cache_init(&small, 8, 16);
+    gprc_evaluate_nodes(&population, &small, 1, 1,
+                        no_of_samples, inputs, targets, 0, 0);
+    assert(small.no_of_stores == 0);
+    gprc_node_cache_free(&small);
+
+    gprc_node_cache_free(&cache);
+    free(inputs);
+    free(targets);
+    free(outputs);
+    free(expected);
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
 static void test_gprc_environment()
 {
     int result, i, n, population_size = 32;
@@ -443,11 +1832,13 @@ static void test_gprc_run_dynamic()
 {
     gprc_function f,f2;
     int rows=20, columns=20, sensors=8, actuators=8;
-    int connections_per_gene=2, tick, i, j, ctr, trial;
+    int connections_per_gene=2, tick, i, j, ctr, trial, src, dest;
+    int step = GPRC_GENE_SIZE(connections_per_gene);
+    int * program, * program2;
     int chromosomes=2;
     int modules=1;
     int retval;
-    float min_value=-10, max_value=10;
+    float min_value=-10, max_value=10, * gene;
     int integers_only=0;
     unsigned int random_seed = 123;
     int instruction_set[64], no_of_instructions=0;
@@ -600,6 +1991,62 @@ static void test_gprc_run_dynamic()
         }
     }
 
+    /* a dynamic run which alters a used gene causes the compiled
+       list of used genes to be rebuilt */
+    no_of_instructions =
+        gprc_equation_instruction_set((int*)instruction_set);
+    gprc_init(&f, rows, columns, sensors, actuators,
+              connections_per_gene, modules,
+              data_size, data_fields, &random_seed);
+    gprc_init(&f2, rows, columns, sensors, actuators,
+              connections_per_gene, modules,
+              data_size, data_fields, &random_seed);
+    gprc_random(&f, rows, columns, sensors, actuators,
+                connections_per_gene, min_value, max_value,
+                0, &random_seed,
+                instruction_set, no_of_instructions);
+    gprc_used_functions(&f, rows, columns, connections_per_gene,
+                        sensors, actuators);
+    gprc_run(&f, &population, dropout_rate, 0, 0);
+    assert(f.genome[0].program_length >= 0);
+
+    /* an unused gene copies the function of one gene into
+       the first used gene */
+    gene = f.genome[0].gene;
+    for (dest = 1; dest < rows*columns; dest++) {
+        if (f.genome[0].used[sensors+dest] != 0) break;
+    }
+    for (i = (rows*columns)-1; i >= 0; i--) {
+        if ((f.genome[0].used[sensors+i] == 0) &&
+            (i/rows > dest/rows)) break;
+    }
+    for (src = 1; src < (i/rows)*rows; src++) {
+        if (gene[src*step] != gene[dest*step]) break;
+    }
+    assert((dest < rows*columns) && (i >= 0) && (src < (i/rows)*rows));
+    gene[i*step + GPRC_GENE_FUNCTION_TYPE] = GPR_FUNCTION_COPY_FUNCTION;
+    gene[i*step + GPRC_INITIAL] = sensors + src;
+    gene[i*step + GPRC_INITIAL + 1] = sensors + dest;
+
+    gprc_run(&f, &population, dropout_rate, 1, 0);
+    assert(gene[dest*step] == gene[src*step]);
+
+    /* the same as compiling a copy of the altered genome */
+    gprc_copy(&f, &f2, rows, columns, connections_per_gene,
+              sensors, actuators);
+    program = gprc_compiled_program(&f, 0, rows, columns,
+                                    connections_per_gene, sensors, 0);
+    program2 = gprc_compiled_program(&f2, 0, rows, columns,
+                                     connections_per_gene, sensors, 0);
+    assert((program != NULL) && (program2 != NULL));
+    assert(f.genome[0].program_length == f2.genome[0].program_length);
+    assert(memcmp(program, program2,
+                  f.genome[0].program_length*
+                  GPRC_INSTR_SIZE(connections_per_gene)*sizeof(int)) == 0);
+
+    gprc_free(&f);
+    gprc_free(&f2);
+
     gprc_free_population(&population);
 
     printf("Ok\n");
@@ -1330,6 +2777,338 @@ static void test_gprc_generation()
     printf("Ok\n");
 }
 
+static void test_gprc_generation_threads()
+{
+    int population_size = 256;
+    int rows = 6, columns = 10, sensors = 5, actuators = 3;
+    int connections_per_gene = GPRC_MAX_ADF_MODULE_SENSORS+1;
+    int chromosomes = 2, modules = 1;
+    float min_value = -5, max_value = 5;
+    gprc_population population[2];
+    int i, p, gen, time_steps = 10;
+    int genes = rows*columns*GPRC_GENE_SIZE(connections_per_gene);
+    int threads = omp_get_max_threads();
+    unsigned int random_seed[2];
+    int instruction_set[64], no_of_instructions=0;
+    int data_size = 8, data_fields = 2;
+
+    printf("test_gprc_generation_threads...");
+
+    no_of_instructions =
+        gprc_default_instruction_set((int*)instruction_set);
+
+    /* the same population bred on one thread and on several */
+    for (p = 0; p < 2; p++) {
+        random_seed[p] = 123;
+        gprc_init_population(&population[p],
+                             population_size,
+                             rows, columns,
+                             sensors, actuators,
+                             connections_per_gene,
+                             modules, chromosomes,
+                             min_value, max_value, 0,
+                             data_size, data_fields,
+                             &random_seed[p],
+                             instruction_set, no_of_instructions);
+
+        omp_set_num_threads(p == 0 ? 1 : 4);
+        for (gen = 0; gen < 5; gen++) {
+            gprc_evaluate(&population[p], time_steps, 0,
+                          (*test_evaluate_program));
+            gprc_generation(&population[p], 0.3f, 0.5f, 1,
+                            &random_seed[p],
+                            instruction_set, no_of_instructions);
+        }
+    }
+    omp_set_num_threads(threads);
+
+    assert(random_seed[0] == random_seed[1]);
+    for (i = 0; i < population_size; i++) {
+        assert(population[0].fitness[i] == population[1].fitness[i]);
+        assert(memcmp(population[0].individual[i].genome[0].gene,
+                      population[1].individual[i].genome[0].gene,
+                      genes*sizeof(float)) == 0);
+    }
+
+    for (p = 0; p < 2; p++) {
+        gprc_free_population(&population[p]);
+    }
+
+    printf("Ok\n");
+}
+
+static void test_gprc_steady_state()
+{
+    int population_size = 128;
+    int rows = 6, columns = 10, sensors = 5, actuators = 3;
+    int connections_per_gene = GPRC_MAX_ADF_MODULE_SENSORS+1;
+    int chromosomes = 2, modules = 1;
+    float min_value = -5, max_value = 5;
+    gprc_population population;
+    int i, retval, evaluations = 2000, time_steps = 10;
+    unsigned int random_seed = 123;
+    int instruction_set[64], no_of_instructions=0;
+    int data_size = 8, data_fields = 2;
+
+    printf("test_gprc_steady_state...");
+
+    no_of_instructions =
+        gprc_default_instruction_set((int*)instruction_set);
+
+    gprc_init_population(&population,
+                         population_size,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules, chromosomes,
+                         min_value, max_value, 0,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+
+    gprc_steady_state(&population, evaluations, 4, 0.5f, 1,
+                      &random_seed,
+                      instruction_set, no_of_instructions,
+                      time_steps, (*test_evaluate_program));
+    assert(population.offspring == evaluations);
+
+    /* the population is sorted and every individual is valid */
+    for (i = 0; i < population_size; i++) {
+        if (i > 0) {
+            assert(population.fitness[i-1] >= population.fitness[i]);
+        }
+        retval = gprc_validate(&population.individual[i],
+                               rows, columns,
+                               sensors, actuators,
+                               connections_per_gene, 0,
+                               instruction_set,
+                               no_of_instructions);
+        show_validation_message(retval);
+        assert(retval==GPR_VALIDATE_OK);
+    }
+    assert(gprc_best_individual(&population) ==
+           &population.individual[0]);
+
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+static void test_gprc_es()
+{
+    int lineages = 8, lambda = 4, generations = 20;
+    int population_size = lineages*(1+lambda);
+    int rows = 6, columns = 10, sensors = 5, actuators = 3;
+    int connections_per_gene = GPRC_MAX_ADF_MODULE_SENSORS+1;
+    int chromosomes = 2, modules = 1;
+    float min_value = -5, max_value = 5;
+    gprc_population population;
+    gprc_function child;
+    int i, retval, changed = 0, time_steps = 10;
+    unsigned int random_seed = 123;
+    int instruction_set[64], no_of_instructions=0;
+    int data_size = 8, data_fields = 2;
+
+    printf("test_gprc_es...");
+
+    no_of_instructions =
+        gprc_default_instruction_set((int*)instruction_set);
+
+    gprc_init_population(&population,
+                         population_size,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules, chromosomes,
+                         min_value, max_value, 0,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+
+    /* a single active mutation almost always changes the phenotype */
+    gprc_init(&child, rows, columns, sensors, actuators,
+              connections_per_gene, modules,
+              data_size, data_fields, &random_seed);
+    for (i = 0; i < 100; i++) {
+        gprc_copy(&population.individual[0], &child,
+                  rows, columns, connections_per_gene,
+                  sensors, actuators);
+        gprc_mutate_active(&child, rows, columns, sensors, actuators,
+                           connections_per_gene, min_value, max_value, 0,
+                           instruction_set, no_of_instructions);
+        gprc_used_functions(&child, rows, columns,
+                            connections_per_gene, sensors, actuators);
+        if (gprc_same_phenotype(&child, &population.individual[0],
+                                rows, columns, connections_per_gene,
+                                sensors, actuators) == 0) {
+            changed++;
+        }
+    }
+    assert(changed > 90);
+    gprc_free(&child);
+
+    for (i = 0; i < 2; i++) {
+        gprc_es(&population, lambda, generations, 0.2f, 1-i,
+                &random_seed,
+                instruction_set, no_of_instructions,
+                time_steps, (*test_evaluate_program));
+    }
+    assert(population.offspring == 2*lineages*lambda*generations);
+
+    /* the parents of the lineages are sorted */
+    for (i = 1; i < lineages; i++) {
+        assert(population.fitness[i-1] >= population.fitness[i]);
+    }
+    for (i = 0; i < population_size; i++) {
+        retval = gprc_validate(&population.individual[i],
+                               rows, columns,
+                               sensors, actuators,
+                               connections_per_gene, 0,
+                               instruction_set,
+                               no_of_instructions);
+        show_validation_message(retval);
+        assert(retval==GPR_VALIDATE_OK);
+    }
+
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
+/* errors upon each time step of the quadratic used by
+   test_evaluate_program */
+static float test_evaluate_cases(int time_steps,
+                                 gprc_population * population,
+                                 int individual_index,
+                                 float * errors)
+{
+    int t, i;
+    float x, result, fitness = 0;
+    gprc_function * f = &population->individual[individual_index];
+
+    for (t = 0; t < time_steps; t++) {
+        x = t+1;
+        for (i = 0; i < population->sensors; i++) {
+            gprc_set_sensor(f,i,x);
+        }
+        gprc_run(f, population, 0, 0, 0);
+        result = gprc_get_actuator(f,0,
+                                   population->rows,
+                                   population->columns,
+                                   population->sensors);
+        errors[t] = fabs(result - ((3*x*x) + (2*x) - 5));
+        if (errors[t] < 100) fitness += 100 - errors[t];
+    }
+    return fitness / (float)time_steps;
+}
+
+static void test_gprc_lexicase()
+{
+    int population_size = 130, cases = 10;
+    int rows = 6, columns = 10, sensors = 5, actuators = 3;
+    int connections_per_gene = GPRC_MAX_ADF_MODULE_SENSORS+1;
+    int chromosomes = 2, modules = 1;
+    float min_value = -5, max_value = 5;
+    gprc_population population;
+    gprc_lexicase lexicase;
+    int i, c, level, gen, retval, selected[3], sequence[3][200];
+    int simd_level = gprc_simd_level();
+    float errors[10], best_fitness = 0, max_fitness;
+    unsigned int random_seed = 123;
+    int instruction_set[64], no_of_instructions=0;
+    int data_size = 8, data_fields = 2;
+
+    printf("test_gprc_lexicase...");
+
+    /* only specialists upon a case can be selected */
+    gprc_lexicase_init(&lexicase, 4, population_size);
+    for (i = 0; i < population_size; i++) {
+        for (c = 0; c < 4; c++) errors[c] = 10;
+        if (i == 5) errors[0] = 0;
+        if (i == 70) errors[1] = 0;
+        if (i == 129) errors[2] = errors[3] = 0;
+        gprc_lexicase_set(&lexicase, i, errors);
+    }
+    memset(selected, 0, sizeof(selected));
+    for (i = 0; i < 300; i++) {
+        c = gprc_lexicase_select(&lexicase, 0, &random_seed);
+        assert((c == 5) || (c == 70) || (c == 129));
+        selected[(c == 5) ? 0 : ((c == 70) ? 1 : 2)]++;
+    }
+    assert((selected[0] > 0) && (selected[1] > 0) && (selected[2] > 0));
+    gprc_lexicase_free(&lexicase);
+
+    /* vector instructions select the same individuals */
+    for (level = GPRC_SIMD_NONE; level <= GPRC_SIMD_AVX512; level++) {
+        gprc_simd_set_level(level);
+        gprc_lexicase_init(&lexicase, cases, population_size);
+        random_seed = 555;
+        for (i = 0; i < population_size; i++) {
+            for (c = 0; c < cases; c++) {
+                errors[c] = rand_num(&random_seed)%4;
+            }
+            gprc_lexicase_set(&lexicase, i, errors);
+        }
+        gprc_lexicase_update_epsilon(&lexicase);
+        for (i = 0; i < 200; i++) {
+            sequence[level][i] =
+                gprc_lexicase_select(&lexicase, i%2, &random_seed);
+            assert(sequence[level][i] == sequence[0][i]);
+        }
+        gprc_lexicase_free(&lexicase);
+    }
+    gprc_simd_set_level(simd_level);
+
+    /* evolve using epsilon lexicase */
+    no_of_instructions =
+        gprc_default_instruction_set((int*)instruction_set);
+    gprc_init_population(&population,
+                         population_size,
+                         rows, columns,
+                         sensors, actuators,
+                         connections_per_gene,
+                         modules, chromosomes,
+                         min_value, max_value, 0,
+                         data_size, data_fields,
+                         &random_seed,
+                         instruction_set, no_of_instructions);
+    gprc_lexicase_init(&lexicase, cases, population_size);
+
+    for (gen = 0; gen < 10; gen++) {
+        gprc_evaluate_cases(&population, &lexicase, cases, 0,
+                            (*test_evaluate_cases));
+        /* the fittest individual survives */
+        max_fitness = 0;
+        for (i = 0; i < population_size; i++) {
+            if (population.fitness[i] > max_fitness) {
+                max_fitness = population.fitness[i];
+            }
+        }
+        assert(max_fitness >= best_fitness);
+        best_fitness = max_fitness;
+        gprc_generation_lexicase(&population, &lexicase, 1,
+                                 0.3f, 1, &random_seed,
+                                 instruction_set, no_of_instructions);
+        assert(population.fitness[0] == best_fitness);
+    }
+
+    for (i = 0; i < population_size; i++) {
+        retval = gprc_validate(&population.individual[i],
+                               rows, columns,
+                               sensors, actuators,
+                               connections_per_gene, 0,
+                               instruction_set,
+                               no_of_instructions);
+        show_validation_message(retval);
+        assert(retval==GPR_VALIDATE_OK);
+    }
+
+    gprc_lexicase_free(&lexicase);
+    gprc_free_population(&population);
+
+    printf("Ok\n");
+}
+
 static void test_gprc_generation_system()
 {
     int population_per_island = 256;
@@ -1969,12 +3748,30 @@ int run_tests_cartesian()
     test_gprc_copy();
     test_gprc_run();
     test_gprc_run_dynamic();
+    test_gprc_run_batch();
+    test_gprc_simd();
+    test_gprc_jit();
+    test_gprc_mc();
+    test_gprc_real_only();
+    test_gprc_neutral_offspring();
+    test_gprc_fitness_cache();
+    test_gprc_run_bits();
+    test_gprc_compact();
+    test_gprc_retrace_gene();
+    test_gprc_ADF_calls();
+    test_gprc_snapshot();
+    test_gprc_dropout();
+    test_gprc_evaluate_nodes();
     test_gprc_mutate();
     test_gprc_crossover();
     test_gprc_sort();
     test_gprc_sort_system();
     test_gprc_mate();
     test_gprc_generation();
+    test_gprc_generation_threads();
+    test_gprc_steady_state();
+    test_gprc_es();
+    test_gprc_lexicase();
     test_gprc_generation_system();
     test_gprc_save_load();
     test_gprc_save_load_system();
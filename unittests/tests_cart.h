@@ -39,6 +39,13 @@
 #include "globals.h"
 #include "gpr.h"
 #include "gprc.h"
+#include "gprc_batch.h"
+#include "gprc_jit.h"
+#include "gprc_mc.h"
+#include "gprc_bits.h"
+#include "gprc_compact.h"
+#include "gprc_nodes.h"
+#include "gprc_lexicase.h"
 
 int run_tests_cartesian();
 